@@ -212,6 +212,127 @@ int linkedlist_get(linkedlist_t* linkedlist, unsigned int index, void** element)
     return SUCCESSFUL_EXEC;
 }
 
+/// <summary>
+/// Inserts an element into a linked list before the given node. No lookup by index is needed.
+/// </summary>
+/// <param name="linkedlist">The linked list in which to insert. This cannot be null.</param>
+/// <param name="next">The node before which to insert. If null, the element is inserted at the tail.</param>
+/// <param name="element">The element to insert.</param>
+/// <param name="node">The out parameter for the node that wraps the element. This can be null.</param>
+/// <returns>Value of SUCCESSFUL_EXEC if successful.</returns>
+int linkedlist_insert(linkedlist_t* linkedlist, node_t* next, void* element, node_t** node) {
+    log_debug("Entering linkedlist_insert().");
+    if (linkedlist == NULL) {
+        // Linked list cannot be null.
+        return NULL_LINKED_LIST_ERRNO;
+    }
+
+    // Create a new node that wraps the element.
+    node_t *cnode = malloc(sizeof(node_t));
+    cnode->element = element;
+    linkedlist_link_node(linkedlist, next, cnode);
+
+    if (node != NULL) {
+        *node = cnode;
+    }
+
+    log_debug("Exiting linkedlist_insert().");
+    return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Removes a node from a linked list. No lookup by index is needed.
+/// </summary>
+/// <param name="linkedlist">The linked list in which to remove. This cannot be null.</param>
+/// <param name="node">The node to remove. This must belong to the linked list.</param>
+/// <returns>Value of SUCCESSFUL_EXEC if successful.</returns>
+int linkedlist_remove_node(linkedlist_t* linkedlist, node_t* node) {
+    log_debug("Entering linkedlist_remove_node().");
+    int result = linkedlist_unlink_node(linkedlist, node);
+    if (result != SUCCESSFUL_EXEC) {
+        return result;
+    }
+
+    // Free memory of removed node.
+    free(node);
+
+    log_debug("Exiting linkedlist_remove_node().");
+    return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Links a node into a linked list before the given node. The node belongs to the callee, which sets its element.
+/// No memory is allocated.
+/// </summary>
+/// <param name="linkedlist">The linked list in which to link. This cannot be null.</param>
+/// <param name="next">The node before which to link. If null, the node is linked at the tail.</param>
+/// <param name="node">The node to link. This cannot be null.</param>
+/// <returns>Value of SUCCESSFUL_EXEC if successful.</returns>
+int linkedlist_link_node(linkedlist_t* linkedlist, node_t* next, node_t* node) {
+    if (linkedlist == NULL) {
+        // Linked list cannot be null.
+        return NULL_LINKED_LIST_ERRNO;
+    }
+
+    if (node == NULL) {
+        return OUT_OF_BOUNDS_ERRNO;
+    }
+
+    node->next = next;
+    node->previous = next != NULL ? next->previous : linkedlist->tail;
+
+    // Update all links. Set new head and tail if applicable.
+    if (node->previous != NULL) {
+        node->previous->next = node;
+    } else {
+        linkedlist->head = node;
+    }
+
+    if (next != NULL) {
+        next->previous = node;
+    } else {
+        linkedlist->tail = node;
+    }
+
+    linkedlist->length++;
+    return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Unlinks a node from a linked list. The node belongs to the callee and is not freed.
+/// </summary>
+/// <param name="linkedlist">The linked list in which to unlink. This cannot be null.</param>
+/// <param name="node">The node to unlink. This must belong to the linked list.</param>
+/// <returns>Value of SUCCESSFUL_EXEC if successful.</returns>
+int linkedlist_unlink_node(linkedlist_t* linkedlist, node_t* node) {
+    if (linkedlist == NULL) {
+        // Linked list cannot be null.
+        return NULL_LINKED_LIST_ERRNO;
+    }
+
+    if (node == NULL) {
+        return OUT_OF_BOUNDS_ERRNO;
+    }
+
+    // Update all links. Set new head and tail if applicable.
+    if (node->previous != NULL) {
+        node->previous->next = node->next;
+    } else {
+        linkedlist->head = node->next;
+    }
+
+    if (node->next != NULL) {
+        node->next->previous = node->previous;
+    } else {
+        linkedlist->tail = node->previous;
+    }
+
+    node->next = NULL;
+    node->previous = NULL;
+    linkedlist->length--;
+    return SUCCESSFUL_EXEC;
+}
+
 /// <summary>
 /// Destroys a linked list and all used memory. The linked list structure does not belong to this module;
 /// The callee should deal with the structure memory itself.
@@ -357,5 +478,707 @@ int queue_destroy(queue_t* queue) {
     queue->llist = NULL;
     
     log_debug("Exiting queue_destroy().");
+    return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Initializes an AVL tree.
+/// </summary>
+/// <param name="tree">The tree to initialize. This cannot be null.</param>
+/// <param name="comparator">The ordering of the tree elements. This cannot be null.</param>
+/// <returns>Value of SUCCESSFUL_EXEC if successful.</returns>
+int avltree_init(avltree_t* tree, comparator_t comparator) {
+    if (tree == NULL || comparator == NULL) {
+        return NULL_TREE_ERRNO;
+    }
+
+    tree->root = NULL;
+    tree->comparator = comparator;
+    tree->length = 0;
+
+    return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Gets the height of a subtree. An empty subtree has a height of 0.
+/// </summary>
+/// <param name="node">The root of the subtree.</param>
+/// <returns>The height.</returns>
+static int avltree_height(treenode_t* node) {
+    return node != NULL ? node->height : 0;
+}
+
+/// <summary>
+/// Gets the number of nodes of the subtree of a node. The subtree of a null node is empty.
+/// </summary>
+/// <param name="node">The node. This can be null.</param>
+/// <returns>The number of nodes.</returns>
+static int avltree_count(treenode_t* node) {
+    return node != NULL ? node->count : 0;
+}
+
+/// <summary>
+/// Computes the height and the count of a node from the height and the count of its children.
+/// </summary>
+/// <param name="node">The node to update. This cannot be null.</param>
+static void avltree_update(treenode_t* node) {
+    int left_height = avltree_height(node->left), right_height = avltree_height(node->right);
+    node->height = 1 + (left_height > right_height ? left_height : right_height);
+    node->count = 1 + avltree_count(node->left) + avltree_count(node->right);
+}
+
+/// <summary>
+/// Replaces the subtree rooted at a node by another subtree, in the parent of the node.
+/// </summary>
+/// <param name="tree">The tree in which to replace.</param>
+/// <param name="node">The node to replace.</param>
+/// <param name="replacement">The replacing node. This can be null.</param>
+static void avltree_transplant(avltree_t* tree, treenode_t* node, treenode_t* replacement) {
+    if (node->parent == NULL) {
+        tree->root = replacement;
+    } else if (node->parent->left == node) {
+        node->parent->left = replacement;
+    } else {
+        node->parent->right = replacement;
+    }
+
+    if (replacement != NULL) {
+        replacement->parent = node->parent;
+    }
+}
+
+/// <summary>
+/// Rotates a subtree to the left. The right child of the node becomes the root of the subtree.
+/// </summary>
+/// <param name="tree">The tree in which to rotate.</param>
+/// <param name="node">The root of the subtree.</param>
+/// <returns>The new root of the subtree.</returns>
+static treenode_t* avltree_rotate_left(avltree_t* tree, treenode_t* node) {
+    treenode_t* pivot = node->right;
+    node->right = pivot->left;
+    if (pivot->left != NULL) {
+        pivot->left->parent = node;
+    }
+
+    avltree_transplant(tree, node, pivot);
+    pivot->left = node;
+    node->parent = pivot;
+
+    avltree_update(node);
+    avltree_update(pivot);
+    return pivot;
+}
+
+/// <summary>
+/// Rotates a subtree to the right. The left child of the node becomes the root of the subtree.
+/// </summary>
+/// <param name="tree">The tree in which to rotate.</param>
+/// <param name="node">The root of the subtree.</param>
+/// <returns>The new root of the subtree.</returns>
+static treenode_t* avltree_rotate_right(avltree_t* tree, treenode_t* node) {
+    treenode_t* pivot = node->left;
+    node->left = pivot->right;
+    if (pivot->right != NULL) {
+        pivot->right->parent = node;
+    }
+
+    avltree_transplant(tree, node, pivot);
+    pivot->right = node;
+    node->parent = pivot;
+
+    avltree_update(node);
+    avltree_update(pivot);
+    return pivot;
+}
+
+/// <summary>
+/// Updates heights and counts, and restores the AVL balance from a node up to the root.
+/// </summary>
+/// <param name="tree">The tree to rebalance.</param>
+/// <param name="node">The deepest node whose subtree changed. This can be null.</param>
+static void avltree_rebalance(avltree_t* tree, treenode_t* node) {
+    while (node != NULL) {
+        avltree_update(node);
+        int balance = avltree_height(node->left) - avltree_height(node->right);
+        if (balance > 1) {
+            // Left heavy. A left-right case needs a double rotation.
+            if (avltree_height(node->left->left) < avltree_height(node->left->right)) {
+                avltree_rotate_left(tree, node->left);
+            }
+
+            node = avltree_rotate_right(tree, node);
+        } else if (balance < -1) {
+            // Right heavy. A right-left case needs a double rotation.
+            if (avltree_height(node->right->right) < avltree_height(node->right->left)) {
+                avltree_rotate_right(tree, node->right);
+            }
+
+            node = avltree_rotate_left(tree, node);
+        }
+
+        node = node->parent;
+    }
+}
+
+/// <summary>
+/// Adds an element to an AVL tree. The tree is rebalanced in O(log n).
+/// </summary>
+/// <param name="tree">The tree in which to add. This cannot be null.</param>
+/// <param name="element">The element to add.</param>
+/// <param name="node">The out parameter for the node that wraps the element. This can be null.</param>
+/// <returns>Value of SUCCESSFUL_EXEC if successful.</returns>
+int avltree_add(avltree_t* tree, void* element, treenode_t** node) {
+    log_debug("Entering avltree_add().");
+    if (tree == NULL) {
+        // Tree cannot be null.
+        return NULL_TREE_ERRNO;
+    }
+
+    // Create a new node that wraps the element.
+    treenode_t *cnode = malloc(sizeof(treenode_t));
+    cnode->element = element;
+    avltree_link_node(tree, cnode);
+
+    if (node != NULL) {
+        *node = cnode;
+    }
+
+    log_debug("Exiting avltree_add().");
+    return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Removes a node from an AVL tree. The tree is rebalanced in O(log n).
+/// Other nodes of the tree are not moved in memory, so references to them stay valid.
+/// </summary>
+/// <param name="tree">The tree in which to remove. This cannot be null.</param>
+/// <param name="node">The node to remove. This must belong to the tree.</param>
+/// <returns>Value of SUCCESSFUL_EXEC if successful.</returns>
+int avltree_remove_node(avltree_t* tree, treenode_t* node) {
+    log_debug("Entering avltree_remove_node().");
+    int result = avltree_unlink_node(tree, node);
+    if (result != SUCCESSFUL_EXEC) {
+        return result;
+    }
+
+    // Free memory of removed node.
+    free(node);
+
+    log_debug("Exiting avltree_remove_node().");
+    return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Links a node into an AVL tree. The node belongs to the callee, which sets its element.
+/// No memory is allocated. The tree is rebalanced in O(log n).
+/// </summary>
+/// <param name="tree">The tree in which to link. This cannot be null.</param>
+/// <param name="node">The node to link. This cannot be null.</param>
+/// <returns>Value of SUCCESSFUL_EXEC if successful.</returns>
+int avltree_link_node(avltree_t* tree, treenode_t* node) {
+    if (tree == NULL) {
+        // Tree cannot be null.
+        return NULL_TREE_ERRNO;
+    }
+
+    if (node == NULL) {
+        return OUT_OF_BOUNDS_ERRNO;
+    }
+
+    node->left = NULL;
+    node->right = NULL;
+    node->height = 1;
+    node->count = 1;
+
+    // Find the parent of the new leaf. Equal elements go to the right to keep insertion order.
+    treenode_t *pnode = NULL, *nnode = tree->root;
+    int comparison = 0;
+    while (nnode != NULL) {
+        pnode = nnode;
+        comparison = tree->comparator(node->element, nnode->element);
+        nnode = comparison < 0 ? nnode->left : nnode->right;
+    }
+
+    node->parent = pnode;
+    if (pnode == NULL) {
+        tree->root = node;
+    } else if (comparison < 0) {
+        pnode->left = node;
+    } else {
+        pnode->right = node;
+    }
+
+    avltree_rebalance(tree, pnode);
+    tree->length++;
+    return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Unlinks a node from an AVL tree. The node belongs to the callee and is not freed. The tree is rebalanced in O(log n).
+/// Other nodes of the tree are not moved in memory, so references to them stay valid.
+/// </summary>
+/// <param name="tree">The tree in which to unlink. This cannot be null.</param>
+/// <param name="node">The node to unlink. This must belong to the tree.</param>
+/// <returns>Value of SUCCESSFUL_EXEC if successful.</returns>
+int avltree_unlink_node(avltree_t* tree, treenode_t* node) {
+    if (tree == NULL) {
+        // Tree cannot be null.
+        return NULL_TREE_ERRNO;
+    }
+
+    if (node == NULL) {
+        return OUT_OF_BOUNDS_ERRNO;
+    }
+
+    // The deepest node from which heights may have changed.
+    treenode_t* rebalance_from;
+    if (node->left == NULL) {
+        rebalance_from = node->parent;
+        avltree_transplant(tree, node, node->right);
+    } else if (node->right == NULL) {
+        rebalance_from = node->parent;
+        avltree_transplant(tree, node, node->left);
+    } else {
+        // Two children: relink the successor in place of the node, instead of swapping elements.
+        treenode_t* successor = node->right;
+        while (successor->left != NULL) {
+            successor = successor->left;
+        }
+
+        if (successor->parent != node) {
+            rebalance_from = successor->parent;
+            avltree_transplant(tree, successor, successor->right);
+            successor->right = node->right;
+            successor->right->parent = successor;
+        } else {
+            rebalance_from = successor;
+        }
+
+        avltree_transplant(tree, node, successor);
+        successor->left = node->left;
+        successor->left->parent = successor;
+    }
+
+    avltree_rebalance(tree, rebalance_from);
+
+    node->parent = NULL;
+    node->left = NULL;
+    node->right = NULL;
+    tree->length--;
+    return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Finds the first node whose element is not ordered before the given key.
+/// </summary>
+/// <param name="tree">The tree in which to search. This cannot be null.</param>
+/// <param name="key">The key to compare elements with, using the tree comparator.</param>
+/// <param name="node">The out parameter for the node. Null if all elements are ordered before the key.</param>
+/// <returns>Value of SUCCESSFUL_EXEC if successful.</returns>
+int avltree_lower_bound(avltree_t* tree, const void* key, treenode_t** node) {
+    if (tree == NULL) {
+        // Tree cannot be null.
+        return NULL_TREE_ERRNO;
+    }
+
+    *node = NULL;
+    treenode_t* cnode = tree->root;
+    while (cnode != NULL) {
+        if (tree->comparator(cnode->element, key) >= 0) {
+            // Candidate. A better one can only be on the left.
+            *node = cnode;
+            cnode = cnode->left;
+        } else {
+            cnode = cnode->right;
+        }
+    }
+
+    return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Counts the elements ordered before the given key, in O(log n).
+/// </summary>
+/// <param name="tree">The tree in which to count. This cannot be null.</param>
+/// <param name="key">The key to compare elements with, using the tree comparator.</param>
+/// <param name="rank">The out parameter for the count.</param>
+/// <returns>Value of SUCCESSFUL_EXEC if successful.</returns>
+int avltree_rank(avltree_t* tree, const void* key, unsigned int* rank) {
+    if (tree == NULL) {
+        // Tree cannot be null.
+        return NULL_TREE_ERRNO;
+    }
+
+    *rank = 0;
+    treenode_t* cnode = tree->root;
+    while (cnode != NULL) {
+        if (tree->comparator(cnode->element, key) >= 0) {
+            cnode = cnode->left;
+        } else {
+            // The node and its left subtree are ordered before the key.
+            *rank += 1 + avltree_count(cnode->left);
+            cnode = cnode->right;
+        }
+    }
+
+    return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Finds the first node of an AVL tree.
+/// </summary>
+/// <param name="tree">The tree in which to search. This cannot be null.</param>
+/// <param name="node">The out parameter for the node. Null if the tree is empty.</param>
+/// <returns>Value of SUCCESSFUL_EXEC if successful.</returns>
+int avltree_first(avltree_t* tree, treenode_t** node) {
+    if (tree == NULL) {
+        // Tree cannot be null.
+        return NULL_TREE_ERRNO;
+    }
+
+    treenode_t* cnode = tree->root;
+    while (cnode != NULL && cnode->left != NULL) {
+        cnode = cnode->left;
+    }
+
+    *node = cnode;
+    return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Finds the last node of an AVL tree.
+/// </summary>
+/// <param name="tree">The tree in which to search. This cannot be null.</param>
+/// <param name="node">The out parameter for the node. Null if the tree is empty.</param>
+/// <returns>Value of SUCCESSFUL_EXEC if successful.</returns>
+int avltree_last(avltree_t* tree, treenode_t** node) {
+    if (tree == NULL) {
+        // Tree cannot be null.
+        return NULL_TREE_ERRNO;
+    }
+
+    treenode_t* cnode = tree->root;
+    while (cnode != NULL && cnode->right != NULL) {
+        cnode = cnode->right;
+    }
+
+    *node = cnode;
+    return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Gets the node that follows the given node in the tree order.
+/// </summary>
+/// <param name="node">The current node. This cannot be null.</param>
+/// <returns>The next node, or null if the node is the last.</returns>
+treenode_t* avltree_next(treenode_t* node) {
+    if (node->right != NULL) {
+        // Leftmost node of the right subtree.
+        node = node->right;
+        while (node->left != NULL) {
+            node = node->left;
+        }
+
+        return node;
+    }
+
+    // First ancestor of which the node is in the left subtree.
+    while (node->parent != NULL && node->parent->right == node) {
+        node = node->parent;
+    }
+
+    return node->parent;
+}
+
+/// <summary>
+/// Gets the node that precedes the given node in the tree order.
+/// </summary>
+/// <param name="node">The current node. This cannot be null.</param>
+/// <returns>The previous node, or null if the node is the first.</returns>
+treenode_t* avltree_previous(treenode_t* node) {
+    if (node->left != NULL) {
+        // Rightmost node of the left subtree.
+        node = node->left;
+        while (node->right != NULL) {
+            node = node->right;
+        }
+
+        return node;
+    }
+
+    // First ancestor of which the node is in the right subtree.
+    while (node->parent != NULL && node->parent->left == node) {
+        node = node->parent;
+    }
+
+    return node->parent;
+}
+
+/// <summary>
+/// Destroys an AVL tree and all used memory. The tree structure does not belong to this module;
+/// the callee has to deal with the structure memory itself.
+/// </summary>
+/// <param name="tree">The tree to destroy. This cannot be null.</param>
+/// <returns>Value of SUCCESSFUL_EXEC if successful.</returns>
+int avltree_destroy(avltree_t* tree) {
+    log_debug("Entering avltree_destroy().");
+    if (tree == NULL) {
+        // Tree cannot be null.
+        return NULL_TREE_ERRNO;
+    }
+
+    // Free memory of all nodes, leaves first, without recursion.
+    treenode_t *cnode = tree->root, *tnode = NULL;
+    while (cnode != NULL) {
+        if (cnode->left != NULL) {
+            cnode = cnode->left;
+        } else if (cnode->right != NULL) {
+            cnode = cnode->right;
+        } else {
+            tnode = cnode;
+            cnode = cnode->parent;
+            if (cnode != NULL) {
+                if (cnode->left == tnode) {
+                    cnode->left = NULL;
+                } else {
+                    cnode->right = NULL;
+                }
+            }
+
+            free(tnode);
+        }
+    }
+
+    // Reset the structure to initial values.
+    tree->root = NULL;
+    tree->length = 0;
+
+    log_debug("Exiting avltree_destroy().");
+    return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Initializes a hash map.
+/// </summary>
+/// <param name="hashmap">The hash map to initialize. This cannot be null.</param>
+/// <param name="capacity">The initial capacity. It is rounded up to a power of two.</param>
+/// <returns>Value of SUCCESSFUL_EXEC if successful, OUT_OF_MEMORY_ERRNO if the entries cannot be allocated.</returns>
+int hashmap_init(hashmap_t* hashmap, unsigned int capacity) {
+    if (hashmap == NULL) {
+        return NULL_HASHMAP_ERRNO;
+    }
+
+    hashmap->capacity = 8;
+    while (hashmap->capacity < capacity) {
+        hashmap->capacity *= 2;
+    }
+
+    hashmap->entries = calloc(hashmap->capacity, sizeof(hashmap_entry_t));
+    hashmap->length = 0;
+    if (hashmap->entries == NULL) {
+        hashmap->capacity = 0;
+        return OUT_OF_MEMORY_ERRNO;
+    }
+
+    return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Gets the slot at which a key is expected in a hash map, before any probing.
+/// </summary>
+/// <param name="hashmap">The hash map.</param>
+/// <param name="key">The key.</param>
+/// <returns>The index of the slot.</returns>
+static unsigned int hashmap_slot(hashmap_t* hashmap, unsigned long key) {
+    // Fibonacci hashing: multiply by 2^64 / golden ratio and keep the high bits.
+    return (unsigned int) ((key * 11400714819323198485ull) >> 32) & (hashmap->capacity - 1);
+}
+
+/// <summary>
+/// Changes the capacity of a hash map and moves all entries to their new slot.
+/// </summary>
+/// <param name="hashmap">The hash map to resize.</param>
+/// <param name="capacity">The new capacity. It must be a power of two that holds all entries.</param>
+/// <returns>Value of SUCCESSFUL_EXEC if successful, OUT_OF_MEMORY_ERRNO if the new entries cannot be allocated. The map is then unchanged.</returns>
+static int hashmap_rehash(hashmap_t* hashmap, unsigned int capacity) {
+    hashmap_entry_t* entries = hashmap->entries;
+    unsigned int i, previous_capacity = hashmap->capacity;
+
+    // Keep the old entries if the new ones cannot be allocated.
+    hashmap_entry_t* new_entries = calloc(capacity, sizeof(hashmap_entry_t));
+    if (new_entries == NULL) {
+        return OUT_OF_MEMORY_ERRNO;
+    }
+
+    hashmap->capacity = capacity;
+    hashmap->entries = new_entries;
+    for (i = 0; i < previous_capacity; i++) {
+        if (entries[i].is_used) {
+            unsigned int i_slot = hashmap_slot(hashmap, entries[i].key);
+            while (hashmap->entries[i_slot].is_used) {
+                i_slot = (i_slot + 1) & (hashmap->capacity - 1);
+            }
+
+            hashmap->entries[i_slot] = entries[i];
+        }
+    }
+
+    free(entries);
+    return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Grows a hash map so it holds the given count of entries without growing again.
+/// </summary>
+/// <param name="hashmap">The hash map to grow. This cannot be null.</param>
+/// <param name="count">The count of entries to hold.</param>
+/// <returns>Value of SUCCESSFUL_EXEC if successful, NULL_HASHMAP_ERRNO if the map has no entries, i.e. its initialization failed or it was destroyed,
+/// OUT_OF_MEMORY_ERRNO if the map cannot grow. The map is then unchanged.</returns>
+int hashmap_reserve(hashmap_t* hashmap, unsigned int count) {
+    if (hashmap == NULL || !hashmap->capacity) {
+        return NULL_HASHMAP_ERRNO;
+    }
+
+    // Keep the load factor under 3/4, like a put does. A capacity that would not fit in an unsigned int cannot be allocated.
+    unsigned int capacity = hashmap->capacity;
+    while (4 * (unsigned long) count > 3 * (unsigned long) capacity) {
+        if (capacity > ~0u / 2) {
+            return OUT_OF_MEMORY_ERRNO;
+        }
+
+        capacity *= 2;
+    }
+
+    if (capacity != hashmap->capacity) {
+        return hashmap_rehash(hashmap, capacity);
+    }
+
+    return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Associates a value to a key in a hash map. The previous value of the key is replaced.
+/// </summary>
+/// <param name="hashmap">The hash map in which to put. This cannot be null.</param>
+/// <param name="key">The key.</param>
+/// <param name="value">The value.</param>
+/// <returns>Value of SUCCESSFUL_EXEC if successful, NULL_HASHMAP_ERRNO if the map has no entries, OUT_OF_MEMORY_ERRNO if the map cannot grow. The map is then unchanged.</returns>
+int hashmap_put(hashmap_t* hashmap, unsigned long key, void* value) {
+    if (hashmap == NULL || !hashmap->capacity) {
+        return NULL_HASHMAP_ERRNO;
+    }
+
+    // Probe until the key or an empty slot is found.
+    unsigned int i_slot = hashmap_slot(hashmap, key);
+    while (hashmap->entries[i_slot].is_used && hashmap->entries[i_slot].key != key) {
+        i_slot = (i_slot + 1) & (hashmap->capacity - 1);
+    }
+
+    // Only a new key grows the map. If it cannot grow, the map is left unchanged.
+    if (!hashmap->entries[i_slot].is_used && 4 * ((unsigned long) hashmap->length + 1) > 3 * (unsigned long) hashmap->capacity) {
+        int result = hashmap->capacity <= ~0u / 2 ? hashmap_rehash(hashmap, 2 * hashmap->capacity) : OUT_OF_MEMORY_ERRNO;
+        if (result != SUCCESSFUL_EXEC) {
+            return result;
+        }
+
+        i_slot = hashmap_slot(hashmap, key);
+        while (hashmap->entries[i_slot].is_used) {
+            i_slot = (i_slot + 1) & (hashmap->capacity - 1);
+        }
+    }
+
+    if (!hashmap->entries[i_slot].is_used) {
+        hashmap->entries[i_slot].key = key;
+        hashmap->entries[i_slot].is_used = 1;
+        hashmap->length++;
+    }
+
+    hashmap->entries[i_slot].value = value;
+    return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Gets the value associated to a key in a hash map.
+/// </summary>
+/// <param name="hashmap">The hash map in which to get. This cannot be null.</param>
+/// <param name="key">The key.</param>
+/// <param name="value">The out parameter for the value. Null if the key is not in the map.</param>
+/// <returns>Value of SUCCESSFUL_EXEC if successful.</returns>
+int hashmap_get(hashmap_t* hashmap, unsigned long key, void** value) {
+    if (hashmap == NULL) {
+        return NULL_HASHMAP_ERRNO;
+    }
+
+    *value = NULL;
+    unsigned int i_slot = hashmap_slot(hashmap, key);
+    while (hashmap->entries[i_slot].is_used) {
+        if (hashmap->entries[i_slot].key == key) {
+            *value = hashmap->entries[i_slot].value;
+            break;
+        }
+
+        i_slot = (i_slot + 1) & (hashmap->capacity - 1);
+    }
+
+    return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Removes a key from a hash map. Removing a missing key does nothing.
+/// </summary>
+/// <param name="hashmap">The hash map in which to remove. This cannot be null.</param>
+/// <param name="key">The key.</param>
+/// <returns>Value of SUCCESSFUL_EXEC if successful.</returns>
+int hashmap_remove(hashmap_t* hashmap, unsigned long key) {
+    if (hashmap == NULL) {
+        return NULL_HASHMAP_ERRNO;
+    }
+
+    unsigned int mask = hashmap->capacity - 1;
+    unsigned int i_slot = hashmap_slot(hashmap, key);
+    while (hashmap->entries[i_slot].is_used && hashmap->entries[i_slot].key != key) {
+        i_slot = (i_slot + 1) & mask;
+    }
+
+    if (!hashmap->entries[i_slot].is_used) {
+        return SUCCESSFUL_EXEC;
+    }
+
+    // Shift back the following entries of the probe sequence, so no tombstone is needed.
+    unsigned int i_empty = i_slot, i_next = (i_slot + 1) & mask;
+    while (hashmap->entries[i_next].is_used) {
+        unsigned int i_home = hashmap_slot(hashmap, hashmap->entries[i_next].key);
+
+        // The entry can fill the hole only if its home slot is not within (hole, entry].
+        if (((i_next - i_home) & mask) >= ((i_next - i_empty) & mask)) {
+            hashmap->entries[i_empty] = hashmap->entries[i_next];
+            i_empty = i_next;
+        }
+
+        i_next = (i_next + 1) & mask;
+    }
+
+    hashmap->entries[i_empty].is_used = 0;
+    hashmap->entries[i_empty].value = NULL;
+    hashmap->length--;
+    return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Destroys a hash map and all used memory. The hash map structure does not belong to this module;
+/// the callee has to deal with the structure memory itself.
+/// </summary>
+/// <param name="hashmap">The hash map to destroy. This cannot be null.</param>
+/// <returns>Value of SUCCESSFUL_EXEC if successful.</returns>
+int hashmap_destroy(hashmap_t* hashmap) {
+    if (hashmap == NULL) {
+        return NULL_HASHMAP_ERRNO;
+    }
+
+    free(hashmap->entries);
+    hashmap->entries = NULL;
+    hashmap->capacity = 0;
+    hashmap->length = 0;
+
     return SUCCESSFUL_EXEC;
 }
\ No newline at end of file
@@ -20,6 +20,15 @@ extern const int NULL_LINKED_LIST_ERRNO;
 // Error number when trying to modify a null queue.
 extern const int NULL_QUEUE_ERRNO;
 
+// Error number when trying to modify a null tree.
+extern const int NULL_TREE_ERRNO;
+
+// Error number when trying to modify a null hash map.
+extern const int NULL_HASHMAP_ERRNO;
+
+// Error number when the memory of a collection cannot be allocated.
+extern const int OUT_OF_MEMORY_ERRNO;
+
 // Structure for a double linked list node. Every node points to the previous and next node.
 // If the next node is NULL, then this node is the last.
 typedef struct node_t node_t;
@@ -41,6 +50,44 @@ typedef struct queue_t {
 	linkedlist_t* llist;
 } queue_t;
 
+// Function pointer for the ordering of tree elements.
+// Returns a negative value if left comes before right, 0 if they are equal and a positive value otherwise.
+typedef int (*comparator_t)(const void* left, const void* right);
+
+// Structure for a binary tree node. Every node points to its parent and children.
+// If the parent node is NULL, then this node is the root. The count is the number of nodes of its subtree.
+typedef struct treenode_t treenode_t;
+struct treenode_t {
+	void* element;
+    treenode_t* parent;
+    treenode_t* left;
+    treenode_t* right;
+    int height;
+    int count;
+};
+
+// Structure for a self-balancing (AVL) binary search tree. Equal elements are kept in insertion order.
+typedef struct avltree_t {
+    treenode_t* root;
+    comparator_t comparator;
+    int length;
+} avltree_t;
+
+// Structure for a hash map entry.
+typedef struct hashmap_entry_t {
+    unsigned long key;
+    void* value;
+    int is_used;
+} hashmap_entry_t;
+
+// Structure for a hash map from integer keys to values. Collisions are resolved by linear probing.
+// The capacity is always a power of two and doubles when the map is three quarters full.
+typedef struct hashmap_t {
+    hashmap_entry_t* entries;
+    unsigned int capacity;
+    unsigned int length;
+} hashmap_t;
+
 /// <summary>
 /// Initializes an linked list.
 /// </summary>
@@ -74,6 +121,42 @@ int linkedlist_remove(linkedlist_t* linkedlist, unsigned int index);
 /// <returns>Value of SUCCESSFUL_EXEC if successful.</returns>
 int linkedlist_get(linkedlist_t* linkedlist, unsigned int index, void** element);
 
+/// <summary>
+/// Inserts an element into a linked list before the given node. No lookup by index is needed.
+/// </summary>
+/// <param name="linkedlist">The linked list in which to insert. This cannot be null.</param>
+/// <param name="next">The node before which to insert. If null, the element is inserted at the tail.</param>
+/// <param name="element">The element to insert.</param>
+/// <param name="node">The out parameter for the node that wraps the element. This can be null.</param>
+/// <returns>Value of SUCCESSFUL_EXEC if successful.</returns>
+int linkedlist_insert(linkedlist_t* linkedlist, node_t* next, void* element, node_t** node);
+
+/// <summary>
+/// Removes a node from a linked list. No lookup by index is needed.
+/// </summary>
+/// <param name="linkedlist">The linked list in which to remove. This cannot be null.</param>
+/// <param name="node">The node to remove. This must belong to the linked list.</param>
+/// <returns>Value of SUCCESSFUL_EXEC if successful.</returns>
+int linkedlist_remove_node(linkedlist_t* linkedlist, node_t* node);
+
+/// <summary>
+/// Links a node into a linked list before the given node. The node belongs to the callee, which sets its element.
+/// No memory is allocated.
+/// </summary>
+/// <param name="linkedlist">The linked list in which to link. This cannot be null.</param>
+/// <param name="next">The node before which to link. If null, the node is linked at the tail.</param>
+/// <param name="node">The node to link. This cannot be null.</param>
+/// <returns>Value of SUCCESSFUL_EXEC if successful.</returns>
+int linkedlist_link_node(linkedlist_t* linkedlist, node_t* next, node_t* node);
+
+/// <summary>
+/// Unlinks a node from a linked list. The node belongs to the callee and is not freed.
+/// </summary>
+/// <param name="linkedlist">The linked list in which to unlink. This cannot be null.</param>
+/// <param name="node">The node to unlink. This must belong to the linked list.</param>
+/// <returns>Value of SUCCESSFUL_EXEC if successful.</returns>
+int linkedlist_unlink_node(linkedlist_t* linkedlist, node_t* node);
+
 /// <summary>
 /// Destroys a linked list and all used memory. The linked list structure does not belong to this module;
 /// The callee should deal with the structure memory itself.
@@ -121,4 +204,155 @@ int queue_isempty(queue_t* queue, int* empty);
 /// <returns>Value of SUCCESSFUL_EXEC if successful.</returns>
 int queue_destroy(queue_t* queue);
 
+/// <summary>
+/// Initializes an AVL tree.
+/// </summary>
+/// <param name="tree">The tree to initialize. This cannot be null.</param>
+/// <param name="comparator">The ordering of the tree elements. This cannot be null.</param>
+/// <returns>Value of SUCCESSFUL_EXEC if successful.</returns>
+int avltree_init(avltree_t* tree, comparator_t comparator);
+
+/// <summary>
+/// Adds an element to an AVL tree. The tree is rebalanced in O(log n).
+/// </summary>
+/// <param name="tree">The tree in which to add. This cannot be null.</param>
+/// <param name="element">The element to add.</param>
+/// <param name="node">The out parameter for the node that wraps the element. This can be null.</param>
+/// <returns>Value of SUCCESSFUL_EXEC if successful.</returns>
+int avltree_add(avltree_t* tree, void* element, treenode_t** node);
+
+/// <summary>
+/// Removes a node from an AVL tree. The tree is rebalanced in O(log n).
+/// Other nodes of the tree are not moved in memory, so references to them stay valid.
+/// </summary>
+/// <param name="tree">The tree in which to remove. This cannot be null.</param>
+/// <param name="node">The node to remove. This must belong to the tree.</param>
+/// <returns>Value of SUCCESSFUL_EXEC if successful.</returns>
+int avltree_remove_node(avltree_t* tree, treenode_t* node);
+
+/// <summary>
+/// Links a node into an AVL tree. The node belongs to the callee, which sets its element.
+/// No memory is allocated. The tree is rebalanced in O(log n).
+/// </summary>
+/// <param name="tree">The tree in which to link. This cannot be null.</param>
+/// <param name="node">The node to link. This cannot be null.</param>
+/// <returns>Value of SUCCESSFUL_EXEC if successful.</returns>
+int avltree_link_node(avltree_t* tree, treenode_t* node);
+
+/// <summary>
+/// Unlinks a node from an AVL tree. The node belongs to the callee and is not freed. The tree is rebalanced in O(log n).
+/// Other nodes of the tree are not moved in memory, so references to them stay valid.
+/// </summary>
+/// <param name="tree">The tree in which to unlink. This cannot be null.</param>
+/// <param name="node">The node to unlink. This must belong to the tree.</param>
+/// <returns>Value of SUCCESSFUL_EXEC if successful.</returns>
+int avltree_unlink_node(avltree_t* tree, treenode_t* node);
+
+/// <summary>
+/// Finds the first node whose element is not ordered before the given key.
+/// </summary>
+/// <param name="tree">The tree in which to search. This cannot be null.</param>
+/// <param name="key">The key to compare elements with, using the tree comparator.</param>
+/// <param name="node">The out parameter for the node. Null if all elements are ordered before the key.</param>
+/// <returns>Value of SUCCESSFUL_EXEC if successful.</returns>
+int avltree_lower_bound(avltree_t* tree, const void* key, treenode_t** node);
+
+/// <summary>
+/// Counts the elements ordered before the given key, in O(log n).
+/// </summary>
+/// <param name="tree">The tree in which to count. This cannot be null.</param>
+/// <param name="key">The key to compare elements with, using the tree comparator.</param>
+/// <param name="rank">The out parameter for the count.</param>
+/// <returns>Value of SUCCESSFUL_EXEC if successful.</returns>
+int avltree_rank(avltree_t* tree, const void* key, unsigned int* rank);
+
+/// <summary>
+/// Finds the first node of an AVL tree.
+/// </summary>
+/// <param name="tree">The tree in which to search. This cannot be null.</param>
+/// <param name="node">The out parameter for the node. Null if the tree is empty.</param>
+/// <returns>Value of SUCCESSFUL_EXEC if successful.</returns>
+int avltree_first(avltree_t* tree, treenode_t** node);
+
+/// <summary>
+/// Finds the last node of an AVL tree.
+/// </summary>
+/// <param name="tree">The tree in which to search. This cannot be null.</param>
+/// <param name="node">The out parameter for the node. Null if the tree is empty.</param>
+/// <returns>Value of SUCCESSFUL_EXEC if successful.</returns>
+int avltree_last(avltree_t* tree, treenode_t** node);
+
+/// <summary>
+/// Gets the node that follows the given node in the tree order.
+/// </summary>
+/// <param name="node">The current node. This cannot be null.</param>
+/// <returns>The next node, or null if the node is the last.</returns>
+treenode_t* avltree_next(treenode_t* node);
+
+/// <summary>
+/// Gets the node that precedes the given node in the tree order.
+/// </summary>
+/// <param name="node">The current node. This cannot be null.</param>
+/// <returns>The previous node, or null if the node is the first.</returns>
+treenode_t* avltree_previous(treenode_t* node);
+
+/// <summary>
+/// Destroys an AVL tree and all used memory. The tree structure does not belong to this module;
+/// the callee has to deal with the structure memory itself.
+/// </summary>
+/// <param name="tree">The tree to destroy. This cannot be null.</param>
+/// <returns>Value of SUCCESSFUL_EXEC if successful.</returns>
+int avltree_destroy(avltree_t* tree);
+
+/// <summary>
+/// Initializes a hash map.
+/// </summary>
+/// <param name="hashmap">The hash map to initialize. This cannot be null.</param>
+/// <param name="capacity">The initial capacity. It is rounded up to a power of two.</param>
+/// <returns>Value of SUCCESSFUL_EXEC if successful, OUT_OF_MEMORY_ERRNO if the entries cannot be allocated.</returns>
+int hashmap_init(hashmap_t* hashmap, unsigned int capacity);
+
+/// <summary>
+/// Associates a value to a key in a hash map. The previous value of the key is replaced.
+/// </summary>
+/// <param name="hashmap">The hash map in which to put. This cannot be null.</param>
+/// <param name="key">The key.</param>
+/// <param name="value">The value.</param>
+/// <returns>Value of SUCCESSFUL_EXEC if successful, NULL_HASHMAP_ERRNO if the map has no entries, OUT_OF_MEMORY_ERRNO if the map cannot grow. The map is then unchanged.</returns>
+int hashmap_put(hashmap_t* hashmap, unsigned long key, void* value);
+
+/// <summary>
+/// Gets the value associated to a key in a hash map.
+/// </summary>
+/// <param name="hashmap">The hash map in which to get. This cannot be null.</param>
+/// <param name="key">The key.</param>
+/// <param name="value">The out parameter for the value. Null if the key is not in the map.</param>
+/// <returns>Value of SUCCESSFUL_EXEC if successful.</returns>
+int hashmap_get(hashmap_t* hashmap, unsigned long key, void** value);
+
+/// <summary>
+/// Removes a key from a hash map. Removing a missing key does nothing.
+/// </summary>
+/// <param name="hashmap">The hash map in which to remove. This cannot be null.</param>
+/// <param name="key">The key.</param>
+/// <returns>Value of SUCCESSFUL_EXEC if successful.</returns>
+int hashmap_remove(hashmap_t* hashmap, unsigned long key);
+
+/// <summary>
+/// Grows a hash map so it holds the given count of entries without growing again.
+/// </summary>
+/// <param name="hashmap">The hash map to grow. This cannot be null.</param>
+/// <param name="count">The count of entries to hold.</param>
+/// <returns>Value of SUCCESSFUL_EXEC if successful, NULL_HASHMAP_ERRNO if the map has no entries, i.e. its initialization failed or it was destroyed,
+/// OUT_OF_MEMORY_ERRNO if the map cannot grow. The map is then unchanged.</returns>
+int hashmap_reserve(hashmap_t* hashmap, unsigned int count);
+
+/// <summary>
+/// Destroys a hash map and all used memory. The hash map structure does not belong to this module;
+/// the callee has to deal with the structure memory itself.
+/// </summary>
+/// <param name="hashmap">The hash map to destroy. This cannot be null.</param>
+/// <returns>Value of SUCCESSFUL_EXEC if successful.</returns>
+int hashmap_destroy(hashmap_t* hashmap);
+
 #endif
\ No newline at end of file
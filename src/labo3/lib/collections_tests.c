@@ -17,6 +17,9 @@ const int EMPTY_QUEUE_ERRNO = 2;
 const int OUT_OF_BOUNDS_ERRNO = 3;
 const int NULL_LINKED_LIST_ERRNO = 4;
 const int NULL_QUEUE_ERRNO = 5;
+const int NULL_TREE_ERRNO = 6;
+const int NULL_HASHMAP_ERRNO = 7;
+const int OUT_OF_MEMORY_ERRNO = 8;
 
 int main(void) {
     struct testresults_t results;
@@ -33,6 +36,10 @@ int main(void) {
     test_linkedlist_addone(&results, &linkedlist, 8);
     test_linkedlist_removeone(&results, &linkedlist, 3);
     test_linkedlist_removeone(&results, &linkedlist, 7);
+    test_linkedlist_insertremovenode(&results, &linkedlist, 0);
+    test_linkedlist_insertremovenode(&results, &linkedlist, 5);
+    test_linkedlist_insertremovenode(&results, &linkedlist, linkedlist.length);
+    test_linkedlist_linkunlinknode(&results, &linkedlist);
     test_linkedlist_removeall(&results, &linkedlist);
     test_linkedlist_destroy(&results, &linkedlist);
     tests_end(&results);
@@ -45,6 +52,35 @@ int main(void) {
     test_queue_dequeueall(&results, &queue);
     test_queue_destroy(&results, &queue);
     tests_end(&results);
+
+    // Tests AVL tree.
+    struct avltree_t tree;
+    int elements[TEST_SIZE];
+    treenode_t* nodes[TEST_SIZE];
+    tests_start(&results, stdout);
+    test_avltree_init(&results, &tree);
+    test_avltree_addall(&results, &tree, elements, nodes);
+    test_avltree_inorder(&results, &tree);
+    test_avltree_lowerbound(&results, &tree);
+    test_avltree_rank(&results, &tree);
+    test_avltree_removehalf(&results, &tree, nodes);
+    test_avltree_inorder(&results, &tree);
+    test_avltree_rank(&results, &tree);
+    test_avltree_linkunlinknode(&results, &tree);
+    test_avltree_inorder(&results, &tree);
+    test_avltree_destroy(&results, &tree);
+    tests_end(&results);
+
+    // Tests hash map.
+    struct hashmap_t hashmap;
+    tests_start(&results, stdout);
+    test_hashmap_init(&results, &hashmap);
+    test_hashmap_putall(&results, &hashmap, elements);
+    test_hashmap_getall(&results, &hashmap, elements);
+    test_hashmap_removehalf(&results, &hashmap, elements);
+    test_hashmap_reserve(&results, &hashmap, elements);
+    test_hashmap_destroy(&results, &hashmap);
+    tests_end(&results);
     
     exit(0);
 }
@@ -124,6 +160,70 @@ void test_linkedlist_removeone(testresults_t* results, linkedlist_t* linkedlist,
         "test_linkedlist_removeone(): Discrepancy in linked list length.", index);
 }
 
+// @LinkedListTest
+void test_linkedlist_insertremovenode(testresults_t* results, linkedlist_t* linkedlist, int index) {
+    int length = linkedlist->length;
+    char element[BUFFER_SIZE];
+    sprintf(element, "Element %d (inserted)", index);
+
+    // Find the node before which to insert. Inserting before null appends at the tail.
+    int i;
+    node_t* next = linkedlist->head;
+    for (i = 0; i < index; i++) {
+        next = next->next;
+    }
+
+    node_t* node = NULL;
+    tests_assert(results, 
+        linkedlist_insert(linkedlist, next, element, &node) == SUCCESSFUL_EXEC && node != NULL,
+        "test_linkedlist_insertremovenode(): Insertion of linked list element at index %d returned wrong value.", index);
+
+    tests_assert(results, 
+        linkedlist->length == length + 1 && node->next == next,
+        "test_linkedlist_insertremovenode(): Discrepancy in linked list after insertion at index %d.", index);
+
+    void* elemento;
+    linkedlist_get(linkedlist, index, &elemento);
+    tests_assert(results, 
+        strcmp((char*) elemento, element) == 0,
+        "test_linkedlist_insertremovenode(): Discrepancy in linked list element at index %d.", index);
+
+    tests_assert(results, 
+        linkedlist_remove_node(linkedlist, node) == SUCCESSFUL_EXEC,
+        "test_linkedlist_insertremovenode(): Removal of linked list node at index %d returned wrong value.", index);
+
+    tests_assert(results, 
+        linkedlist->length == length && (index == length || (linkedlist_get(linkedlist, index, &elemento) == SUCCESSFUL_EXEC && elemento == next->element)),
+        "test_linkedlist_insertremovenode(): Discrepancy in linked list after removal at index %d.", index);
+}
+
+// @LinkedListTest
+void test_linkedlist_linkunlinknode(testresults_t* results, linkedlist_t* linkedlist) {
+    int length = linkedlist->length;
+    char element[BUFFER_SIZE] = "Element (linked)";
+
+    // The node belongs to the test, not to the linked list.
+    node_t node = { .element = element };
+    node_t* next = linkedlist->head->next;
+    tests_assert(results, 
+        linkedlist_link_node(linkedlist, next, &node) == SUCCESSFUL_EXEC,
+        "test_linkedlist_linkunlinknode(): Link of linked list node returned wrong value.");
+
+    void* elemento;
+    linkedlist_get(linkedlist, 1, &elemento);
+    tests_assert(results, 
+        linkedlist->length == length + 1 && elemento == element && node.next == next && next->previous == &node,
+        "test_linkedlist_linkunlinknode(): Discrepancy in linked list after link.");
+
+    tests_assert(results, 
+        linkedlist_unlink_node(linkedlist, &node) == SUCCESSFUL_EXEC,
+        "test_linkedlist_linkunlinknode(): Unlink of linked list node returned wrong value.");
+
+    tests_assert(results, 
+        linkedlist->length == length && linkedlist->head->next == next && next->previous == linkedlist->head,
+        "test_linkedlist_linkunlinknode(): Discrepancy in linked list after unlink.");
+}
+
 // @LinkedListTest
 void test_linkedlist_removeall(testresults_t* results, linkedlist_t* linkedlist) {
     for (;0 < linkedlist->length;) {
@@ -192,6 +292,260 @@ void test_queue_destroy(testresults_t* results, queue_t* queue) {
         "test_queue_destroy(): Destroyal of queue returned wrong value.");
 }
 
+// @AvlTreeTest
+void test_avltree_init(testresults_t* results, avltree_t* tree) {
+    tests_assert(results, 
+        avltree_init(tree, &test_avltree_compare) == SUCCESSFUL_EXEC,
+        "test_avltree_init(): Initialization of tree returned wrong value.");
+}
+
+// @AvlTreeTest
+void test_avltree_addall(testresults_t* results, avltree_t* tree, int* elements, treenode_t** nodes) {
+    // Add even numbers in a scrambled order. TEST_SIZE and the step are coprime.
+    int i; for (i = 0; i < TEST_SIZE; i++) {
+        elements[i] = ((i * 37) % TEST_SIZE) * 2;
+        tests_assert(results, 
+            avltree_add(tree, &elements[i], &nodes[i]) == SUCCESSFUL_EXEC && nodes[i]->element == &elements[i],
+            "test_avltree_addall(): Add of element %d returned the wrong value.", elements[i]);
+    }
+
+    tests_assert(results, 
+        tree->length == TEST_SIZE,
+        "test_avltree_addall(): Discrepancy in tree length.");
+
+    // An AVL tree of n nodes is never higher than 1.44 * log2(n).
+    tests_assert(results, 
+        tree->root->height <= 10,
+        "test_avltree_addall(): Tree is not balanced. Height is %d.", tree->root->height);
+}
+
+// @AvlTreeTest
+void test_avltree_inorder(testresults_t* results, avltree_t* tree) {
+    int count = 0, previous = -1;
+    treenode_t* node;
+    avltree_first(tree, &node);
+    while (node != NULL) {
+        int element = *(int*) node->element;
+        tests_assert(results, 
+            element > previous,
+            "test_avltree_inorder(): Got element %d after element %d.", element, previous);
+
+        previous = element;
+        node = avltree_next(node);
+        count++;
+    }
+
+    tests_assert(results, 
+        count == tree->length,
+        "test_avltree_inorder(): Iterated over %d elements. Expected %d.", count, tree->length);
+
+    avltree_last(tree, &node);
+    tests_assert(results, 
+        node != NULL && *(int*) node->element == previous && (avltree_previous(node) == NULL || *(int*) avltree_previous(node)->element < previous),
+        "test_avltree_inorder(): Discrepancy in last element.");
+}
+
+// @AvlTreeTest
+void test_avltree_lowerbound(testresults_t* results, avltree_t* tree) {
+    treenode_t* node;
+    int i; for (i = -1; i < 2 * TEST_SIZE; i++) {
+        // Elements are the even numbers of [0, 2 * TEST_SIZE).
+        int expected = i < 0 ? 0 : i + (i % 2);
+        avltree_lower_bound(tree, &i, &node);
+        if (expected >= 2 * TEST_SIZE) {
+            tests_assert(results, 
+                node == NULL,
+                "test_avltree_lowerbound(): Lower bound of %d should not exist.", i);
+        } else {
+            tests_assert(results, 
+                node != NULL && *(int*) node->element == expected,
+                "test_avltree_lowerbound(): Lower bound of %d is not %d.", i, expected);
+        }
+    }
+}
+
+// @AvlTreeTest
+void test_avltree_rank(testresults_t* results, avltree_t* tree) {
+    // Every key, in or between elements, must be ranked after all smaller elements.
+    int key; for (key = -1; key <= 2 * TEST_SIZE; key++) {
+        unsigned int rank, expected = 0;
+        treenode_t* node;
+        avltree_first(tree, &node);
+        while (node != NULL && *(int*) node->element < key) {
+            expected++;
+            node = avltree_next(node);
+        }
+
+        tests_assert(results, 
+            avltree_rank(tree, &key, &rank) == SUCCESSFUL_EXEC && rank == expected,
+            "test_avltree_rank(): Rank of key %d is %u. Expected %u.", key, rank, expected);
+    }
+
+    tests_assert(results, 
+        tree->root == NULL || tree->root->count == tree->length,
+        "test_avltree_rank(): Discrepancy in the count of the root.");
+}
+
+// @AvlTreeTest
+void test_avltree_removehalf(testresults_t* results, avltree_t* tree, treenode_t** nodes) {
+    int i; for (i = 0; i < TEST_SIZE; i += 2) {
+        tests_assert(results, 
+            avltree_remove_node(tree, nodes[i]) == SUCCESSFUL_EXEC,
+            "test_avltree_removehalf(): Removal of node %d returned wrong value.", i);
+    }
+
+    tests_assert(results, 
+        tree->length == TEST_SIZE / 2 && tree->root->height <= 9,
+        "test_avltree_removehalf(): Discrepancy in tree length or height.");
+
+    // Remaining nodes must still wrap their original elements.
+    for (i = 1; i < TEST_SIZE; i += 2) {
+        treenode_t* node;
+        avltree_lower_bound(tree, nodes[i]->element, &node);
+        tests_assert(results, 
+            node == nodes[i],
+            "test_avltree_removehalf(): Node %d was moved by a removal.", i);
+    }
+}
+
+// @AvlTreeTest
+void test_avltree_linkunlinknode(testresults_t* results, avltree_t* tree) {
+    int length = tree->length;
+    int elements[TEST_SIZE];
+    treenode_t nodes[TEST_SIZE];
+
+    // The nodes belong to the test, not to the tree.
+    int i; for (i = 0; i < TEST_SIZE; i++) {
+        elements[i] = (i * 37) % TEST_SIZE;
+        nodes[i].element = &elements[i];
+        tests_assert(results, 
+            avltree_link_node(tree, &nodes[i]) == SUCCESSFUL_EXEC,
+            "test_avltree_linkunlinknode(): Link of node %d returned wrong value.", i);
+    }
+
+    tests_assert(results, 
+        tree->length == length + TEST_SIZE,
+        "test_avltree_linkunlinknode(): Discrepancy in tree length after link.");
+
+    for (i = 0; i < TEST_SIZE; i++) {
+        tests_assert(results, 
+            avltree_unlink_node(tree, &nodes[i]) == SUCCESSFUL_EXEC && nodes[i].parent == NULL,
+            "test_avltree_linkunlinknode(): Unlink of node %d returned wrong value.", i);
+    }
+
+    tests_assert(results, 
+        tree->length == length,
+        "test_avltree_linkunlinknode(): Discrepancy in tree length after unlink.");
+}
+
+// @AvlTreeTest
+void test_avltree_destroy(testresults_t* results, avltree_t* tree) {
+    tests_assert(results, 
+        avltree_destroy(tree) == SUCCESSFUL_EXEC && tree->root == NULL && tree->length == 0,
+        "test_avltree_destroy(): Destroyal of tree returned wrong value.");
+}
+
+// @HashMapTest
+void test_hashmap_init(testresults_t* results, hashmap_t* hashmap) {
+    tests_assert(results, 
+        hashmap_init(hashmap, 0) == SUCCESSFUL_EXEC && hashmap->length == 0,
+        "test_hashmap_init(): Initialization of hash map returned wrong value.");
+}
+
+// @HashMapTest
+void test_hashmap_putall(testresults_t* results, hashmap_t* hashmap, int* elements) {
+    // Keys are aligned like memory addresses, which must still spread over the slots.
+    int i; for (i = 0; i < TEST_SIZE; i++) {
+        elements[i] = i;
+        tests_assert(results, 
+            hashmap_put(hashmap, i * 4096UL, &elements[i]) == SUCCESSFUL_EXEC,
+            "test_hashmap_putall(): Put of key %d returned the wrong value.", i * 4096);
+    }
+
+    // Putting an existing key replaces its value.
+    hashmap_put(hashmap, 0, &elements[1]);
+    hashmap_put(hashmap, 0, &elements[0]);
+    tests_assert(results, 
+        hashmap->length == TEST_SIZE && hashmap->capacity >= TEST_SIZE,
+        "test_hashmap_putall(): Discrepancy in hash map length.");
+}
+
+// @HashMapTest
+void test_hashmap_getall(testresults_t* results, hashmap_t* hashmap, int* elements) {
+    void* value;
+    int i; for (i = 0; i < TEST_SIZE; i++) {
+        tests_assert(results, 
+            hashmap_get(hashmap, i * 4096UL, &value) == SUCCESSFUL_EXEC && value == &elements[i],
+            "test_hashmap_getall(): Got the wrong value for key %d.", i * 4096);
+    }
+
+    hashmap_get(hashmap, 1, &value);
+    tests_assert(results, 
+        value == NULL,
+        "test_hashmap_getall(): Got a value for a missing key.");
+}
+
+// @HashMapTest
+void test_hashmap_removehalf(testresults_t* results, hashmap_t* hashmap, int* elements) {
+    void* value;
+    int i; for (i = 0; i < TEST_SIZE; i += 2) {
+        tests_assert(results, 
+            hashmap_remove(hashmap, i * 4096UL) == SUCCESSFUL_EXEC,
+            "test_hashmap_removehalf(): Removal of key %d returned wrong value.", i * 4096);
+    }
+
+    tests_assert(results, 
+        hashmap->length == TEST_SIZE / 2,
+        "test_hashmap_removehalf(): Discrepancy in hash map length.");
+
+    for (i = 0; i < TEST_SIZE; i++) {
+        hashmap_get(hashmap, i * 4096UL, &value);
+        tests_assert(results, 
+            value == (i % 2 ? &elements[i] : NULL),
+            "test_hashmap_removehalf(): Got the wrong value for key %d.", i * 4096);
+    }
+}
+
+// @HashMapTest
+void test_hashmap_reserve(testresults_t* results, hashmap_t* hashmap, int* elements) {
+    tests_assert(results, 
+        hashmap_reserve(hashmap, 8 * TEST_SIZE) == SUCCESSFUL_EXEC && 4 * 8 * TEST_SIZE <= 3 * hashmap->capacity,
+        "test_hashmap_reserve(): Reservation of hash map returned wrong value.");
+
+    // Entries are kept, and putting up to the reserved count does not grow the map.
+    void* value;
+    unsigned int capacity = hashmap->capacity;
+    int i; for (i = 1; i < TEST_SIZE; i += 2) {
+        tests_assert(results, 
+            hashmap_get(hashmap, i * 4096UL, &value) == SUCCESSFUL_EXEC && value == &elements[i],
+            "test_hashmap_reserve(): Got the wrong value for key %d.", i * 4096);
+    }
+
+    for (i = 0; hashmap->length < 8 * TEST_SIZE; i++) {
+        hashmap_put(hashmap, i * 4096UL + 1, &elements[0]);
+    }
+
+    tests_assert(results, 
+        hashmap->capacity == capacity,
+        "test_hashmap_reserve(): Hash map grew before its reserved count.");
+}
+
+// @HashMapTest
+void test_hashmap_destroy(testresults_t* results, hashmap_t* hashmap) {
+    tests_assert(results, 
+        hashmap_destroy(hashmap) == SUCCESSFUL_EXEC && hashmap->length == 0,
+        "test_hashmap_destroy(): Destroyal of hash map returned wrong value.");
+
+    // A destroyed map has no entries, so it cannot be grown or put into.
+    tests_assert(results, 
+        hashmap_reserve(hashmap, TEST_SIZE) == NULL_HASHMAP_ERRNO && hashmap_put(hashmap, 0, NULL) == NULL_HASHMAP_ERRNO,
+        "test_hashmap_destroy(): Reservation of a destroyed hash map returned wrong value.");
+}
+
+int test_avltree_compare(const void* left, const void* right) {
+    return *(const int*) left - *(const int*) right;
+}
+
 void test_linkedlist_printlist(linkedlist_t* linkedlist) {
     log_debug("test_linkedlist_printlist(): Printing list of elements.");
     node_t *cnode = linkedlist->head;
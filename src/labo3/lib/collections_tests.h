@@ -4,6 +4,8 @@ void test_linkedlist_addall(testresults_t* results, linkedlist_t* linkedlist);
 void test_linkedlist_addone(testresults_t* results, linkedlist_t* linkedlist, int index);
 void test_linkedlist_getall(testresults_t* results, linkedlist_t* linkedlist);
 void test_linkedlist_removeone(testresults_t* results, linkedlist_t* linkedlist, int index);
+void test_linkedlist_insertremovenode(testresults_t* results, linkedlist_t* linkedlist, int index);
+void test_linkedlist_linkunlinknode(testresults_t* results, linkedlist_t* linkedlist);
 void test_linkedlist_removeall(testresults_t* results, linkedlist_t* linkedlist);
 void test_linkedlist_destroy(testresults_t* results, linkedlist_t* linkedlist);
 
@@ -13,6 +15,25 @@ void test_queue_queueall(testresults_t* results, queue_t* queue);
 void test_queue_dequeueall(testresults_t* results, queue_t* queue);
 void test_queue_destroy(testresults_t* results, queue_t* queue);
 
+// Unit test methods for the AVL tree collection.
+void test_avltree_init(testresults_t* results, avltree_t* tree);
+void test_avltree_addall(testresults_t* results, avltree_t* tree, int* elements, treenode_t** nodes);
+void test_avltree_inorder(testresults_t* results, avltree_t* tree);
+void test_avltree_lowerbound(testresults_t* results, avltree_t* tree);
+void test_avltree_rank(testresults_t* results, avltree_t* tree);
+void test_avltree_removehalf(testresults_t* results, avltree_t* tree, treenode_t** nodes);
+void test_avltree_linkunlinknode(testresults_t* results, avltree_t* tree);
+void test_avltree_destroy(testresults_t* results, avltree_t* tree);
+
+// Unit test methods for the hash map collection.
+void test_hashmap_init(testresults_t* results, hashmap_t* hashmap);
+void test_hashmap_putall(testresults_t* results, hashmap_t* hashmap, int* elements);
+void test_hashmap_getall(testresults_t* results, hashmap_t* hashmap, int* elements);
+void test_hashmap_removehalf(testresults_t* results, hashmap_t* hashmap, int* elements);
+void test_hashmap_reserve(testresults_t* results, hashmap_t* hashmap, int* elements);
+void test_hashmap_destroy(testresults_t* results, hashmap_t* hashmap);
+
 // Utility methods relative to tests.
+int test_avltree_compare(const void* left, const void* right);
 void test_linkedlist_printlist(linkedlist_t* linkedlist);
 void test_linkedlist_rprintlist(linkedlist_t* linkedlist);
\ No newline at end of file
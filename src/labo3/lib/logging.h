@@ -49,7 +49,7 @@ extern const unsigned int LOG_BUFFER_SIZE;
 /// <param name="func">the function in which the event occured.</param>
 /// <param name="format">The format string of the message.</param>
 /// <param name="...">The variable number of arguments for the format.</param>
-void flog_format(FILE* stream, const unsigned int level, const char *file, int line, const char *func, const char* format, ...) ;
+void flog_format(FILE* stream, const unsigned int level, const char *file, int line, const char *func, const char* format, ...) __attribute__((format(printf, 6, 7)));
 
 /// <summary>
 /// Logs an event to a stream. 
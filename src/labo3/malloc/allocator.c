@@ -2,164 +2,908 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/types.h>
+#include <sys/mman.h>
 #include <errno.h>
+#include <time.h>
 
 #include "../lib/collections.h"
 #include "../lib/logging.h"
 #include "allocator.h"
+#include "blocks.h"
 
 #define true 1
 #define false 0
 
-// The count of blocks still allocated.
-unsigned int allocated_block_count;
+// Structure for a block to relocate by a compaction: its address and its handle.
+typedef struct relocation_t {
+	mem_address_t address;
+	mem_handle_t handle;
+} relocation_t;
 
-// The current options applied.
-allocator_options_t* allocation_options;
+/// <summary>
+/// Initializes the free blocks and their indexes, the page map and the initial free blocks of an allocator, in that order.
+/// </summary>
+/// <param name="allocator">The allocator, whose options and strategies are set, and whose parts are empty.</param>
+/// <param name="strategy">The allocation strategy.</param>
+/// <returns>The state code. On failure, the parts initialized so far are left for mem_allocator_destroy().</returns>
+static int mem_allocator_init_parts(allocator_t* allocator, mem_allocation_strategy_t strategy) {
+	if (mem_blocks_init(&allocator->free_blocks) != SUCCESSFUL_EXEC) {
+		return COLLECTIONS_ERRNO;
+	}
+
+	// The size and address trees are only kept for the strategies that search by size or by address, or keep the free block list in address order.
+	// The segregated fit, TLSF and buddy strategies only search the bins, so their allocations and frees stay in bounded time.
+	if (strategy != &mem_allocation_strategy_segregated_fit && strategy != &mem_allocation_strategy_tlsf && strategy != &mem_allocation_strategy_buddy && 
+		mem_blocks_index_trees(&allocator->free_blocks) != SUCCESSFUL_EXEC) {
+		return COLLECTIONS_ERRNO;
+	}
+
+	// The first fit on arrays searches the free blocks as arrays ordered by address.
+	if (strategy == &mem_allocation_strategy_first_fit_arrays && mem_blocks_index_arrays(&allocator->free_blocks) != SUCCESSFUL_EXEC) {
+		return COLLECTIONS_ERRNO;
+	}
+
+	// The bitmap strategy searches the free blocks as a bitmap of granules.
+	int result;
+	if (strategy == &mem_allocation_strategy_bitmap) {
+		result = mem_blocks_index_bitmap(&allocator->free_blocks, allocator->options.address_space_first_address, allocator->options.address_space_size, 
+			allocator->options.granule_size ? allocator->options.granule_size : mem_block_bitmap_default_granule_size(allocator->options.address_space_size));
+		if (result != SUCCESSFUL_EXEC) {
+			return result;
+		}
+	}
+
+	// The pool of records grows outside of the allocations and frees for the reserved count of free blocks.
+	if (mem_blocks_reserve(&allocator->free_blocks, allocator->options.reserved_block_count) != SUCCESSFUL_EXEC) {
+		return OUT_OF_MEMORY_ERRNO;
+	}
+
+	if (mem_page_map_init(&allocator->page_map, allocator->options.address_space_first_address, allocator->options.address_space_size) != SUCCESSFUL_EXEC) {
+		return OUT_OF_MEMORY_ERRNO;
+	}
+
+	// Create the initial blocks. A deallocation strategy decides how the address space is cut into blocks.
+	if (allocator->deallocation_strategy != NULL) {
+		ptr_t address_space = { allocator->options.address_space_first_address, allocator->options.address_space_size, false };
+		return allocator->deallocation_strategy(allocator, &address_space);
+	}
 
-// The current memory allocation strategy applied.
-mem_allocation_strategy_t allocation_strategy;
+	if (mem_block_insert(&allocator->free_blocks, NULL, allocator->options.address_space_first_address, allocator->options.address_space_size, NULL) != SUCCESSFUL_EXEC) {
+		return COLLECTIONS_ERRNO;
+	}
 
-// The linked list of all free blocks.
-linkedlist_t* free_block_list;
+	return SUCCESSFUL_EXEC;
+}
 
 /// <summary>
 /// Initializes the allocator.
 /// </summary>
+/// <param name="allocator">The allocator to initialize.</param>
 /// <param name="strategy">Function pointer for memory allocation strategy to use.</param>
-/// <param name="options">Options for the allocator.</param>
+/// <param name="options">Options for the allocator. They are copied. If they are mapped, the address space is reserved with mmap.</param>
 /// <returns>The state code.</returns>
-int mem_allocator_init(mem_allocation_strategy_t strategy, allocator_options_t* options) {
-	if (strategy == NULL || options == NULL) {
+int mem_allocator_init(allocator_t* allocator, mem_allocation_strategy_t strategy, allocator_options_t* options) {
+	if (allocator == NULL || strategy == NULL || options == NULL || options->address_space_first_address > SZ_MAX - options->address_space_size) {
 		return ILLEGAL_ARGUMENTS_ERRNO;
 	}
 
-	log_debug("Entering mem_allocator_init(). First address: %lu, Adress space size: %u.", 
+	log_debug("Entering mem_allocator_init(). First address: %lu, Adress space size: %lu.", 
 		options->address_space_first_address, options->address_space_size);
 
-	// Initialize all globals.
-	allocation_strategy = strategy;
-	allocation_options = options;
-	free_block_list = malloc(sizeof(linkedlist_t));
-	if (linkedlist_init(free_block_list) != SUCCESSFUL_EXEC) {
-		return COLLECTIONS_ERRNO;
+	// Initialize the state of the allocator and of its strategy.
+	allocator->allocation_strategy = strategy;
+	allocator->deallocation_strategy = mem_deallocation_strategy_of(strategy);
+	allocator->reallocation_strategy = mem_reallocation_strategy_of(strategy);
+	allocator->aligned_allocation_strategy = mem_aligned_allocation_strategy_of(strategy);
+	allocator->options = *options;
+	if (options->is_mapped && mem_map_address_space(&allocator->options) != SUCCESSFUL_EXEC) {
+		return OUT_OF_MEMORY_ERRNO;
 	}
 
-	// Create the initial block.
-	ptr_t* initial_block = malloc(sizeof(ptr_t));
-	initial_block->address = options->address_space_first_address;
-	initial_block->size = options->address_space_size;
-	if (linkedlist_add(free_block_list, 0, initial_block) != SUCCESSFUL_EXEC) {
-		return COLLECTIONS_ERRNO;
+	allocator->allocated_block_count = 0;
+	allocator->next_fit_current = NULL;
+	allocator->search_step_count = 0;
+	memset(&allocator->adaptive, 0, sizeof(adaptive_state_t));
+	memset(&allocator->handles, 0, sizeof(handle_table_t));
+	memset(&allocator->compaction_stats, 0, sizeof(compaction_stats_t));
+	allocator->trace_recorder = NULL;
+
+	// Every part starts empty, so a failure anywhere is undone by mem_allocator_destroy(), which frees the parts in reverse order and unmaps the address space.
+	memset(&allocator->free_blocks, 0, sizeof(free_blocks_t));
+	memset(&allocator->page_map, 0, sizeof(page_map_t));
+	int result = mem_allocator_init_parts(allocator, strategy);
+	if (result != SUCCESSFUL_EXEC) {
+		mem_allocator_destroy(allocator);
+		return result;
 	}
-	
+
     log_debug("Exiting mem_allocator_init().");
     return SUCCESSFUL_EXEC;
 }
 
+/// <summary>
+/// Reserves the address space of the options with mmap, and sets their first address to the reserved range.
+/// The pages are only backed by memory once they are touched.
+/// </summary>
+/// <param name="options">The options to map.</param>
+/// <returns>The state code.</returns>
+int mem_map_address_space(allocator_options_t* options) {
+	log_debug("Entering mem_map_address_space().");
+	if (options == NULL || !options->address_space_size) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	void* mapping = mmap(NULL, options->address_space_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (mapping == MAP_FAILED) {
+		return OUT_OF_MEMORY_ERRNO;
+	}
+
+	options->address_space_first_address = (mem_address_t) mapping;
+
+	log_debug("Exiting mem_map_address_space(). First address: %lu.", options->address_space_first_address);
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Releases the address space of the options, reserved by mem_map_address_space().
+/// </summary>
+/// <param name="options">The options to unmap.</param>
+/// <returns>The state code.</returns>
+int mem_unmap_address_space(const allocator_options_t* options) {
+	log_debug("Entering mem_unmap_address_space().");
+	if (options == NULL || munmap((void*) options->address_space_first_address, options->address_space_size)) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	log_debug("Exiting mem_unmap_address_space().");
+	return SUCCESSFUL_EXEC;
+}
+
 /// <summary>
 /// Destroys the allocator.
 /// </summary>
+/// <param name="allocator">The allocator.</param>
 /// <returns>The state code.</returns>
-int mem_allocator_destroy() {
+int mem_allocator_destroy(allocator_t* allocator) {
 	log_debug("Entering mem_allocator_destroy().");
+	if (allocator == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
 
-	// Free all pointers.
-	node_t* current = free_block_list->head;
-	while (current != NULL) {
-		free(current->element);
-		current = current->next;
+	// Free the parts in the reverse order of their initialization.
+	free(allocator->handles.pointers);
+	free(allocator->handles.free_handles);
+	memset(&allocator->handles, 0, sizeof(handle_table_t));
+	mem_page_map_destroy(&allocator->page_map);
+	mem_blocks_destroy(&allocator->free_blocks);
+
+	if (allocator->options.is_mapped) {
+		mem_unmap_address_space(&allocator->options);
 	}
 
-	// Destroy all globals.
-	allocation_strategy = NULL;
-	linkedlist_destroy(free_block_list);
-	free(free_block_list);
+	// Reset the state of the allocator and of its strategy.
+	allocator->allocation_strategy = NULL;
+	allocator->deallocation_strategy = NULL;
+	allocator->reallocation_strategy = NULL;
+	allocator->aligned_allocation_strategy = NULL;
+	allocator->next_fit_current = NULL;
+	allocator->trace_recorder = NULL;
 
     log_debug("Exiting mem_allocator_destroy().");
     return SUCCESSFUL_EXEC;
 }
 
+/// <summary>
+/// Starts recording the allocations, reallocations and frees of the allocator into a trace, or stops if the recorder is null.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <param name="recorder">The recorder, opened by mem_trace_recorder_open(). It must stay open while the allocator records.</param>
+/// <returns>The state code.</returns>
+int mem_allocator_record(allocator_t* allocator, trace_recorder_t* recorder) {
+	log_debug("Entering mem_allocator_record().");
+	if (allocator == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	allocator->trace_recorder = recorder;
+
+	log_debug("Exiting mem_allocator_record().");
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Puts the memory of a block back into the free blocks.
+/// The deallocation strategy is called, if the allocation strategy has one.
+/// Otherwise, the memory is merged with its free neighbours and the free block list is kept in address order.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <param name="pointer">The pointer of the block.</param>
+/// <returns>The state code.</returns>
+static int mem_release_block(allocator_t* allocator, ptr_t* pointer) {
+	if (allocator->deallocation_strategy != NULL) {
+		return allocator->deallocation_strategy(allocator, pointer);
+	}
+
+	return mem_block_coalesce(&allocator->free_blocks, true, pointer->address, pointer->size, NULL);
+}
+
+/// <summary>
+/// Resizes an allocated block in place.
+/// The reallocation strategy is called, if the allocation strategy has one.
+/// Otherwise, the block shrinks by giving its tail back, or grows by taking the front of the free block right after it.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <param name="pointer">The pointer of the block.</param>
+/// <param name="size">The new size of the block.</param>
+/// <returns>The state code. OUT_OF_MEMORY_ERRNO if the block cannot grow in place.</returns>
+static int mem_resize_block(allocator_t* allocator, ptr_t* pointer, sz_t size) {
+	if (allocator->reallocation_strategy != NULL) {
+		return allocator->reallocation_strategy(allocator, pointer, size);
+	}
+
+	int result;
+	if (size < pointer->size) {
+		// The tail merges with the free block right after it, if any.
+		ptr_t tail = { pointer->address + size, pointer->size - size, false };
+		if ((result = mem_release_block(allocator, &tail)) != SUCCESSFUL_EXEC) {
+			return result;
+		}
+	} else {
+		void* element;
+		hashmap_get(&allocator->free_blocks.starts, pointer->address + pointer->size, &element);
+		block_t* next_block = element;
+		ptr_t growth = { 0, size - pointer->size, false };
+		if (next_block == NULL || next_block->pointer.size < growth.size) {
+			return OUT_OF_MEMORY_ERRNO;
+		}
+
+		if ((result = mem_block_split(&allocator->free_blocks, next_block, &growth)) != SUCCESSFUL_EXEC) {
+			return result;
+		}
+	}
+
+	pointer->size = size;
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Records a block given by a strategy as allocated, so it can be freed by its address only.
+/// If the page map cannot grow, the block is given back.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <param name="pointer">The pointer of the block.</param>
+/// <returns>The state code.</returns>
+static int mem_record_block(allocator_t* allocator, ptr_t* pointer) {
+	if (mem_page_map_set(&allocator->page_map, pointer->address, pointer->size) != SUCCESSFUL_EXEC) {
+		mem_release_block(allocator, pointer);
+		return OUT_OF_MEMORY_ERRNO;
+	}
+
+	pointer->is_allocated = true;
+	allocator->allocated_block_count++;
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Allocates an aligned block with the allocation strategy, by asking for its size plus the alignment minus one.
+/// Any block that large holds an aligned block of the size. The slack before it and the tail after it are given back to the free blocks.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <param name="pointer">The pointer into which to allocate. Its size is the size of the allocation.</param>
+/// <param name="alignment">The alignment of the address. It must be a power of two.</param>
+/// <returns>The state code.</returns>
+static int mem_allocate_padded(allocator_t* allocator, ptr_t* pointer, sz_t alignment) {
+	sz_t size = pointer->size;
+	if (size > SZ_MAX - (alignment - 1)) {
+		return OUT_OF_MEMORY_ERRNO;
+	}
+
+	pointer->size = size + (alignment - 1);
+	int result = allocator->allocation_strategy(allocator, pointer);
+	if (result != SUCCESSFUL_EXEC) {
+		pointer->size = size;
+		return result;
+	}
+
+	mem_address_t address = (pointer->address + (alignment - 1)) & ~(mem_address_t) (alignment - 1);
+	ptr_t slack = { pointer->address, address - pointer->address, false };
+	ptr_t tail = { address + size, pointer->address + pointer->size - address - size, false };
+	if ((slack.size && (result = mem_release_block(allocator, &slack)) != SUCCESSFUL_EXEC) || 
+		(tail.size && (result = mem_release_block(allocator, &tail)) != SUCCESSFUL_EXEC)) {
+		return result;
+	}
+
+	pointer->address = address;
+	pointer->size = size;
+	return SUCCESSFUL_EXEC;
+}
+
 /// <summary>
 /// Allocates a memory block of at least size bytes.
 /// The allocated memory location will be put into the pointer struct.
 /// </summary>
+/// <param name="allocator">The allocator.</param>
 /// <param name="size">The size of the allocation.</param>
 /// <param name="pointer">The pointer into which to allocate.</param>
 /// <returns>The state code.</returns>
-int mem_allocate(sz_t size, ptr_t* pointer) {
-    log_debug("Entering mem_allocate(). Size value: %u.", size);
-	if (!size || pointer == NULL) {
+int mem_allocate(allocator_t* allocator, sz_t size, ptr_t* pointer) {
+    log_debug("Entering mem_allocate(). Size value: %lu.", size);
+	if (allocator == NULL || !size || pointer == NULL) {
 		return ILLEGAL_ARGUMENTS_ERRNO;
 	}
 
 	// Call the allocation strategy.
 	pointer->size = size;
 	pointer->is_allocated = false;
-	int result = allocation_strategy(free_block_list, pointer);
-	if (result == SUCCESSFUL_EXEC) {
-		pointer->is_allocated = true;
-		allocated_block_count++;
-		log_debug("Exiting mem_allocate(). Address value: %lu.", pointer->address);
+	int result = allocator->allocation_strategy(allocator, pointer);
+	if (result != SUCCESSFUL_EXEC || (result = mem_record_block(allocator, pointer)) != SUCCESSFUL_EXEC) {
+		return result;
 	}
 
-    return result;
+	// The requested size is recorded, so that a replay asks the same of any strategy.
+	// A failed recording leaves the trace incomplete, but does not fail the allocation.
+	if (allocator->trace_recorder != NULL) {
+		mem_trace_record_allocation(allocator->trace_recorder, pointer->address, size);
+	}
+
+	log_debug("Exiting mem_allocate(). Address value: %lu.", pointer->address);
+    return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Allocates a memory block of at least size bytes, whose address is a multiple of the alignment.
+/// The allocated memory location will be put into the pointer struct.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <param name="size">The size of the allocation.</param>
+/// <param name="alignment">The alignment of the address. It must be a power of two.</param>
+/// <param name="pointer">The pointer into which to allocate.</param>
+/// <returns>The state code.</returns>
+int mem_allocate_aligned(allocator_t* allocator, sz_t size, sz_t alignment, ptr_t* pointer) {
+    log_debug("Entering mem_allocate_aligned(). Size value: %lu, Alignment value: %lu.", size, alignment);
+	if (allocator == NULL || !size || !alignment || (alignment & (alignment - 1)) || pointer == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	// Call the aligned allocation strategy, if the allocation strategy has one.
+	// Otherwise, allocate a block padded by the alignment and give back the slack around its aligned part.
+	int result;
+	pointer->size = size;
+	pointer->is_allocated = false;
+	if (allocator->aligned_allocation_strategy != NULL) {
+		result = allocator->aligned_allocation_strategy(allocator, pointer, alignment);
+	} else {
+		result = mem_allocate_padded(allocator, pointer, alignment);
+	}
+
+	if (result != SUCCESSFUL_EXEC || (result = mem_record_block(allocator, pointer)) != SUCCESSFUL_EXEC) {
+		return result;
+	}
+
+	if (allocator->trace_recorder != NULL) {
+		mem_trace_record_allocation(allocator->trace_recorder, pointer->address, size);
+	}
+
+	log_debug("Exiting mem_allocate_aligned(). Address value: %lu.", pointer->address);
+    return SUCCESSFUL_EXEC;
 }
 
 /// <summary>
 /// Frees a memory pointer and put the memory back into the allocator.
 /// </summary>
+/// <param name="allocator">The allocator.</param>
 /// <param name="pointer">The pointer from which to free.</param>
 /// <returns>The state code.</returns>
-int mem_free(ptr_t* pointer) {
-    log_debug("Entering mem_free(). Pointer address: %lu, Pointer size: %u.", pointer->address, pointer->size);
-	if (pointer == NULL) {
+int mem_free(allocator_t* allocator, ptr_t* pointer) {
+    log_debug("Entering mem_free(). Pointer address: %lu, Pointer size: %lu.", pointer->address, pointer->size);
+	if (allocator == NULL || pointer == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	// Only the blocks allocated at that address, with that size, can be freed. This rejects double frees.
+	if (mem_page_map_get(&allocator->page_map, pointer->address) != pointer->size) {
 		return ILLEGAL_ARGUMENTS_ERRNO;
 	}
 
-	// Find the node where to insert.
-	unsigned int i_current = 0;
-	ptr_t* next_pointer;
-	node_t* next = free_block_list->head;
-	while (next != NULL) {
-		next_pointer = next->element;
-		log_trace("next_pointer->address: %lu, pointer->address: %lu", next_pointer->address, pointer->address);
+	pointer->is_allocated = false;
+	int result = mem_release_block(allocator, pointer);
+	if (result != SUCCESSFUL_EXEC) {
+		return result;
+	}
 
-		if (next_pointer->address >= pointer->address) {
-			break;
+	allocator->allocated_block_count--;
+	mem_page_map_set(&allocator->page_map, pointer->address, 0);
+	if (allocator->trace_recorder != NULL) {
+		mem_trace_record_free(allocator->trace_recorder, pointer->address);
+	}
+
+    log_debug("Exiting mem_free().");
+    return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Allocates count memory blocks of the given sizes at once. Either all blocks are allocated, or none.
+/// The blocks are carved from a single free block found by one search of the allocation strategy, if one is large enough for all.
+/// Otherwise, or with the buddy system and the bitmap whose rounded blocks cannot be carved, they are allocated one by one.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <param name="count">The count of blocks.</param>
+/// <param name="sizes">The sizes of the blocks.</param>
+/// <param name="pointers">The pointers into which to allocate, one per size.</param>
+/// <returns>The state code.</returns>
+int mem_allocate_batch(allocator_t* allocator, unsigned int count, const sz_t sizes[], ptr_t pointers[]) {
+    log_debug("Entering mem_allocate_batch(). Count value: %u.", count);
+	if (allocator == NULL || !count || sizes == NULL || pointers == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	unsigned int i_pointer;
+	sz_t total_size = 0;
+	for (i_pointer = 0; i_pointer < count; i_pointer++) {
+		if (!sizes[i_pointer]) {
+			return ILLEGAL_ARGUMENTS_ERRNO;
 		}
 
-		// Move to the next node.
-		next = next->next;
-		i_current++;
+		// A total that does not fit a size saturates, and the blocks are then allocated one by one.
+		total_size = total_size < SZ_MAX - sizes[i_pointer] ? total_size + sizes[i_pointer] : SZ_MAX;
 	}
 
-	// Add the pointer to the linked list at the given position.
-	pointer->is_allocated = false;
-	ptr_t* new_pointer = malloc (sizeof(ptr_t));
-	*new_pointer = *pointer;
-	linkedlist_add(free_block_list, i_current, new_pointer);
+	// Carve all blocks, in order, from a single block of the total size.
+	int result;
+	ptr_t batch = { 0, total_size, false };
+	if (allocator->deallocation_strategy != &mem_deallocation_strategy_buddy && allocator->allocation_strategy != &mem_allocation_strategy_bitmap && total_size < SZ_MAX && 
+		allocator->allocation_strategy(allocator, &batch) == SUCCESSFUL_EXEC) {
+		mem_address_t address = batch.address;
+		for (i_pointer = 0; i_pointer < count; i_pointer++) {
+			pointers[i_pointer].address = address;
+			pointers[i_pointer].size = sizes[i_pointer];
+			if ((result = mem_page_map_set(&allocator->page_map, address, sizes[i_pointer])) != SUCCESSFUL_EXEC) {
+				// Forget the blocks recorded so far, and give the whole batch back.
+				while (i_pointer--) {
+					mem_page_map_set(&allocator->page_map, pointers[i_pointer].address, 0);
+				}
 
-	// Merge contigous memory from the inserted node (which is the node before next node).
-	mem_merge_contiguous(i_current, next->previous);
-	allocated_block_count--;
+				mem_release_block(allocator, &batch);
+				return OUT_OF_MEMORY_ERRNO;
+			}
 
-    log_debug("Exiting mem_free().");
+			pointers[i_pointer].is_allocated = true;
+			address += sizes[i_pointer];
+		}
+
+		for (i_pointer = 0; allocator->trace_recorder != NULL && i_pointer < count; i_pointer++) {
+			mem_trace_record_allocation(allocator->trace_recorder, pointers[i_pointer].address, pointers[i_pointer].size);
+		}
+
+		allocator->allocated_block_count += count;
+		log_debug("Exiting mem_allocate_batch(). Address value: %lu.", batch.address);
+		return SUCCESSFUL_EXEC;
+	}
+
+	// Allocate the blocks one by one. If one fails, the blocks allocated so far are freed.
+	for (i_pointer = 0; i_pointer < count; i_pointer++) {
+		if ((result = mem_allocate(allocator, sizes[i_pointer], &pointers[i_pointer])) != SUCCESSFUL_EXEC) {
+			if (i_pointer) {
+				mem_free_batch(allocator, i_pointer, pointers);
+			}
+
+			return result;
+		}
+	}
+
+    log_debug("Exiting mem_allocate_batch().");
+    return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Frees count memory pointers at once. A free block record is reserved for every pointer first, so either all pointers are freed, or none.
+/// The pointers are sorted by address, so contiguous pointers are merged into a single span before they are put back into the allocator.
+/// If a span still cannot be put back, the pointers of the spans before it are freed and the others stay allocated, with is_allocated telling which.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <param name="count">The count of pointers.</param>
+/// <param name="pointers">The pointers from which to free. They are sorted by address in place.</param>
+/// <returns>The state code.</returns>
+int mem_free_batch(allocator_t* allocator, unsigned int count, ptr_t pointers[]) {
+    log_debug("Entering mem_free_batch(). Count value: %u.", count);
+	if (allocator == NULL || !count || pointers == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	// Only blocks allocated at those addresses, with those sizes, can be freed, and only once each.
+	qsort(pointers, count, sizeof(ptr_t), &mem_block_compare_address);
+	unsigned int i_pointer;
+	for (i_pointer = 0; i_pointer < count; i_pointer++) {
+		if (mem_page_map_get(&allocator->page_map, pointers[i_pointer].address) != pointers[i_pointer].size || 
+			(i_pointer && pointers[i_pointer - 1].address == pointers[i_pointer].address)) {
+			return ILLEGAL_ARGUMENTS_ERRNO;
+		}
+	}
+
+	// A span puts back at most one free block per pointer, so a record is reserved for every pointer before any is freed.
+	int result = mem_blocks_reserve(&allocator->free_blocks, count);
+	if (result != SUCCESSFUL_EXEC) {
+		return result;
+	}
+
+	// Put every span of contiguous pointers back at once. The pointers of a span are only forgotten once the span is back,
+	// so a span that fails leaves its pointers and the following ones allocated.
+	unsigned int i_span = 0, j_pointer;
+	ptr_t span = pointers[0];
+	for (i_pointer = 1; i_pointer <= count; i_pointer++) {
+		if (i_pointer < count && span.address + span.size == pointers[i_pointer].address) {
+			span.size += pointers[i_pointer].size;
+			continue;
+		}
+
+		if ((result = mem_release_block(allocator, &span)) != SUCCESSFUL_EXEC) {
+			return result;
+		}
+
+		for (j_pointer = i_span; j_pointer < i_pointer; j_pointer++) {
+			pointers[j_pointer].is_allocated = false;
+			mem_page_map_set(&allocator->page_map, pointers[j_pointer].address, 0);
+			allocator->allocated_block_count--;
+			if (allocator->trace_recorder != NULL) {
+				mem_trace_record_free(allocator->trace_recorder, pointers[j_pointer].address);
+			}
+		}
+
+		if (i_pointer < count) {
+			i_span = i_pointer;
+			span = pointers[i_pointer];
+		}
+	}
+
+    log_debug("Exiting mem_free_batch().");
+    return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Frees the memory block allocated at an address and put the memory back into the allocator.
+/// The size of the block is found in the page map, so the caller does not have to keep it: its page in O(1), then the blocks of the page by offset.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <param name="address">The address of the allocated block.</param>
+/// <returns>The state code.</returns>
+int mem_free_address(allocator_t* allocator, mem_address_t address) {
+    log_debug("Entering mem_free_address(). Address value: %lu.", address);
+	if (allocator == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	ptr_t pointer = { address, mem_page_map_get(&allocator->page_map, address), true };
+	if (!pointer.size) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	int result = mem_free(allocator, &pointer);
+
+    log_debug("Exiting mem_free_address().");
+    return result;
+}
+
+/// <summary>
+/// Resizes the memory block of a pointer to at least size bytes.
+/// The block grows in place into the free block right after it, or shrinks in place by giving its tail back.
+/// Only if it cannot grow in place, it is moved: a new block is allocated, the memory is copied if it is mapped, then the old block is freed.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <param name="pointer">The pointer to resize. Its address changes if the block was moved.</param>
+/// <param name="size">The new size of the allocation.</param>
+/// <returns>The state code. If the allocator is out of memory, the pointer is left untouched.</returns>
+int mem_reallocate(allocator_t* allocator, ptr_t* pointer, sz_t size) {
+	if (allocator == NULL || pointer == NULL || !size) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+    log_debug("Entering mem_reallocate(). Pointer address: %lu, Pointer size: %lu, Size value: %lu.", pointer->address, pointer->size, size);
+	if (mem_page_map_get(&allocator->page_map, pointer->address) != pointer->size) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	if (size == pointer->size) {
+		if (allocator->trace_recorder != NULL) {
+			mem_trace_record_reallocation(allocator->trace_recorder, pointer->address, pointer->address, size);
+		}
+
+		return SUCCESSFUL_EXEC;
+	}
+
+	// The entry of the block already exists in the page map, so updating it cannot fail.
+	int result = mem_resize_block(allocator, pointer, size);
+	if (result == SUCCESSFUL_EXEC) {
+		mem_page_map_set(&allocator->page_map, pointer->address, pointer->size);
+		if (allocator->trace_recorder != NULL) {
+			mem_trace_record_reallocation(allocator->trace_recorder, pointer->address, pointer->address, size);
+		}
+
+		log_debug("Exiting mem_reallocate(). Resized in place.");
+		return SUCCESSFUL_EXEC;
+	} else if (result != OUT_OF_MEMORY_ERRNO) {
+		return result;
+	}
+
+	// Move the block as a last resort. The move is recorded as a single reallocation, not as an allocation and a free.
+	ptr_t moved_pointer;
+	trace_recorder_t* trace_recorder = allocator->trace_recorder;
+	allocator->trace_recorder = NULL;
+	if ((result = mem_allocate(allocator, size, &moved_pointer)) == SUCCESSFUL_EXEC) {
+		if (allocator->options.is_mapped) {
+			memcpy((void*) moved_pointer.address, (void*) pointer->address, pointer->size < moved_pointer.size ? pointer->size : moved_pointer.size);
+		}
+
+		result = mem_free(allocator, pointer);
+	}
+
+	allocator->trace_recorder = trace_recorder;
+	if (result != SUCCESSFUL_EXEC) {
+		return result;
+	}
+
+	if (trace_recorder != NULL) {
+		mem_trace_record_reallocation(trace_recorder, pointer->address, moved_pointer.address, size);
+	}
+
+	*pointer = moved_pointer;
+
+    log_debug("Exiting mem_reallocate(). Address value: %lu.", pointer->address);
     return SUCCESSFUL_EXEC;
 }
 
+/// <summary>
+/// Puts the size of the memory block allocated at an address into the size argument.
+/// Its page is found in O(1) in the page map, then the blocks of the page are searched by offset.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <param name="address">The address of the allocated block.</param>
+/// <param name="size">The out argument for the size. It is 0 if no allocated block starts at the address.</param>
+/// <returns>The state code.</returns>
+int mem_allocated_size(allocator_t* allocator, mem_address_t address, sz_t* size) {
+    log_debug("Entering mem_allocated_size(). Address value: %lu.", address);
+	if (allocator == NULL || size == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	*size = mem_page_map_get(&allocator->page_map, address);
+    log_debug("Exiting mem_allocated_size(). Size value: %lu.", *size);
+    return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Doubles the capacity of the table of handles.
+/// </summary>
+/// <param name="handles">The table of handles.</param>
+/// <returns>The state code.</returns>
+static int mem_handle_table_grow(handle_table_t* handles) {
+	unsigned int capacity = handles->capacity ? 2 * handles->capacity : HANDLE_TABLE_INITIAL_CAPACITY;
+	handles->libc_call_count += 2;
+	ptr_t* pointers = realloc(handles->pointers, capacity * sizeof(ptr_t));
+	if (pointers == NULL) {
+		return OUT_OF_MEMORY_ERRNO;
+	}
+
+	handles->pointers = pointers;
+	mem_handle_t* free_handles = realloc(handles->free_handles, capacity * sizeof(mem_handle_t));
+	if (free_handles == NULL) {
+		return OUT_OF_MEMORY_ERRNO;
+	}
+
+	handles->free_handles = free_handles;
+	handles->capacity = capacity;
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Compares two relocations by address.
+/// </summary>
+/// <param name="left">The left relocation.</param>
+/// <param name="right">The right relocation.</param>
+/// <returns>A negative value if left is smaller, 0 if both are equal and a positive value otherwise.</returns>
+static int mem_relocation_compare(const void* left, const void* right) {
+	const relocation_t* left_relocation = left;
+	const relocation_t* right_relocation = right;
+	if (left_relocation->address != right_relocation->address) {
+		return left_relocation->address < right_relocation->address ? -1 : 1;
+	}
+
+	return 0;
+}
+
+/// <summary>
+/// Allocates a relocatable memory block of at least size bytes, and puts its handle into the handle argument.
+/// The block can be moved by a compaction, so its pointer must be read through the handle again after any allocation.
+/// If the allocator is compacting and out of memory, but has enough free memory in total, it compacts and retries.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <param name="size">The size of the allocation.</param>
+/// <param name="handle">The out argument for the handle.</param>
+/// <returns>The state code.</returns>
+int mem_allocate_handle(allocator_t* allocator, sz_t size, mem_handle_t* handle) {
+    log_debug("Entering mem_allocate_handle(). Size value: %lu.", size);
+	if (allocator == NULL || !size || handle == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	// Make room for the handle first, so a block is never allocated without one.
+	handle_table_t* handles = &allocator->handles;
+	if (!handles->free_handle_count && handles->length == handles->capacity && mem_handle_table_grow(handles) != SUCCESSFUL_EXEC) {
+		return OUT_OF_MEMORY_ERRNO;
+	}
+
+	ptr_t pointer;
+	int result = mem_allocate(allocator, size, &pointer);
+	if (result == OUT_OF_MEMORY_ERRNO && allocator->options.is_compacting) {
+		unsigned long free_bytes;
+		mem_count_free(allocator, &free_bytes);
+		if (free_bytes >= size && mem_compact(allocator) == SUCCESSFUL_EXEC) {
+			result = mem_allocate(allocator, size, &pointer);
+		}
+	}
+
+	if (result != SUCCESSFUL_EXEC) {
+		return result;
+	}
+
+	*handle = handles->free_handle_count ? handles->free_handles[--handles->free_handle_count] : handles->length++;
+	handles->pointers[*handle] = pointer;
+
+    log_debug("Exiting mem_allocate_handle(). Handle value: %u.", *handle);
+    return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Frees the block of a handle and put the memory back into the allocator. The handle can be given again.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <param name="handle">The handle.</param>
+/// <returns>The state code.</returns>
+int mem_free_handle(allocator_t* allocator, mem_handle_t handle) {
+    log_debug("Entering mem_free_handle(). Handle value: %u.", handle);
+	if (allocator == NULL || handle >= allocator->handles.length || !allocator->handles.pointers[handle].is_allocated) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	int result = mem_free(allocator, &allocator->handles.pointers[handle]);
+	if (result != SUCCESSFUL_EXEC) {
+		return result;
+	}
+
+	allocator->handles.free_handles[allocator->handles.free_handle_count++] = handle;
+
+    log_debug("Exiting mem_free_handle().");
+    return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Puts the current pointer of the block of a handle into the pointer argument.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <param name="handle">The handle.</param>
+/// <param name="pointer">The out argument for the pointer.</param>
+/// <returns>The state code.</returns>
+int mem_handle_pointer(allocator_t* allocator, mem_handle_t handle, ptr_t* pointer) {
+	if (allocator == NULL || pointer == NULL || handle >= allocator->handles.length || !allocator->handles.pointers[handle].is_allocated) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	*pointer = allocator->handles.pointers[handle];
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Compacts the heap: the blocks of handles slide down, by address order, into the free block right before them, so free blocks merge.
+/// Blocks allocated without a handle are pinned, and blocks of the buddy system never move, as they must stay aligned on their size.
+/// The memory is moved if it is mapped.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <returns>The state code.</returns>
+int mem_compact(allocator_t* allocator) {
+    log_debug("Entering mem_compact().");
+	if (allocator == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	handle_table_t* handles = &allocator->handles;
+	unsigned int relocation_count = handles->length - handles->free_handle_count;
+	if (allocator->deallocation_strategy == &mem_deallocation_strategy_buddy || !relocation_count) {
+		return SUCCESSFUL_EXEC;
+	}
+
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	// Sort the blocks of handles by address, so every block slides into the space freed by the block before it.
+	handles->libc_call_count++;
+	relocation_t* relocations = malloc(relocation_count * sizeof(relocation_t));
+	if (relocations == NULL) {
+		return OUT_OF_MEMORY_ERRNO;
+	}
+
+	unsigned int i_relocation = 0;
+	mem_handle_t handle;
+	for (handle = 0; handle < handles->length; handle++) {
+		if (handles->pointers[handle].is_allocated) {
+			relocations[i_relocation].address = handles->pointers[handle].address;
+			relocations[i_relocation++].handle = handle;
+		}
+	}
+
+	qsort(relocations, relocation_count, sizeof(relocation_t), &mem_relocation_compare);
+
+	int result = SUCCESSFUL_EXEC;
+	void* element;
+	for (i_relocation = 0; i_relocation < relocation_count; i_relocation++) {
+		ptr_t* pointer = &handles->pointers[relocations[i_relocation].handle];
+		hashmap_get(&allocator->free_blocks.ends, pointer->address, &element);
+		block_t* hole = element;
+		if (hole == NULL) {
+			continue;
+		}
+
+		// The block takes the start of the hole, and the hole moves after the block, where it merges with the next free block.
+		mem_address_t address = hole->pointer.address;
+		ptr_t moved_hole = { address + pointer->size, hole->pointer.size, false };
+		if ((result = mem_page_map_set(&allocator->page_map, address, pointer->size)) != SUCCESSFUL_EXEC || 
+			(result = mem_block_remove(&allocator->free_blocks, hole)) != SUCCESSFUL_EXEC) {
+			break;
+		}
+
+		if (allocator->options.is_mapped) {
+			memmove((void*) address, (void*) pointer->address, pointer->size);
+		}
+
+		mem_page_map_set(&allocator->page_map, pointer->address, 0);
+		if (allocator->trace_recorder != NULL) {
+			mem_trace_record_relocation(allocator->trace_recorder, pointer->address, address);
+		}
+
+		pointer->address = address;
+		if ((result = mem_release_block(allocator, &moved_hole)) != SUCCESSFUL_EXEC) {
+			break;
+		}
+
+		allocator->compaction_stats.moved_block_count++;
+		allocator->compaction_stats.moved_bytes += pointer->size;
+	}
+
+	free(relocations);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	allocator->compaction_stats.compaction_count++;
+	allocator->compaction_stats.ns += (end.tv_sec - start.tv_sec) * 1000000000UL + end.tv_nsec - start.tv_nsec;
+
+    log_debug("Exiting mem_compact(). Moved blocks: %lu.", allocator->compaction_stats.moved_block_count);
+    return result;
+}
+
+/// <summary>
+/// Puts the measurements of all compactions since the initialization into the stats argument.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <param name="stats">The out argument for the measurements.</param>
+/// <returns>The state code.</returns>
+int mem_compaction_stats(allocator_t* allocator, compaction_stats_t* stats) {
+	if (allocator == NULL || stats == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	*stats = allocator->compaction_stats;
+	return SUCCESSFUL_EXEC;
+}
+
 /// <summary>
 /// Puts the number of allocated blocks into the count argument.
 /// </summary>
+/// <param name="allocator">The allocator.</param>
 /// <param name="count">The out argument for the count.</param>
 /// <returns>The state code.</returns>
-int mem_count_allocated_block(unsigned int* count) {
+int mem_count_allocated_block(allocator_t* allocator, unsigned int* count) {
     log_debug("Entering mem_count_allocated_block().");
-	if (count == NULL) {
+	if (allocator == NULL || count == NULL) {
 		return ILLEGAL_ARGUMENTS_ERRNO;
 	}
 
-	*count = allocated_block_count;
+	*count = allocator->allocated_block_count;
     log_debug("Exiting mem_count_allocated_block(). Count value: %u.", *count);
     return SUCCESSFUL_EXEC;
 }
@@ -167,15 +911,16 @@ int mem_count_allocated_block(unsigned int* count) {
 /// <summary>
 /// Puts the number of free blocks into the count argument.
 /// </summary>
+/// <param name="allocator">The allocator.</param>
 /// <param name="count">The out argument for the count.</param>
 /// <returns>The state code.</returns>
-int mem_count_free_block(unsigned int* count) {
+int mem_count_free_block(allocator_t* allocator, unsigned int* count) {
     log_debug("Entering mem_count_free_block().");
-	if (count == NULL) {
+	if (allocator == NULL || count == NULL) {
 		return ILLEGAL_ARGUMENTS_ERRNO;
 	}
 
-	*count = free_block_list->length;
+	*count = allocator->free_blocks.list.length;
     log_debug("Exiting mem_count_free_block(). Count value: %u.", *count);
     return SUCCESSFUL_EXEC;
 }
@@ -183,24 +928,17 @@ int mem_count_free_block(unsigned int* count) {
 /// <summary>
 /// Puts the number of free bytes into the count argument.
 /// </summary>
+/// <param name="allocator">The allocator.</param>
 /// <param name="count">The out argument for the count.</param>
 /// <returns>The state code.</returns>
-int mem_count_free(unsigned long* count) {
+int mem_count_free(allocator_t* allocator, unsigned long* count) {
     log_debug("Entering mem_count_free().");
-	if (count == NULL) {
+	if (allocator == NULL || count == NULL) {
 		return ILLEGAL_ARGUMENTS_ERRNO;
 	}
 
-	*count = 0;
-	node_t* current = free_block_list->head;
-	ptr_t* current_pointer;
-	while (current != NULL) {
-		current_pointer = current->element;
-		*count += current_pointer->size;
-
-		// Move to the next node.
-		current = current->next;
-	}
+	// The count is kept by the free blocks on every change.
+	*count = allocator->free_blocks.bytes;
 
     log_debug("Exiting mem_count_free(). Count value: %lu.", *count);
     return SUCCESSFUL_EXEC;
@@ -209,86 +947,95 @@ int mem_count_free(unsigned long* count) {
 /// <summary>
 /// Puts the size of the greatest free block into the size argument.
 /// </summary>
+/// <param name="allocator">The allocator.</param>
 /// <param name="size">The out argument for the size.</param>
 /// <returns>The state code.</returns>
-int mem_greatest_free_block(sz_t* size) {
+int mem_greatest_free_block(allocator_t* allocator, sz_t* size) {
     log_debug("Entering mem_greatest_free_block().");
-	if (size == NULL) {
+	if (allocator == NULL || size == NULL) {
 		return ILLEGAL_ARGUMENTS_ERRNO;
 	}
 
-	*size = 0;
-	node_t* current = free_block_list->head;
-	ptr_t* current_pointer;
-	while (current != NULL) {
-		current_pointer = current->element;
-		if (current_pointer->size > *size) {
-			*size = current_pointer->size;
-		}
-
-		// Move to the next node.
-		current = current->next;
-	}
+	block_t* block = mem_block_greatest(&allocator->free_blocks);
+	*size = block != NULL ? block->pointer.size : 0;
 
-    log_debug("Exiting mem_greatest_free_block(). Size value: %u.", *size);
+    log_debug("Exiting mem_greatest_free_block(). Size value: %lu.", *size);
     return SUCCESSFUL_EXEC;
 }
 
 /// <summary>
 /// Puts the count of free blocks smaller than the given size into the count argument.
 /// </summary>
+/// <param name="allocator">The allocator.</param>
 /// <param name="size">The maximum size that can be considered small.</param>
 /// <param name="count">The out argument for the count.</param>
 /// <returns>The state code.</returns>
-int mem_count_free_block_smaller_than(sz_t size, unsigned int* count) {
-    log_debug("Entering mem_count_free_block_smaller_than(). Size value: %u.", size);
-	if (!size || count == NULL) {
+int mem_count_free_block_smaller_than(allocator_t* allocator, sz_t size, unsigned int* count) {
+    log_debug("Entering mem_count_free_block_smaller_than(). Size value: %lu.", size);
+	if (allocator == NULL || !size || count == NULL) {
 		return ILLEGAL_ARGUMENTS_ERRNO;
 	}
 
-	*count = 0;
-	node_t* current = free_block_list->head;
-	ptr_t* current_pointer;
-	while (current != NULL) {
-		current_pointer = current->element;
-		if (current_pointer->size < size) {
-			*count = *count + 1;
+	// The size tree is ordered by size then by address, so the rank of the size at address 0 counts the smaller blocks.
+	// Without the size tree, the free blocks are counted one by one.
+	if (allocator->free_blocks.is_tree_indexed) {
+		ptr_t key = { 0, size, false };
+		avltree_rank(&allocator->free_blocks.size_tree, &key, count);
+	} else {
+		*count = 0;
+		node_t* node;
+		for (node = allocator->free_blocks.list.head; node != NULL; node = node->next) {
+			*count += ((block_t*) node->element)->pointer.size < size;
 		}
-
-		// Move to the next node.
-		current = current->next;
 	}
 
     log_debug("Exiting mem_count_free_block_smaller_than(). Count value: %u.", *count);
     return SUCCESSFUL_EXEC;
 }
 
+/// <summary>
+/// Puts the number of calls to the C library made by the allocator for its own records, since its initialization, into the count argument.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <param name="count">The out argument for the count.</param>
+/// <returns>The state code.</returns>
+int mem_count_libc_calls(allocator_t* allocator, unsigned long* count) {
+    log_debug("Entering mem_count_libc_calls().");
+	if (allocator == NULL || count == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	*count = allocator->free_blocks.libc_call_count + allocator->free_blocks.arrays.libc_call_count + allocator->free_blocks.bitmap.libc_call_count + allocator->page_map.libc_call_count + allocator->handles.libc_call_count;
+    log_debug("Exiting mem_count_libc_calls(). Count value: %lu.", *count);
+    return SUCCESSFUL_EXEC;
+}
+
 /// <summary>
 /// Puts whether the given address is allocated into the flag argument.
+/// With the bitmap strategy, this is a single bit test.
 /// </summary>
+/// <param name="allocator">The allocator.</param>
 /// <param name="address">The address to check.</param>
 /// <param name="flag">The out argument for whether it is allocated.</param>
 /// <returns>The state code.</returns>
-int mem_is_allocated(mem_address_t address, unsigned int* flag) {
+int mem_is_allocated(allocator_t* allocator, mem_address_t address, unsigned int* flag) {
     log_debug("Entering mem_is_allocated(). Address value: %lu.", address);
-	*flag = false;
+	if (allocator == NULL || flag == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
 
-	// check if address is within the bound. If not, flag as false.
-	if ((address >= allocation_options->address_space_first_address) && 
-		(address <= allocation_options->address_space_first_address + allocation_options->address_space_size)) {
-		*flag = true;
-
-		node_t* current = free_block_list->head;
-		ptr_t* current_pointer;
-		while (current != NULL) {
-			current_pointer = current->element;
-			if (address >= current_pointer->address && address <= (current_pointer->address + current_pointer->size)) {
-				*flag = false;
-				break;
-			}
+	*flag = false;
 
-			// Move to the next node.
-			current = current->next;
+	// check if address is within the bound. If not, flag as false. Bounds are half-open: a block ends before its last address plus one.
+	if ((address >= allocator->options.address_space_first_address) && 
+		(address < allocator->options.address_space_first_address + allocator->options.address_space_size)) {
+		// Blocks of the bitmap strategy are whole granules, so the bit of the granule tells. Only the bytes before the first granule and after the last have none.
+		// Otherwise, only the last free block that starts at or before the address can contain it.
+		if (allocator->free_blocks.is_bitmap_indexed && mem_block_bitmap_contains(&allocator->free_blocks.bitmap, address)) {
+			*flag = mem_block_bitmap_test(&allocator->free_blocks.bitmap, address);
+		} else {
+			block_t* block = mem_block_floor(&allocator->free_blocks, address);
+			*flag = block == NULL || address >= block->pointer.address + block->pointer.size;
 		}
 	}
 
@@ -297,39 +1044,75 @@ int mem_is_allocated(mem_address_t address, unsigned int* flag) {
 }
 
 /// <summary>
-/// Merges adjacent nodes of the current node if pointer are contiguous.
+/// Puts the free blocks that intersect the address range [first_address, last_address) into the spans argument, by address order.
+/// The blocks are found in O(log n + k) with the address tree, where k is the count of intersecting blocks, and in O(n) without it.
 /// </summary>
-/// <param name="current">The current pointer node in the linked list.</param>
+/// <param name="allocator">The allocator.</param>
+/// <param name="first_address">The first address of the range.</param>
+/// <param name="last_address">The address right after the range.</param>
+/// <param name="spans">The out argument for the free blocks. At most capacity blocks are put. This can be null if capacity is 0.</param>
+/// <param name="capacity">The capacity of the spans argument.</param>
+/// <param name="count">The out argument for the count of intersecting free blocks. It can be greater than the capacity.</param>
 /// <returns>The state code.</returns>
-int mem_merge_contiguous(unsigned int i_current, node_t* current) {
-	log_debug("Entering mem_merge_contiguous().");
-	
-	node_t* previous = current->previous;
-	node_t* next = current->next;
-	ptr_t* previous_pointer = previous != NULL ? previous->element : NULL;
-	ptr_t* current_pointer = current->element;
-	ptr_t* next_pointer = next != NULL ? next->element : NULL;
-
-	// Check if the current pointer would contiguous with its previous pointer.
-	if (previous_pointer != NULL && (previous_pointer->address + previous_pointer->size == current_pointer->address)) {
-		// Contiguous with previous node: append size to the previous pointer.
-		previous_pointer->size += current_pointer->size;
-
-		free(current_pointer);
-		linkedlist_remove(free_block_list, i_current);
-		mem_merge_contiguous(i_current - 1, previous);
-	}
-	// Check if the pointer would be contiguous with its next pointer.
-	else if (next_pointer != NULL && (current_pointer->address + current_pointer->size == next_pointer->address)) {
-		// Contiguous with next node: append size to the next pointer.
-		next_pointer->address -= current_pointer->size;
-		next_pointer->size += current_pointer->size;
-
-		free(current_pointer);
-		linkedlist_remove(free_block_list, i_current);
-		mem_merge_contiguous(i_current + 1, next);
-	}
-
-    log_debug("Exiting mem_merge_contiguous().");
+int mem_find_free_spans(allocator_t* allocator, mem_address_t first_address, mem_address_t last_address, ptr_t* spans, unsigned int capacity, unsigned int* count) {
+    log_debug("Entering mem_find_free_spans(). First address: %lu, Last address: %lu.", first_address, last_address);
+	if (allocator == NULL || (spans == NULL && capacity) || count == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	*count = 0;
+	if (first_address >= last_address) {
+		return SUCCESSFUL_EXEC;
+	}
+
+	// Without the address tree, the free blocks are walked one by one, and the lowest intersecting ones are kept in address order.
+	if (!allocator->free_blocks.is_tree_indexed) {
+		node_t* list_node;
+		for (list_node = allocator->free_blocks.list.head; list_node != NULL; list_node = list_node->next) {
+			ptr_t pointer = ((block_t*) list_node->element)->pointer;
+			if (pointer.address >= last_address || pointer.address + pointer.size <= first_address) {
+				continue;
+			}
+
+			unsigned int i_span = *count < capacity ? *count : capacity;
+			for (; i_span > 0 && spans[i_span - 1].address > pointer.address; i_span--) {
+				if (i_span < capacity) {
+					spans[i_span] = spans[i_span - 1];
+				}
+			}
+
+			if (i_span < capacity) {
+				spans[i_span] = pointer;
+			}
+
+			*count = *count + 1;
+		}
+
+		log_debug("Exiting mem_find_free_spans(). Count value: %u.", *count);
+		return SUCCESSFUL_EXEC;
+	}
+
+	// Start from the block that may contain the first address, then walk the address tree until the end of the range.
+	treenode_t* node;
+	block_t* block = mem_block_floor(&allocator->free_blocks, first_address);
+	if (block != NULL) {
+		node = &block->address_node;
+		if (first_address >= block->pointer.address + block->pointer.size) {
+			node = avltree_next(node);
+		}
+	} else {
+		avltree_first(&allocator->free_blocks.address_tree, &node);
+	}
+
+	while (node != NULL && ((block_t*) node->element)->pointer.address < last_address) {
+		if (*count < capacity) {
+			spans[*count] = ((block_t*) node->element)->pointer;
+		}
+
+		*count = *count + 1;
+		node = avltree_next(node);
+	}
+
+    log_debug("Exiting mem_find_free_spans(). Count value: %u.", *count);
     return SUCCESSFUL_EXEC;
 }
\ No newline at end of file
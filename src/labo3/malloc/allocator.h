@@ -4,95 +4,338 @@
 #include "../lib/collections.h"
 #include "commons.h"
 #include "strategies.h"
+#include "blocks.h"
+#include "pagemap.h"
+#include "trace.h"
+
+// Initial capacity of the table of handles. It doubles as needed.
+#define HANDLE_TABLE_INITIAL_CAPACITY 1024
 
 // Structure for the options of the allocator.
+// A mapped allocator reserves its address space with mmap, so its addresses are real pointers and its first address is chosen by the system.
 typedef struct allocator_options_t {
 	mem_address_t address_space_first_address;
 	sz_t address_space_size;
+	unsigned int is_mapped;
+
+	// Whether an allocation of a handle that runs out of memory compacts the heap and retries, if enough free memory exists in total.
+	unsigned int is_compacting;
+
+	// The size of the granules of the bitmap strategy. It must be a power of two. If 0, BLOCK_BITMAP_DEFAULT_GRANULE_SIZE is used, or more for large address spaces.
+	sz_t granule_size;
+
+	// The count of free block records, with their address map entries, reserved at initialization. Until more free blocks than that exist at once,
+	// allocations and frees never grow the pool of records. If 0, the pool starts with a single chunk and grows as needed.
+	unsigned int reserved_block_count;
 } allocator_options_t;
 
-// The linked list of all free blocks.
-extern linkedlist_t* free_block_list;
+// Structure for a handle: the index of a relocatable block in the table of handles.
+typedef unsigned int mem_handle_t;
+
+// Structure for the table of handles. The block of a handle can be moved by a compaction, while the handle stays the same.
+typedef struct handle_table_t {
+	// The pointers of the handles, by handle. The pointer of an unused handle is not allocated.
+	ptr_t* pointers;
+
+	// The stack of unused handles below the length.
+	mem_handle_t* free_handles;
+	unsigned int free_handle_count;
+
+	// The count of handles ever used, and the capacity of the table.
+	unsigned int length;
+	unsigned int capacity;
+
+	// The count of calls to the C library made to grow the table and to sort it during compactions.
+	unsigned long libc_call_count;
+} handle_table_t;
+
+// Structure for the measurements of the compactions of an allocator.
+typedef struct compaction_stats_t {
+	unsigned long compaction_count;
+	unsigned long moved_block_count;
+	unsigned long moved_bytes;
+	unsigned long ns;
+} compaction_stats_t;
+
+// Structure for an allocator. Every allocator manages its own address space, so several can be used at once.
+struct allocator_t {
+	// The options applied.
+	allocator_options_t options;
+
+	// The memory allocation strategy applied.
+	mem_allocation_strategy_t allocation_strategy;
+
+	// The memory deallocation strategy paired with the allocation strategy. If null, contiguous free blocks are merged.
+	mem_deallocation_strategy_t deallocation_strategy;
+
+	// The memory reallocation strategy paired with the allocation strategy. If null, blocks grow into the free block right after them.
+	mem_reallocation_strategy_t reallocation_strategy;
+
+	// The aligned memory allocation strategy paired with the allocation strategy. If null, a block padded by the alignment is allocated and its slack is given back.
+	mem_aligned_allocation_strategy_t aligned_allocation_strategy;
+
+	// The count of blocks still allocated.
+	unsigned int allocated_block_count;
+
+	// The free blocks and their indexes.
+	free_blocks_t free_blocks;
+
+	// The sizes of the allocated blocks, by address.
+	page_map_t page_map;
+
+	// The relocatable blocks, by handle, and the measurements of their compactions.
+	handle_table_t handles;
+	compaction_stats_t compaction_stats;
+
+	// The recorder of the allocations and frees into a trace, or null if they are not recorded.
+	trace_recorder_t* trace_recorder;
+
+	// Current node in the next fit algorithm.
+	node_t* next_fit_current;
+
+	// The count of free blocks visited by the searches of the allocation strategies. A search of a tree counts its height.
+	unsigned long search_step_count;
+
+	// The state of the adaptive strategy.
+	adaptive_state_t adaptive;
+};
 
 /// <summary>
 /// Initializes the allocator.
 /// </summary>
+/// <param name="allocator">The allocator to initialize.</param>
 /// <param name="strategy">Function pointer for memory allocation strategy to use.</param>
-/// <param name="options">Options for the allocator.</param>
+/// <param name="options">Options for the allocator. They are copied. If they are mapped, the address space is reserved with mmap.</param>
 /// <returns>The state code.</returns>
-int mem_allocator_init(mem_allocation_strategy_t strategy, allocator_options_t* options);
+int mem_allocator_init(allocator_t* allocator, mem_allocation_strategy_t strategy, allocator_options_t* options);
+
+/// <summary>
+/// Reserves the address space of the options with mmap, and sets their first address to the reserved range.
+/// The pages are only backed by memory once they are touched.
+/// </summary>
+/// <param name="options">The options to map.</param>
+/// <returns>The state code.</returns>
+int mem_map_address_space(allocator_options_t* options);
+
+/// <summary>
+/// Releases the address space of the options, reserved by mem_map_address_space().
+/// </summary>
+/// <param name="options">The options to unmap.</param>
+/// <returns>The state code.</returns>
+int mem_unmap_address_space(const allocator_options_t* options);
 
 /// <summary>
 /// Destroys the allocator.
 /// </summary>
+/// <param name="allocator">The allocator.</param>
 /// <returns>The state code.</returns>
-int mem_allocator_destroy();
+int mem_allocator_destroy(allocator_t* allocator);
+
+/// <summary>
+/// Starts recording the allocations, reallocations and frees of the allocator into a trace, or stops if the recorder is null.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <param name="recorder">The recorder, opened by mem_trace_recorder_open(). It must stay open while the allocator records.</param>
+/// <returns>The state code.</returns>
+int mem_allocator_record(allocator_t* allocator, trace_recorder_t* recorder);
 
 /// <summary>
 /// Allocates a memory block of at least size bytes.
 /// The allocated memory location will be put into the pointer struct.
 /// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <param name="size">The size of the allocation.</param>
+/// <param name="pointer">The pointer into which to allocate.</param>
+/// <returns>The state code.</returns>
+int mem_allocate(allocator_t* allocator, sz_t size, ptr_t* pointer);
+
+/// <summary>
+/// Allocates a memory block of at least size bytes, whose address is a multiple of the alignment.
+/// The allocated memory location will be put into the pointer struct.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
 /// <param name="size">The size of the allocation.</param>
+/// <param name="alignment">The alignment of the address. It must be a power of two.</param>
 /// <param name="pointer">The pointer into which to allocate.</param>
 /// <returns>The state code.</returns>
-int mem_allocate(sz_t size, ptr_t* pointer);
+int mem_allocate_aligned(allocator_t* allocator, sz_t size, sz_t alignment, ptr_t* pointer);
 
 /// <summary>
 /// Frees a memory pointer and put the memory back into the allocator.
 /// </summary>
+/// <param name="allocator">The allocator.</param>
 /// <param name="pointer">The pointer from which to free.</param>
 /// <returns>The state code.</returns>
-int mem_free(ptr_t* pointer);
+int mem_free(allocator_t* allocator, ptr_t* pointer);
+
+/// <summary>
+/// Allocates count memory blocks of the given sizes at once. Either all blocks are allocated, or none.
+/// The blocks are carved from a single free block found by one search of the allocation strategy, if one is large enough for all.
+/// Otherwise, or with the buddy system and the bitmap whose rounded blocks cannot be carved, they are allocated one by one.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <param name="count">The count of blocks.</param>
+/// <param name="sizes">The sizes of the blocks.</param>
+/// <param name="pointers">The pointers into which to allocate, one per size.</param>
+/// <returns>The state code.</returns>
+int mem_allocate_batch(allocator_t* allocator, unsigned int count, const sz_t sizes[], ptr_t pointers[]);
+
+/// <summary>
+/// Frees count memory pointers at once. A free block record is reserved for every pointer first, so either all pointers are freed, or none.
+/// The pointers are sorted by address, so contiguous pointers are merged into a single span before they are put back into the allocator.
+/// If a span still cannot be put back, the pointers of the spans before it are freed and the others stay allocated, with is_allocated telling which.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <param name="count">The count of pointers.</param>
+/// <param name="pointers">The pointers from which to free. They are sorted by address in place.</param>
+/// <returns>The state code.</returns>
+int mem_free_batch(allocator_t* allocator, unsigned int count, ptr_t pointers[]);
+
+/// <summary>
+/// Frees the memory block allocated at an address and put the memory back into the allocator.
+/// The size of the block is found in the page map, so the caller does not have to keep it: its page in O(1), then the blocks of the page by offset.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <param name="address">The address of the allocated block.</param>
+/// <returns>The state code.</returns>
+int mem_free_address(allocator_t* allocator, mem_address_t address);
+
+/// <summary>
+/// Resizes the memory block of a pointer to at least size bytes.
+/// The block grows in place into the free block right after it, or shrinks in place by giving its tail back.
+/// Only if it cannot grow in place, it is moved: a new block is allocated, the memory is copied if it is mapped, then the old block is freed.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <param name="pointer">The pointer to resize. Its address changes if the block was moved.</param>
+/// <param name="size">The new size of the allocation.</param>
+/// <returns>The state code. If the allocator is out of memory, the pointer is left untouched.</returns>
+int mem_reallocate(allocator_t* allocator, ptr_t* pointer, sz_t size);
+
+/// <summary>
+/// Puts the size of the memory block allocated at an address into the size argument.
+/// Its page is found in O(1) in the page map, then the blocks of the page are searched by offset.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <param name="address">The address of the allocated block.</param>
+/// <param name="size">The out argument for the size. It is 0 if no allocated block starts at the address.</param>
+/// <returns>The state code.</returns>
+int mem_allocated_size(allocator_t* allocator, mem_address_t address, sz_t* size);
+
+/// <summary>
+/// Allocates a relocatable memory block of at least size bytes, and puts its handle into the handle argument.
+/// The block can be moved by a compaction, so its pointer must be read through the handle again after any allocation.
+/// If the allocator is compacting and out of memory, but has enough free memory in total, it compacts and retries.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <param name="size">The size of the allocation.</param>
+/// <param name="handle">The out argument for the handle.</param>
+/// <returns>The state code.</returns>
+int mem_allocate_handle(allocator_t* allocator, sz_t size, mem_handle_t* handle);
+
+/// <summary>
+/// Frees the block of a handle and put the memory back into the allocator. The handle can be given again.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <param name="handle">The handle.</param>
+/// <returns>The state code.</returns>
+int mem_free_handle(allocator_t* allocator, mem_handle_t handle);
+
+/// <summary>
+/// Puts the current pointer of the block of a handle into the pointer argument.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <param name="handle">The handle.</param>
+/// <param name="pointer">The out argument for the pointer.</param>
+/// <returns>The state code.</returns>
+int mem_handle_pointer(allocator_t* allocator, mem_handle_t handle, ptr_t* pointer);
+
+/// <summary>
+/// Compacts the heap: the blocks of handles slide down, by address order, into the free block right before them, so free blocks merge.
+/// Blocks allocated without a handle are pinned, and blocks of the buddy system never move, as they must stay aligned on their size.
+/// The memory is moved if it is mapped.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <returns>The state code.</returns>
+int mem_compact(allocator_t* allocator);
+
+/// <summary>
+/// Puts the measurements of all compactions since the initialization into the stats argument.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <param name="stats">The out argument for the measurements.</param>
+/// <returns>The state code.</returns>
+int mem_compaction_stats(allocator_t* allocator, compaction_stats_t* stats);
 
 /// <summary>
 /// Puts the number of allocated blocks into the count argument.
 /// </summary>
+/// <param name="allocator">The allocator.</param>
 /// <param name="count">The out argument for the count.</param>
 /// <returns>The state code.</returns>
-int mem_count_allocated_block(unsigned int* count);
+int mem_count_allocated_block(allocator_t* allocator, unsigned int* count);
 
 /// <summary>
 /// Puts the number of free blocks into the count argument.
 /// </summary>
+/// <param name="allocator">The allocator.</param>
 /// <param name="count">The out argument for the count.</param>
 /// <returns>The state code.</returns>
-int mem_count_free_block(unsigned int* count);
+int mem_count_free_block(allocator_t* allocator, unsigned int* count);
 
 /// <summary>
 /// Puts the number of free bytes into the count argument.
 /// </summary>
+/// <param name="allocator">The allocator.</param>
 /// <param name="count">The out argument for the count.</param>
 /// <returns>The state code.</returns>
-int mem_count_free(unsigned long* count);
+int mem_count_free(allocator_t* allocator, unsigned long* count);
 
 /// <summary>
 /// Puts the size of the greatest free block into the size argument.
 /// </summary>
+/// <param name="allocator">The allocator.</param>
 /// <param name="size">The out argument for the size.</param>
 /// <returns>The state code.</returns>
-int mem_greatest_free_block(sz_t* size);
+int mem_greatest_free_block(allocator_t* allocator, sz_t* size);
 
 /// <summary>
 /// Puts the count of free blocks smaller than the given size into the count argument.
 /// </summary>
+/// <param name="allocator">The allocator.</param>
 /// <param name="size">The maximum size that can be considered small.</param>
 /// <param name="count">The out argument for the count.</param>
 /// <returns>The state code.</returns>
-int mem_count_free_block_smaller_than(sz_t size, unsigned int* count);
+int mem_count_free_block_smaller_than(allocator_t* allocator, sz_t size, unsigned int* count);
+
+/// <summary>
+/// Puts the number of calls to the C library made by the allocator for its own records, since its initialization, into the count argument.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <param name="count">The out argument for the count.</param>
+/// <returns>The state code.</returns>
+int mem_count_libc_calls(allocator_t* allocator, unsigned long* count);
 
 /// <summary>
 /// Puts whether the given address is allocated into the flag argument.
+/// With the bitmap strategy, this is a single bit test.
 /// </summary>
+/// <param name="allocator">The allocator.</param>
 /// <param name="address">The address to check.</param>
 /// <param name="flag">The out argument for whether it is allocated.</param>
 /// <returns>The state code.</returns>
-int mem_is_allocated(mem_address_t address, unsigned int* flag);
+int mem_is_allocated(allocator_t* allocator, mem_address_t address, unsigned int* flag);
 
 /// <summary>
-/// Merges adjacent nodes of the current node if pointer are contiguous.
+/// Puts the free blocks that intersect the address range [first_address, last_address) into the spans argument, by address order.
+/// The blocks are found in O(log n + k), where k is the count of intersecting blocks.
 /// </summary>
-/// <param name="current">The current pointer node in the linked list.</param>
+/// <param name="allocator">The allocator.</param>
+/// <param name="first_address">The first address of the range.</param>
+/// <param name="last_address">The address right after the range.</param>
+/// <param name="spans">The out argument for the free blocks. At most capacity blocks are put. This can be null if capacity is 0.</param>
+/// <param name="capacity">The capacity of the spans argument.</param>
+/// <param name="count">The out argument for the count of intersecting free blocks. It can be greater than the capacity.</param>
 /// <returns>The state code.</returns>
-int mem_merge_contiguous(unsigned int i_current, node_t* current);
+int mem_find_free_spans(allocator_t* allocator, mem_address_t first_address, mem_address_t last_address, ptr_t* spans, unsigned int capacity, unsigned int* count);
 
 #endif
\ No newline at end of file
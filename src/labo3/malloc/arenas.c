@@ -0,0 +1,414 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <errno.h>
+
+#include "../lib/logging.h"
+#include "arenas.h"
+
+#define true 1
+#define false 0
+
+static void mem_arenas_cache_release(void* cache);
+
+/// <summary>
+/// Initializes the arenas. The address space is split in equal slices, one per arena.
+/// </summary>
+/// <param name="arenas">The arenas to initialize.</param>
+/// <param name="count">The count of arenas. It cannot be greater than the address space size.</param>
+/// <param name="assignment">How threads are assigned to arenas. Values are ARENA_ASSIGNMENT_ROUND_ROBIN and ARENA_ASSIGNMENT_THREAD_ID.</param>
+/// <param name="magazine_capacity">The capacity of the magazines of every thread, up to MAGAZINE_MAXIMUM_CAPACITY. If 0, threads have no magazines.</param>
+/// <param name="strategy">Function pointer for memory allocation strategy to use in every arena.</param>
+/// <param name="options">Options for the whole address space. They are copied. If they are mapped, the whole address space is reserved at once.</param>
+/// <returns>The state code.</returns>
+int mem_arenas_init(arenas_t* arenas, unsigned int count, unsigned int assignment, unsigned int magazine_capacity, mem_allocation_strategy_t strategy, allocator_options_t* options) {
+	if (arenas == NULL || !count || strategy == NULL || options == NULL || count > options->address_space_size ||
+		(assignment != ARENA_ASSIGNMENT_ROUND_ROBIN && assignment != ARENA_ASSIGNMENT_THREAD_ID) || magazine_capacity > MAGAZINE_MAXIMUM_CAPACITY) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	log_debug("Entering mem_arenas_init(). Count value: %u, Assignment value: %u.", count, assignment);
+
+	arenas->arenas = malloc(count * sizeof(arena_t));
+	if (arenas->arenas == NULL) {
+		return OUT_OF_MEMORY_ERRNO;
+	}
+
+	// A thread that exits flushes its magazines back into the arenas.
+	if (pthread_key_create(&arenas->thread_cache_key, &mem_arenas_cache_release)) {
+		free(arenas->arenas);
+		return OUT_OF_MEMORY_ERRNO;
+	}
+
+	if (pthread_mutex_init(&arenas->caches_lock, NULL)) {
+		pthread_key_delete(arenas->thread_cache_key);
+		free(arenas->arenas);
+		return OUT_OF_MEMORY_ERRNO;
+	}
+
+	// The slices of a mapped address space are within a single mapping, so an address still finds its arena.
+	arenas->options = *options;
+	if (options->is_mapped && mem_map_address_space(&arenas->options) != SUCCESSFUL_EXEC) {
+		pthread_mutex_destroy(&arenas->caches_lock);
+		pthread_key_delete(arenas->thread_cache_key);
+		free(arenas->arenas);
+		return OUT_OF_MEMORY_ERRNO;
+	}
+
+	arenas->count = count;
+	arenas->assignment = assignment;
+	arenas->first_address = arenas->options.address_space_first_address;
+	arenas->slice_size = options->address_space_size / count;
+	arenas->next_arena = 0;
+	arenas->magazine_capacity = magazine_capacity;
+	arenas->caches = NULL;
+
+	// The last arena also owns the remainder of the address space.
+	unsigned int i_arena;
+	for (i_arena = 0; i_arena < count; i_arena++) {
+		allocator_options_t slice = {
+			.address_space_first_address = arenas->first_address + (mem_address_t) i_arena * arenas->slice_size,
+			.address_space_size = i_arena + 1 < count ? arenas->slice_size : options->address_space_size - i_arena * arenas->slice_size,
+			.is_mapped = false,
+			.granule_size = options->granule_size,
+			.reserved_block_count = options->reserved_block_count
+		};
+
+		int result = mem_allocator_init(&arenas->arenas[i_arena].allocator, strategy, &slice);
+		if (result == SUCCESSFUL_EXEC && pthread_mutex_init(&arenas->arenas[i_arena].lock, NULL)) {
+			mem_allocator_destroy(&arenas->arenas[i_arena].allocator);
+			result = OUT_OF_MEMORY_ERRNO;
+		}
+
+		if (result != SUCCESSFUL_EXEC) {
+			arenas->count = i_arena;
+			mem_arenas_destroy(arenas);
+			return result;
+		}
+	}
+
+	log_debug("Exiting mem_arenas_init().");
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Gets the arena that owns an address.
+/// A block never crosses slices, so the arena of its first address owns it.
+/// </summary>
+/// <param name="arenas">The arenas.</param>
+/// <param name="address">The address. It must be within the address space.</param>
+/// <returns>The arena.</returns>
+static arena_t* mem_arenas_owner(arenas_t* arenas, mem_address_t address) {
+	mem_address_t i_arena = (address - arenas->first_address) / arenas->slice_size;
+	return &arenas->arenas[i_arena < arenas->count ? i_arena : arenas->count - 1];
+}
+
+/// <summary>
+/// Frees the oldest blocks of a magazine back into the arenas that own them.
+/// The lock of an arena is kept for as long as consecutive blocks belong to it.
+/// </summary>
+/// <param name="arenas">The arenas.</param>
+/// <param name="magazine">The magazine to flush.</param>
+/// <param name="count">The count of blocks to flush. It cannot be greater than the length of the magazine.</param>
+/// <returns>The state code.</returns>
+static int mem_arenas_flush(arenas_t* arenas, magazine_t* magazine, unsigned int count) {
+	log_trace("Flushing magazine. count: %u.", count);
+
+	int result = SUCCESSFUL_EXEC;
+	arena_t* locked_arena = NULL;
+	unsigned int i_pointer;
+	for (i_pointer = 0; i_pointer < count; i_pointer++) {
+		arena_t* arena = mem_arenas_owner(arenas, magazine->pointers[i_pointer].address);
+		if (arena != locked_arena) {
+			if (locked_arena != NULL) pthread_mutex_unlock(&locked_arena->lock);
+			pthread_mutex_lock(&arena->lock);
+			locked_arena = arena;
+		}
+
+		int free_result = mem_free(&arena->allocator, &magazine->pointers[i_pointer]);
+		if (free_result != SUCCESSFUL_EXEC) result = free_result;
+	}
+
+	if (locked_arena != NULL) pthread_mutex_unlock(&locked_arena->lock);
+
+	// The newest blocks stay, at the bottom of the magazine.
+	magazine->length -= count;
+	memmove(&magazine->pointers[0], &magazine->pointers[count], magazine->length * sizeof(ptr_t));
+	return result;
+}
+
+/// <summary>
+/// Flushes all magazines of the cache of a thread. This is called when the thread exits.
+/// The cache itself is kept, with its counters, until the arenas are destroyed.
+/// </summary>
+/// <param name="cache">The cache of the thread, as a thread_cache_t.</param>
+static void mem_arenas_cache_release(void* cache) {
+	thread_cache_t* thread_cache = cache;
+	unsigned int i_class;
+	for (i_class = 0; i_class < MAGAZINE_CLASS_COUNT; i_class++) {
+		if (thread_cache->magazines[i_class].length) {
+			mem_arenas_flush(thread_cache->arenas, &thread_cache->magazines[i_class], thread_cache->magazines[i_class].length);
+		}
+	}
+}
+
+/// <summary>
+/// Destroys the arenas. The magazines of all threads are flushed first. No thread can use the arenas anymore.
+/// </summary>
+/// <param name="arenas">The arenas.</param>
+/// <returns>The state code.</returns>
+int mem_arenas_destroy(arenas_t* arenas) {
+	log_debug("Entering mem_arenas_destroy().");
+	if (arenas == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	pthread_key_delete(arenas->thread_cache_key);
+	while (arenas->caches != NULL) {
+		thread_cache_t* cache = arenas->caches;
+		arenas->caches = cache->next;
+		mem_arenas_cache_release(cache);
+		free(cache);
+	}
+
+	unsigned int i_arena;
+	for (i_arena = 0; i_arena < arenas->count; i_arena++) {
+		mem_allocator_destroy(&arenas->arenas[i_arena].allocator);
+		pthread_mutex_destroy(&arenas->arenas[i_arena].lock);
+	}
+
+	if (arenas->options.is_mapped) {
+		mem_unmap_address_space(&arenas->options);
+	}
+
+	pthread_mutex_destroy(&arenas->caches_lock);
+	free(arenas->arenas);
+	arenas->arenas = NULL;
+	arenas->count = 0;
+
+	log_debug("Exiting mem_arenas_destroy().");
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Gets the cache of the calling thread. It is created on the first call of the thread, which assigns its arena.
+/// </summary>
+/// <param name="arenas">The arenas.</param>
+/// <returns>The cache, or null if it could not be created.</returns>
+static thread_cache_t* mem_arenas_cache_of_thread(arenas_t* arenas) {
+	thread_cache_t* cache = pthread_getspecific(arenas->thread_cache_key);
+	if (cache != NULL) {
+		return cache;
+	}
+
+	cache = calloc(1, sizeof(thread_cache_t));
+	if (cache == NULL) {
+		return NULL;
+	}
+
+	cache->arenas = arenas;
+	if (arenas->assignment == ARENA_ASSIGNMENT_THREAD_ID) {
+		// Thread ids are often aligned addresses, so they are mixed before being reduced to an index.
+		uint64_t id = (uint64_t) (uintptr_t) pthread_self();
+		cache->i_arena = (unsigned int) ((id * 0x9E3779B97F4A7C15ULL) >> 32) % arenas->count;
+	} else {
+		cache->i_arena = __sync_fetch_and_add(&arenas->next_arena, 1) % arenas->count;
+	}
+
+	pthread_mutex_lock(&arenas->caches_lock);
+	cache->next = arenas->caches;
+	arenas->caches = cache;
+	pthread_mutex_unlock(&arenas->caches_lock);
+
+	pthread_setspecific(arenas->thread_cache_key, cache);
+	return cache;
+}
+
+/// <summary>
+/// Allocates a memory block of at least size bytes from the magazines of the calling thread, or from its arena.
+/// A small size is rounded up to its size class. An empty magazine is refilled with a batch of blocks of its class at once.
+/// If the arena of the thread is out of memory, the other arenas are tried in turn.
+/// This can be called from many threads at once.
+/// </summary>
+/// <param name="arenas">The arenas.</param>
+/// <param name="size">The size of the allocation.</param>
+/// <param name="pointer">The pointer into which to allocate.</param>
+/// <returns>The state code.</returns>
+int mem_arenas_allocate(arenas_t* arenas, sz_t size, ptr_t* pointer) {
+	log_debug("Entering mem_arenas_allocate(). Size value: %lu.", size);
+	if (arenas == NULL || !size || pointer == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	thread_cache_t* cache = mem_arenas_cache_of_thread(arenas);
+	if (cache == NULL) {
+		return OUT_OF_MEMORY_ERRNO;
+	}
+
+	if (arenas->magazine_capacity && size <= MAGAZINE_CLASS_COUNT * MAGAZINE_CLASS_GRANULE) {
+		// Every block of the magazine fits the whole class, so any of them is returned.
+		unsigned int i_class = (size - 1) / MAGAZINE_CLASS_GRANULE;
+		magazine_t* magazine = &cache->magazines[i_class];
+		size = (i_class + 1) * MAGAZINE_CLASS_GRANULE;
+		cache->stats.allocation_count++;
+		if (magazine->length) {
+			cache->stats.hit_count++;
+		} else {
+			// Refill half of the magazine under a single lock of the arena.
+			arena_t* arena = &arenas->arenas[cache->i_arena];
+			unsigned int batch = (arenas->magazine_capacity + 1) / 2;
+			cache->stats.refill_count++;
+			pthread_mutex_lock(&arena->lock);
+			while (magazine->length < batch && mem_allocate(&arena->allocator, size, &magazine->pointers[magazine->length]) == SUCCESSFUL_EXEC) {
+				magazine->length++;
+			}
+
+			pthread_mutex_unlock(&arena->lock);
+		}
+
+		if (magazine->length) {
+			*pointer = magazine->pointers[--magazine->length];
+			log_debug("Exiting mem_arenas_allocate(). Address value: %lu.", pointer->address);
+			return SUCCESSFUL_EXEC;
+		}
+
+		// The arena of the thread is out of memory for the class, so the other arenas are tried for a single block.
+	}
+
+	unsigned int i_try;
+	int result = OUT_OF_MEMORY_ERRNO;
+	for (i_try = 0; i_try < arenas->count && result == OUT_OF_MEMORY_ERRNO; i_try++) {
+		arena_t* arena = &arenas->arenas[(cache->i_arena + i_try) % arenas->count];
+		pthread_mutex_lock(&arena->lock);
+		result = mem_allocate(&arena->allocator, size, pointer);
+		pthread_mutex_unlock(&arena->lock);
+	}
+
+	log_debug("Exiting mem_arenas_allocate(). Tries: %u.", i_try);
+	return result;
+}
+
+/// <summary>
+/// Frees a memory pointer into the magazine of its size class, or puts the memory back into the arena that owns its address.
+/// A full magazine is flushed by a batch of its oldest blocks at once.
+/// This can be called from many threads at once, and from another thread than the one that allocated.
+/// </summary>
+/// <param name="arenas">The arenas.</param>
+/// <param name="pointer">The pointer from which to free.</param>
+/// <returns>The state code.</returns>
+int mem_arenas_free(arenas_t* arenas, ptr_t* pointer) {
+	if (arenas == NULL || pointer == NULL || pointer->address < arenas->first_address) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	log_debug("Entering mem_arenas_free(). Pointer address: %lu, Pointer size: %lu.", pointer->address, pointer->size);
+
+	// A block goes to the greatest class that it fits entirely.
+	thread_cache_t* cache;
+	if (arenas->magazine_capacity && pointer->size >= MAGAZINE_CLASS_GRANULE && pointer->size / MAGAZINE_CLASS_GRANULE <= MAGAZINE_CLASS_COUNT &&
+		(cache = mem_arenas_cache_of_thread(arenas)) != NULL) {
+		magazine_t* magazine = &cache->magazines[pointer->size / MAGAZINE_CLASS_GRANULE - 1];
+		if (magazine->length == arenas->magazine_capacity) {
+			cache->stats.flush_count++;
+			int result = mem_arenas_flush(arenas, magazine, (arenas->magazine_capacity + 1) / 2);
+			if (result != SUCCESSFUL_EXEC) {
+				return result;
+			}
+		}
+
+		magazine->pointers[magazine->length++] = *pointer;
+		pointer->is_allocated = false;
+		log_debug("Exiting mem_arenas_free().");
+		return SUCCESSFUL_EXEC;
+	}
+
+	arena_t* arena = mem_arenas_owner(arenas, pointer->address);
+	pthread_mutex_lock(&arena->lock);
+	int result = mem_free(&arena->allocator, pointer);
+	pthread_mutex_unlock(&arena->lock);
+
+	log_debug("Exiting mem_arenas_free().");
+	return result;
+}
+
+/// <summary>
+/// Puts the number of allocated blocks of all arenas into the count argument.
+/// </summary>
+/// <param name="arenas">The arenas.</param>
+/// <param name="count">The out argument for the count.</param>
+/// <returns>The state code.</returns>
+int mem_arenas_count_allocated_block(arenas_t* arenas, unsigned int* count) {
+	log_debug("Entering mem_arenas_count_allocated_block().");
+	if (arenas == NULL || count == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	*count = 0;
+	unsigned int i_arena, arena_count;
+	for (i_arena = 0; i_arena < arenas->count; i_arena++) {
+		pthread_mutex_lock(&arenas->arenas[i_arena].lock);
+		mem_count_allocated_block(&arenas->arenas[i_arena].allocator, &arena_count);
+		pthread_mutex_unlock(&arenas->arenas[i_arena].lock);
+		*count += arena_count;
+	}
+
+	log_debug("Exiting mem_arenas_count_allocated_block(). Count value: %u.", *count);
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Puts the number of free bytes of all arenas into the count argument.
+/// </summary>
+/// <param name="arenas">The arenas.</param>
+/// <param name="count">The out argument for the count.</param>
+/// <returns>The state code.</returns>
+int mem_arenas_count_free(arenas_t* arenas, unsigned long* count) {
+	log_debug("Entering mem_arenas_count_free().");
+	if (arenas == NULL || count == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	*count = 0;
+	unsigned int i_arena;
+	unsigned long arena_count;
+	for (i_arena = 0; i_arena < arenas->count; i_arena++) {
+		pthread_mutex_lock(&arenas->arenas[i_arena].lock);
+		mem_count_free(&arenas->arenas[i_arena].allocator, &arena_count);
+		pthread_mutex_unlock(&arenas->arenas[i_arena].lock);
+		*count += arena_count;
+	}
+
+	log_debug("Exiting mem_arenas_count_free(). Count value: %lu.", *count);
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Puts the sum of the counters of the magazines of all threads into the stats argument.
+/// </summary>
+/// <param name="arenas">The arenas.</param>
+/// <param name="stats">The out argument for the counters.</param>
+/// <returns>The state code.</returns>
+int mem_arenas_magazine_stats(arenas_t* arenas, magazine_stats_t* stats) {
+	log_debug("Entering mem_arenas_magazine_stats().");
+	if (arenas == NULL || stats == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	memset(stats, 0, sizeof(magazine_stats_t));
+	pthread_mutex_lock(&arenas->caches_lock);
+	thread_cache_t* cache;
+	for (cache = arenas->caches; cache != NULL; cache = cache->next) {
+		stats->allocation_count += cache->stats.allocation_count;
+		stats->hit_count += cache->stats.hit_count;
+		stats->refill_count += cache->stats.refill_count;
+		stats->flush_count += cache->stats.flush_count;
+	}
+
+	pthread_mutex_unlock(&arenas->caches_lock);
+
+	log_debug("Exiting mem_arenas_magazine_stats(). Hit count: %lu.", stats->hit_count);
+	return SUCCESSFUL_EXEC;
+}
\ No newline at end of file
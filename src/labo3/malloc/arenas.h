@@ -0,0 +1,145 @@
+#ifndef MALLOC_ARENAS_H
+#define MALLOC_ARENAS_H
+
+#include <pthread.h>
+
+#include "commons.h"
+#include "strategies.h"
+#include "allocator.h"
+
+// Threads are assigned to the next arena on their first call, in turn.
+#define ARENA_ASSIGNMENT_ROUND_ROBIN 0
+
+// Threads are assigned to an arena by a hash of their id.
+#define ARENA_ASSIGNMENT_THREAD_ID 1
+
+// Granularity of the size classes of the magazines. Class i holds blocks of at least (i + 1) times this size.
+#define MAGAZINE_CLASS_GRANULE 16
+
+// Number of size classes of the magazines. Greater blocks always go to the arenas.
+#define MAGAZINE_CLASS_COUNT 64
+
+// Maximum number of blocks in a magazine.
+#define MAGAZINE_MAXIMUM_CAPACITY 64
+
+// Structure for an arena: an allocator over a slice of the address space, behind its own lock.
+typedef struct arena_t {
+	allocator_t allocator;
+	pthread_mutex_t lock;
+} arena_t;
+
+// Structure for a magazine: a stack of allocated blocks of one size class, kept by a thread for its next allocations.
+typedef struct magazine_t {
+	ptr_t pointers[MAGAZINE_MAXIMUM_CAPACITY];
+	unsigned int length;
+} magazine_t;
+
+// Structure for the counters of the magazines.
+typedef struct magazine_stats_t {
+	unsigned long allocation_count;
+	unsigned long hit_count;
+	unsigned long refill_count;
+	unsigned long flush_count;
+} magazine_stats_t;
+
+// Structure for the state of a thread that uses the arenas: its arena and its magazines, by size class.
+typedef struct thread_cache_t {
+	struct arenas_t* arenas;
+	unsigned int i_arena;
+	magazine_t magazines[MAGAZINE_CLASS_COUNT];
+	magazine_stats_t stats;
+	struct thread_cache_t* next;
+} thread_cache_t;
+
+// Structure for a set of arenas that splits the address space, so that threads allocate concurrently.
+// Every arena owns a contiguous slice of the address space, so the arena of a pointer is found from its address.
+typedef struct arenas_t {
+	arena_t* arenas;
+	unsigned int count;
+	unsigned int assignment;
+	mem_address_t first_address;
+	sz_t slice_size;
+
+	// The options of the whole address space. If they are mapped, the arenas reserved the address space at once.
+	allocator_options_t options;
+
+	// The next arena to assign, for the round robin assignment.
+	unsigned int next_arena;
+
+	// The capacity of the magazines of every thread. If 0, threads have no magazines.
+	unsigned int magazine_capacity;
+
+	// The key of the cache of each thread.
+	pthread_key_t thread_cache_key;
+
+	// The caches of all threads that used the arenas, and the lock of that list.
+	thread_cache_t* caches;
+	pthread_mutex_t caches_lock;
+} arenas_t;
+
+/// <summary>
+/// Initializes the arenas. The address space is split in equal slices, one per arena.
+/// </summary>
+/// <param name="arenas">The arenas to initialize.</param>
+/// <param name="count">The count of arenas. It cannot be greater than the address space size.</param>
+/// <param name="assignment">How threads are assigned to arenas. Values are ARENA_ASSIGNMENT_ROUND_ROBIN and ARENA_ASSIGNMENT_THREAD_ID.</param>
+/// <param name="magazine_capacity">The capacity of the magazines of every thread, up to MAGAZINE_MAXIMUM_CAPACITY. If 0, threads have no magazines.</param>
+/// <param name="strategy">Function pointer for memory allocation strategy to use in every arena.</param>
+/// <param name="options">Options for the whole address space. They are copied. If they are mapped, the whole address space is reserved at once.</param>
+/// <returns>The state code.</returns>
+int mem_arenas_init(arenas_t* arenas, unsigned int count, unsigned int assignment, unsigned int magazine_capacity, mem_allocation_strategy_t strategy, allocator_options_t* options);
+
+/// <summary>
+/// Destroys the arenas. The magazines of all threads are flushed first. No thread can use the arenas anymore.
+/// </summary>
+/// <param name="arenas">The arenas.</param>
+/// <returns>The state code.</returns>
+int mem_arenas_destroy(arenas_t* arenas);
+
+/// <summary>
+/// Allocates a memory block of at least size bytes from the magazines of the calling thread, or from its arena.
+/// A small size is rounded up to its size class. An empty magazine is refilled with a batch of blocks of its class at once.
+/// If the arena of the thread is out of memory, the other arenas are tried in turn.
+/// This can be called from many threads at once.
+/// </summary>
+/// <param name="arenas">The arenas.</param>
+/// <param name="size">The size of the allocation.</param>
+/// <param name="pointer">The pointer into which to allocate.</param>
+/// <returns>The state code.</returns>
+int mem_arenas_allocate(arenas_t* arenas, sz_t size, ptr_t* pointer);
+
+/// <summary>
+/// Frees a memory pointer into the magazine of its size class, or puts the memory back into the arena that owns its address.
+/// A full magazine is flushed by a batch of its oldest blocks at once.
+/// This can be called from many threads at once, and from another thread than the one that allocated.
+/// </summary>
+/// <param name="arenas">The arenas.</param>
+/// <param name="pointer">The pointer from which to free.</param>
+/// <returns>The state code.</returns>
+int mem_arenas_free(arenas_t* arenas, ptr_t* pointer);
+
+/// <summary>
+/// Puts the number of allocated blocks of all arenas into the count argument.
+/// </summary>
+/// <param name="arenas">The arenas.</param>
+/// <param name="count">The out argument for the count.</param>
+/// <returns>The state code.</returns>
+int mem_arenas_count_allocated_block(arenas_t* arenas, unsigned int* count);
+
+/// <summary>
+/// Puts the number of free bytes of all arenas into the count argument.
+/// </summary>
+/// <param name="arenas">The arenas.</param>
+/// <param name="count">The out argument for the count.</param>
+/// <returns>The state code.</returns>
+int mem_arenas_count_free(arenas_t* arenas, unsigned long* count);
+
+/// <summary>
+/// Puts the sum of the counters of the magazines of all threads into the stats argument.
+/// </summary>
+/// <param name="arenas">The arenas.</param>
+/// <param name="stats">The out argument for the counters.</param>
+/// <returns>The state code.</returns>
+int mem_arenas_magazine_stats(arenas_t* arenas, magazine_stats_t* stats);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,441 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <errno.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "../lib/logging.h"
+#include "blockarrays.h"
+
+// Initial capacity of the array of chunks. It doubles as needed.
+#define BLOCK_ARRAYS_INITIAL_CHUNK_CAPACITY 16
+
+/// <summary>
+/// Scans sizes one at a time for the first size greater than the given size.
+/// </summary>
+/// <param name="sizes">The sizes.</param>
+/// <param name="length">The count of sizes.</param>
+/// <param name="size">The size.</param>
+/// <returns>The index of the first greater size, or the length if there is none.</returns>
+static unsigned int mem_block_arrays_scan_scalar(const sz_t* sizes, unsigned int length, sz_t size) {
+	unsigned int i_size;
+	for (i_size = 0; i_size < length && sizes[i_size] <= size; i_size++);
+	return i_size;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+/// <summary>
+/// Scans sizes two at a time with SSE2 for the first size greater than the given size.
+/// SSE2 only compares signed 32-bit integers, so the sign bit of every half is flipped first, and a size is greater
+/// if its high half is greater, or if its high half is equal and its low half is greater.
+/// </summary>
+/// <param name="sizes">The sizes.</param>
+/// <param name="length">The count of sizes.</param>
+/// <param name="size">The size.</param>
+/// <returns>The index of the first greater size, or the length if there is none.</returns>
+__attribute__((target("sse2")))
+static unsigned int mem_block_arrays_scan_sse2(const sz_t* sizes, unsigned int length, sz_t size) {
+	const __m128i sign = _mm_set1_epi64x((long long) 0x8000000080000000ULL);
+	const __m128i key = _mm_set1_epi64x((long long) (size ^ 0x8000000080000000ULL));
+	unsigned int i_size;
+	for (i_size = 0; i_size + 2 <= length; i_size += 2) {
+		__m128i values = _mm_xor_si128(_mm_loadu_si128((const __m128i*) (sizes + i_size)), sign);
+		__m128i greater = _mm_cmpgt_epi32(values, key);
+		__m128i equal = _mm_cmpeq_epi32(values, key);
+
+		// Spread the result of the high half, and of the low half, over both halves of every size.
+		__m128i high_greater = _mm_shuffle_epi32(greater, _MM_SHUFFLE(3, 3, 1, 1));
+		__m128i high_equal = _mm_shuffle_epi32(equal, _MM_SHUFFLE(3, 3, 1, 1));
+		__m128i low_greater = _mm_shuffle_epi32(greater, _MM_SHUFFLE(2, 2, 0, 0));
+		__m128i result = _mm_or_si128(high_greater, _mm_and_si128(high_equal, low_greater));
+		int mask = _mm_movemask_pd(_mm_castsi128_pd(result));
+		if (mask) {
+			return i_size + __builtin_ctz(mask);
+		}
+	}
+
+	return i_size + mem_block_arrays_scan_scalar(sizes + i_size, length - i_size, size);
+}
+
+/// <summary>
+/// Scans sizes four at a time with AVX2 for the first size greater than the given size.
+/// AVX2 only compares signed 64-bit integers, so the sign bit of both sides is flipped first.
+/// </summary>
+/// <param name="sizes">The sizes.</param>
+/// <param name="length">The count of sizes.</param>
+/// <param name="size">The size.</param>
+/// <returns>The index of the first greater size, or the length if there is none.</returns>
+__attribute__((target("avx2")))
+static unsigned int mem_block_arrays_scan_avx2(const sz_t* sizes, unsigned int length, sz_t size) {
+	const __m256i sign = _mm256_set1_epi64x((long long) 0x8000000000000000ULL);
+	const __m256i key = _mm256_set1_epi64x((long long) (size ^ 0x8000000000000000ULL));
+	unsigned int i_size;
+	for (i_size = 0; i_size + 4 <= length; i_size += 4) {
+		__m256i values = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*) (sizes + i_size)), sign);
+		int mask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(values, key)));
+		if (mask) {
+			return i_size + __builtin_ctz(mask);
+		}
+	}
+
+	return i_size + mem_block_arrays_scan_scalar(sizes + i_size, length - i_size, size);
+}
+#endif
+
+/// <summary>
+/// Initializes empty block arrays. The fastest scan supported by the processor is used.
+/// </summary>
+/// <param name="arrays">The block arrays to initialize.</param>
+/// <returns>The state code.</returns>
+int mem_block_arrays_init(block_arrays_t* arrays) {
+	log_debug("Entering mem_block_arrays_init().");
+	if (arrays == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	memset(arrays, 0, sizeof(block_arrays_t));
+	if (mem_block_arrays_use_scan(arrays, BLOCK_ARRAYS_SCAN_AVX2) != SUCCESSFUL_EXEC &&
+		mem_block_arrays_use_scan(arrays, BLOCK_ARRAYS_SCAN_SSE2) != SUCCESSFUL_EXEC) {
+		mem_block_arrays_use_scan(arrays, BLOCK_ARRAYS_SCAN_SCALAR);
+	}
+
+	log_debug("Exiting mem_block_arrays_init(). Scan: %s.", mem_block_arrays_scan_name(arrays->scan_kind));
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Frees the chunks of the block arrays.
+/// </summary>
+/// <param name="arrays">The block arrays.</param>
+/// <returns>The state code.</returns>
+int mem_block_arrays_destroy(block_arrays_t* arrays) {
+	log_debug("Entering mem_block_arrays_destroy().");
+	if (arrays == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	unsigned int i_chunk;
+	for (i_chunk = 0; i_chunk < arrays->chunk_count; i_chunk++) {
+		free(arrays->chunks[i_chunk]);
+	}
+
+	free(arrays->chunks);
+	arrays->chunks = NULL;
+	arrays->chunk_count = arrays->chunk_capacity = arrays->length = 0;
+
+	log_debug("Exiting mem_block_arrays_destroy().");
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Chooses the scan of the sizes of the chunks.
+/// </summary>
+/// <param name="arrays">The block arrays.</param>
+/// <param name="scan_kind">The kind of scan. Values are BLOCK_ARRAYS_SCAN_SCALAR, BLOCK_ARRAYS_SCAN_SSE2 and BLOCK_ARRAYS_SCAN_AVX2.</param>
+/// <returns>The state code. ILLEGAL_ARGUMENTS_ERRNO if the processor does not support the scan.</returns>
+int mem_block_arrays_use_scan(block_arrays_t* arrays, unsigned int scan_kind) {
+	if (arrays == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	mem_block_arrays_scan_t scan = NULL;
+	if (scan_kind == BLOCK_ARRAYS_SCAN_SCALAR) {
+		scan = &mem_block_arrays_scan_scalar;
+	}
+
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_cpu_init();
+	if (scan_kind == BLOCK_ARRAYS_SCAN_SSE2 && __builtin_cpu_supports("sse2")) {
+		scan = &mem_block_arrays_scan_sse2;
+	} else if (scan_kind == BLOCK_ARRAYS_SCAN_AVX2 && __builtin_cpu_supports("avx2")) {
+		scan = &mem_block_arrays_scan_avx2;
+	}
+#endif
+
+	if (scan == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	arrays->scan = scan;
+	arrays->scan_kind = scan_kind;
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Gets the name of a kind of scan.
+/// </summary>
+/// <param name="scan_kind">The kind of scan.</param>
+/// <returns>The name of the scan, or null if the kind is not known.</returns>
+const char* mem_block_arrays_scan_name(unsigned int scan_kind) {
+	if (scan_kind == BLOCK_ARRAYS_SCAN_SCALAR) return "scalar";
+	if (scan_kind == BLOCK_ARRAYS_SCAN_SSE2) return "sse2";
+	if (scan_kind == BLOCK_ARRAYS_SCAN_AVX2) return "avx2";
+	return NULL;
+}
+
+/// <summary>
+/// Gets the index of the chunk that holds an address: the last chunk that starts at or before it, or the first chunk.
+/// </summary>
+/// <param name="arrays">The block arrays. They must have at least one chunk.</param>
+/// <param name="address">The address.</param>
+/// <returns>The index of the chunk.</returns>
+static unsigned int mem_block_arrays_chunk_of(const block_arrays_t* arrays, mem_address_t address) {
+	unsigned int low = 0, high = arrays->chunk_count;
+	while (high - low > 1) {
+		unsigned int middle = low + (high - low) / 2;
+		if (arrays->chunks[middle]->addresses[0] <= address) low = middle;
+		else high = middle;
+	}
+
+	return low;
+}
+
+/// <summary>
+/// Gets the index of the first entry of a chunk whose address is greater or equal to an address.
+/// </summary>
+/// <param name="chunk">The chunk.</param>
+/// <param name="address">The address.</param>
+/// <returns>The index of the entry, or the length of the chunk if all addresses are lower.</returns>
+static unsigned int mem_block_arrays_lower_bound(const block_arrays_chunk_t* chunk, mem_address_t address) {
+	unsigned int low = 0, high = chunk->length;
+	while (low < high) {
+		unsigned int middle = low + (high - low) / 2;
+		if (chunk->addresses[middle] < address) low = middle + 1;
+		else high = middle;
+	}
+
+	return low;
+}
+
+/// <summary>
+/// Computes again the greatest size of a chunk.
+/// </summary>
+/// <param name="chunk">The chunk.</param>
+static void mem_block_arrays_update_max(block_arrays_chunk_t* chunk) {
+	unsigned int i_entry;
+	chunk->max_size = 0;
+	for (i_entry = 0; i_entry < chunk->length; i_entry++) {
+		if (chunk->sizes[i_entry] > chunk->max_size) chunk->max_size = chunk->sizes[i_entry];
+	}
+}
+
+/// <summary>
+/// Moves entries of a chunk, or between chunks, in all the parallel arrays.
+/// </summary>
+/// <param name="to">The chunk into which to move.</param>
+/// <param name="i_to">The index of the first entry moved to.</param>
+/// <param name="from">The chunk from which to move.</param>
+/// <param name="i_from">The index of the first entry moved from.</param>
+/// <param name="count">The count of entries.</param>
+static void mem_block_arrays_move(block_arrays_chunk_t* to, unsigned int i_to, const block_arrays_chunk_t* from, unsigned int i_from, unsigned int count) {
+	memmove(to->addresses + i_to, from->addresses + i_from, count * sizeof(mem_address_t));
+	memmove(to->sizes + i_to, from->sizes + i_from, count * sizeof(sz_t));
+	memmove(to->blocks + i_to, from->blocks + i_from, count * sizeof(struct block_t*));
+}
+
+/// <summary>
+/// Creates an empty chunk at an index of the array of chunks. The array grows as needed.
+/// </summary>
+/// <param name="arrays">The block arrays.</param>
+/// <param name="i_chunk">The index of the chunk.</param>
+/// <returns>The chunk, or null if it could not be allocated.</returns>
+static block_arrays_chunk_t* mem_block_arrays_chunk_insert(block_arrays_t* arrays, unsigned int i_chunk) {
+	if (arrays->chunk_count == arrays->chunk_capacity) {
+		// Double the capacity of the array of chunks.
+		unsigned int capacity = arrays->chunk_capacity ? 2 * arrays->chunk_capacity : BLOCK_ARRAYS_INITIAL_CHUNK_CAPACITY;
+		block_arrays_chunk_t** chunks = realloc(arrays->chunks, capacity * sizeof(block_arrays_chunk_t*));
+		arrays->libc_call_count++;
+		if (chunks == NULL) {
+			return NULL;
+		}
+
+		arrays->chunks = chunks;
+		arrays->chunk_capacity = capacity;
+	}
+
+	block_arrays_chunk_t* chunk = malloc(sizeof(block_arrays_chunk_t));
+	arrays->libc_call_count++;
+	if (chunk == NULL) {
+		return NULL;
+	}
+
+	chunk->length = 0;
+	chunk->max_size = 0;
+	memmove(arrays->chunks + i_chunk + 1, arrays->chunks + i_chunk, (arrays->chunk_count - i_chunk) * sizeof(block_arrays_chunk_t*));
+	arrays->chunks[i_chunk] = chunk;
+	arrays->chunk_count++;
+	return chunk;
+}
+
+/// <summary>
+/// Frees the chunk at an index of the array of chunks.
+/// </summary>
+/// <param name="arrays">The block arrays.</param>
+/// <param name="i_chunk">The index of the chunk.</param>
+static void mem_block_arrays_chunk_remove(block_arrays_t* arrays, unsigned int i_chunk) {
+	free(arrays->chunks[i_chunk]);
+	arrays->chunk_count--;
+	memmove(arrays->chunks + i_chunk, arrays->chunks + i_chunk + 1, (arrays->chunk_count - i_chunk) * sizeof(block_arrays_chunk_t*));
+}
+
+/// <summary>
+/// Inserts a free block at its place by address.
+/// </summary>
+/// <param name="arrays">The block arrays.</param>
+/// <param name="address">The address of the block.</param>
+/// <param name="size">The size of the block.</param>
+/// <param name="block">The record of the block.</param>
+/// <returns>The state code.</returns>
+int mem_block_arrays_insert(block_arrays_t* arrays, mem_address_t address, sz_t size, struct block_t* block) {
+	if (arrays == NULL || block == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	if (!arrays->chunk_count && mem_block_arrays_chunk_insert(arrays, 0) == NULL) {
+		return OUT_OF_MEMORY_ERRNO;
+	}
+
+	unsigned int i_chunk = mem_block_arrays_chunk_of(arrays, address);
+	block_arrays_chunk_t* chunk = arrays->chunks[i_chunk];
+	if (chunk->length == BLOCK_ARRAYS_CHUNK_CAPACITY) {
+		// Split the full chunk in halves. The upper half goes to a new chunk right after it.
+		block_arrays_chunk_t* upper_chunk = mem_block_arrays_chunk_insert(arrays, i_chunk + 1);
+		if (upper_chunk == NULL) {
+			return OUT_OF_MEMORY_ERRNO;
+		}
+
+		unsigned int half = BLOCK_ARRAYS_CHUNK_CAPACITY / 2;
+		mem_block_arrays_move(upper_chunk, 0, chunk, half, BLOCK_ARRAYS_CHUNK_CAPACITY - half);
+		upper_chunk->length = BLOCK_ARRAYS_CHUNK_CAPACITY - half;
+		chunk->length = half;
+		mem_block_arrays_update_max(chunk);
+		mem_block_arrays_update_max(upper_chunk);
+		if (address >= upper_chunk->addresses[0]) {
+			chunk = upper_chunk;
+		}
+	}
+
+	unsigned int i_entry = mem_block_arrays_lower_bound(chunk, address);
+	mem_block_arrays_move(chunk, i_entry + 1, chunk, i_entry, chunk->length - i_entry);
+	chunk->addresses[i_entry] = address;
+	chunk->sizes[i_entry] = size;
+	chunk->blocks[i_entry] = block;
+	chunk->length++;
+	if (size > chunk->max_size) {
+		chunk->max_size = size;
+	}
+
+	arrays->length++;
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Removes the free block at an address.
+/// </summary>
+/// <param name="arrays">The block arrays.</param>
+/// <param name="address">The address of the block.</param>
+/// <returns>The state code.</returns>
+int mem_block_arrays_remove(block_arrays_t* arrays, mem_address_t address) {
+	if (arrays == NULL || !arrays->chunk_count) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	unsigned int i_chunk = mem_block_arrays_chunk_of(arrays, address);
+	block_arrays_chunk_t* chunk = arrays->chunks[i_chunk];
+	unsigned int i_entry = mem_block_arrays_lower_bound(chunk, address);
+	if (i_entry == chunk->length || chunk->addresses[i_entry] != address) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	sz_t size = chunk->sizes[i_entry];
+	mem_block_arrays_move(chunk, i_entry, chunk, i_entry + 1, chunk->length - i_entry - 1);
+	chunk->length--;
+	arrays->length--;
+	if (!chunk->length) {
+		mem_block_arrays_chunk_remove(arrays, i_chunk);
+		return SUCCESSFUL_EXEC;
+	}
+
+	if (size == chunk->max_size) {
+		mem_block_arrays_update_max(chunk);
+	}
+
+	// Merge the chunk with the next one once both fit in half a chunk, so that chunks stay dense.
+	if (i_chunk + 1 < arrays->chunk_count && chunk->length + arrays->chunks[i_chunk + 1]->length <= BLOCK_ARRAYS_CHUNK_CAPACITY / 2) {
+		block_arrays_chunk_t* next_chunk = arrays->chunks[i_chunk + 1];
+		mem_block_arrays_move(chunk, chunk->length, next_chunk, 0, next_chunk->length);
+		chunk->length += next_chunk->length;
+		if (next_chunk->max_size > chunk->max_size) {
+			chunk->max_size = next_chunk->max_size;
+		}
+
+		mem_block_arrays_chunk_remove(arrays, i_chunk + 1);
+	}
+
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Changes the bounds of the free block at an address. Free blocks never overlap, so the block keeps its place.
+/// </summary>
+/// <param name="arrays">The block arrays.</param>
+/// <param name="address">The address of the block.</param>
+/// <param name="new_address">The new address of the block.</param>
+/// <param name="size">The new size of the block.</param>
+/// <returns>The state code.</returns>
+int mem_block_arrays_update(block_arrays_t* arrays, mem_address_t address, mem_address_t new_address, sz_t size) {
+	if (arrays == NULL || !arrays->chunk_count) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	block_arrays_chunk_t* chunk = arrays->chunks[mem_block_arrays_chunk_of(arrays, address)];
+	unsigned int i_entry = mem_block_arrays_lower_bound(chunk, address);
+	if (i_entry == chunk->length || chunk->addresses[i_entry] != address) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	sz_t old_size = chunk->sizes[i_entry];
+	chunk->addresses[i_entry] = new_address;
+	chunk->sizes[i_entry] = size;
+	if (size > chunk->max_size) {
+		chunk->max_size = size;
+	} else if (old_size == chunk->max_size && size < old_size) {
+		mem_block_arrays_update_max(chunk);
+	}
+
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Finds the free block with the lowest address whose size is greater than the given size.
+/// The chunks whose greatest size is too small are skipped, and the sizes of the others are scanned many at once.
+/// </summary>
+/// <param name="arrays">The block arrays.</param>
+/// <param name="size">The size.</param>
+/// <param name="step_count">The count to which to add the chunks and sizes visited.</param>
+/// <returns>The record of the block, or null if no block is large enough.</returns>
+struct block_t* mem_block_arrays_first_fit(block_arrays_t* arrays, sz_t size, unsigned long* step_count) {
+	if (arrays == NULL || step_count == NULL) {
+		return NULL;
+	}
+
+	unsigned int i_chunk;
+	for (i_chunk = 0; i_chunk < arrays->chunk_count; i_chunk++) {
+		block_arrays_chunk_t* chunk = arrays->chunks[i_chunk];
+		(*step_count)++;
+		if (chunk->max_size <= size) {
+			continue;
+		}
+
+		// The greatest size of the chunk fits, so the scan finds a block.
+		unsigned int i_entry = arrays->scan(chunk->sizes, chunk->length, size);
+		*step_count += i_entry + 1;
+		return chunk->blocks[i_entry];
+	}
+
+	return NULL;
+}
\ No newline at end of file
@@ -0,0 +1,118 @@
+#ifndef MALLOC_BLOCKARRAYS_H
+#define MALLOC_BLOCKARRAYS_H
+
+#include "commons.h"
+
+// Capacity of a chunk of the block arrays. It is a multiple of the count of sizes compared at once by every scan.
+#define BLOCK_ARRAYS_CHUNK_CAPACITY 256
+
+// Kinds of scans of the sizes of a chunk.
+#define BLOCK_ARRAYS_SCAN_SCALAR 0
+#define BLOCK_ARRAYS_SCAN_SSE2 1
+#define BLOCK_ARRAYS_SCAN_AVX2 2
+
+// Structure for a free block. It is defined by the free blocks.
+struct block_t;
+
+// Function pointer for a scan of the sizes of a chunk. It gets the index of the first size greater than the given size, or the length if there is none.
+typedef unsigned int (*mem_block_arrays_scan_t)(const sz_t* sizes, unsigned int length, sz_t size);
+
+// Structure for a chunk of the block arrays: the addresses, sizes and records of contiguous free blocks in parallel arrays, ordered by address.
+typedef struct block_arrays_chunk_t {
+	unsigned int length;
+
+	// The greatest size of the chunk, so that a search skips the chunks where no block is large enough.
+	sz_t max_size;
+
+	mem_address_t addresses[BLOCK_ARRAYS_CHUNK_CAPACITY];
+	sz_t sizes[BLOCK_ARRAYS_CHUNK_CAPACITY];
+	struct block_t* blocks[BLOCK_ARRAYS_CHUNK_CAPACITY];
+} block_arrays_chunk_t;
+
+// Structure for the free blocks as a structure of arrays, ordered by address. A search reads sizes from contiguous memory instead of following nodes.
+// The arrays are cut into chunks, so an insert or a remove only moves the entries of a single chunk.
+typedef struct block_arrays_t {
+	// The chunks, ordered by address. No chunk is empty.
+	block_arrays_chunk_t** chunks;
+	unsigned int chunk_count;
+	unsigned int chunk_capacity;
+
+	// The count of free blocks.
+	unsigned int length;
+
+	// The scan of the sizes of a chunk, and its kind.
+	mem_block_arrays_scan_t scan;
+	unsigned int scan_kind;
+
+	// The count of calls to the C library made to create chunks and to grow the array of chunks.
+	unsigned long libc_call_count;
+} block_arrays_t;
+
+/// <summary>
+/// Initializes empty block arrays. The fastest scan supported by the processor is used.
+/// </summary>
+/// <param name="arrays">The block arrays to initialize.</param>
+/// <returns>The state code.</returns>
+int mem_block_arrays_init(block_arrays_t* arrays);
+
+/// <summary>
+/// Frees the chunks of the block arrays.
+/// </summary>
+/// <param name="arrays">The block arrays.</param>
+/// <returns>The state code.</returns>
+int mem_block_arrays_destroy(block_arrays_t* arrays);
+
+/// <summary>
+/// Chooses the scan of the sizes of the chunks.
+/// </summary>
+/// <param name="arrays">The block arrays.</param>
+/// <param name="scan_kind">The kind of scan. Values are BLOCK_ARRAYS_SCAN_SCALAR, BLOCK_ARRAYS_SCAN_SSE2 and BLOCK_ARRAYS_SCAN_AVX2.</param>
+/// <returns>The state code. ILLEGAL_ARGUMENTS_ERRNO if the processor does not support the scan.</returns>
+int mem_block_arrays_use_scan(block_arrays_t* arrays, unsigned int scan_kind);
+
+/// <summary>
+/// Gets the name of a kind of scan.
+/// </summary>
+/// <param name="scan_kind">The kind of scan.</param>
+/// <returns>The name of the scan, or null if the kind is not known.</returns>
+const char* mem_block_arrays_scan_name(unsigned int scan_kind);
+
+/// <summary>
+/// Inserts a free block at its place by address.
+/// </summary>
+/// <param name="arrays">The block arrays.</param>
+/// <param name="address">The address of the block.</param>
+/// <param name="size">The size of the block.</param>
+/// <param name="block">The record of the block.</param>
+/// <returns>The state code.</returns>
+int mem_block_arrays_insert(block_arrays_t* arrays, mem_address_t address, sz_t size, struct block_t* block);
+
+/// <summary>
+/// Removes the free block at an address.
+/// </summary>
+/// <param name="arrays">The block arrays.</param>
+/// <param name="address">The address of the block.</param>
+/// <returns>The state code.</returns>
+int mem_block_arrays_remove(block_arrays_t* arrays, mem_address_t address);
+
+/// <summary>
+/// Changes the bounds of the free block at an address. Free blocks never overlap, so the block keeps its place.
+/// </summary>
+/// <param name="arrays">The block arrays.</param>
+/// <param name="address">The address of the block.</param>
+/// <param name="new_address">The new address of the block.</param>
+/// <param name="size">The new size of the block.</param>
+/// <returns>The state code.</returns>
+int mem_block_arrays_update(block_arrays_t* arrays, mem_address_t address, mem_address_t new_address, sz_t size);
+
+/// <summary>
+/// Finds the free block with the lowest address whose size is greater than the given size.
+/// The chunks whose greatest size is too small are skipped, and the sizes of the others are scanned many at once.
+/// </summary>
+/// <param name="arrays">The block arrays.</param>
+/// <param name="size">The size.</param>
+/// <param name="step_count">The count to which to add the chunks and sizes visited.</param>
+/// <returns>The record of the block, or null if no block is large enough.</returns>
+struct block_t* mem_block_arrays_first_fit(block_arrays_t* arrays, sz_t size, unsigned long* step_count);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,322 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <errno.h>
+
+#include "../lib/logging.h"
+#include "blockbitmap.h"
+
+/// <summary>
+/// Gets the index of the granule of an address, clamped to the granules of the block bitmap.
+/// </summary>
+/// <param name="bitmap">The block bitmap.</param>
+/// <param name="address">The address.</param>
+/// <param name="is_rounded_up">Whether an address within a granule gives the next granule. Otherwise, it gives its own granule.</param>
+/// <returns>The index of the granule, between 0 and the count of granules.</returns>
+static unsigned long mem_block_bitmap_granule(const block_bitmap_t* bitmap, mem_address_t address, unsigned int is_rounded_up) {
+	if (address <= bitmap->first_address) {
+		return 0;
+	}
+
+	unsigned long offset = address - bitmap->first_address;
+	unsigned long i_granule = offset >> bitmap->granule_log2;
+	if (is_rounded_up && (offset & (bitmap->granule_size - 1))) {
+		i_granule++;
+	}
+
+	return i_granule < bitmap->granule_count ? i_granule : bitmap->granule_count;
+}
+
+/// <summary>
+/// Sets or clears the bits of the granules [i_first, i_last), a word at a time, and keeps the summary of the words touched.
+/// </summary>
+/// <param name="bitmap">The block bitmap.</param>
+/// <param name="i_first">The index of the first granule.</param>
+/// <param name="i_last">The index right after the last granule.</param>
+/// <param name="is_set">Whether the bits are set. Otherwise, they are cleared.</param>
+static void mem_block_bitmap_assign(block_bitmap_t* bitmap, unsigned long i_first, unsigned long i_last, unsigned int is_set) {
+	while (i_first < i_last) {
+		unsigned long i_word = i_first / BLOCK_BITMAP_WORD_BITS;
+		unsigned int i_bit = i_first % BLOCK_BITMAP_WORD_BITS;
+		unsigned long bit_count = BLOCK_BITMAP_WORD_BITS - i_bit;
+		if (bit_count > i_last - i_first) {
+			bit_count = i_last - i_first;
+		}
+
+		unsigned long mask = bit_count == BLOCK_BITMAP_WORD_BITS ? ~0UL : ((1UL << bit_count) - 1) << i_bit;
+		if (is_set) {
+			bitmap->words[i_word] |= mask;
+		} else {
+			bitmap->words[i_word] &= ~mask;
+		}
+
+		unsigned long summary_bit = 1UL << (i_word % BLOCK_BITMAP_WORD_BITS);
+		if (bitmap->words[i_word] == ~0UL) {
+			bitmap->summary[i_word / BLOCK_BITMAP_WORD_BITS] |= summary_bit;
+		} else {
+			bitmap->summary[i_word / BLOCK_BITMAP_WORD_BITS] &= ~summary_bit;
+		}
+
+		i_first += bit_count;
+	}
+}
+
+/// <summary>
+/// Gets the default granule size of a block bitmap over an address space: BLOCK_BITMAP_DEFAULT_GRANULE_SIZE, doubled until the address space
+/// holds at most BLOCK_BITMAP_MAXIMUM_DEFAULT_GRANULE_COUNT granules.
+/// </summary>
+/// <param name="size">The size of the address space.</param>
+/// <returns>The granule size.</returns>
+sz_t mem_block_bitmap_default_granule_size(sz_t size) {
+	sz_t granule_size = BLOCK_BITMAP_DEFAULT_GRANULE_SIZE;
+	while (size / granule_size > BLOCK_BITMAP_MAXIMUM_DEFAULT_GRANULE_COUNT) {
+		granule_size *= 2;
+	}
+
+	return granule_size;
+}
+
+/// <summary>
+/// Initializes a block bitmap over an address space, with all granules not free.
+/// </summary>
+/// <param name="bitmap">The block bitmap to initialize.</param>
+/// <param name="first_address">The first address of the address space.</param>
+/// <param name="size">The size of the address space.</param>
+/// <param name="granule_size">The size of a granule. It must be a power of two.</param>
+/// <returns>The state code.</returns>
+int mem_block_bitmap_init(block_bitmap_t* bitmap, mem_address_t first_address, sz_t size, sz_t granule_size) {
+	log_debug("Entering mem_block_bitmap_init(). First address: %lu, Size value: %lu, Granule size: %lu.", first_address, size, granule_size);
+	if (bitmap == NULL || !granule_size || (granule_size & (granule_size - 1))) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	// Only the granules wholly within the address space are kept.
+	memset(bitmap, 0, sizeof(block_bitmap_t));
+	mem_address_t mask = ~(mem_address_t) (granule_size - 1);
+	mem_address_t last_address = (first_address + size) & mask;
+	bitmap->first_address = (first_address + granule_size - 1) & mask;
+	bitmap->granule_size = granule_size;
+	bitmap->granule_log2 = __builtin_ctzl(granule_size);
+	bitmap->granule_count = last_address > bitmap->first_address ? (last_address - bitmap->first_address) >> bitmap->granule_log2 : 0;
+	bitmap->word_count = (bitmap->granule_count + BLOCK_BITMAP_WORD_BITS - 1) / BLOCK_BITMAP_WORD_BITS;
+	bitmap->summary_count = (bitmap->word_count + BLOCK_BITMAP_WORD_BITS - 1) / BLOCK_BITMAP_WORD_BITS;
+	if (!bitmap->word_count) {
+		return SUCCESSFUL_EXEC;
+	}
+
+	bitmap->libc_call_count += 2;
+	bitmap->words = malloc(bitmap->word_count * sizeof(unsigned long));
+	bitmap->summary = malloc(bitmap->summary_count * sizeof(unsigned long));
+	if (bitmap->words == NULL || bitmap->summary == NULL) {
+		mem_block_bitmap_destroy(bitmap);
+		return OUT_OF_MEMORY_ERRNO;
+	}
+
+	memset(bitmap->words, 0xFF, bitmap->word_count * sizeof(unsigned long));
+	memset(bitmap->summary, 0xFF, bitmap->summary_count * sizeof(unsigned long));
+
+	log_debug("Exiting mem_block_bitmap_init(). Granule count: %lu.", bitmap->granule_count);
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Frees the words of the block bitmap.
+/// </summary>
+/// <param name="bitmap">The block bitmap.</param>
+/// <returns>The state code.</returns>
+int mem_block_bitmap_destroy(block_bitmap_t* bitmap) {
+	log_debug("Entering mem_block_bitmap_destroy().");
+	if (bitmap == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	free(bitmap->words);
+	free(bitmap->summary);
+	bitmap->words = NULL;
+	bitmap->summary = NULL;
+	bitmap->word_count = 0;
+	bitmap->summary_count = 0;
+	bitmap->granule_count = 0;
+
+	log_debug("Exiting mem_block_bitmap_destroy().");
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Clears the bits of the granules wholly within a free span of memory.
+/// </summary>
+/// <param name="bitmap">The block bitmap.</param>
+/// <param name="address">The address of the span.</param>
+/// <param name="size">The size of the span.</param>
+void mem_block_bitmap_free(block_bitmap_t* bitmap, mem_address_t address, sz_t size) {
+	mem_block_bitmap_assign(bitmap, mem_block_bitmap_granule(bitmap, address, 1), mem_block_bitmap_granule(bitmap, address + size, 0), 0);
+}
+
+/// <summary>
+/// Sets the bits of the granules that a span of memory no longer free touches.
+/// </summary>
+/// <param name="bitmap">The block bitmap.</param>
+/// <param name="address">The address of the span.</param>
+/// <param name="size">The size of the span.</param>
+void mem_block_bitmap_take(block_bitmap_t* bitmap, mem_address_t address, sz_t size) {
+	mem_block_bitmap_assign(bitmap, mem_block_bitmap_granule(bitmap, address, 0), mem_block_bitmap_granule(bitmap, address + size, 1), 1);
+}
+
+/// <summary>
+/// Changes the bounds of a free block. Only the bits of the granules gained or lost by the block change.
+/// </summary>
+/// <param name="bitmap">The block bitmap.</param>
+/// <param name="address">The address of the block.</param>
+/// <param name="size">The size of the block.</param>
+/// <param name="new_address">The new address of the block.</param>
+/// <param name="new_size">The new size of the block.</param>
+void mem_block_bitmap_update(block_bitmap_t* bitmap, mem_address_t address, sz_t size, mem_address_t new_address, sz_t new_size) {
+	mem_address_t end = address + size, new_end = new_address + new_size;
+	if (new_address >= end || address >= new_end) {
+		mem_block_bitmap_take(bitmap, address, size);
+		mem_block_bitmap_free(bitmap, new_address, new_size);
+		return;
+	}
+
+	// The lost spans give back their granules. A granule cut by an old bound can become wholly free when the block grows, so the gained spans start a granule back.
+	if (new_address > address) {
+		mem_block_bitmap_take(bitmap, address, new_address - address);
+	}
+
+	if (new_end < end) {
+		mem_block_bitmap_take(bitmap, new_end, end - new_end);
+	}
+
+	if (new_address < address) {
+		mem_address_t gained_end = address + bitmap->granule_size < new_end ? address + bitmap->granule_size : new_end;
+		mem_block_bitmap_free(bitmap, new_address, gained_end - new_address);
+	}
+
+	if (new_end > end) {
+		mem_address_t gained_address = end > new_address + bitmap->granule_size ? end - bitmap->granule_size : new_address;
+		mem_block_bitmap_free(bitmap, gained_address, new_end - gained_address);
+	}
+}
+
+/// <summary>
+/// Gets whether the granule of an address is not wholly free, with a single bit test.
+/// </summary>
+/// <param name="bitmap">The block bitmap.</param>
+/// <param name="address">The address. It must be within the granules of the bitmap.</param>
+/// <returns>Whether the bit of the granule is set.</returns>
+unsigned int mem_block_bitmap_test(const block_bitmap_t* bitmap, mem_address_t address) {
+	unsigned long i_granule = (address - bitmap->first_address) >> bitmap->granule_log2;
+	return (bitmap->words[i_granule / BLOCK_BITMAP_WORD_BITS] >> (i_granule % BLOCK_BITMAP_WORD_BITS)) & 1;
+}
+
+/// <summary>
+/// Gets whether an address is within the granules of the block bitmap.
+/// </summary>
+/// <param name="bitmap">The block bitmap.</param>
+/// <param name="address">The address.</param>
+/// <returns>Whether the address has a bit.</returns>
+unsigned int mem_block_bitmap_contains(const block_bitmap_t* bitmap, mem_address_t address) {
+	return address >= bitmap->first_address && ((address - bitmap->first_address) >> bitmap->granule_log2) < bitmap->granule_count;
+}
+
+/// <summary>
+/// Counts the free bytes of the granules, with a popcount of every word.
+/// </summary>
+/// <param name="bitmap">The block bitmap.</param>
+/// <returns>The count of free granules times the size of a granule.</returns>
+unsigned long mem_block_bitmap_count_free(const block_bitmap_t* bitmap) {
+	// The bits after the last granule are set, so they are never counted.
+	unsigned long i_word, free_granule_count = 0;
+	for (i_word = 0; i_word < bitmap->word_count; i_word++) {
+		free_granule_count += __builtin_popcountl(~bitmap->words[i_word]);
+	}
+
+	return free_granule_count << bitmap->granule_log2;
+}
+
+/// <summary>
+/// Finds the run of free granules with the lowest address that holds count granules.
+/// Full words are skipped with the summary. The runs within a word are found with shifts of the whole word, and the runs across words by counting its leading and trailing free bits.
+/// </summary>
+/// <param name="bitmap">The block bitmap.</param>
+/// <param name="count">The count of granules. This cannot be 0.</param>
+/// <param name="step_count">The count to which to add the words visited.</param>
+/// <param name="address">The out argument for the address of the run.</param>
+/// <returns>The state code. OUT_OF_MEMORY_ERRNO if no run is long enough.</returns>
+int mem_block_bitmap_find(const block_bitmap_t* bitmap, unsigned long count, unsigned long* step_count, mem_address_t* address) {
+	if (bitmap == NULL || !count || step_count == NULL || address == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	unsigned long i_word = 0, run_start = 0, run_length = 0;
+	while (i_word < bitmap->word_count) {
+		(*step_count)++;
+		unsigned long free_bits = ~bitmap->words[i_word];
+		if (!free_bits) {
+			// Jump to the next word that is not full, a summary word at a time.
+			run_length = 0;
+			unsigned long i_summary = i_word / BLOCK_BITMAP_WORD_BITS;
+			unsigned long not_full = ~bitmap->summary[i_summary] & (~0UL << (i_word % BLOCK_BITMAP_WORD_BITS));
+			while (!not_full && ++i_summary < bitmap->summary_count) {
+				(*step_count)++;
+				not_full = ~bitmap->summary[i_summary];
+			}
+
+			if (!not_full) {
+				break;
+			}
+
+			i_word = i_summary * BLOCK_BITMAP_WORD_BITS + __builtin_ctzl(not_full);
+			continue;
+		}
+
+		if (free_bits == ~0UL) {
+			if (!run_length) {
+				run_start = i_word * BLOCK_BITMAP_WORD_BITS;
+			}
+
+			run_length += BLOCK_BITMAP_WORD_BITS;
+		} else {
+			// The run carried from the previous words goes on with the low free bits of the word.
+			if (run_length && run_length + __builtin_ctzl(~free_bits) >= count) {
+				run_length += __builtin_ctzl(~free_bits);
+				break;
+			}
+
+			// A run within the word is found by shifting its free bits onto themselves: bit i stays set only if bits i to i + count - 1 are all free.
+			// Every step doubles the length tested, so it takes log2(count) steps for the whole word at once.
+			if (count <= BLOCK_BITMAP_WORD_BITS) {
+				unsigned long runs = free_bits, tested_length = 1;
+				while (runs && tested_length < count) {
+					unsigned long shift = tested_length < count - tested_length ? tested_length : count - tested_length;
+					runs &= runs >> shift;
+					tested_length += shift;
+				}
+
+				if (runs) {
+					run_start = i_word * BLOCK_BITMAP_WORD_BITS + __builtin_ctzl(runs);
+					run_length = count;
+					break;
+				}
+			}
+
+			// The high free bits of the word start the run carried to the next words.
+			run_length = __builtin_clzl(~free_bits);
+			run_start = (i_word + 1) * BLOCK_BITMAP_WORD_BITS - run_length;
+		}
+
+		if (run_length >= count) {
+			break;
+		}
+
+		i_word++;
+	}
+
+	if (run_length < count) {
+		return OUT_OF_MEMORY_ERRNO;
+	}
+
+	*address = bitmap->first_address + (run_start << bitmap->granule_log2);
+	return SUCCESSFUL_EXEC;
+}
\ No newline at end of file
@@ -0,0 +1,121 @@
+#ifndef MALLOC_BLOCKBITMAP_H
+#define MALLOC_BLOCKBITMAP_H
+
+#include "commons.h"
+
+// Default size of a granule of the block bitmap, in bytes.
+#define BLOCK_BITMAP_DEFAULT_GRANULE_SIZE 16
+
+// Greatest count of granules of a block bitmap with the default granule size. Larger address spaces get larger granules, so the words stay within 16 MiB.
+#define BLOCK_BITMAP_MAXIMUM_DEFAULT_GRANULE_COUNT (1ul << 27)
+
+// Number of granules of a word of the block bitmap.
+#define BLOCK_BITMAP_WORD_BITS 64
+
+// Structure for the free blocks as a bitmap of granules. Bit i is set if granule i is not wholly free.
+// The granules are aligned on their size, so the bytes of the address space before the first granule and after the last are never in the bitmap.
+typedef struct block_bitmap_t {
+	// The address of the first granule, the size of a granule and its log2.
+	mem_address_t first_address;
+	sz_t granule_size;
+	unsigned int granule_log2;
+
+	// The bits of the granules, by word. The bits after the last granule are set.
+	unsigned long* words;
+	unsigned long word_count;
+	unsigned long granule_count;
+
+	// The summary of the words: bit j of summary word i is set if word 64 * i + j is full, so a search skips 64 full words at once.
+	unsigned long* summary;
+	unsigned long summary_count;
+
+	// The count of calls to the C library made to create the bitmap.
+	unsigned long libc_call_count;
+} block_bitmap_t;
+
+/// <summary>
+/// Gets the default granule size of a block bitmap over an address space: BLOCK_BITMAP_DEFAULT_GRANULE_SIZE, doubled until the address space
+/// holds at most BLOCK_BITMAP_MAXIMUM_DEFAULT_GRANULE_COUNT granules.
+/// </summary>
+/// <param name="size">The size of the address space.</param>
+/// <returns>The granule size.</returns>
+sz_t mem_block_bitmap_default_granule_size(sz_t size);
+
+/// <summary>
+/// Initializes a block bitmap over an address space, with all granules not free.
+/// </summary>
+/// <param name="bitmap">The block bitmap to initialize.</param>
+/// <param name="first_address">The first address of the address space.</param>
+/// <param name="size">The size of the address space.</param>
+/// <param name="granule_size">The size of a granule. It must be a power of two.</param>
+/// <returns>The state code.</returns>
+int mem_block_bitmap_init(block_bitmap_t* bitmap, mem_address_t first_address, sz_t size, sz_t granule_size);
+
+/// <summary>
+/// Frees the words of the block bitmap.
+/// </summary>
+/// <param name="bitmap">The block bitmap.</param>
+/// <returns>The state code.</returns>
+int mem_block_bitmap_destroy(block_bitmap_t* bitmap);
+
+/// <summary>
+/// Clears the bits of the granules wholly within a free span of memory.
+/// </summary>
+/// <param name="bitmap">The block bitmap.</param>
+/// <param name="address">The address of the span.</param>
+/// <param name="size">The size of the span.</param>
+void mem_block_bitmap_free(block_bitmap_t* bitmap, mem_address_t address, sz_t size);
+
+/// <summary>
+/// Sets the bits of the granules that a span of memory no longer free touches.
+/// </summary>
+/// <param name="bitmap">The block bitmap.</param>
+/// <param name="address">The address of the span.</param>
+/// <param name="size">The size of the span.</param>
+void mem_block_bitmap_take(block_bitmap_t* bitmap, mem_address_t address, sz_t size);
+
+/// <summary>
+/// Changes the bounds of a free block. Only the bits of the granules gained or lost by the block change.
+/// </summary>
+/// <param name="bitmap">The block bitmap.</param>
+/// <param name="address">The address of the block.</param>
+/// <param name="size">The size of the block.</param>
+/// <param name="new_address">The new address of the block.</param>
+/// <param name="new_size">The new size of the block.</param>
+void mem_block_bitmap_update(block_bitmap_t* bitmap, mem_address_t address, sz_t size, mem_address_t new_address, sz_t new_size);
+
+/// <summary>
+/// Gets whether the granule of an address is not wholly free, with a single bit test.
+/// </summary>
+/// <param name="bitmap">The block bitmap.</param>
+/// <param name="address">The address. It must be within the granules of the bitmap.</param>
+/// <returns>Whether the bit of the granule is set.</returns>
+unsigned int mem_block_bitmap_test(const block_bitmap_t* bitmap, mem_address_t address);
+
+/// <summary>
+/// Gets whether an address is within the granules of the block bitmap.
+/// </summary>
+/// <param name="bitmap">The block bitmap.</param>
+/// <param name="address">The address.</param>
+/// <returns>Whether the address has a bit.</returns>
+unsigned int mem_block_bitmap_contains(const block_bitmap_t* bitmap, mem_address_t address);
+
+/// <summary>
+/// Counts the free bytes of the granules, with a popcount of every word.
+/// </summary>
+/// <param name="bitmap">The block bitmap.</param>
+/// <returns>The count of free granules times the size of a granule.</returns>
+unsigned long mem_block_bitmap_count_free(const block_bitmap_t* bitmap);
+
+/// <summary>
+/// Finds the run of free granules with the lowest address that holds count granules.
+/// Full words are skipped with the summary. The runs within a word are found with shifts of the whole word, and the runs across words by counting its leading and trailing free bits.
+/// </summary>
+/// <param name="bitmap">The block bitmap.</param>
+/// <param name="count">The count of granules. This cannot be 0.</param>
+/// <param name="step_count">The count to which to add the words visited.</param>
+/// <param name="address">The out argument for the address of the run.</param>
+/// <returns>The state code. OUT_OF_MEMORY_ERRNO if no run is long enough.</returns>
+int mem_block_bitmap_find(const block_bitmap_t* bitmap, unsigned long count, unsigned long* step_count, mem_address_t* address);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,810 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <errno.h>
+
+#include "../lib/collections.h"
+#include "../lib/logging.h"
+#include "blocks.h"
+
+/// <summary>
+/// Initializes the free block list and the free block indexes.
+/// </summary>
+/// <param name="free_blocks">The free blocks.</param>
+/// <returns>The state code.</returns>
+int mem_blocks_init(free_blocks_t* free_blocks) {
+	log_debug("Entering mem_blocks_init().");
+	if (free_blocks == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	if (linkedlist_init(&free_blocks->list) != SUCCESSFUL_EXEC) {
+		return COLLECTIONS_ERRNO;
+	}
+
+	int i_bin, i_subbin;
+	for (i_bin = 0; i_bin < FREE_BLOCK_BIN_COUNT; i_bin++) {
+		for (i_subbin = 0; i_subbin < FREE_BLOCK_SUBBIN_COUNT; i_subbin++) {
+			if (linkedlist_init(&free_blocks->bins[i_bin][i_subbin]) != SUCCESSFUL_EXEC) {
+				return COLLECTIONS_ERRNO;
+			}
+		}
+
+		free_blocks->subbin_maps[i_bin] = 0;
+	}
+
+	free_blocks->chunks = NULL;
+	free_blocks->records = NULL;
+	free_blocks->record_count = 0;
+	free_blocks->free_record_count = 0;
+	free_blocks->libc_call_count = 0;
+	free_blocks->bytes = 0;
+	free_blocks->bin_map = 0;
+	free_blocks->is_tree_indexed = 0;
+	free_blocks->is_array_indexed = 0;
+	mem_block_arrays_init(&free_blocks->arrays);
+	free_blocks->is_bitmap_indexed = 0;
+	memset(&free_blocks->bitmap, 0, sizeof(block_bitmap_t));
+	if (avltree_init(&free_blocks->size_tree, &mem_block_compare_size) != SUCCESSFUL_EXEC || 
+		avltree_init(&free_blocks->address_tree, &mem_block_compare_address) != SUCCESSFUL_EXEC || 
+		hashmap_init(&free_blocks->starts, 0) != SUCCESSFUL_EXEC || 
+		hashmap_init(&free_blocks->ends, 0) != SUCCESSFUL_EXEC) {
+		return COLLECTIONS_ERRNO;
+	}
+
+	log_debug("Exiting mem_blocks_init().");
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Frees the pool of free block records, empties the free block list and destroys the free block indexes.
+/// </summary>
+/// <param name="free_blocks">The free blocks.</param>
+/// <returns>The state code.</returns>
+int mem_blocks_destroy(free_blocks_t* free_blocks) {
+	log_debug("Entering mem_blocks_destroy().");
+	if (free_blocks == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	// The nodes of the list, bins and trees are embedded in the records, so they are only reset.
+	linkedlist_init(&free_blocks->list);
+	int i_bin, i_subbin;
+	for (i_bin = 0; i_bin < FREE_BLOCK_BIN_COUNT; i_bin++) {
+		for (i_subbin = 0; i_subbin < FREE_BLOCK_SUBBIN_COUNT; i_subbin++) {
+			linkedlist_init(&free_blocks->bins[i_bin][i_subbin]);
+		}
+
+		free_blocks->subbin_maps[i_bin] = 0;
+	}
+
+	free_blocks->bin_map = 0;
+	free_blocks->bytes = 0;
+	avltree_init(&free_blocks->size_tree, &mem_block_compare_size);
+	avltree_init(&free_blocks->address_tree, &mem_block_compare_address);
+	free_blocks->is_tree_indexed = 0;
+	hashmap_destroy(&free_blocks->starts);
+	hashmap_destroy(&free_blocks->ends);
+	mem_block_arrays_destroy(&free_blocks->arrays);
+	free_blocks->is_array_indexed = 0;
+	mem_block_bitmap_destroy(&free_blocks->bitmap);
+	free_blocks->is_bitmap_indexed = 0;
+
+	// Free all chunks of records.
+	while (free_blocks->chunks != NULL) {
+		block_chunk_t* chunk = free_blocks->chunks;
+		free_blocks->chunks = chunk->next;
+		free(chunk);
+	}
+
+	free_blocks->records = NULL;
+	free_blocks->record_count = 0;
+	free_blocks->free_record_count = 0;
+
+	log_debug("Exiting mem_blocks_destroy().");
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Starts to index the free blocks by the size and address trees as well, for the searches by size and by address. The current free blocks are added.
+/// </summary>
+/// <param name="free_blocks">The free blocks.</param>
+/// <returns>The state code.</returns>
+int mem_blocks_index_trees(free_blocks_t* free_blocks) {
+	log_debug("Entering mem_blocks_index_trees().");
+	if (free_blocks == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	if (free_blocks->is_tree_indexed) {
+		return SUCCESSFUL_EXEC;
+	}
+
+	node_t* node;
+	for (node = free_blocks->list.head; node != NULL; node = node->next) {
+		block_t* block = node->element;
+		block->tree_node.element = block;
+		block->address_node.element = block;
+		if (avltree_link_node(&free_blocks->size_tree, &block->tree_node) != SUCCESSFUL_EXEC || 
+			avltree_link_node(&free_blocks->address_tree, &block->address_node) != SUCCESSFUL_EXEC) {
+			return COLLECTIONS_ERRNO;
+		}
+	}
+
+	free_blocks->is_tree_indexed = 1;
+	log_debug("Exiting mem_blocks_index_trees().");
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Starts to index the free blocks by arrays ordered by address as well, for the searches that scan sizes. The current free blocks are added.
+/// </summary>
+/// <param name="free_blocks">The free blocks.</param>
+/// <returns>The state code.</returns>
+int mem_blocks_index_arrays(free_blocks_t* free_blocks) {
+	log_debug("Entering mem_blocks_index_arrays().");
+	if (free_blocks == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	if (free_blocks->is_array_indexed) {
+		return SUCCESSFUL_EXEC;
+	}
+
+	// The arrays insert every block at its place by address, so the list can be walked in any order.
+	int result;
+	node_t* node;
+	for (node = free_blocks->list.head; node != NULL; node = node->next) {
+		block_t* block = node->element;
+		if ((result = mem_block_arrays_insert(&free_blocks->arrays, block->pointer.address, block->pointer.size, block)) != SUCCESSFUL_EXEC) {
+			return result;
+		}
+	}
+
+	free_blocks->is_array_indexed = 1;
+	log_debug("Exiting mem_blocks_index_arrays().");
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Starts to index the free blocks by a bitmap of granules as well, for the searches of free runs. The current free blocks are added.
+/// </summary>
+/// <param name="free_blocks">The free blocks.</param>
+/// <param name="first_address">The first address of the address space.</param>
+/// <param name="size">The size of the address space.</param>
+/// <param name="granule_size">The size of a granule. It must be a power of two.</param>
+/// <returns>The state code.</returns>
+int mem_blocks_index_bitmap(free_blocks_t* free_blocks, mem_address_t first_address, sz_t size, sz_t granule_size) {
+	log_debug("Entering mem_blocks_index_bitmap().");
+	if (free_blocks == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	if (free_blocks->is_bitmap_indexed) {
+		return SUCCESSFUL_EXEC;
+	}
+
+	int result = mem_block_bitmap_init(&free_blocks->bitmap, first_address, size, granule_size);
+	if (result != SUCCESSFUL_EXEC) {
+		return result;
+	}
+
+	node_t* node;
+	for (node = free_blocks->list.head; node != NULL; node = node->next) {
+		mem_block_bitmap_free(&free_blocks->bitmap, ((block_t*) node->element)->pointer.address, ((block_t*) node->element)->pointer.size);
+	}
+
+	free_blocks->is_bitmap_indexed = 1;
+	log_debug("Exiting mem_blocks_index_bitmap().");
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Grows the pool of free block records by a chunk of records.
+/// The address maps grow with the pool, so they never grow while a record is in use.
+/// </summary>
+/// <param name="free_blocks">The free blocks.</param>
+/// <returns>The state code. OUT_OF_MEMORY_ERRNO if the chunk or the address maps cannot be allocated.</returns>
+static int mem_block_pool_grow(free_blocks_t* free_blocks) {
+	log_trace("Growing the pool of free block records. record_count: %u.", free_blocks->record_count);
+	block_chunk_t* chunk = malloc(sizeof(block_chunk_t));
+	free_blocks->libc_call_count++;
+	if (chunk == NULL) {
+		return OUT_OF_MEMORY_ERRNO;
+	}
+
+	// A map that grows allocates its new entries and frees its old ones.
+	// If a map cannot hold the new records, the chunk is given back, so no record is ever used without its entries.
+	unsigned int starts_capacity = free_blocks->starts.capacity, ends_capacity = free_blocks->ends.capacity;
+	int result = hashmap_reserve(&free_blocks->starts, free_blocks->record_count + FREE_BLOCK_POOL_CHUNK_SIZE);
+	if (result == SUCCESSFUL_EXEC) {
+		result = hashmap_reserve(&free_blocks->ends, free_blocks->record_count + FREE_BLOCK_POOL_CHUNK_SIZE);
+	}
+
+	free_blocks->libc_call_count += (free_blocks->starts.capacity != starts_capacity ? 2 : 0) + (free_blocks->ends.capacity != ends_capacity ? 2 : 0);
+	if (result != SUCCESSFUL_EXEC) {
+		log_trace("The address maps could not grow with the pool. Result: %d.", result);
+		free(chunk);
+		free_blocks->libc_call_count++;
+		return OUT_OF_MEMORY_ERRNO;
+	}
+
+	chunk->next = free_blocks->chunks;
+	free_blocks->chunks = chunk;
+	int i_record;
+	for (i_record = 0; i_record < FREE_BLOCK_POOL_CHUNK_SIZE; i_record++) {
+		chunk->records[i_record].next_record = i_record + 1 < FREE_BLOCK_POOL_CHUNK_SIZE ? &chunk->records[i_record + 1] : free_blocks->records;
+	}
+
+	free_blocks->records = &chunk->records[0];
+	free_blocks->record_count += FREE_BLOCK_POOL_CHUNK_SIZE;
+	free_blocks->free_record_count += FREE_BLOCK_POOL_CHUNK_SIZE;
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Grows the pool of free block records until it holds at least count unused records, so the next count inserts do not run out of records.
+/// </summary>
+/// <param name="free_blocks">The free blocks.</param>
+/// <param name="count">The count of records to reserve.</param>
+/// <returns>The state code. OUT_OF_MEMORY_ERRNO if the pool cannot grow.</returns>
+int mem_blocks_reserve(free_blocks_t* free_blocks, unsigned int count) {
+	if (free_blocks == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	int result;
+	while (free_blocks->free_record_count < count) {
+		if ((result = mem_block_pool_grow(free_blocks)) != SUCCESSFUL_EXEC) {
+			return result;
+		}
+	}
+
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Takes a free block record from the pool. The pool grows by a chunk of records if it is empty,
+/// so its growth and that of the address maps is amortized over a chunk of inserts, unless the records were reserved beforehand.
+/// </summary>
+/// <param name="free_blocks">The free blocks.</param>
+/// <returns>The record, or null if the pool could not grow.</returns>
+static block_t* mem_block_record_take(free_blocks_t* free_blocks) {
+	if (free_blocks->records == NULL && mem_block_pool_grow(free_blocks) != SUCCESSFUL_EXEC) {
+		return NULL;
+	}
+
+	block_t* record = free_blocks->records;
+	free_blocks->records = record->next_record;
+	free_blocks->free_record_count--;
+	return record;
+}
+
+/// <summary>
+/// Gives a free block record back to the pool.
+/// </summary>
+/// <param name="free_blocks">The free blocks.</param>
+/// <param name="record">The record.</param>
+static void mem_block_record_give(free_blocks_t* free_blocks, block_t* record) {
+	record->next_record = free_blocks->records;
+	free_blocks->records = record;
+	free_blocks->free_record_count++;
+}
+
+/// <summary>
+/// Gets the index of the size class bin for the given size.
+/// </summary>
+/// <param name="size">The size of the block. This cannot be 0.</param>
+/// <returns>The index of the bin.</returns>
+unsigned int mem_block_bin_index(sz_t size) {
+	// Index of the most significant bit, i.e. floor(log2(size)).
+	return (sizeof(sz_t) * 8 - 1) - __builtin_clzl(size);
+}
+
+/// <summary>
+/// Gets the indexes of the size class bin and of its sub-bin for the given size.
+/// </summary>
+/// <param name="size">The size of the block. This cannot be 0.</param>
+/// <param name="i_bin">The out argument for the index of the bin.</param>
+/// <param name="i_subbin">The out argument for the index of the sub-bin.</param>
+void mem_block_bin_indexes(sz_t size, unsigned int* i_bin, unsigned int* i_subbin) {
+	// The sub-bin is given by the bits right after the most significant bit.
+	// Bins smaller than the sub-bin count have one size per used sub-bin.
+	*i_bin = mem_block_bin_index(size);
+	if (*i_bin >= FREE_BLOCK_SUBBIN_LOG2) {
+		*i_subbin = (size >> (*i_bin - FREE_BLOCK_SUBBIN_LOG2)) & (FREE_BLOCK_SUBBIN_COUNT - 1);
+	} else {
+		*i_subbin = (size << (FREE_BLOCK_SUBBIN_LOG2 - *i_bin)) & (FREE_BLOCK_SUBBIN_COUNT - 1);
+	}
+}
+
+/// <summary>
+/// Gets the first block of the smallest non-empty sub-bin at or after the given sub-bin.
+/// Sub-bins are ordered by bin, then by sub-bin.
+/// </summary>
+/// <param name="free_blocks">The free blocks.</param>
+/// <param name="i_bin">The index of the bin from which to search.</param>
+/// <param name="i_subbin">The index of the sub-bin from which to search. If it is the sub-bin count, the search starts at the next bin.</param>
+/// <returns>The block, or null if all searched sub-bins are empty.</returns>
+block_t* mem_block_bin_find(free_blocks_t* free_blocks, unsigned int i_bin, unsigned int i_subbin) {
+	if (i_bin >= FREE_BLOCK_BIN_COUNT) {
+		return NULL;
+	}
+
+	// Search the sub-bins of the same bin first, then the first non-empty greater bin.
+	unsigned int subbin_map = i_subbin < FREE_BLOCK_SUBBIN_COUNT ? free_blocks->subbin_maps[i_bin] & (~0u << i_subbin) : 0;
+	if (!subbin_map) {
+		unsigned long bin_map = i_bin + 1 < FREE_BLOCK_BIN_COUNT ? free_blocks->bin_map & (~0ul << (i_bin + 1)) : 0;
+		if (!bin_map) {
+			return NULL;
+		}
+
+		i_bin = __builtin_ctzl(bin_map);
+		subbin_map = free_blocks->subbin_maps[i_bin];
+	}
+
+	return free_blocks->bins[i_bin][__builtin_ctz(subbin_map)].head->element;
+}
+
+/// <summary>
+/// Compares two free blocks by size, then by address.
+/// </summary>
+/// <param name="left">The left block, as a ptr_t.</param>
+/// <param name="right">The right block, as a ptr_t.</param>
+/// <returns>A negative value if left is smaller, 0 if both are equal and a positive value otherwise.</returns>
+int mem_block_compare_size(const void* left, const void* right) {
+	const ptr_t* left_pointer = left;
+	const ptr_t* right_pointer = right;
+	if (left_pointer->size != right_pointer->size) {
+		return left_pointer->size < right_pointer->size ? -1 : 1;
+	}
+
+	if (left_pointer->address != right_pointer->address) {
+		return left_pointer->address < right_pointer->address ? -1 : 1;
+	}
+
+	return 0;
+}
+
+/// <summary>
+/// Compares two free blocks by address.
+/// </summary>
+/// <param name="left">The left block, as a ptr_t.</param>
+/// <param name="right">The right block, as a ptr_t.</param>
+/// <returns>A negative value if left is smaller, 0 if both are equal and a positive value otherwise.</returns>
+int mem_block_compare_address(const void* left, const void* right) {
+	const ptr_t* left_pointer = left;
+	const ptr_t* right_pointer = right;
+	if (left_pointer->address != right_pointer->address) {
+		return left_pointer->address < right_pointer->address ? -1 : 1;
+	}
+
+	return 0;
+}
+
+/// <summary>
+/// Finds the free block with the greatest address that is lower or equal to the given address.
+/// This is O(log n) with the address tree, and O(n) without it.
+/// </summary>
+/// <param name="free_blocks">The free blocks.</param>
+/// <param name="address">The address.</param>
+/// <returns>The block, or null if all free blocks start after the address.</returns>
+block_t* mem_block_floor(free_blocks_t* free_blocks, mem_address_t address) {
+	if (!free_blocks->is_tree_indexed) {
+		block_t* floor_block = NULL;
+		node_t* list_node;
+		for (list_node = free_blocks->list.head; list_node != NULL; list_node = list_node->next) {
+			block_t* block = list_node->element;
+			if (block->pointer.address <= address && (floor_block == NULL || block->pointer.address > floor_block->pointer.address)) {
+				floor_block = block;
+			}
+		}
+
+		return floor_block;
+	}
+
+	// The floor is the block before the first block that starts after the address.
+	treenode_t* node = NULL;
+	if (address + 1 != 0) {
+		ptr_t key = { address + 1, 0, 0 };
+		avltree_lower_bound(&free_blocks->address_tree, &key, &node);
+	}
+
+	if (node != NULL) {
+		node = avltree_previous(node);
+	} else {
+		avltree_last(&free_blocks->address_tree, &node);
+	}
+
+	return node != NULL ? node->element : NULL;
+}
+
+/// <summary>
+/// Finds the greatest free block. This is O(log n) with the size tree, and otherwise a walk of the highest sub-bin that is not empty.
+/// </summary>
+/// <param name="free_blocks">The free blocks.</param>
+/// <returns>The block, or null if there is no free block.</returns>
+block_t* mem_block_greatest(free_blocks_t* free_blocks) {
+	if (free_blocks->is_tree_indexed) {
+		treenode_t* node;
+		avltree_last(&free_blocks->size_tree, &node);
+		return node != NULL ? node->element : NULL;
+	}
+
+	// Sub-bins are ordered by size, so the greatest block is in the highest one, which is not ordered itself.
+	if (!free_blocks->bin_map) {
+		return NULL;
+	}
+
+	unsigned int i_bin = FREE_BLOCK_BIN_COUNT - 1 - __builtin_clzl(free_blocks->bin_map);
+	unsigned int i_subbin = 8 * sizeof(unsigned int) - 1 - __builtin_clz(free_blocks->subbin_maps[i_bin]);
+	block_t* greatest_block = NULL;
+	node_t* node;
+	for (node = free_blocks->bins[i_bin][i_subbin].head; node != NULL; node = node->next) {
+		block_t* block = node->element;
+		if (greatest_block == NULL || block->pointer.size > greatest_block->pointer.size) {
+			greatest_block = block;
+		}
+	}
+
+	return greatest_block;
+}
+
+/// <summary>
+/// Adds a free block to the size class sub-bin of its current size.
+/// </summary>
+/// <param name="free_blocks">The free blocks.</param>
+/// <param name="block">The block to add.</param>
+/// <returns>The state code.</returns>
+static int mem_block_bin_add(free_blocks_t* free_blocks, block_t* block) {
+	unsigned int i_bin, i_subbin;
+	mem_block_bin_indexes(block->pointer.size, &i_bin, &i_subbin);
+	linkedlist_t* bin = &free_blocks->bins[i_bin][i_subbin];
+	block->bin_node.element = block;
+	if (linkedlist_link_node(bin, bin->head, &block->bin_node) != SUCCESSFUL_EXEC) {
+		return COLLECTIONS_ERRNO;
+	}
+
+	free_blocks->subbin_maps[i_bin] |= (1u << i_subbin);
+	free_blocks->bin_map |= (1ul << i_bin);
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Removes a free block from the size class sub-bin of its current size.
+/// </summary>
+/// <param name="free_blocks">The free blocks.</param>
+/// <param name="block">The block to remove.</param>
+/// <returns>The state code.</returns>
+static int mem_block_bin_remove(free_blocks_t* free_blocks, block_t* block) {
+	unsigned int i_bin, i_subbin;
+	mem_block_bin_indexes(block->pointer.size, &i_bin, &i_subbin);
+	linkedlist_t* bin = &free_blocks->bins[i_bin][i_subbin];
+	if (linkedlist_unlink_node(bin, &block->bin_node) != SUCCESSFUL_EXEC) {
+		return COLLECTIONS_ERRNO;
+	}
+
+	if (bin->length == 0) {
+		free_blocks->subbin_maps[i_bin] &= ~(1u << i_subbin);
+		if (!free_blocks->subbin_maps[i_bin]) {
+			free_blocks->bin_map &= ~(1ul << i_bin);
+		}
+	}
+
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Adds a free block to the indexes of free blocks: its size class bin, the size and address trees if they are kept, the address maps and the free byte count.
+/// If an index fails, the block is left in none of them.
+/// </summary>
+/// <param name="free_blocks">The free blocks.</param>
+/// <param name="block">The block to add.</param>
+/// <returns>The state code.</returns>
+static int mem_block_index(free_blocks_t* free_blocks, block_t* block) {
+	int result = mem_block_bin_add(free_blocks, block);
+	if (result != SUCCESSFUL_EXEC) {
+		return result;
+	}
+
+	// Every index that fails undoes the ones before it, so the block is either fully indexed or not at all.
+	unsigned int is_size_linked = 0, is_address_linked = 0, is_start_put = 0, is_end_put = 0;
+	block->tree_node.element = block;
+	block->address_node.element = block;
+	result = COLLECTIONS_ERRNO;
+	if ((!free_blocks->is_tree_indexed || 
+			((is_size_linked = avltree_link_node(&free_blocks->size_tree, &block->tree_node) == SUCCESSFUL_EXEC) && 
+			(is_address_linked = avltree_link_node(&free_blocks->address_tree, &block->address_node) == SUCCESSFUL_EXEC))) && 
+		(is_start_put = hashmap_put(&free_blocks->starts, block->pointer.address, block) == SUCCESSFUL_EXEC) && 
+		(is_end_put = hashmap_put(&free_blocks->ends, block->pointer.address + block->pointer.size, block) == SUCCESSFUL_EXEC)) {
+		result = free_blocks->is_array_indexed ? mem_block_arrays_insert(&free_blocks->arrays, block->pointer.address, block->pointer.size, block) : SUCCESSFUL_EXEC;
+	}
+
+	if (result != SUCCESSFUL_EXEC) {
+		if (is_end_put) {
+			hashmap_remove(&free_blocks->ends, block->pointer.address + block->pointer.size);
+		}
+
+		if (is_start_put) {
+			hashmap_remove(&free_blocks->starts, block->pointer.address);
+		}
+
+		if (is_address_linked) {
+			avltree_unlink_node(&free_blocks->address_tree, &block->address_node);
+		}
+
+		if (is_size_linked) {
+			avltree_unlink_node(&free_blocks->size_tree, &block->tree_node);
+		}
+
+		mem_block_bin_remove(free_blocks, block);
+		return result;
+	}
+
+	if (free_blocks->is_bitmap_indexed) {
+		mem_block_bitmap_free(&free_blocks->bitmap, block->pointer.address, block->pointer.size);
+	}
+
+	free_blocks->bytes += block->pointer.size;
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Removes a free block from the indexes of free blocks: its size class bin, the size and address trees if they are kept, the address maps and the free byte count.
+/// </summary>
+/// <param name="free_blocks">The free blocks.</param>
+/// <param name="block">The block to remove.</param>
+/// <returns>The state code.</returns>
+static int mem_block_unindex(free_blocks_t* free_blocks, block_t* block) {
+	int result = mem_block_bin_remove(free_blocks, block);
+	if (result != SUCCESSFUL_EXEC) {
+		return result;
+	}
+
+	if ((free_blocks->is_tree_indexed && (avltree_unlink_node(&free_blocks->size_tree, &block->tree_node) != SUCCESSFUL_EXEC || 
+		avltree_unlink_node(&free_blocks->address_tree, &block->address_node) != SUCCESSFUL_EXEC)) || 
+		hashmap_remove(&free_blocks->starts, block->pointer.address) != SUCCESSFUL_EXEC || 
+		hashmap_remove(&free_blocks->ends, block->pointer.address + block->pointer.size) != SUCCESSFUL_EXEC) {
+		return COLLECTIONS_ERRNO;
+	}
+
+	if (free_blocks->is_array_indexed && (result = mem_block_arrays_remove(&free_blocks->arrays, block->pointer.address)) != SUCCESSFUL_EXEC) {
+		return result;
+	}
+
+	if (free_blocks->is_bitmap_indexed) {
+		mem_block_bitmap_take(&free_blocks->bitmap, block->pointer.address, block->pointer.size);
+	}
+
+	free_blocks->bytes -= block->pointer.size;
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Creates a free block and inserts it into the free block list and the free block indexes.
+/// </summary>
+/// <param name="free_blocks">The free blocks.</param>
+/// <param name="next">The node before which to insert in the free block list. If null, the block is inserted at the tail.</param>
+/// <param name="address">The address of the block.</param>
+/// <param name="size">The size of the block.</param>
+/// <param name="block">The out argument for the created block. This can be null.</param>
+/// <returns>The state code.</returns>
+int mem_block_insert(free_blocks_t* free_blocks, node_t* next, mem_address_t address, sz_t size, block_t** block) {
+	log_debug("Entering mem_block_insert(). Address value: %lu, Size value: %lu.", address, size);
+	if (free_blocks == NULL || !size) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	block_t* new_block = mem_block_record_take(free_blocks);
+	if (new_block == NULL) {
+		return OUT_OF_MEMORY_ERRNO;
+	}
+
+	new_block->pointer.address = address;
+	new_block->pointer.size = size;
+	new_block->pointer.is_allocated = 0;
+	new_block->list_node.element = new_block;
+	if (linkedlist_link_node(&free_blocks->list, next, &new_block->list_node) != SUCCESSFUL_EXEC) {
+		mem_block_record_give(free_blocks, new_block);
+		return COLLECTIONS_ERRNO;
+	}
+
+	// A block that cannot be indexed is not a free block, so it leaves the list and its record goes back to the pool.
+	int result = mem_block_index(free_blocks, new_block);
+	if (result != SUCCESSFUL_EXEC) {
+		linkedlist_unlink_node(&free_blocks->list, &new_block->list_node);
+		mem_block_record_give(free_blocks, new_block);
+		return result;
+	}
+
+	if (block != NULL) {
+		*block = new_block;
+	}
+
+	log_debug("Exiting mem_block_insert().");
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Removes a free block from the free block list and the free block indexes, then frees it.
+/// </summary>
+/// <param name="free_blocks">The free blocks.</param>
+/// <param name="block">The block to remove.</param>
+/// <returns>The state code.</returns>
+int mem_block_remove(free_blocks_t* free_blocks, block_t* block) {
+	log_debug("Entering mem_block_remove().");
+	if (free_blocks == NULL || block == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	int result = mem_block_unindex(free_blocks, block);
+	if (result != SUCCESSFUL_EXEC) {
+		return result;
+	}
+
+	if (linkedlist_unlink_node(&free_blocks->list, &block->list_node) != SUCCESSFUL_EXEC) {
+		return COLLECTIONS_ERRNO;
+	}
+
+	mem_block_record_give(free_blocks, block);
+
+	log_debug("Exiting mem_block_remove().");
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Changes the bounds of a free block and updates the free block indexes.
+/// The block keeps its position in the free block list.
+/// </summary>
+/// <param name="free_blocks">The free blocks.</param>
+/// <param name="block">The block to resize.</param>
+/// <param name="address">The new address of the block.</param>
+/// <param name="size">The new size of the block. This cannot be 0.</param>
+/// <returns>The state code.</returns>
+int mem_block_resize(free_blocks_t* free_blocks, block_t* block, mem_address_t address, sz_t size) {
+	log_debug("Entering mem_block_resize(). Address value: %lu, Size value: %lu.", address, size);
+	if (block == NULL || !size) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	// The block only changes bin if its size class changed, but its key in the size tree always changes.
+	// Free blocks never overlap, so the block keeps its place in the address tree.
+	int result;
+	unsigned int i_bin, i_subbin, i_new_bin, i_new_subbin;
+	mem_block_bin_indexes(block->pointer.size, &i_bin, &i_subbin);
+	mem_block_bin_indexes(size, &i_new_bin, &i_new_subbin);
+	unsigned int is_rebinned = i_bin != i_new_bin || i_subbin != i_new_subbin;
+	if (is_rebinned && (result = mem_block_bin_remove(free_blocks, block)) != SUCCESSFUL_EXEC) {
+		return result;
+	}
+
+	if (free_blocks->is_tree_indexed && avltree_unlink_node(&free_blocks->size_tree, &block->tree_node) != SUCCESSFUL_EXEC) {
+		return COLLECTIONS_ERRNO;
+	}
+
+	if (block->pointer.address != address) {
+		if (hashmap_remove(&free_blocks->starts, block->pointer.address) != SUCCESSFUL_EXEC || 
+			hashmap_put(&free_blocks->starts, address, block) != SUCCESSFUL_EXEC) {
+			return COLLECTIONS_ERRNO;
+		}
+	}
+
+	if (block->pointer.address + block->pointer.size != address + size) {
+		if (hashmap_remove(&free_blocks->ends, block->pointer.address + block->pointer.size) != SUCCESSFUL_EXEC || 
+			hashmap_put(&free_blocks->ends, address + size, block) != SUCCESSFUL_EXEC) {
+			return COLLECTIONS_ERRNO;
+		}
+	}
+
+	if (free_blocks->is_array_indexed && (result = mem_block_arrays_update(&free_blocks->arrays, block->pointer.address, address, size)) != SUCCESSFUL_EXEC) {
+		return result;
+	}
+
+	if (free_blocks->is_bitmap_indexed) {
+		mem_block_bitmap_update(&free_blocks->bitmap, block->pointer.address, block->pointer.size, address, size);
+	}
+
+	free_blocks->bytes += (unsigned long) size - block->pointer.size;
+	block->pointer.address = address;
+	block->pointer.size = size;
+	if (is_rebinned && (result = mem_block_bin_add(free_blocks, block)) != SUCCESSFUL_EXEC) {
+		return result;
+	}
+
+	if (free_blocks->is_tree_indexed && avltree_link_node(&free_blocks->size_tree, &block->tree_node) != SUCCESSFUL_EXEC) {
+		return COLLECTIONS_ERRNO;
+	}
+
+	log_debug("Exiting mem_block_resize().");
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Allocates the pointer argument at the start of a free block.
+/// If the block has more memory than required, it is split. Otherwise, it is removed.
+/// </summary>
+/// <param name="free_blocks">The free blocks.</param>
+/// <param name="block">The block from which to allocate. It must be at least as large as the pointer.</param>
+/// <param name="pointer">The pointer into which to allocate.</param>
+/// <returns>The state code.</returns>
+int mem_block_split(free_blocks_t* free_blocks, block_t* block, ptr_t* pointer) {
+	if (free_blocks == NULL || block == NULL || pointer == NULL || block->pointer.size < pointer->size) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	pointer->address = block->pointer.address;
+	if (block->pointer.size > pointer->size) {
+		// The found block has more memory than required, split it.
+		log_trace("Splitting block. block->pointer.address: %lu.", block->pointer.address);
+		return mem_block_resize(free_blocks, block, block->pointer.address + pointer->size, block->pointer.size - pointer->size);
+	}
+
+	// Size matched perfectly. Remove the block from the free blocks.
+	log_trace("Size matched perfectly. block->pointer.address: %lu.", block->pointer.address);
+	return mem_block_remove(free_blocks, block);
+}
+
+/// <summary>
+/// Puts a span of memory back into the free blocks, and merges it with the free blocks right before and after it.
+/// The neighbours are found by address in constant time. If the span merges with none, a new block is inserted.
+/// </summary>
+/// <param name="free_blocks">The free blocks.</param>
+/// <param name="is_address_ordered">Whether a new block is inserted in address order in the free block list, if the address tree is kept. Otherwise, it is inserted at the head.</param>
+/// <param name="address">The address of the span.</param>
+/// <param name="size">The size of the span. This cannot be 0.</param>
+/// <param name="block">The out argument for the free block that holds the span. This can be null.</param>
+/// <returns>The state code.</returns>
+int mem_block_coalesce(free_blocks_t* free_blocks, unsigned int is_address_ordered, mem_address_t address, sz_t size, block_t** block) {
+	log_debug("Entering mem_block_coalesce(). Address value: %lu, Size value: %lu.", address, size);
+	if (free_blocks == NULL || !size) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	// The previous free block ends where the span starts, and the next one starts where the span ends.
+	void* element;
+	hashmap_get(&free_blocks->ends, address, &element);
+	block_t* previous_block = element;
+	hashmap_get(&free_blocks->starts, address + size, &element);
+	block_t* next_block = element;
+
+	int result;
+	block_t* merged_block;
+	if (previous_block != NULL) {
+		// Append the span, then the next block, to the previous block. It keeps its position in the free block list.
+		log_trace("Merging with previous block. previous_block->pointer.address: %lu.", previous_block->pointer.address);
+		sz_t merged_size = previous_block->pointer.size + size;
+		if (next_block != NULL) {
+			merged_size += next_block->pointer.size;
+			if ((result = mem_block_remove(free_blocks, next_block)) != SUCCESSFUL_EXEC) {
+				return result;
+			}
+		}
+
+		merged_block = previous_block;
+		result = mem_block_resize(free_blocks, previous_block, previous_block->pointer.address, merged_size);
+	} else if (next_block != NULL) {
+		// Prepend the span to the next block. It keeps its position in the free block list.
+		log_trace("Merging with next block. next_block->pointer.address: %lu.", next_block->pointer.address);
+		merged_block = next_block;
+		result = mem_block_resize(free_blocks, next_block, address, next_block->pointer.size + size);
+	} else {
+		// Insert before the first free block after the span, or at the tail if there is none.
+		node_t* next = free_blocks->list.head;
+		if (is_address_ordered && free_blocks->is_tree_indexed) {
+			ptr_t key = { address, size, 0 };
+			treenode_t* next_node;
+			avltree_lower_bound(&free_blocks->address_tree, &key, &next_node);
+			next = next_node != NULL ? &((block_t*) next_node->element)->list_node : NULL;
+		}
+
+		result = mem_block_insert(free_blocks, next, address, size, &merged_block);
+	}
+
+	if (result == SUCCESSFUL_EXEC && block != NULL) {
+		*block = merged_block;
+	}
+
+	log_debug("Exiting mem_block_coalesce().");
+	return result;
+}
\ No newline at end of file
@@ -0,0 +1,248 @@
+#ifndef MALLOC_BLOCKS_H
+#define MALLOC_BLOCKS_H
+
+#include "../lib/collections.h"
+#include "commons.h"
+#include "blockarrays.h"
+#include "blockbitmap.h"
+
+// Number of size class bins. Bin i holds the free blocks whose size is within [2^i, 2^(i+1)).
+#define FREE_BLOCK_BIN_COUNT 64
+
+// Log2 of the number of sub-bins per bin. Sub-bins split the range of a bin in equal parts.
+#define FREE_BLOCK_SUBBIN_LOG2 4
+
+// Number of sub-bins per bin.
+#define FREE_BLOCK_SUBBIN_COUNT (1 << FREE_BLOCK_SUBBIN_LOG2)
+
+// Number of free block records allocated at once when the pool of records is empty.
+#define FREE_BLOCK_POOL_CHUNK_SIZE 1024
+
+// Structure for a free block.
+// The pointer must stay the first member: elements of the free block list can then be read as ptr_t.
+// The nodes of the free block list and of the indexes are embedded, so a block is a single record of the pool.
+typedef struct block_t {
+	ptr_t pointer;
+	node_t list_node;
+	node_t bin_node;
+	treenode_t tree_node;
+	treenode_t address_node;
+	struct block_t* next_record;
+} block_t;
+
+// Structure for a chunk of free block records.
+typedef struct block_chunk_t {
+	struct block_chunk_t* next;
+	block_t records[FREE_BLOCK_POOL_CHUNK_SIZE];
+} block_chunk_t;
+
+// Structure for the free blocks of a heap: the free block list, its indexes and the pool of its records.
+typedef struct free_blocks_t {
+	// The list of free blocks.
+	linkedlist_t list;
+
+	// The size class bins of free blocks, split in sub-bins.
+	linkedlist_t bins[FREE_BLOCK_BIN_COUNT][FREE_BLOCK_SUBBIN_COUNT];
+
+	// Bitmap of the size class bins that are not empty. Bit i is set if bin i holds at least one block.
+	unsigned long bin_map;
+
+	// Bitmaps of the sub-bins that are not empty. Bit j of bitmap i is set if sub-bin j of bin i holds at least one block.
+	unsigned int subbin_maps[FREE_BLOCK_BIN_COUNT];
+
+	// The tree of free blocks, ordered by size then by address.
+	avltree_t size_tree;
+
+	// The tree of free blocks, ordered by address.
+	avltree_t address_tree;
+
+	// Whether the size and address trees are kept. The strategies that only search the bins leave them empty.
+	unsigned int is_tree_indexed;
+
+	// The map of free blocks by start address.
+	hashmap_t starts;
+
+	// The map of free blocks by end address, i.e. their address plus their size.
+	hashmap_t ends;
+
+	// The count of free bytes, i.e. the sum of the sizes of all free blocks.
+	unsigned long bytes;
+
+	// The free blocks as arrays ordered by address, kept only if they are indexed by arrays.
+	block_arrays_t arrays;
+	unsigned int is_array_indexed;
+
+	// The free blocks as a bitmap of granules, kept only if they are indexed by a bitmap.
+	block_bitmap_t bitmap;
+	unsigned int is_bitmap_indexed;
+
+	// The chunks of free block records.
+	block_chunk_t* chunks;
+
+	// The pool of unused free block records.
+	block_t* records;
+
+	// The count of free block records, used or not, and the count of unused ones.
+	unsigned int record_count;
+	unsigned int free_record_count;
+
+	// The count of calls to the C library made by the free blocks and their indexes, i.e. to grow the pool of records.
+	unsigned long libc_call_count;
+} free_blocks_t;
+
+/// <summary>
+/// Initializes the free block list and the free block indexes.
+/// </summary>
+/// <param name="free_blocks">The free blocks.</param>
+/// <returns>The state code.</returns>
+int mem_blocks_init(free_blocks_t* free_blocks);
+
+/// <summary>
+/// Frees the pool of free block records, empties the free block list and destroys the free block indexes.
+/// </summary>
+/// <param name="free_blocks">The free blocks.</param>
+/// <returns>The state code.</returns>
+int mem_blocks_destroy(free_blocks_t* free_blocks);
+
+/// <summary>
+/// Grows the pool of free block records until it holds at least count unused records, so the next count inserts do not run out of records.
+/// </summary>
+/// <param name="free_blocks">The free blocks.</param>
+/// <param name="count">The count of records to reserve.</param>
+/// <returns>The state code. OUT_OF_MEMORY_ERRNO if the pool cannot grow.</returns>
+int mem_blocks_reserve(free_blocks_t* free_blocks, unsigned int count);
+
+/// <summary>
+/// Starts to index the free blocks by the size and address trees as well, for the searches by size and by address. The current free blocks are added.
+/// </summary>
+/// <param name="free_blocks">The free blocks.</param>
+/// <returns>The state code.</returns>
+int mem_blocks_index_trees(free_blocks_t* free_blocks);
+
+/// <summary>
+/// Starts to index the free blocks by arrays ordered by address as well, for the searches that scan sizes. The current free blocks are added.
+/// </summary>
+/// <param name="free_blocks">The free blocks.</param>
+/// <returns>The state code.</returns>
+int mem_blocks_index_arrays(free_blocks_t* free_blocks);
+
+/// <summary>
+/// Starts to index the free blocks by a bitmap of granules as well, for the searches of free runs. The current free blocks are added.
+/// </summary>
+/// <param name="free_blocks">The free blocks.</param>
+/// <param name="first_address">The first address of the address space.</param>
+/// <param name="size">The size of the address space.</param>
+/// <param name="granule_size">The size of a granule. It must be a power of two.</param>
+/// <returns>The state code.</returns>
+int mem_blocks_index_bitmap(free_blocks_t* free_blocks, mem_address_t first_address, sz_t size, sz_t granule_size);
+
+/// <summary>
+/// Gets the index of the size class bin for the given size.
+/// </summary>
+/// <param name="size">The size of the block. This cannot be 0.</param>
+/// <returns>The index of the bin.</returns>
+unsigned int mem_block_bin_index(sz_t size);
+
+/// <summary>
+/// Gets the indexes of the size class bin and of its sub-bin for the given size.
+/// </summary>
+/// <param name="size">The size of the block. This cannot be 0.</param>
+/// <param name="i_bin">The out argument for the index of the bin.</param>
+/// <param name="i_subbin">The out argument for the index of the sub-bin.</param>
+void mem_block_bin_indexes(sz_t size, unsigned int* i_bin, unsigned int* i_subbin);
+
+/// <summary>
+/// Gets the first block of the smallest non-empty sub-bin at or after the given sub-bin.
+/// Sub-bins are ordered by bin, then by sub-bin.
+/// </summary>
+/// <param name="free_blocks">The free blocks.</param>
+/// <param name="i_bin">The index of the bin from which to search.</param>
+/// <param name="i_subbin">The index of the sub-bin from which to search. If it is the sub-bin count, the search starts at the next bin.</param>
+/// <returns>The block, or null if all searched sub-bins are empty.</returns>
+block_t* mem_block_bin_find(free_blocks_t* free_blocks, unsigned int i_bin, unsigned int i_subbin);
+
+/// <summary>
+/// Compares two free blocks by size, then by address.
+/// </summary>
+/// <param name="left">The left block, as a ptr_t.</param>
+/// <param name="right">The right block, as a ptr_t.</param>
+/// <returns>A negative value if left is smaller, 0 if both are equal and a positive value otherwise.</returns>
+int mem_block_compare_size(const void* left, const void* right);
+
+/// <summary>
+/// Compares two free blocks by address.
+/// </summary>
+/// <param name="left">The left block, as a ptr_t.</param>
+/// <param name="right">The right block, as a ptr_t.</param>
+/// <returns>A negative value if left is smaller, 0 if both are equal and a positive value otherwise.</returns>
+int mem_block_compare_address(const void* left, const void* right);
+
+/// <summary>
+/// Finds the free block with the greatest address that is lower or equal to the given address.
+/// This is O(log n) with the address tree, and O(n) without it.
+/// </summary>
+/// <param name="free_blocks">The free blocks.</param>
+/// <param name="address">The address.</param>
+/// <returns>The block, or null if all free blocks start after the address.</returns>
+block_t* mem_block_floor(free_blocks_t* free_blocks, mem_address_t address);
+
+/// <summary>
+/// Finds the greatest free block. This is O(log n) with the size tree, and otherwise a walk of the highest sub-bin that is not empty.
+/// </summary>
+/// <param name="free_blocks">The free blocks.</param>
+/// <returns>The block, or null if there is no free block.</returns>
+block_t* mem_block_greatest(free_blocks_t* free_blocks);
+
+/// <summary>
+/// Creates a free block from the pool of records and inserts it into the free block list and the free block indexes.
+/// </summary>
+/// <param name="free_blocks">The free blocks.</param>
+/// <param name="next">The node before which to insert in the free block list. If null, the block is inserted at the tail.</param>
+/// <param name="address">The address of the block.</param>
+/// <param name="size">The size of the block.</param>
+/// <param name="block">The out argument for the created block. This can be null.</param>
+/// <returns>The state code.</returns>
+int mem_block_insert(free_blocks_t* free_blocks, node_t* next, mem_address_t address, sz_t size, block_t** block);
+
+/// <summary>
+/// Removes a free block from the free block list and the free block indexes, then gives its record back to the pool.
+/// </summary>
+/// <param name="free_blocks">The free blocks.</param>
+/// <param name="block">The block to remove.</param>
+/// <returns>The state code.</returns>
+int mem_block_remove(free_blocks_t* free_blocks, block_t* block);
+
+/// <summary>
+/// Changes the bounds of a free block and updates the free block indexes.
+/// The block keeps its position in the free block list.
+/// </summary>
+/// <param name="free_blocks">The free blocks.</param>
+/// <param name="block">The block to resize.</param>
+/// <param name="address">The new address of the block.</param>
+/// <param name="size">The new size of the block. This cannot be 0.</param>
+/// <returns>The state code.</returns>
+int mem_block_resize(free_blocks_t* free_blocks, block_t* block, mem_address_t address, sz_t size);
+
+/// <summary>
+/// Allocates the pointer argument at the start of a free block.
+/// If the block has more memory than required, it is split. Otherwise, it is removed.
+/// </summary>
+/// <param name="free_blocks">The free blocks.</param>
+/// <param name="block">The block from which to allocate. It must be at least as large as the pointer.</param>
+/// <param name="pointer">The pointer into which to allocate.</param>
+/// <returns>The state code.</returns>
+int mem_block_split(free_blocks_t* free_blocks, block_t* block, ptr_t* pointer);
+
+/// <summary>
+/// Puts a span of memory back into the free blocks, and merges it with the free blocks right before and after it.
+/// The neighbours are found by address in constant time. If the span merges with none, a new block is inserted.
+/// </summary>
+/// <param name="free_blocks">The free blocks.</param>
+/// <param name="is_address_ordered">Whether a new block is inserted in address order in the free block list, if the address tree is kept. Otherwise, it is inserted at the head.</param>
+/// <param name="address">The address of the span.</param>
+/// <param name="size">The size of the span. This cannot be 0.</param>
+/// <param name="block">The out argument for the free block that holds the span. This can be null.</param>
+/// <returns>The state code.</returns>
+int mem_block_coalesce(free_blocks_t* free_blocks, unsigned int is_address_ordered, mem_address_t address, sz_t size, block_t** block);
+
+#endif
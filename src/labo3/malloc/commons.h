@@ -17,7 +17,10 @@ extern const int OUT_OF_MEMORY_ERRNO;
 typedef unsigned long mem_address_t;
 
 // Structure for the size of a memory address.
-typedef unsigned int sz_t;
+typedef unsigned long sz_t;
+
+// Greatest size of a memory address.
+#define SZ_MAX ((sz_t) ~0ul)
 
 // Structure for a memory pointer.
 typedef struct ptr_t {
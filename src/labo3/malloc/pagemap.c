@@ -0,0 +1,270 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <errno.h>
+
+#include "../lib/logging.h"
+#include "pagemap.h"
+
+// Masks of the bits of each level, once shifted.
+#define PAGE_MAP_NODE_MASK ((1 << PAGE_MAP_NODE_BITS) - 1)
+#define PAGE_MAP_LEAF_MASK ((1 << PAGE_MAP_LEAF_BITS) - 1)
+
+/// <summary>
+/// Initializes an empty page map over an address space. Its pages are of PAGE_MAP_DEFAULT_PAGE_BITS bits, doubled until the address space
+/// holds at most PAGE_MAP_MAXIMUM_PAGE_COUNT pages, and its root has as many nodes as the address space needs.
+/// </summary>
+/// <param name="page_map">The page map to initialize.</param>
+/// <param name="first_address">The first address of the address space. Offsets are taken from it.</param>
+/// <param name="size">The size of the address space.</param>
+/// <returns>The state code.</returns>
+int mem_page_map_init(page_map_t* page_map, mem_address_t first_address, sz_t size) {
+	log_debug("Entering mem_page_map_init(). First address: %lu, Size: %lu.", first_address, size);
+	if (page_map == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	sz_t last_offset = size ? size - 1 : 0;
+	page_map->first_address = first_address;
+	page_map->page_bits = PAGE_MAP_DEFAULT_PAGE_BITS;
+	while (last_offset >> page_map->page_bits >= PAGE_MAP_MAXIMUM_PAGE_COUNT) {
+		page_map->page_bits++;
+	}
+
+	page_map->node_count = (last_offset >> (page_map->page_bits + PAGE_MAP_LEAF_BITS + PAGE_MAP_NODE_BITS)) + 1;
+	memset(page_map->free_pages, 0, sizeof(page_map->free_pages));
+	page_map->slabs = NULL;
+	page_map->libc_call_count = 1;
+	if ((page_map->nodes = calloc(page_map->node_count, sizeof(page_map_node_t*))) == NULL) {
+		return OUT_OF_MEMORY_ERRNO;
+	}
+
+	log_debug("Exiting mem_page_map_init().");
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Frees the root, nodes, leaves and slabs of descriptors of the page map.
+/// </summary>
+/// <param name="page_map">The page map.</param>
+/// <returns>The state code.</returns>
+int mem_page_map_destroy(page_map_t* page_map) {
+	log_debug("Entering mem_page_map_destroy().");
+	if (page_map == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	unsigned long i_node;
+	unsigned int i_leaf;
+	for (i_node = 0; page_map->nodes != NULL && i_node < page_map->node_count; i_node++) {
+		page_map_node_t* node = page_map->nodes[i_node];
+		if (node == NULL) {
+			continue;
+		}
+
+		for (i_leaf = 0; i_leaf < (1 << PAGE_MAP_NODE_BITS); i_leaf++) {
+			free(node->leaves[i_leaf]);
+		}
+
+		free(node);
+	}
+
+	// The descriptors, used or not, are all within the slabs.
+	while (page_map->slabs != NULL) {
+		page_map_slab_t* slab = page_map->slabs;
+		page_map->slabs = slab->next;
+		free(slab);
+	}
+
+	memset(page_map->free_pages, 0, sizeof(page_map->free_pages));
+
+	free(page_map->nodes);
+	page_map->nodes = NULL;
+
+	log_debug("Exiting mem_page_map_destroy().");
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Finds the first block of a page whose offset within the page is not lower than the given offset.
+/// </summary>
+/// <param name="page">The descriptor of the page.</param>
+/// <param name="offset">The offset within the page.</param>
+/// <returns>The index of the block, or the count of blocks if there is none.</returns>
+static unsigned int mem_page_map_search(const page_map_page_t* page, sz_t offset) {
+	unsigned int i_low = 0, i_high = page->count;
+	while (i_low < i_high) {
+		unsigned int i_middle = (i_low + i_high) / 2;
+		if (page->entries[i_middle].offset < offset) {
+			i_low = i_middle + 1;
+		} else {
+			i_high = i_middle;
+		}
+	}
+
+	return i_low;
+}
+
+/// <summary>
+/// Takes an unused descriptor from the pool of a capacity class. If the pool is empty, a slab of descriptors of that class is created first.
+/// </summary>
+/// <param name="page_map">The page map.</param>
+/// <param name="i_class">The capacity class.</param>
+/// <returns>The descriptor, with no block, or null if the slab could not be allocated.</returns>
+static page_map_page_t* mem_page_map_page_take(page_map_t* page_map, unsigned int i_class) {
+	if (page_map->free_pages[i_class] == NULL) {
+		unsigned int capacity = PAGE_MAP_PAGE_INITIAL_CAPACITY << i_class;
+		sz_t descriptor_size = sizeof(page_map_page_t) + capacity * sizeof(page_map_entry_t);
+		sz_t descriptor_count = descriptor_size < PAGE_MAP_SLAB_SIZE ? PAGE_MAP_SLAB_SIZE / descriptor_size : 1;
+		page_map->libc_call_count++;
+		page_map_slab_t* slab = malloc(sizeof(page_map_slab_t) + descriptor_count * descriptor_size);
+		if (slab == NULL) {
+			return NULL;
+		}
+
+		slab->next = page_map->slabs;
+		page_map->slabs = slab;
+		sz_t i_descriptor;
+		for (i_descriptor = 0; i_descriptor < descriptor_count; i_descriptor++) {
+			page_map_page_t* page = (page_map_page_t*) ((char*) slab->descriptors + i_descriptor * descriptor_size);
+			page->capacity = capacity;
+			page->next_page = page_map->free_pages[i_class];
+			page_map->free_pages[i_class] = page;
+		}
+	}
+
+	page_map_page_t* page = page_map->free_pages[i_class];
+	page_map->free_pages[i_class] = page->next_page;
+	page->count = 0;
+	return page;
+}
+
+/// <summary>
+/// Gives a descriptor back to the pool of its capacity class.
+/// </summary>
+/// <param name="page_map">The page map.</param>
+/// <param name="page">The descriptor.</param>
+static void mem_page_map_page_give(page_map_t* page_map, page_map_page_t* page) {
+	unsigned int i_class = __builtin_ctz(page->capacity / PAGE_MAP_PAGE_INITIAL_CAPACITY);
+	page->next_page = page_map->free_pages[i_class];
+	page_map->free_pages[i_class] = page;
+}
+
+/// <summary>
+/// Sets the size of the block that starts at an address. The missing node and leaf of the address are created,
+/// and its descriptor is taken from the pool of its capacity class, or moved to the next class when it is full.
+/// </summary>
+/// <param name="page_map">The page map.</param>
+/// <param name="address">The address of the block. It must be within the address space.</param>
+/// <param name="size">The size of the block, or 0 if no block starts there anymore.</param>
+/// <returns>The state code.</returns>
+int mem_page_map_set(page_map_t* page_map, mem_address_t address, sz_t size) {
+	if (page_map == NULL || address < page_map->first_address || (address - page_map->first_address) >> (page_map->page_bits + PAGE_MAP_LEAF_BITS + PAGE_MAP_NODE_BITS) >= page_map->node_count) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	sz_t offset = address - page_map->first_address;
+	page_map_node_t** node = &page_map->nodes[offset >> (page_map->page_bits + PAGE_MAP_LEAF_BITS + PAGE_MAP_NODE_BITS)];
+	if (*node == NULL) {
+		if (!size) {
+			return SUCCESSFUL_EXEC;
+		}
+
+		page_map->libc_call_count++;
+		if ((*node = calloc(1, sizeof(page_map_node_t))) == NULL) {
+			return OUT_OF_MEMORY_ERRNO;
+		}
+	}
+
+	page_map_leaf_t** leaf = &(*node)->leaves[(offset >> (page_map->page_bits + PAGE_MAP_LEAF_BITS)) & PAGE_MAP_NODE_MASK];
+	if (*leaf == NULL) {
+		if (!size) {
+			return SUCCESSFUL_EXEC;
+		}
+
+		page_map->libc_call_count++;
+		if ((*leaf = calloc(1, sizeof(page_map_leaf_t))) == NULL) {
+			return OUT_OF_MEMORY_ERRNO;
+		}
+	}
+
+	page_map_page_t** page = &(*leaf)->pages[(offset >> page_map->page_bits) & PAGE_MAP_LEAF_MASK];
+	sz_t page_offset = offset & (((sz_t) 1 << page_map->page_bits) - 1);
+	unsigned int i_entry = *page != NULL ? mem_page_map_search(*page, page_offset) : 0;
+	if (*page != NULL && i_entry < (*page)->count && (*page)->entries[i_entry].offset == page_offset) {
+		if (size) {
+			(*page)->entries[i_entry].size = size;
+			return SUCCESSFUL_EXEC;
+		}
+
+		// The last block of a page gives its descriptor back to its pool.
+		(*page)->count--;
+		memmove(&(*page)->entries[i_entry], &(*page)->entries[i_entry + 1], ((*page)->count - i_entry) * sizeof(page_map_entry_t));
+		if (!(*page)->count) {
+			mem_page_map_page_give(page_map, *page);
+			*page = NULL;
+		}
+
+		return SUCCESSFUL_EXEC;
+	}
+
+	if (!size) {
+		return SUCCESSFUL_EXEC;
+	}
+
+	// The first block of a page takes a descriptor of the first class, and a full descriptor moves its blocks to one of the next class.
+	if (*page == NULL && (*page = mem_page_map_page_take(page_map, 0)) == NULL) {
+		return OUT_OF_MEMORY_ERRNO;
+	}
+
+	if ((*page)->count == (*page)->capacity) {
+		unsigned int i_class = __builtin_ctz((*page)->capacity / PAGE_MAP_PAGE_INITIAL_CAPACITY) + 1;
+		page_map_page_t* grown_page = i_class < PAGE_MAP_CLASS_COUNT ? mem_page_map_page_take(page_map, i_class) : NULL;
+		if (grown_page == NULL) {
+			return OUT_OF_MEMORY_ERRNO;
+		}
+
+		memcpy(grown_page->entries, (*page)->entries, (*page)->count * sizeof(page_map_entry_t));
+		grown_page->count = (*page)->count;
+		mem_page_map_page_give(page_map, *page);
+		*page = grown_page;
+	}
+
+	memmove(&(*page)->entries[i_entry + 1], &(*page)->entries[i_entry], ((*page)->count - i_entry) * sizeof(page_map_entry_t));
+	(*page)->entries[i_entry] = (page_map_entry_t) { size, page_offset };
+	(*page)->count++;
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Gets the size of the block that starts at an address. The descriptor of its page is found in O(1), then its blocks are searched by offset.
+/// </summary>
+/// <param name="page_map">The page map.</param>
+/// <param name="address">The address.</param>
+/// <returns>The size of the block, or 0 if no block starts at the address.</returns>
+sz_t mem_page_map_get(const page_map_t* page_map, mem_address_t address) {
+	if (page_map == NULL || address < page_map->first_address || (address - page_map->first_address) >> (page_map->page_bits + PAGE_MAP_LEAF_BITS + PAGE_MAP_NODE_BITS) >= page_map->node_count) {
+		return 0;
+	}
+
+	sz_t offset = address - page_map->first_address;
+	const page_map_node_t* node = page_map->nodes[offset >> (page_map->page_bits + PAGE_MAP_LEAF_BITS + PAGE_MAP_NODE_BITS)];
+	if (node == NULL) {
+		return 0;
+	}
+
+	const page_map_leaf_t* leaf = node->leaves[(offset >> (page_map->page_bits + PAGE_MAP_LEAF_BITS)) & PAGE_MAP_NODE_MASK];
+	if (leaf == NULL) {
+		return 0;
+	}
+
+	const page_map_page_t* page = leaf->pages[(offset >> page_map->page_bits) & PAGE_MAP_LEAF_MASK];
+	if (page == NULL) {
+		return 0;
+	}
+
+	sz_t page_offset = offset & (((sz_t) 1 << page_map->page_bits) - 1);
+	unsigned int i_entry = mem_page_map_search(page, page_offset);
+	return i_entry < page->count && page->entries[i_entry].offset == page_offset ? page->entries[i_entry].size : 0;
+}
\ No newline at end of file
@@ -0,0 +1,113 @@
+#ifndef MALLOC_PAGEMAP_H
+#define MALLOC_PAGEMAP_H
+
+#include "commons.h"
+
+// Default bits of the offset of an address, from the first address, within its page.
+#define PAGE_MAP_DEFAULT_PAGE_BITS 12
+
+// Greatest count of pages of an address space. Larger address spaces get larger pages, so the leaves stay within 128 MiB.
+#define PAGE_MAP_MAXIMUM_PAGE_COUNT (1ul << 24)
+
+// Bits of the page of an address resolved by the nodes and by the leaves of the page map. The root has as many nodes as the address space needs.
+#define PAGE_MAP_NODE_BITS 10
+#define PAGE_MAP_LEAF_BITS 10
+
+// Initial capacity of the descriptor of a page, in blocks. It doubles as needed, by moving to a descriptor of the next capacity class.
+#define PAGE_MAP_PAGE_INITIAL_CAPACITY 2
+
+// Count of capacity classes of descriptors. Class i holds PAGE_MAP_PAGE_INITIAL_CAPACITY << i blocks, so the last class holds as many blocks as a capacity can count.
+#define PAGE_MAP_CLASS_COUNT 31
+
+// Size of a slab of descriptors, in bytes. A slab holds at least one descriptor, so the slabs of the largest classes are larger.
+#define PAGE_MAP_SLAB_SIZE (64 * 1024)
+
+// Structure for a block that starts within a page: its offset within the page and its size.
+typedef struct page_map_entry_t {
+	sz_t size;
+	sz_t offset;
+} page_map_entry_t;
+
+// Structure for the descriptor of a page: the blocks that start within the page, ordered by offset.
+// A page with no block has no descriptor, so the page map takes memory by block and not by byte of the address space.
+typedef struct page_map_page_t {
+	unsigned int count;
+	unsigned int capacity;
+
+	// The next descriptor of the pool of unused descriptors of its capacity class.
+	struct page_map_page_t* next_page;
+
+	page_map_entry_t entries[];
+} page_map_page_t;
+
+// Structure for a slab of descriptors, all of the same capacity class. Slabs are only freed with the page map.
+typedef struct page_map_slab_t {
+	struct page_map_slab_t* next;
+
+	// The descriptors, as words so that they are aligned.
+	unsigned long descriptors[];
+} page_map_slab_t;
+
+// Structure for a leaf of the page map: the descriptors of its pages.
+typedef struct page_map_leaf_t {
+	page_map_page_t* pages[1 << PAGE_MAP_LEAF_BITS];
+} page_map_leaf_t;
+
+// Structure for an inner node of the page map.
+typedef struct page_map_node_t {
+	page_map_leaf_t* leaves[1 << PAGE_MAP_NODE_BITS];
+} page_map_node_t;
+
+// Structure for a radix page map from the address of an allocated block to its size.
+// Nodes and leaves are only created for the pages where blocks were allocated, and descriptors only for the pages where blocks start.
+typedef struct page_map_t {
+	mem_address_t first_address;
+	unsigned int page_bits;
+	page_map_node_t** nodes;
+	unsigned long node_count;
+
+	// The pools of unused descriptors, by capacity class. Descriptors are carved from slabs, and go back to their pool when they are emptied or outgrown,
+	// so once the slabs hold enough descriptors, setting and clearing blocks does not call the C library.
+	page_map_page_t* free_pages[PAGE_MAP_CLASS_COUNT];
+	page_map_slab_t* slabs;
+
+	// The count of calls to the C library made to create the root, nodes, leaves and slabs.
+	unsigned long libc_call_count;
+} page_map_t;
+
+/// <summary>
+/// Initializes an empty page map over an address space. Its pages are of PAGE_MAP_DEFAULT_PAGE_BITS bits, doubled until the address space
+/// holds at most PAGE_MAP_MAXIMUM_PAGE_COUNT pages, and its root has as many nodes as the address space needs.
+/// </summary>
+/// <param name="page_map">The page map to initialize.</param>
+/// <param name="first_address">The first address of the address space. Offsets are taken from it.</param>
+/// <param name="size">The size of the address space.</param>
+/// <returns>The state code.</returns>
+int mem_page_map_init(page_map_t* page_map, mem_address_t first_address, sz_t size);
+
+/// <summary>
+/// Frees the root, nodes, leaves and slabs of descriptors of the page map.
+/// </summary>
+/// <param name="page_map">The page map.</param>
+/// <returns>The state code.</returns>
+int mem_page_map_destroy(page_map_t* page_map);
+
+/// <summary>
+/// Sets the size of the block that starts at an address. The missing node and leaf of the address are created,
+/// and its descriptor is taken from the pool of its capacity class, or moved to the next class when it is full.
+/// </summary>
+/// <param name="page_map">The page map.</param>
+/// <param name="address">The address of the block. It must be within the address space.</param>
+/// <param name="size">The size of the block, or 0 if no block starts there anymore.</param>
+/// <returns>The state code.</returns>
+int mem_page_map_set(page_map_t* page_map, mem_address_t address, sz_t size);
+
+/// <summary>
+/// Gets the size of the block that starts at an address. The descriptor of its page is found in O(1), then its blocks are searched by offset.
+/// </summary>
+/// <param name="page_map">The page map.</param>
+/// <param name="address">The address.</param>
+/// <returns>The size of the block, or 0 if no block starts at the address.</returns>
+sz_t mem_page_map_get(const page_map_t* page_map, mem_address_t address);
+
+#endif
\ No newline at end of file
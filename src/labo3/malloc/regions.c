@@ -0,0 +1,214 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <errno.h>
+
+#include "../lib/logging.h"
+#include "regions.h"
+
+#define true 1
+#define false 0
+
+/// <summary>
+/// Takes a chunk of at least size bytes from the allocator and appends it to the chunks of a region.
+/// The array of chunks is doubled when it is full.
+/// </summary>
+/// <param name="region">The region.</param>
+/// <param name="size">The size of the chunk.</param>
+/// <param name="chunk">The out argument for the chunk.</param>
+/// <returns>The state code.</returns>
+static int mem_region_take_chunk(region_t* region, sz_t size, ptr_t* chunk) {
+	log_trace("Taking region chunk. size: %lu.", size);
+
+	if (region->chunk_count == region->chunk_capacity) {
+		unsigned int capacity = region->chunk_capacity * 2;
+		ptr_t* chunks = realloc(region->chunks, capacity * sizeof(ptr_t));
+		if (chunks == NULL) {
+			return OUT_OF_MEMORY_ERRNO;
+		}
+
+		region->chunks = chunks;
+		region->chunk_capacity = capacity;
+		region->libc_call_count++;
+	}
+
+	int result = mem_allocate_aligned(region->allocator, size, REGION_ALIGNMENT, chunk);
+	if (result != SUCCESSFUL_EXEC) {
+		return result;
+	}
+
+	region->chunks[region->chunk_count++] = *chunk;
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Drops the chunks of a region that a failed batch has freed, so the region only keeps the chunks it still owns.
+/// </summary>
+/// <param name="region">The region.</param>
+/// <param name="i_first">The index of the first chunk of the batch.</param>
+static void mem_region_keep_allocated_chunks(region_t* region, unsigned int i_first) {
+	unsigned int i_chunk, chunk_count = i_first;
+	for (i_chunk = i_first; i_chunk < region->chunk_count; i_chunk++) {
+		if (region->chunks[i_chunk].is_allocated) {
+			region->chunks[chunk_count++] = region->chunks[i_chunk];
+		}
+	}
+
+	region->chunk_count = chunk_count;
+}
+
+/// <summary>
+/// Creates a region over an allocator. Its first chunk is taken from the allocator at once.
+/// </summary>
+/// <param name="region">The region to create.</param>
+/// <param name="allocator">The allocator from which to take the chunks. It must outlive the region.</param>
+/// <param name="chunk_size">The size of a chunk. If 0, REGION_DEFAULT_CHUNK_SIZE is used.</param>
+/// <returns>The state code.</returns>
+int mem_region_create(region_t* region, allocator_t* allocator, sz_t chunk_size) {
+	if (region == NULL || allocator == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	log_debug("Entering mem_region_create(). Chunk size value: %lu.", chunk_size);
+
+	region->chunks = malloc(REGION_INITIAL_CHUNK_CAPACITY * sizeof(ptr_t));
+	if (region->chunks == NULL) {
+		return OUT_OF_MEMORY_ERRNO;
+	}
+
+	region->allocator = allocator;
+	region->chunk_size = chunk_size ? chunk_size : REGION_DEFAULT_CHUNK_SIZE;
+	region->chunk_count = 0;
+	region->chunk_capacity = REGION_INITIAL_CHUNK_CAPACITY;
+	region->allocation_count = 0;
+	region->allocated_bytes = 0;
+	region->libc_call_count = 1;
+
+	ptr_t chunk;
+	int result = mem_region_take_chunk(region, region->chunk_size, &chunk);
+	if (result != SUCCESSFUL_EXEC) {
+		free(region->chunks);
+		region->chunks = NULL;
+		return result;
+	}
+
+	// The strategy can give more than the chunk size, and the cursor can use all of it.
+	region->cursor = chunk.address;
+	region->limit = chunk.address + chunk.size;
+
+	log_debug("Exiting mem_region_create().");
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Frees all the chunks of a region back into its allocator at once. The region cannot be used anymore.
+/// If some chunks cannot be freed, the region keeps them and can be destroyed again.
+/// </summary>
+/// <param name="region">The region.</param>
+/// <returns>The state code.</returns>
+int mem_region_destroy(region_t* region) {
+	if (region == NULL || region->chunks == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	log_debug("Entering mem_region_destroy(). Chunk count value: %u.", region->chunk_count);
+
+	// The chunks that could not be freed are kept, so that the region can be destroyed again.
+	int result = mem_free_batch(region->allocator, region->chunk_count, region->chunks);
+	if (result != SUCCESSFUL_EXEC) {
+		mem_region_keep_allocated_chunks(region, 0);
+		return result;
+	}
+
+	free(region->chunks);
+	region->chunks = NULL;
+	region->chunk_count = 0;
+	region->cursor = region->limit = 0;
+
+	log_debug("Exiting mem_region_destroy().");
+	return result;
+}
+
+/// <summary>
+/// Allocates a memory block of at least size bytes by moving the cursor of the current chunk.
+/// When the current chunk is full, a new chunk is taken from the allocator. A size greater than a chunk gets a chunk of its own.
+/// The allocated memory location will be put into the pointer struct. It must not be freed by the allocator.
+/// </summary>
+/// <param name="region">The region.</param>
+/// <param name="size">The size of the allocation.</param>
+/// <param name="pointer">The pointer into which to allocate.</param>
+/// <returns>The state code.</returns>
+int mem_region_alloc(region_t* region, sz_t size, ptr_t* pointer) {
+	if (region == NULL || region->chunks == NULL || !size || pointer == NULL || size > SZ_MAX - REGION_ALIGNMENT) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	// Every allocation keeps the cursor aligned, so the next one needs no padding.
+	sz_t rounded_size = (size + REGION_ALIGNMENT - 1) & ~(sz_t) (REGION_ALIGNMENT - 1);
+	if (rounded_size > region->limit - region->cursor) {
+		ptr_t chunk;
+		int result;
+
+		// A large allocation would waste the rest of the current chunk, so it takes its own and the cursor stays.
+		if (rounded_size > region->chunk_size) {
+			if ((result = mem_region_take_chunk(region, rounded_size, &chunk)) != SUCCESSFUL_EXEC) {
+				return result;
+			}
+
+			pointer->address = chunk.address;
+			pointer->size = size;
+			pointer->is_allocated = true;
+			region->allocation_count++;
+			region->allocated_bytes += size;
+			return SUCCESSFUL_EXEC;
+		}
+
+		if ((result = mem_region_take_chunk(region, region->chunk_size, &chunk)) != SUCCESSFUL_EXEC) {
+			return result;
+		}
+
+		region->cursor = chunk.address;
+		region->limit = chunk.address + chunk.size;
+	}
+
+	pointer->address = region->cursor;
+	pointer->size = size;
+	pointer->is_allocated = true;
+	region->cursor += rounded_size;
+	region->allocation_count++;
+	region->allocated_bytes += size;
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Frees all the allocations of a region at once. Every chunk but the first is freed back into the allocator with a single batch,
+/// and the cursor goes back to the start of the first chunk. The chunks that cannot be freed stay in the region until it is destroyed.
+/// </summary>
+/// <param name="region">The region.</param>
+/// <returns>The state code.</returns>
+int mem_region_reset(region_t* region) {
+	if (region == NULL || region->chunks == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	log_debug("Entering mem_region_reset(). Chunk count value: %u.", region->chunk_count);
+
+	// The batch sorts the chunks it frees, so the first chunk is left out of it and stays first.
+	// The chunks that could not be freed are kept after it, and the region is still reset.
+	int result = SUCCESSFUL_EXEC;
+	if (region->chunk_count > 1 && (result = mem_free_batch(region->allocator, region->chunk_count - 1, &region->chunks[1])) != SUCCESSFUL_EXEC) {
+		mem_region_keep_allocated_chunks(region, 1);
+	} else {
+		region->chunk_count = 1;
+	}
+
+	region->cursor = region->chunks[0].address;
+	region->limit = region->chunks[0].address + region->chunks[0].size;
+	region->allocation_count = 0;
+	region->allocated_bytes = 0;
+
+	log_debug("Exiting mem_region_reset().");
+	return result;
+}
\ No newline at end of file
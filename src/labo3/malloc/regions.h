@@ -0,0 +1,75 @@
+#ifndef MALLOC_REGIONS_H
+#define MALLOC_REGIONS_H
+
+#include "commons.h"
+#include "allocator.h"
+
+// Default size of a chunk of a region, in bytes.
+#define REGION_DEFAULT_CHUNK_SIZE 65536
+
+// Alignment of the chunks of a region and of every allocation within them.
+#define REGION_ALIGNMENT 16
+
+// Initial capacity of the array of chunks of a region.
+#define REGION_INITIAL_CHUNK_CAPACITY 16
+
+// Structure for a region: chunks taken from an allocator, from which allocations are carved by moving a cursor.
+// The allocations of a region are never freed one by one. They are all freed at once when the region is reset or destroyed.
+typedef struct region_t {
+	allocator_t* allocator;
+	sz_t chunk_size;
+
+	// The chunks taken from the allocator, in the order they were taken. The first chunk is kept by a reset.
+	ptr_t* chunks;
+	unsigned int chunk_count;
+	unsigned int chunk_capacity;
+
+	// The next free address of the current chunk, and the address after its end.
+	mem_address_t cursor;
+	mem_address_t limit;
+
+	// The count of allocations and of bytes allocated since the last reset.
+	unsigned long allocation_count;
+	unsigned long allocated_bytes;
+
+	// The count of calls to the C library made to grow the array of chunks.
+	unsigned long libc_call_count;
+} region_t;
+
+/// <summary>
+/// Creates a region over an allocator. Its first chunk is taken from the allocator at once.
+/// </summary>
+/// <param name="region">The region to create.</param>
+/// <param name="allocator">The allocator from which to take the chunks. It must outlive the region.</param>
+/// <param name="chunk_size">The size of a chunk. If 0, REGION_DEFAULT_CHUNK_SIZE is used.</param>
+/// <returns>The state code.</returns>
+int mem_region_create(region_t* region, allocator_t* allocator, sz_t chunk_size);
+
+/// <summary>
+/// Frees all the chunks of a region back into its allocator at once. The region cannot be used anymore.
+/// If some chunks cannot be freed, the region keeps them and can be destroyed again.
+/// </summary>
+/// <param name="region">The region.</param>
+/// <returns>The state code.</returns>
+int mem_region_destroy(region_t* region);
+
+/// <summary>
+/// Allocates a memory block of at least size bytes by moving the cursor of the current chunk.
+/// When the current chunk is full, a new chunk is taken from the allocator. A size greater than a chunk gets a chunk of its own.
+/// The allocated memory location will be put into the pointer struct. It must not be freed by the allocator.
+/// </summary>
+/// <param name="region">The region.</param>
+/// <param name="size">The size of the allocation.</param>
+/// <param name="pointer">The pointer into which to allocate.</param>
+/// <returns>The state code.</returns>
+int mem_region_alloc(region_t* region, sz_t size, ptr_t* pointer);
+
+/// <summary>
+/// Frees all the allocations of a region at once. Every chunk but the first is freed back into the allocator with a single batch,
+/// and the cursor goes back to the start of the first chunk. The chunks that cannot be freed stay in the region until it is destroyed.
+/// </summary>
+/// <param name="region">The region.</param>
+/// <returns>The state code.</returns>
+int mem_region_reset(region_t* region);
+
+#endif
\ No newline at end of file
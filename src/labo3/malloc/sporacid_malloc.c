@@ -0,0 +1,400 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <dlfcn.h>
+#include <sys/types.h>
+#include <errno.h>
+
+#include "../lib/logging.h"
+#include "commons.h"
+#include "strategies.h"
+#include "allocator.h"
+#include "arenas.h"
+
+#define true 1
+#define false 0
+#define EXPORTED __attribute__((visibility("default")))
+#define DEFAULT_HEAP_SIZE (1u << 30)
+#define DEFAULT_ARENA_COUNT 1
+#define DEFAULT_STRATEGY "first"
+#define MINIMUM_ALIGNMENT 16
+#define HEADER_SIZE sizeof(ptr_t)
+
+// The room taken by the header before the memory, in whole minimum alignments, so every block size stays a multiple of the minimum alignment.
+#define HEADER_ROOM ((HEADER_SIZE + MINIMUM_ALIGNMENT - 1) & ~(size_t) (MINIMUM_ALIGNMENT - 1))
+_Static_assert(HEADER_ROOM >= HEADER_SIZE && HEADER_ROOM % MINIMUM_ALIGNMENT == 0, "The header must fit within whole minimum alignments.");
+
+// The entry points of the C library allocator.
+// The allocator records of the heap are linked to them with --wrap, so they never come from the heap itself.
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t count, size_t size);
+extern void* __libc_realloc(void* pointer, size_t size);
+extern void* __libc_memalign(size_t alignment, size_t size);
+extern void __libc_free(void* pointer);
+
+// Only errors are logged, so that the logs do not change the behaviour of the program.
+unsigned int log_level = ERROR_LVL;
+
+// The buffer size to use for logging.
+const unsigned int LOG_BUFFER_SIZE = 1024;
+
+// Constant for a successful execution.
+const int SUCCESSFUL_EXEC = 0;
+
+// Error number for illegal arguments.
+const int ILLEGAL_ARGUMENTS_ERRNO = 1;
+
+// Error number for the impossibility to allocate memory.
+const int OUT_OF_MEMORY_ERRNO = 2;
+
+// Error number when trying to dequeue an empty queue.
+const int EMPTY_QUEUE_ERRNO = 3;
+
+// Error number when trying to access or modify an out of bound index.
+const int OUT_OF_BOUNDS_ERRNO = 4;
+
+// Error number when trying to modify a null linked list.
+const int NULL_LINKED_LIST_ERRNO = 5;
+
+// Error number when trying to modify a null queue.
+const int NULL_QUEUE_ERRNO = 6;
+
+// Error number for a generic error with collection handling.
+const int COLLECTIONS_ERRNO = 7;
+
+// Error number when trying to modify a null tree.
+const int NULL_TREE_ERRNO = 8;
+
+// Error number when trying to modify a null hash map.
+const int NULL_HASHMAP_ERRNO = 9;
+
+// The mapped heap, split in arenas.
+arenas_t heap;
+
+// Whether the heap was initialized. If not, every request goes to the C library.
+unsigned int is_heap_ready;
+
+// The initialization of the heap, on the first request.
+pthread_once_t heap_once = PTHREAD_ONCE_INIT;
+
+// Whether the calling thread is within the heap. The C library may allocate from there, e.g. for thread specific data, and is then served by itself.
+__thread unsigned int is_within_heap __attribute__((tls_model("initial-exec")));
+
+// The usable size function of the C library, found at the initialization of the heap.
+size_t (*libc_malloc_usable_size)(void* pointer);
+
+// The allocator records of the heap call these instead of malloc, calloc, realloc and free.
+void* __wrap_malloc(size_t size) { return __libc_malloc(size); }
+void* __wrap_calloc(size_t count, size_t size) { return __libc_calloc(count, size); }
+void* __wrap_realloc(void* pointer, size_t size) { return __libc_realloc(pointer, size); }
+void __wrap_free(void* pointer) { __libc_free(pointer); }
+
+/// <summary>
+/// Locks the heap before a fork, so that the child does not inherit a lock held by another thread.
+/// </summary>
+static void heap_lock() {
+	unsigned int i_arena;
+	pthread_mutex_lock(&heap.caches_lock);
+	for (i_arena = 0; i_arena < heap.count; i_arena++) {
+		pthread_mutex_lock(&heap.arenas[i_arena].lock);
+	}
+}
+
+/// <summary>
+/// Unlocks the heap after a fork, in the parent and in the child.
+/// </summary>
+static void heap_unlock() {
+	unsigned int i_arena;
+	for (i_arena = 0; i_arena < heap.count; i_arena++) {
+		pthread_mutex_unlock(&heap.arenas[i_arena].lock);
+	}
+
+	pthread_mutex_unlock(&heap.caches_lock);
+}
+
+/// <summary>
+/// Gets a positive integer from the environment.
+/// </summary>
+/// <param name="name">The name of the variable.</param>
+/// <param name="default_value">The value if the variable is not set or not a positive integer.</param>
+/// <returns>The value.</returns>
+static unsigned long heap_env(const char* name, unsigned long default_value) {
+	const char* value = getenv(name);
+	unsigned long parsed = value != NULL ? strtoul(value, NULL, 10) : 0;
+	return parsed ? parsed : default_value;
+}
+
+/// <summary>
+/// Initializes the heap from the environment:
+/// SPORACID_MALLOC_STRATEGY (first, first-soa, best, worst, next, segregated, buddy, tlsf, bitmap, adaptive), SPORACID_MALLOC_HEAP_SIZE (bytes),
+/// SPORACID_MALLOC_ARENAS and SPORACID_MALLOC_MAGAZINE_CAPACITY (0 by default, so that every request goes through the strategy).
+/// </summary>
+static void heap_init() {
+	const char* strategy_name = getenv("SPORACID_MALLOC_STRATEGY");
+	mem_allocation_strategy_t strategy = mem_allocation_strategy_of_name(strategy_name != NULL ? strategy_name : DEFAULT_STRATEGY);
+	unsigned long arena_count = heap_env("SPORACID_MALLOC_ARENAS", DEFAULT_ARENA_COUNT);
+	unsigned long heap_size = heap_env("SPORACID_MALLOC_HEAP_SIZE", DEFAULT_HEAP_SIZE);
+	const char* magazine_capacity = getenv("SPORACID_MALLOC_MAGAZINE_CAPACITY");
+
+	// Slices are page aligned, so every block is aligned as long as every size is a multiple of the minimum alignment.
+	unsigned long page_size = sysconf(_SC_PAGESIZE);
+	unsigned long slice_size = heap_size / arena_count / page_size * page_size;
+	allocator_options_t options = { .address_space_size = slice_size * arena_count, .is_mapped = true };
+	if (strategy == NULL || !slice_size) {
+		log_error("The heap could not be initialized, so the C library serves every request. Check SPORACID_MALLOC_* variables.");
+		return;
+	}
+
+	int result = mem_arenas_init(&heap, arena_count, ARENA_ASSIGNMENT_ROUND_ROBIN, magazine_capacity != NULL ? atoi(magazine_capacity) : 0, strategy, &options);
+	if (result != SUCCESSFUL_EXEC) {
+		log_error("The heap could not be initialized, so the C library serves every request. mem_arenas_init() returned %d.", result);
+		return;
+	}
+
+	libc_malloc_usable_size = dlsym(RTLD_NEXT, "malloc_usable_size");
+	pthread_atfork(&heap_lock, &heap_unlock, &heap_unlock);
+	is_heap_ready = true;
+}
+
+/// <summary>
+/// Gets whether the heap serves the requests of the calling thread, after initializing it on the first request.
+/// </summary>
+/// <returns>Whether the heap serves the requests.</returns>
+static int heap_is_usable() {
+	if (is_within_heap) {
+		return false;
+	}
+
+	is_within_heap = true;
+	pthread_once(&heap_once, &heap_init);
+	is_within_heap = false;
+	return is_heap_ready;
+}
+
+/// <summary>
+/// Gets whether a pointer was allocated from the heap. Otherwise, it comes from the C library.
+/// </summary>
+/// <param name="pointer">The pointer.</param>
+/// <returns>Whether the pointer is within the heap.</returns>
+static int heap_owns(const void* pointer) {
+	mem_address_t address = (mem_address_t) pointer;
+	return is_heap_ready && address >= heap.first_address && address < heap.first_address + heap.options.address_space_size;
+}
+
+/// <summary>
+/// Gets the header of a pointer of the heap: the block that holds it, right before the pointer.
+/// </summary>
+/// <param name="pointer">The pointer.</param>
+/// <returns>The header.</returns>
+static ptr_t* heap_header(const void* pointer) {
+	return (ptr_t*) ((mem_address_t) pointer - HEADER_SIZE);
+}
+
+/// <summary>
+/// Allocates memory from the heap, with a header that holds its block right before it.
+/// </summary>
+/// <param name="size">The size to allocate.</param>
+/// <param name="alignment">The alignment of the memory. It is a power of two of at least the minimum alignment.</param>
+/// <returns>The memory, or null if the heap is out of memory.</returns>
+static void* heap_allocate(size_t size, size_t alignment) {
+	// A block is aligned on the minimum alignment, so the memory starts at most the header room after it,
+	// plus the slack needed to reach a greater alignment.
+	size_t rounded_size = ((size ? size : 1) + MINIMUM_ALIGNMENT - 1) & ~(size_t) (MINIMUM_ALIGNMENT - 1);
+	size_t total_size = rounded_size + HEADER_ROOM + (alignment - MINIMUM_ALIGNMENT);
+	if (rounded_size < size || total_size < rounded_size || total_size > heap.slice_size) {
+		return NULL;
+	}
+
+	ptr_t block;
+	is_within_heap = true;
+	int result = mem_arenas_allocate(&heap, total_size, &block);
+	is_within_heap = false;
+	if (result != SUCCESSFUL_EXEC) {
+		return NULL;
+	}
+
+	mem_address_t address = (block.address + HEADER_SIZE + alignment - 1) & ~(mem_address_t) (alignment - 1);
+	*heap_header((void*) address) = block;
+	return (void*) address;
+}
+
+/// <summary>
+/// Frees memory of the heap, back into its arena.
+/// </summary>
+/// <param name="pointer">The memory. It must be within the heap.</param>
+static void heap_free(void* pointer) {
+	ptr_t block = *heap_header(pointer);
+	is_within_heap = true;
+	int result = mem_arenas_free(&heap, &block);
+	is_within_heap = false;
+	if (result != SUCCESSFUL_EXEC) {
+		log_error("Memory %p could not be freed. mem_arenas_free() returned %d.", pointer, result);
+	}
+}
+
+/// <summary>
+/// Allocates memory aligned on the given alignment, from the heap if possible, or else from the C library.
+/// </summary>
+/// <param name="alignment">The alignment. It is a power of two.</param>
+/// <param name="size">The size to allocate.</param>
+/// <returns>The memory, or null if it could not be allocated.</returns>
+static void* heap_memalign(size_t alignment, size_t size) {
+	void* memory = heap_is_usable() ? heap_allocate(size, alignment < MINIMUM_ALIGNMENT ? MINIMUM_ALIGNMENT : alignment) : NULL;
+	return memory != NULL ? memory : __libc_memalign(alignment, size);
+}
+
+/// <summary>
+/// Allocates size bytes. If the heap is out of memory, the C library serves the request so that the program keeps running.
+/// </summary>
+/// <param name="size">The size to allocate.</param>
+/// <returns>The memory, or null if it could not be allocated.</returns>
+EXPORTED void* malloc(size_t size) {
+	void* memory = heap_is_usable() ? heap_allocate(size, MINIMUM_ALIGNMENT) : NULL;
+	return memory != NULL ? memory : __libc_malloc(size);
+}
+
+/// <summary>
+/// Frees memory of the heap or of the C library.
+/// </summary>
+/// <param name="pointer">The memory. If null, nothing is done.</param>
+EXPORTED void free(void* pointer) {
+	if (pointer == NULL) {
+		return;
+	}
+
+	if (heap_owns(pointer)) {
+		heap_free(pointer);
+	} else {
+		__libc_free(pointer);
+	}
+}
+
+/// <summary>
+/// Allocates zeroed memory for count elements of size bytes.
+/// </summary>
+/// <param name="count">The count of elements.</param>
+/// <param name="size">The size of an element.</param>
+/// <returns>The memory, or null if it could not be allocated.</returns>
+EXPORTED void* calloc(size_t count, size_t size) {
+	if (size && count > SIZE_MAX / size) {
+		errno = ENOMEM;
+		return NULL;
+	}
+
+	// Memory of the heap may have been used before, so it is zeroed.
+	void* memory = heap_is_usable() ? heap_allocate(count * size, MINIMUM_ALIGNMENT) : NULL;
+	if (memory == NULL) {
+		return __libc_calloc(count, size);
+	}
+
+	memset(memory, 0, count * size);
+	return memory;
+}
+
+/// <summary>
+/// Changes the size of memory. It stays in place if its block is large enough.
+/// </summary>
+/// <param name="pointer">The memory. If null, memory is allocated.</param>
+/// <param name="size">The new size.</param>
+/// <returns>The memory, or null if it could not be allocated, in which case the given memory is left as is.</returns>
+EXPORTED void* realloc(void* pointer, size_t size) {
+	if (pointer == NULL) {
+		return malloc(size);
+	}
+
+	if (!heap_owns(pointer)) {
+		return __libc_realloc(pointer, size);
+	}
+
+	ptr_t* header = heap_header(pointer);
+	size_t usable_size = header->address + header->size - (mem_address_t) pointer;
+	if (size <= usable_size) {
+		return pointer;
+	}
+
+	void* memory = malloc(size);
+	if (memory == NULL) {
+		return NULL;
+	}
+
+	memcpy(memory, pointer, usable_size);
+	heap_free(pointer);
+	return memory;
+}
+
+/// <summary>
+/// Allocates size bytes aligned on the given alignment.
+/// </summary>
+/// <param name="memory">The out argument for the memory.</param>
+/// <param name="alignment">The alignment. It is a power of two multiple of sizeof(void*).</param>
+/// <param name="size">The size to allocate.</param>
+/// <returns>0, EINVAL if the alignment is not valid or ENOMEM if the memory could not be allocated.</returns>
+EXPORTED int posix_memalign(void** memory, size_t alignment, size_t size) {
+	if (!alignment || (alignment & (alignment - 1)) || alignment % sizeof(void*)) {
+		return EINVAL;
+	}
+
+	void* aligned_memory = heap_memalign(alignment, size);
+	if (aligned_memory == NULL) {
+		return ENOMEM;
+	}
+
+	*memory = aligned_memory;
+	return 0;
+}
+
+/// <summary>
+/// Allocates size bytes aligned on the given alignment.
+/// </summary>
+/// <param name="alignment">The alignment. It is a power of two.</param>
+/// <param name="size">The size to allocate.</param>
+/// <returns>The memory, or null if it could not be allocated.</returns>
+EXPORTED void* aligned_alloc(size_t alignment, size_t size) {
+	if (!alignment || (alignment & (alignment - 1))) {
+		errno = EINVAL;
+		return NULL;
+	}
+
+	return heap_memalign(alignment, size);
+}
+
+/// <summary>
+/// Allocates size bytes aligned on the given alignment. This is the obsolete form of aligned_alloc().
+/// </summary>
+/// <param name="alignment">The alignment. It is a power of two.</param>
+/// <param name="size">The size to allocate.</param>
+/// <returns>The memory, or null if it could not be allocated.</returns>
+EXPORTED void* memalign(size_t alignment, size_t size) {
+	return aligned_alloc(alignment, size);
+}
+
+/// <summary>
+/// Allocates size bytes aligned on the page size.
+/// </summary>
+/// <param name="size">The size to allocate.</param>
+/// <returns>The memory, or null if it could not be allocated.</returns>
+EXPORTED void* valloc(size_t size) {
+	return heap_memalign(sysconf(_SC_PAGESIZE), size);
+}
+
+/// <summary>
+/// Gets the count of bytes that can be used in memory, which can be more than the requested size.
+/// </summary>
+/// <param name="pointer">The memory.</param>
+/// <returns>The usable size, or 0 if the memory is null.</returns>
+EXPORTED size_t malloc_usable_size(void* pointer) {
+	if (pointer == NULL) {
+		return 0;
+	}
+
+	if (!heap_owns(pointer)) {
+		return libc_malloc_usable_size != NULL ? libc_malloc_usable_size(pointer) : 0;
+	}
+
+	ptr_t* header = heap_header(pointer);
+	return header->address + header->size - (mem_address_t) pointer;
+}
\ No newline at end of file
@@ -7,34 +7,42 @@
 
 #include "../lib/collections.h"
 #include "../lib/logging.h"
+#include "blocks.h"
 #include "strategies.h"
+#include "allocator.h"
 
 #define true 1
 #define false 0
 
-// Current node in the next fit algorithm.
-node_t* next_fit_current = NULL;
+// Weights of the cost of a window of the adaptive strategy: a unit of cost is this many steps per search, or this growth of the fragmentation,
+// or this rate of failed allocations.
+#define ADAPTIVE_SEARCH_LENGTH_SCALE 32.0
+#define ADAPTIVE_FRAGMENTATION_SCALE 0.02
+#define ADAPTIVE_FAILURE_RATE_SCALE 0.1
 
-// Current index of current node in next fit algorithm.
-int i_next_fit_current;
+// The strategies among which the adaptive strategy switches. They all share the default coalescing of contiguous free blocks.
+static const mem_allocation_strategy_t ADAPTIVE_CANDIDATES[ADAPTIVE_CANDIDATE_COUNT] = { 
+	&mem_allocation_strategy_first_fit, &mem_allocation_strategy_best_fit, &mem_allocation_strategy_worst_fit, 
+	&mem_allocation_strategy_next_fit, &mem_allocation_strategy_segregated_fit 
+};
 
 /// <summary>
 /// Allocates a block of memory into the pointer argument from the list of free blocks using the first fit strategy.
 /// </summary>
-/// <param name="free_block_list">The list of free block.</param>
+/// <param name="allocator">The allocator.</param>
 /// <param name="pointer">The pointer into which to allocate.</param>
 /// <returns>The state code.</returns>
-int mem_allocation_strategy_first_fit (linkedlist_t* free_block_list, ptr_t* pointer) {
-	if (free_block_list == NULL || pointer == NULL) {
+int mem_allocation_strategy_first_fit (allocator_t* allocator, ptr_t* pointer) {
+	if (allocator == NULL || pointer == NULL) {
 		return ILLEGAL_ARGUMENTS_ERRNO;
 	}
 
 	log_debug("Entering mem_allocation_strategy_first_fit().");
 
-	int i_current = 0;
-	node_t* current = free_block_list->head;
+	node_t* current = allocator->free_blocks.list.head;
 	ptr_t* current_pointer;
 	while (current != NULL) {
+		allocator->search_step_count++;
 		current_pointer = current->element;
 		if (pointer->size < current_pointer->size) {
 			break;
@@ -42,190 +50,824 @@ int mem_allocation_strategy_first_fit (linkedlist_t* free_block_list, ptr_t* poi
 
 		// Move to the next node.
 		current = current->next;
-		i_current++;
 	}
 
 	if (current == NULL) {
 		return OUT_OF_MEMORY_ERRNO;
 	}
 
-	// If the found block has more memory than required, split it.
-	if (current_pointer->size > pointer->size) {
-		log_trace("Size matched. current_pointer->address: %lu.", current_pointer->address);
-		pointer->address = current_pointer->address;
-		current_pointer->address += pointer->size;
-		current_pointer->size -= pointer->size;
-	} else {
-		// Size matched perfectly. Remove the block from the free block and return it.
-		log_trace("Size matched perfectly. current_pointer->address: %lu.", current_pointer->address);
-		pointer->address = current_pointer->address;
-		linkedlist_remove(free_block_list, i_current);
-		free(current_pointer);
-	}
+	// Split the found block, or remove it if the size matched perfectly.
+	int result = mem_block_split(&allocator->free_blocks, current->element, pointer);
 
     log_debug("Exiting mem_allocation_strategy_first_fit().");
-    return SUCCESSFUL_EXEC;
+    return result;
 }
 
 /// <summary>
-/// Allocates a block of memory into the pointer argument from the list of free blocks using the best fit strategy.
+/// Allocates a block of memory into the pointer argument using the first fit strategy, from the free blocks as arrays ordered by address.
+/// The sizes are read from contiguous memory, many at once, instead of following the nodes of the free block list.
 /// </summary>
-/// <param name="free_block_list">The list of free block.</param>
+/// <param name="allocator">The allocator.</param>
 /// <param name="pointer">The pointer into which to allocate.</param>
 /// <returns>The state code.</returns>
-int mem_allocation_strategy_best_fit (linkedlist_t* free_block_list, ptr_t* pointer) {
-	if (free_block_list == NULL || pointer == NULL) {
+int mem_allocation_strategy_first_fit_arrays (allocator_t* allocator, ptr_t* pointer) {
+	if (allocator == NULL || pointer == NULL) {
 		return ILLEGAL_ARGUMENTS_ERRNO;
 	}
 
-	log_debug("Entering mem_allocation_strategy_best_fit().");
+	log_debug("Entering mem_allocation_strategy_first_fit_arrays().");
 
-	int i_current = 0, i_best_fit = 0;
-	node_t* current = free_block_list->head;
-	ptr_t* current_pointer;
-	ptr_t* best_fit_pointer = NULL;
-	while (current != NULL) {
-		current_pointer = current->element;
-		if ((best_fit_pointer == NULL && pointer->size <= current_pointer->size) || 
-			(best_fit_pointer != NULL && pointer->size <= current_pointer->size && (current_pointer->size - pointer->size) < (best_fit_pointer->size - pointer->size))) {
-			// Better fit than previous best fit.
-			best_fit_pointer = current_pointer;
-			i_best_fit = i_current;
-		}
-		// Move to the next node.
-		current = current->next;
-		i_current++;
+	// Like the first fit on the free block list, the block must be greater than the pointer.
+	block_t* block = mem_block_arrays_first_fit(&allocator->free_blocks.arrays, pointer->size, &allocator->search_step_count);
+	if (block == NULL) {
+		return OUT_OF_MEMORY_ERRNO;
 	}
-	
+
+	// Split the found block, or remove it if the size matched perfectly.
+	int result = mem_block_split(&allocator->free_blocks, block, pointer);
+
+    log_debug("Exiting mem_allocation_strategy_first_fit_arrays().");
+    return result;
+}
+
+/// <summary>
+/// Allocates a block of memory into the pointer argument from the size tree of free blocks using the best fit strategy.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <param name="pointer">The pointer into which to allocate.</param>
+/// <returns>The state code.</returns>
+int mem_allocation_strategy_best_fit (allocator_t* allocator, ptr_t* pointer) {
+	if (allocator == NULL || pointer == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	log_debug("Entering mem_allocation_strategy_best_fit().");
+
+	// The best fit is the smallest block that is large enough. Among equal sizes, the lowest address wins.
+	ptr_t key = { .address = 0, .size = pointer->size };
+	treenode_t* best_fit_node;
+	allocator->search_step_count += allocator->free_blocks.size_tree.root != NULL ? allocator->free_blocks.size_tree.root->height : 0;
+	avltree_lower_bound(&allocator->free_blocks.size_tree, &key, &best_fit_node);
+	ptr_t* best_fit_pointer = best_fit_node != NULL ? best_fit_node->element : NULL;
 	if (best_fit_pointer == NULL) {
 		return OUT_OF_MEMORY_ERRNO;
 	}
 
-	// If the found block has more memory than required, split it.
-	if (best_fit_pointer->size > pointer->size) {
-		pointer->address = best_fit_pointer->address;
-		best_fit_pointer->address += pointer->size;
-		best_fit_pointer->size -= pointer->size;
-	} else {
-		// Size matched perfectly. Remove the block from the free block and return it.
-		pointer->address = best_fit_pointer->address;
-		linkedlist_remove(free_block_list, i_best_fit);
-		free(best_fit_pointer);
-	}
+	// Split the found block, or remove it if the size matched perfectly.
+	int result = mem_block_split(&allocator->free_blocks, (block_t*) best_fit_pointer, pointer);
 
     log_debug("Exiting mem_allocation_strategy_best_fit().");
-    return SUCCESSFUL_EXEC;
+    return result;
 }
 
 /// <summary>
-/// Allocates a block of memory into the pointer argument from the list of free blocks using the worst fit strategy.
+/// Allocates a block of memory into the pointer argument from the size tree of free blocks using the worst fit strategy.
 /// </summary>
-/// <param name="free_block_list">The list of free block.</param>
+/// <param name="allocator">The allocator.</param>
 /// <param name="pointer">The pointer into which to allocate.</param>
 /// <returns>The state code.</returns>
-int mem_allocation_strategy_worst_fit (linkedlist_t* free_block_list, ptr_t* pointer) {
-	if (free_block_list == NULL || pointer == NULL) {
+int mem_allocation_strategy_worst_fit (allocator_t* allocator, ptr_t* pointer) {
+	if (allocator == NULL || pointer == NULL) {
 		return ILLEGAL_ARGUMENTS_ERRNO;
 	}
 
 	log_debug("Entering mem_allocation_strategy_worst_fit().");
 
-	int i_current = 0, i_worst_fit = 0;
-	node_t* current = free_block_list->head;
-	ptr_t* current_pointer;
-	ptr_t* worst_fit_pointer = NULL;
-	while (current != NULL) {
-		current_pointer = current->element;
-		if ((worst_fit_pointer == NULL && pointer->size <= current_pointer->size) ||
-			(worst_fit_pointer != NULL && pointer->size <= current_pointer->size && (current_pointer->size - pointer->size) > (worst_fit_pointer->size - pointer->size))) {
-			// Worst fit than previous worst fit.
-			worst_fit_pointer = current_pointer;
-			i_worst_fit = i_current;
-		}
-
-		// Move to the next node.
-		current = current->next;
-		i_current++;
+	// The worst fit is the largest block. Among equal sizes, the lowest address wins.
+	treenode_t* worst_fit_node;
+	allocator->search_step_count += allocator->free_blocks.size_tree.root != NULL ? 2 * allocator->free_blocks.size_tree.root->height : 0;
+	avltree_last(&allocator->free_blocks.size_tree, &worst_fit_node);
+	if (worst_fit_node != NULL) {
+		ptr_t key = { .address = 0, .size = ((ptr_t*) worst_fit_node->element)->size };
+		avltree_lower_bound(&allocator->free_blocks.size_tree, &key, &worst_fit_node);
 	}
-	
-	if (worst_fit_pointer == NULL) {
+
+	ptr_t* worst_fit_pointer = worst_fit_node != NULL ? worst_fit_node->element : NULL;
+	if (worst_fit_pointer == NULL || worst_fit_pointer->size < pointer->size) {
 		return OUT_OF_MEMORY_ERRNO;
 	}
 
-	// If the found block has more memory than required, split it.
-	if (worst_fit_pointer->size > pointer->size) {
-		pointer->address = worst_fit_pointer->address;
-		worst_fit_pointer->address += pointer->size;
-		worst_fit_pointer->size -= pointer->size;
-	} else {
-		// Size matched perfectly. Remove the block from the free block and return it.
-		pointer->address = worst_fit_pointer->address;
-		linkedlist_remove(free_block_list, i_worst_fit);
-		free(worst_fit_pointer);
-	}
+	// Split the found block, or remove it if the size matched perfectly.
+	int result = mem_block_split(&allocator->free_blocks, (block_t*) worst_fit_pointer, pointer);
 
     log_debug("Exiting mem_allocation_strategy_worst_fit().");
-    return SUCCESSFUL_EXEC;
+    return result;
 }
 
 /// <summary>
 /// Allocates a block of memory into the pointer argument from the list of free blocks using the next fit strategy.
 /// </summary>
-/// <param name="free_block_list">The list of free block.</param>
+/// <param name="allocator">The allocator.</param>
 /// <param name="pointer">The pointer into which to allocate.</param>
 /// <returns>The state code.</returns>
-int mem_allocation_strategy_next_fit (linkedlist_t* free_block_list, ptr_t* pointer) {
-	if (free_block_list == NULL || pointer == NULL) {
+int mem_allocation_strategy_next_fit (allocator_t* allocator, ptr_t* pointer) {
+	if (allocator == NULL || pointer == NULL) {
 		return ILLEGAL_ARGUMENTS_ERRNO;
 	}
 	
 	log_debug("Entering mem_allocation_strategy_next_fit().");
 	
-	// Initialize next fit global variables.
-	if (next_fit_current == NULL) {
-		next_fit_current = free_block_list->head;
-		i_next_fit_current = 0;
+	// Start from the block of the last allocation. It is dropped if that block left the free block list since.
+	node_t* current = allocator->next_fit_current;
+	void* element = NULL;
+	if (current != NULL) {
+		hashmap_get(&allocator->free_blocks.starts, ((block_t*) current->element)->pointer.address, &element);
 	}
 
-	int i_current = i_next_fit_current, next_fit_found = false;
-	node_t* current = next_fit_current;
-	ptr_t* current_pointer;
-	do {
+	if (current == NULL || element != current->element) {
+		current = allocator->free_blocks.list.head;
+	}
+
+	// Visit every free block at most once, wrapping around at the tail.
+	unsigned int i_visited, next_fit_found = false;
+	ptr_t* current_pointer = NULL;
+	for (i_visited = 0; i_visited < allocator->free_blocks.list.length; i_visited++) {
+		allocator->search_step_count++;
 		current_pointer = current->element;
 		if (pointer->size < current_pointer->size) {
-			next_fit_current = current;
-			i_next_fit_current = i_current;
+			allocator->next_fit_current = current;
 			next_fit_found = true;
 			break;
 		}
 	
-		if (current->next == NULL) {
-			current = free_block_list->head;
-			i_current = 0;
-		} else {
-			current = current->next;
-			i_current++;
-		}
-	} while (i_current != i_next_fit_current);
+		current = current->next != NULL ? current->next : allocator->free_blocks.list.head;
+	}
 		
 	if (!next_fit_found) {
 		return OUT_OF_MEMORY_ERRNO;
 	}
 
-	// If the found block has more memory than required, split it.
-	if (current_pointer->size > pointer->size) {
-		pointer->address = current_pointer->address;
-		current_pointer->address += pointer->size;
-		current_pointer->size -= pointer->size;
-	} else {
-		// Size matched perfectly. Remove the block from the free block and return it.
-		pointer->address = current_pointer->address;
-		linkedlist_remove(free_block_list, i_current);
-
-		next_fit_current = NULL;
-		free(current_pointer);
+	// If the size matched perfectly, the block will be removed from the free blocks.
+	if (current_pointer->size == pointer->size) {
+		allocator->next_fit_current = NULL;
 	}
 
+	// Split the found block, or remove it if the size matched perfectly.
+	int result = mem_block_split(&allocator->free_blocks, current->element, pointer);
+
     log_debug("Exiting mem_allocation_strategy_next_fit().");
+    return result;
+}
+
+/// <summary>
+/// Allocates a block of memory into the pointer argument from the size class bins of free blocks using the segregated fit strategy.
+/// The sub-bin of the requested size class is searched first. Any block from a greater size class fits.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <param name="pointer">The pointer into which to allocate.</param>
+/// <returns>The state code.</returns>
+int mem_allocation_strategy_segregated_fit (allocator_t* allocator, ptr_t* pointer) {
+	if (allocator == NULL || pointer == NULL || !pointer->size) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	log_debug("Entering mem_allocation_strategy_segregated_fit().");
+
+	// Blocks of the requested size class may still be too small: first fit within the bin.
+	unsigned int i_bin, i_subbin;
+	mem_block_bin_indexes(pointer->size, &i_bin, &i_subbin);
+	node_t* current = allocator->free_blocks.bins[i_bin][i_subbin].head;
+	allocator->search_step_count++;
+	while (current != NULL && ((block_t*) current->element)->pointer.size < pointer->size) {
+		allocator->search_step_count++;
+		current = current->next;
+	}
+
+	block_t* block = current != NULL ? current->element : NULL;
+	if (block == NULL) {
+		// Take the first block of the smallest non-empty greater size class.
+		block = mem_block_bin_find(&allocator->free_blocks, i_bin, i_subbin + 1);
+		if (block == NULL) {
+			return OUT_OF_MEMORY_ERRNO;
+		}
+	}
+
+	// Split the found block, or remove it if the size matched perfectly.
+	int result = mem_block_split(&allocator->free_blocks, block, pointer);
+
+    log_debug("Exiting mem_allocation_strategy_segregated_fit().");
+    return result;
+}
+
+/// <summary>
+/// Allocates a block of memory into the pointer argument from the size class bins of free blocks using the buddy system.
+/// The size of the pointer is rounded up to a power of two, and greater blocks are halved until one has that size.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <param name="pointer">The pointer into which to allocate. Its size is set to the rounded size.</param>
+/// <returns>The state code.</returns>
+int mem_allocation_strategy_buddy (allocator_t* allocator, ptr_t* pointer) {
+	if (allocator == NULL || pointer == NULL || !pointer->size) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	log_debug("Entering mem_allocation_strategy_buddy().");
+
+	// Round the size up to a power of two. Its order is also the index of its size class bin.
+	unsigned int order = mem_block_bin_index(pointer->size);
+	if (pointer->size & (pointer->size - 1)) {
+		order++;
+	}
+
+	if (order >= FREE_BLOCK_BIN_COUNT) {
+		return OUT_OF_MEMORY_ERRNO;
+	}
+
+	// All free blocks have a power of two size, so bin i only holds blocks of size 2^i in its first sub-bin.
+	allocator->search_step_count++;
+	block_t* block = mem_block_bin_find(&allocator->free_blocks, order, 0);
+	if (block == NULL) {
+		return OUT_OF_MEMORY_ERRNO;
+	}
+
+	// Every halving inserts an upper half, so their records are reserved before the block is cut.
+	int result = mem_blocks_reserve(&allocator->free_blocks, mem_block_bin_index(block->pointer.size) - order);
+	if (result != SUCCESSFUL_EXEC) {
+		return result;
+	}
+
+	// Halve the block until it has the rounded size. Upper halves become free buddies.
+	// If an upper half still cannot be inserted, the block takes it back, so no memory is lost.
+	sz_t size = (sz_t) 1 << order;
+	while (block->pointer.size > size) {
+		sz_t half = block->pointer.size / 2;
+		log_trace("Splitting buddy. block->pointer.address: %lu, half: %lu.", block->pointer.address, half);
+		if ((result = mem_block_resize(&allocator->free_blocks, block, block->pointer.address, half)) != SUCCESSFUL_EXEC) {
+			return result;
+		}
+
+		if ((result = mem_block_insert(&allocator->free_blocks, block->list_node.next, block->pointer.address + half, half, NULL)) != SUCCESSFUL_EXEC) {
+			mem_block_resize(&allocator->free_blocks, block, block->pointer.address, 2 * half);
+			return result;
+		}
+	}
+
+	// The size matches perfectly. Remove the block from the free blocks.
+	pointer->size = size;
+	result = mem_block_split(&allocator->free_blocks, block, pointer);
+
+    log_debug("Exiting mem_allocation_strategy_buddy().");
+    return result;
+}
+
+/// <summary>
+/// Allocates an aligned block of memory into the pointer argument using the buddy system.
+/// Blocks are aligned on their size, so the size is raised to the alignment, if it is smaller.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <param name="pointer">The pointer into which to allocate. Its size is set to the rounded size.</param>
+/// <param name="alignment">The alignment of the address. It must be a power of two.</param>
+/// <returns>The state code.</returns>
+int mem_aligned_allocation_strategy_buddy (allocator_t* allocator, ptr_t* pointer, sz_t alignment) {
+	if (allocator == NULL || pointer == NULL || !alignment) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	log_debug("Entering mem_aligned_allocation_strategy_buddy().");
+
+	// The address space is cut into blocks aligned on their size, and halving keeps that alignment.
+	if (pointer->size < alignment) {
+		pointer->size = alignment;
+	}
+
+	int result = mem_allocation_strategy_buddy(allocator, pointer);
+
+    log_debug("Exiting mem_aligned_allocation_strategy_buddy().");
+    return result;
+}
+
+/// <summary>
+/// Puts an aligned power of two block back into the free blocks, and merges it with its buddy for as long as the buddy is free.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <param name="address">The address of the block. It must be a multiple of the size.</param>
+/// <param name="size">The size of the block. It must be a power of two.</param>
+/// <returns>The state code.</returns>
+static int mem_deallocation_buddy_merge (allocator_t* allocator, mem_address_t address, sz_t size) {
+	int result;
+	void* element;
+	while (size < ((sz_t) 1 << (FREE_BLOCK_BIN_COUNT - 1))) {
+		// The buddy of a block is its other half in the block of twice its size.
+		mem_address_t buddy_address = address ^ size;
+		hashmap_get(&allocator->free_blocks.starts, buddy_address, &element);
+
+		block_t* buddy = element;
+		if (buddy == NULL || buddy->pointer.size != size) {
+			break;
+		}
+
+		log_trace("Merging buddies. address: %lu, buddy_address: %lu, size: %lu.", address, buddy_address, size);
+		if ((result = mem_block_remove(&allocator->free_blocks, buddy)) != SUCCESSFUL_EXEC) {
+			return result;
+		}
+
+		address &= ~(mem_address_t) size;
+		size *= 2;
+	}
+
+	// Buddies are found by address, so the free block list needs no address order.
+	return mem_block_insert(&allocator->free_blocks, allocator->free_blocks.list.head, address, size, NULL);
+}
+
+/// <summary>
+/// Puts the memory of the pointer back into the free blocks using the buddy system.
+/// The memory is cut into aligned power of two blocks, and every block is merged with its buddy for as long as the buddy is free.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <param name="pointer">The pointer from which to free.</param>
+/// <returns>The state code.</returns>
+int mem_deallocation_strategy_buddy (allocator_t* allocator, ptr_t* pointer) {
+	if (allocator == NULL || pointer == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	log_debug("Entering mem_deallocation_strategy_buddy().");
+
+	// Pointers from mem_allocation_strategy_buddy() are a single block. Other spans, like the
+	// initial address space, are cut into the greatest aligned power of two blocks.
+	int result;
+	mem_address_t address = pointer->address, end = pointer->address + pointer->size;
+	while (address < end) {
+		sz_t size = (sz_t) 1 << mem_block_bin_index(end - address);
+		while (address & (size - 1)) {
+			size /= 2;
+		}
+
+		if ((result = mem_deallocation_buddy_merge(allocator, address, size)) != SUCCESSFUL_EXEC) {
+			return result;
+		}
+
+		address += size;
+	}
+
+    log_debug("Exiting mem_deallocation_strategy_buddy().");
+    return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Resizes the allocated block of the pointer in place using the buddy system.
+/// The size is rounded up to a power of two. A block shrinks by giving its upper halves back, and grows by taking its free buddies, for as long as it is their lower half.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <param name="pointer">The pointer to resize. Its size is set to the rounded size.</param>
+/// <param name="size">The new size of the allocation.</param>
+/// <returns>The state code. OUT_OF_MEMORY_ERRNO if the block cannot grow in place.</returns>
+int mem_reallocation_strategy_buddy (allocator_t* allocator, ptr_t* pointer, sz_t size) {
+	if (allocator == NULL || pointer == NULL || !size) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	log_debug("Entering mem_reallocation_strategy_buddy().");
+
+	unsigned int order = mem_block_bin_index(size);
+	if (size & (size - 1)) {
+		order++;
+	}
+
+	if (order >= FREE_BLOCK_BIN_COUNT) {
+		return OUT_OF_MEMORY_ERRNO;
+	}
+
+	int result;
+	sz_t rounded_size = (sz_t) 1 << order, buddy_size;
+	if (rounded_size < pointer->size) {
+		// The upper halves are given back. Their buddies are within the block, so they cannot merge.
+		ptr_t tail = { pointer->address + rounded_size, pointer->size - rounded_size, false };
+		if ((result = mem_deallocation_strategy_buddy(allocator, &tail)) != SUCCESSFUL_EXEC) {
+			return result;
+		}
+	} else if (rounded_size > pointer->size) {
+		// Every buddy up to the rounded size must be free and whole before any is taken.
+		void* element;
+		for (buddy_size = pointer->size; buddy_size < rounded_size; buddy_size *= 2) {
+			hashmap_get(&allocator->free_blocks.starts, pointer->address + buddy_size, &element);
+			if ((pointer->address & buddy_size) || element == NULL || ((block_t*) element)->pointer.size != buddy_size) {
+				return OUT_OF_MEMORY_ERRNO;
+			}
+		}
+
+		for (buddy_size = pointer->size; buddy_size < rounded_size; buddy_size *= 2) {
+			log_trace("Taking buddy. address: %lu, size: %lu.", pointer->address + buddy_size, buddy_size);
+			hashmap_get(&allocator->free_blocks.starts, pointer->address + buddy_size, &element);
+			if ((result = mem_block_remove(&allocator->free_blocks, element)) != SUCCESSFUL_EXEC) {
+				return result;
+			}
+		}
+	}
+
+	pointer->size = rounded_size;
+
+    log_debug("Exiting mem_reallocation_strategy_buddy().");
     return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Allocates a block of memory into the pointer argument from the size class sub-bins of free blocks using the two-level segregated fit strategy.
+/// The size is rounded up to the next sub-bin, so the first block of any non-empty sub-bin from there fits without a search.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <param name="pointer">The pointer into which to allocate.</param>
+/// <returns>The state code.</returns>
+int mem_allocation_strategy_tlsf (allocator_t* allocator, ptr_t* pointer) {
+	if (allocator == NULL || pointer == NULL || !pointer->size) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	log_debug("Entering mem_allocation_strategy_tlsf().");
+
+	// Sub-bins of small bins hold a single size. Other sizes are rounded up to the start of the next sub-bin.
+	sz_t size = pointer->size;
+	unsigned int i_bin = mem_block_bin_index(size), i_subbin;
+	if (i_bin >= FREE_BLOCK_SUBBIN_LOG2) {
+		sz_t rounding = ((sz_t) 1 << (i_bin - FREE_BLOCK_SUBBIN_LOG2)) - 1;
+		if (size > SZ_MAX - rounding) {
+			return OUT_OF_MEMORY_ERRNO;
+		}
+
+		size += rounding;
+	}
+
+	mem_block_bin_indexes(size, &i_bin, &i_subbin);
+	allocator->search_step_count++;
+	block_t* block = mem_block_bin_find(&allocator->free_blocks, i_bin, i_subbin);
+	if (block == NULL) {
+		return OUT_OF_MEMORY_ERRNO;
+	}
+
+	// Split the found block, or remove it if the size matched perfectly.
+	int result = mem_block_split(&allocator->free_blocks, block, pointer);
+
+    log_debug("Exiting mem_allocation_strategy_tlsf().");
+    return result;
+}
+
+/// <summary>
+/// Puts the memory of the pointer back into the free blocks using the two-level segregated fit strategy.
+/// The memory is merged right away with the free blocks right before and after it.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <param name="pointer">The pointer from which to free.</param>
+/// <returns>The state code.</returns>
+int mem_deallocation_strategy_tlsf (allocator_t* allocator, ptr_t* pointer) {
+	if (allocator == NULL || pointer == NULL || !pointer->size) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	log_debug("Entering mem_deallocation_strategy_tlsf().");
+
+	// Blocks are found through the sub-bins only, so the free block list needs no address order.
+	int result = mem_block_coalesce(&allocator->free_blocks, false, pointer->address, pointer->size, NULL);
+
+    log_debug("Exiting mem_deallocation_strategy_tlsf().");
+    return result;
+}
+
+/// <summary>
+/// Rounds a size up to whole granules of the bitmap of free blocks.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <param name="size">The size.</param>
+/// <param name="rounded_size">The out argument for the rounded size.</param>
+/// <returns>The state code. OUT_OF_MEMORY_ERRNO if the rounded size overflows.</returns>
+static int mem_bitmap_round (allocator_t* allocator, sz_t size, sz_t* rounded_size) {
+	sz_t granule_size = allocator->free_blocks.bitmap.granule_size;
+	if (!granule_size || size > SZ_MAX - (granule_size - 1)) {
+		return OUT_OF_MEMORY_ERRNO;
+	}
+
+	*rounded_size = (size + granule_size - 1) & ~(granule_size - 1);
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Allocates a block of memory into the pointer argument from the bitmap of granules of free blocks, with the first run of free granules that is long enough.
+/// The size is rounded up to whole granules, and the bitmap is searched a word at a time.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <param name="pointer">The pointer into which to allocate. Its size is set to the rounded size.</param>
+/// <returns>The state code.</returns>
+int mem_allocation_strategy_bitmap (allocator_t* allocator, ptr_t* pointer) {
+	if (allocator == NULL || pointer == NULL || !pointer->size) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	log_debug("Entering mem_allocation_strategy_bitmap().");
+
+	sz_t size;
+	mem_address_t address;
+	free_blocks_t* free_blocks = &allocator->free_blocks;
+	if (mem_bitmap_round(allocator, pointer->size, &size) != SUCCESSFUL_EXEC || 
+		mem_block_bitmap_find(&free_blocks->bitmap, size >> free_blocks->bitmap.granule_log2, &allocator->search_step_count, &address) != SUCCESSFUL_EXEC) {
+		return OUT_OF_MEMORY_ERRNO;
+	}
+
+	// Contiguous free blocks are merged, so a run starts a free block, unless it follows the bytes before the first granule.
+	// Those bytes are then left in a free block of their own.
+	int result;
+	void* element;
+	hashmap_get(&free_blocks->starts, address, &element);
+	block_t* block = element;
+	if (block == NULL) {
+		block = mem_block_floor(free_blocks, address);
+		if (block == NULL || block->pointer.address + block->pointer.size < address + size) {
+			return COLLECTIONS_ERRNO;
+		}
+
+		mem_address_t head_address = block->pointer.address;
+		if ((result = mem_block_resize(free_blocks, block, address, block->pointer.address + block->pointer.size - address)) != SUCCESSFUL_EXEC || 
+			(result = mem_block_insert(free_blocks, &block->list_node, head_address, address - head_address, NULL)) != SUCCESSFUL_EXEC) {
+			return result;
+		}
+	}
+
+	// Split the found block, or remove it if the size matched perfectly.
+	pointer->size = size;
+	result = mem_block_split(free_blocks, block, pointer);
+
+    log_debug("Exiting mem_allocation_strategy_bitmap().");
+    return result;
+}
+
+/// <summary>
+/// Allocates an aligned block of memory into the pointer argument from the bitmap of granules of free blocks.
+/// Granules are aligned on their size, so only an alignment greater than a granule pads the run, and the padding is given back in whole granules.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <param name="pointer">The pointer into which to allocate. Its size is set to the rounded size.</param>
+/// <param name="alignment">The alignment of the address. It must be a power of two.</param>
+/// <returns>The state code.</returns>
+int mem_aligned_allocation_strategy_bitmap (allocator_t* allocator, ptr_t* pointer, sz_t alignment) {
+	if (allocator == NULL || pointer == NULL || !pointer->size || !alignment) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	log_debug("Entering mem_aligned_allocation_strategy_bitmap().");
+
+	sz_t granule_size = allocator->free_blocks.bitmap.granule_size;
+	if (alignment <= granule_size) {
+		return mem_allocation_strategy_bitmap(allocator, pointer);
+	}
+
+	// Any run of the size plus the alignment minus a granule holds an aligned run of the size.
+	sz_t size;
+	if (mem_bitmap_round(allocator, pointer->size, &size) != SUCCESSFUL_EXEC || size > SZ_MAX - (alignment - granule_size)) {
+		return OUT_OF_MEMORY_ERRNO;
+	}
+
+	pointer->size = size + (alignment - granule_size);
+	int result = mem_allocation_strategy_bitmap(allocator, pointer);
+	if (result != SUCCESSFUL_EXEC) {
+		pointer->size = size;
+		return result;
+	}
+
+	mem_address_t address = (pointer->address + (alignment - 1)) & ~(mem_address_t) (alignment - 1);
+	mem_address_t tail_address = address + size;
+	sz_t tail_size = pointer->address + pointer->size - tail_address;
+	if ((address > pointer->address && (result = mem_block_coalesce(&allocator->free_blocks, true, pointer->address, address - pointer->address, NULL)) != SUCCESSFUL_EXEC) || 
+		(tail_size && (result = mem_block_coalesce(&allocator->free_blocks, true, tail_address, tail_size, NULL)) != SUCCESSFUL_EXEC)) {
+		return result;
+	}
+
+	pointer->address = address;
+	pointer->size = size;
+
+    log_debug("Exiting mem_aligned_allocation_strategy_bitmap().");
+    return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Resizes the allocated block of the pointer in place to whole granules. A block shrinks by giving its tail back, and grows into the free block right after it.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <param name="pointer">The pointer to resize. Its size is set to the rounded size.</param>
+/// <param name="size">The new size of the allocation.</param>
+/// <returns>The state code. OUT_OF_MEMORY_ERRNO if the block cannot grow in place.</returns>
+int mem_reallocation_strategy_bitmap (allocator_t* allocator, ptr_t* pointer, sz_t size) {
+	if (allocator == NULL || pointer == NULL || !size) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	log_debug("Entering mem_reallocation_strategy_bitmap().");
+
+	int result;
+	sz_t rounded_size;
+	if ((result = mem_bitmap_round(allocator, size, &rounded_size)) != SUCCESSFUL_EXEC) {
+		return result;
+	}
+
+	if (rounded_size < pointer->size) {
+		// The tail merges with the free block right after it, if any.
+		if ((result = mem_block_coalesce(&allocator->free_blocks, true, pointer->address + rounded_size, pointer->size - rounded_size, NULL)) != SUCCESSFUL_EXEC) {
+			return result;
+		}
+	} else if (rounded_size > pointer->size) {
+		void* element;
+		hashmap_get(&allocator->free_blocks.starts, pointer->address + pointer->size, &element);
+		block_t* next_block = element;
+		ptr_t growth = { 0, rounded_size - pointer->size, false };
+		if (next_block == NULL || next_block->pointer.size < growth.size) {
+			return OUT_OF_MEMORY_ERRNO;
+		}
+
+		if ((result = mem_block_split(&allocator->free_blocks, next_block, &growth)) != SUCCESSFUL_EXEC) {
+			return result;
+		}
+	}
+
+	pointer->size = rounded_size;
+
+    log_debug("Exiting mem_reallocation_strategy_bitmap().");
+    return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Gets the fragmentation of the free blocks: the part of the free bytes that is not in the greatest free block.
+/// </summary>
+/// <param name="free_blocks">The free blocks.</param>
+/// <returns>The fragmentation, from 0 to 1.</returns>
+static double mem_adaptive_fragmentation (free_blocks_t* free_blocks) {
+	block_t* greatest_block = mem_block_greatest(free_blocks);
+	if (greatest_block == NULL || !free_blocks->bytes) {
+		return 0;
+	}
+
+	return (double) (free_blocks->bytes - greatest_block->pointer.size) / free_blocks->bytes;
+}
+
+/// <summary>
+/// Ends the window of the adaptive strategy: measures the cost of the candidate in use, then chooses the candidate of the next window.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+static void mem_adaptive_end_window (allocator_t* allocator) {
+	adaptive_state_t* state = &allocator->adaptive;
+	double fragmentation = mem_adaptive_fragmentation(&allocator->free_blocks);
+	double search_length = (double) (allocator->search_step_count - state->window_search_step_start) / state->window_allocation_count;
+	double failure_rate = (double) state->window_failure_count / state->window_allocation_count;
+	unsigned int i_current = state->i_current, i_next = i_current, i_candidate;
+	double cost = search_length / ADAPTIVE_SEARCH_LENGTH_SCALE + (fragmentation - state->window_fragmentation_start) / ADAPTIVE_FRAGMENTATION_SCALE 
+		+ failure_rate / ADAPTIVE_FAILURE_RATE_SCALE;
+
+	// The fragmentation left by a candidate shows in the windows after its own, so its cost is averaged with its previous cost.
+	state->costs[i_current] = state->window_counts[i_current] ? (state->costs[i_current] + cost) / 2 : cost;
+	state->last_windows[i_current] = state->window_count++;
+	state->window_counts[i_current]++;
+
+	// A candidate never measured runs first. Then, the cheapest runs, except at every exploration period, when the candidate measured the longest ago runs.
+	unsigned int is_exploring = state->window_count % ADAPTIVE_EXPLORATION_PERIOD == 0;
+	for (i_candidate = 0; i_candidate < ADAPTIVE_CANDIDATE_COUNT; i_candidate++) {
+		if (!state->window_counts[i_candidate]) {
+			i_next = i_candidate;
+			break;
+		}
+
+		if (is_exploring ? state->last_windows[i_candidate] < state->last_windows[i_next] : state->costs[i_candidate] < state->costs[i_next]) {
+			i_next = i_candidate;
+		}
+	}
+
+	if (i_next != i_current) {
+		state->switches[state->switch_count++ % ADAPTIVE_SWITCH_HISTORY] = (adaptive_switch_t) { .window = state->window_count, .from = i_current, .to = i_next, 
+			.search_length = search_length, .fragmentation = fragmentation, .failure_rate = failure_rate };
+		log_debug("Adaptive strategy switched. from: %s, to: %s, search_length: %.1f, fragmentation: %.3f, failure_rate: %.3f.", 
+			mem_allocation_strategy_name_of(ADAPTIVE_CANDIDATES[i_current]), mem_allocation_strategy_name_of(ADAPTIVE_CANDIDATES[i_next]), search_length, fragmentation, failure_rate);
+	}
+
+	state->i_current = i_next;
+	state->window_allocation_count = state->window_failure_count = 0;
+	state->window_search_step_start = allocator->search_step_count;
+	state->window_fragmentation_start = fragmentation;
+}
+
+/// <summary>
+/// Allocates a block of memory into the pointer argument with one of the first, best, worst, next and segregated fit strategies, switched as the workload goes.
+/// Every window of allocations measures the search length, the fragmentation and the failure rate of the strategy in use. The cheapest strategy runs next,
+/// and every other strategy is measured again from time to time. All of them share the default coalescing of contiguous free blocks, so any can follow another.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <param name="pointer">The pointer into which to allocate.</param>
+/// <returns>The state code.</returns>
+int mem_allocation_strategy_adaptive (allocator_t* allocator, ptr_t* pointer) {
+	if (allocator == NULL || pointer == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	log_debug("Entering mem_allocation_strategy_adaptive().");
+
+	adaptive_state_t* state = &allocator->adaptive;
+	int result = ADAPTIVE_CANDIDATES[state->i_current](allocator, pointer);
+	state->allocation_counts[state->i_current]++;
+	state->window_allocation_count++;
+	if (result == OUT_OF_MEMORY_ERRNO) {
+		state->window_failure_count++;
+	}
+
+	if (state->window_allocation_count == ADAPTIVE_WINDOW_SIZE) {
+		mem_adaptive_end_window(allocator);
+	}
+
+    log_debug("Exiting mem_allocation_strategy_adaptive().");
+    return result;
+}
+
+/// <summary>
+/// Gets a strategy among which the adaptive strategy switches.
+/// </summary>
+/// <param name="i_candidate">The index of the candidate.</param>
+/// <returns>The allocation strategy, or null if the index is out of bounds.</returns>
+mem_allocation_strategy_t mem_adaptive_candidate (unsigned int i_candidate) {
+	return i_candidate < ADAPTIVE_CANDIDATE_COUNT ? ADAPTIVE_CANDIDATES[i_candidate] : NULL;
+}
+
+/// <summary>
+/// Gets the deallocation strategy that must be paired with an allocation strategy.
+/// </summary>
+/// <param name="strategy">The allocation strategy.</param>
+/// <returns>The deallocation strategy, or null if the allocation strategy uses the default coalescing of contiguous free blocks.</returns>
+mem_deallocation_strategy_t mem_deallocation_strategy_of (mem_allocation_strategy_t strategy) {
+	if (strategy == &mem_allocation_strategy_buddy) {
+		return &mem_deallocation_strategy_buddy;
+	}
+
+	if (strategy == &mem_allocation_strategy_tlsf) {
+		return &mem_deallocation_strategy_tlsf;
+	}
+
+	return NULL;
+}
+
+/// <summary>
+/// Gets the reallocation strategy that must be paired with an allocation strategy.
+/// </summary>
+/// <param name="strategy">The allocation strategy.</param>
+/// <returns>The reallocation strategy, or null if the allocation strategy uses the default growth into the next free block.</returns>
+mem_reallocation_strategy_t mem_reallocation_strategy_of (mem_allocation_strategy_t strategy) {
+	if (strategy == &mem_allocation_strategy_buddy) {
+		return &mem_reallocation_strategy_buddy;
+	}
+
+	if (strategy == &mem_allocation_strategy_bitmap) {
+		return &mem_reallocation_strategy_bitmap;
+	}
+
+	return NULL;
+}
+
+/// <summary>
+/// Gets the aligned allocation strategy that must be paired with an allocation strategy.
+/// </summary>
+/// <param name="strategy">The allocation strategy.</param>
+/// <returns>The aligned allocation strategy, or null if the allocation strategy uses the default padding by the alignment.</returns>
+mem_aligned_allocation_strategy_t mem_aligned_allocation_strategy_of (mem_allocation_strategy_t strategy) {
+	if (strategy == &mem_allocation_strategy_buddy) {
+		return &mem_aligned_allocation_strategy_buddy;
+	}
+
+	if (strategy == &mem_allocation_strategy_bitmap) {
+		return &mem_aligned_allocation_strategy_bitmap;
+	}
+
+	return NULL;
+}
+
+/// <summary>
+/// Gets the allocation strategy of a name.
+/// </summary>
+/// <param name="name">The name of the strategy. Values are first, first-soa, best, worst, next, segregated, buddy, tlsf, bitmap, adaptive.</param>
+/// <returns>The allocation strategy, or null if the name is not known.</returns>
+mem_allocation_strategy_t mem_allocation_strategy_of_name (const char* name) {
+	if (name == NULL) {
+		return NULL;
+	}
+
+	if (strcmp(name, "first") == 0) return &mem_allocation_strategy_first_fit;
+	if (strcmp(name, "first-soa") == 0) return &mem_allocation_strategy_first_fit_arrays;
+	if (strcmp(name, "best") == 0) return &mem_allocation_strategy_best_fit;
+	if (strcmp(name, "worst") == 0) return &mem_allocation_strategy_worst_fit;
+	if (strcmp(name, "next") == 0) return &mem_allocation_strategy_next_fit;
+	if (strcmp(name, "segregated") == 0) return &mem_allocation_strategy_segregated_fit;
+	if (strcmp(name, "buddy") == 0) return &mem_allocation_strategy_buddy;
+	if (strcmp(name, "tlsf") == 0) return &mem_allocation_strategy_tlsf;
+	if (strcmp(name, "bitmap") == 0) return &mem_allocation_strategy_bitmap;
+	if (strcmp(name, "adaptive") == 0) return &mem_allocation_strategy_adaptive;
+	return NULL;
+}
+
+/// <summary>
+/// Gets the name of an allocation strategy.
+/// </summary>
+/// <param name="strategy">The allocation strategy.</param>
+/// <returns>The name of the strategy, or null if the strategy is not known.</returns>
+const char* mem_allocation_strategy_name_of (mem_allocation_strategy_t strategy) {
+	if (strategy == &mem_allocation_strategy_first_fit) return "first";
+	if (strategy == &mem_allocation_strategy_first_fit_arrays) return "first-soa";
+	if (strategy == &mem_allocation_strategy_best_fit) return "best";
+	if (strategy == &mem_allocation_strategy_worst_fit) return "worst";
+	if (strategy == &mem_allocation_strategy_next_fit) return "next";
+	if (strategy == &mem_allocation_strategy_segregated_fit) return "segregated";
+	if (strategy == &mem_allocation_strategy_buddy) return "buddy";
+	if (strategy == &mem_allocation_strategy_tlsf) return "tlsf";
+	if (strategy == &mem_allocation_strategy_bitmap) return "bitmap";
+	if (strategy == &mem_allocation_strategy_adaptive) return "adaptive";
+	return NULL;
 }
\ No newline at end of file
@@ -4,39 +4,253 @@
 #include "../lib/collections.h"
 #include "commons.h"
 
+// Structure for an allocator. It is defined by the allocator, and strategies keep their state in it.
+typedef struct allocator_t allocator_t;
+
+// Number of strategies among which the adaptive strategy switches.
+#define ADAPTIVE_CANDIDATE_COUNT 5
+
+// Number of allocations of a window of the adaptive strategy. The candidate in use is measured over a window, then the next one is chosen.
+#define ADAPTIVE_WINDOW_SIZE 512
+
+// Number of windows between two explorations, when the candidate measured the longest ago runs for a window.
+#define ADAPTIVE_EXPLORATION_PERIOD 16
+
+// Number of the last switches kept by the adaptive strategy.
+#define ADAPTIVE_SWITCH_HISTORY 8
+
+// Structure for a switch of the adaptive strategy from one candidate to another, with the measurements of the window that ended.
+typedef struct adaptive_switch_t {
+	unsigned long window;
+	unsigned int from;
+	unsigned int to;
+	double search_length;
+	double fragmentation;
+	double failure_rate;
+} adaptive_switch_t;
+
+// Structure for the state of the adaptive strategy.
+// The cost of a window is its mean search length, the growth of the fragmentation over it and its rate of failed allocations, weighted.
+typedef struct adaptive_state_t {
+	// The index of the candidate in use.
+	unsigned int i_current;
+
+	// The measurements of the current window, from its start.
+	unsigned int window_allocation_count;
+	unsigned int window_failure_count;
+	unsigned long window_search_step_start;
+	double window_fragmentation_start;
+
+	// The count of windows that ended, and the averaged cost and the index of the last window of every candidate.
+	unsigned long window_count;
+	double costs[ADAPTIVE_CANDIDATE_COUNT];
+	unsigned long last_windows[ADAPTIVE_CANDIDATE_COUNT];
+
+	// The counts of windows and allocations of every candidate.
+	unsigned long window_counts[ADAPTIVE_CANDIDATE_COUNT];
+	unsigned long allocation_counts[ADAPTIVE_CANDIDATE_COUNT];
+
+	// The count of switches, and the last of them in a ring.
+	unsigned long switch_count;
+	adaptive_switch_t switches[ADAPTIVE_SWITCH_HISTORY];
+} adaptive_state_t;
+
 // Function pointer for a memory allocation strategy.
-typedef int (*mem_allocation_strategy_t)(linkedlist_t* free_block_list, ptr_t* pointer);
+typedef int (*mem_allocation_strategy_t)(allocator_t* allocator, ptr_t* pointer);
+
+// Function pointer for a memory deallocation strategy. It puts the memory of the pointer back into the free blocks.
+typedef int (*mem_deallocation_strategy_t)(allocator_t* allocator, ptr_t* pointer);
+
+// Function pointer for a memory reallocation strategy. It resizes the allocated block of the pointer in place, or fails with OUT_OF_MEMORY_ERRNO.
+typedef int (*mem_reallocation_strategy_t)(allocator_t* allocator, ptr_t* pointer, sz_t size);
+
+// Function pointer for an aligned memory allocation strategy. It allocates a block whose address is a multiple of the alignment.
+typedef int (*mem_aligned_allocation_strategy_t)(allocator_t* allocator, ptr_t* pointer, sz_t alignment);
 
 /// <summary>
 /// Allocates a block of memory into the pointer argument from the list of free blocks using the first fit strategy.
 /// </summary>
-/// <param name="free_block_list">The list of free block.</param>
+/// <param name="allocator">The allocator.</param>
+/// <param name="pointer">The pointer into which to allocate.</param>
+/// <returns>The state code.</returns>
+int mem_allocation_strategy_first_fit (allocator_t* allocator, ptr_t* pointer);
+
+/// <summary>
+/// Allocates a block of memory into the pointer argument using the first fit strategy, from the free blocks as arrays ordered by address.
+/// The sizes are read from contiguous memory, many at once, instead of following the nodes of the free block list.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
 /// <param name="pointer">The pointer into which to allocate.</param>
 /// <returns>The state code.</returns>
-int mem_allocation_strategy_first_fit (linkedlist_t* free_block_list, ptr_t* pointer);
+int mem_allocation_strategy_first_fit_arrays (allocator_t* allocator, ptr_t* pointer);
 
 /// <summary>
-/// Allocates a block of memory into the pointer argument from the list of free blocks using the best fit strategy.
+/// Allocates a block of memory into the pointer argument from the size tree of free blocks using the best fit strategy.
 /// </summary>
-/// <param name="free_block_list">The list of free block.</param>
+/// <param name="allocator">The allocator.</param>
 /// <param name="pointer">The pointer into which to allocate.</param>
 /// <returns>The state code.</returns>
-int mem_allocation_strategy_best_fit (linkedlist_t* free_block_list, ptr_t* pointer);
+int mem_allocation_strategy_best_fit (allocator_t* allocator, ptr_t* pointer);
 
 /// <summary>
-/// Allocates a block of memory into the pointer argument from the list of free blocks using the worst fit strategy.
+/// Allocates a block of memory into the pointer argument from the size tree of free blocks using the worst fit strategy.
 /// </summary>
-/// <param name="free_block_list">The list of free block.</param>
+/// <param name="allocator">The allocator.</param>
 /// <param name="pointer">The pointer into which to allocate.</param>
 /// <returns>The state code.</returns>
-int mem_allocation_strategy_worst_fit (linkedlist_t* free_block_list, ptr_t* pointer);
+int mem_allocation_strategy_worst_fit (allocator_t* allocator, ptr_t* pointer);
 
 /// <summary>
 /// Allocates a block of memory into the pointer argument from the list of free blocks using the next fit strategy.
 /// </summary>
-/// <param name="free_block_list">The list of free block.</param>
+/// <param name="allocator">The allocator.</param>
+/// <param name="pointer">The pointer into which to allocate.</param>
+/// <returns>The state code.</returns>
+int mem_allocation_strategy_next_fit (allocator_t* allocator, ptr_t* pointer);
+
+/// <summary>
+/// Allocates a block of memory into the pointer argument from the size class bins of free blocks using the segregated fit strategy.
+/// The sub-bin of the requested size class is searched first. Any block from a greater size class fits.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <param name="pointer">The pointer into which to allocate.</param>
+/// <returns>The state code.</returns>
+int mem_allocation_strategy_segregated_fit (allocator_t* allocator, ptr_t* pointer);
+
+/// <summary>
+/// Allocates a block of memory into the pointer argument from the size class bins of free blocks using the buddy system.
+/// The size of the pointer is rounded up to a power of two, and greater blocks are halved until one has that size.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <param name="pointer">The pointer into which to allocate. Its size is set to the rounded size.</param>
+/// <returns>The state code.</returns>
+int mem_allocation_strategy_buddy (allocator_t* allocator, ptr_t* pointer);
+
+/// <summary>
+/// Allocates an aligned block of memory into the pointer argument using the buddy system.
+/// Blocks are aligned on their size, so the size is raised to the alignment, if it is smaller.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <param name="pointer">The pointer into which to allocate. Its size is set to the rounded size.</param>
+/// <param name="alignment">The alignment of the address. It must be a power of two.</param>
+/// <returns>The state code.</returns>
+int mem_aligned_allocation_strategy_buddy (allocator_t* allocator, ptr_t* pointer, sz_t alignment);
+
+/// <summary>
+/// Puts the memory of the pointer back into the free blocks using the buddy system.
+/// The memory is cut into aligned power of two blocks, and every block is merged with its buddy for as long as the buddy is free.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <param name="pointer">The pointer from which to free.</param>
+/// <returns>The state code.</returns>
+int mem_deallocation_strategy_buddy (allocator_t* allocator, ptr_t* pointer);
+
+/// <summary>
+/// Resizes the allocated block of the pointer in place using the buddy system.
+/// The size is rounded up to a power of two. A block shrinks by giving its upper halves back, and grows by taking its free buddies, for as long as it is their lower half.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <param name="pointer">The pointer to resize. Its size is set to the rounded size.</param>
+/// <param name="size">The new size of the allocation.</param>
+/// <returns>The state code. OUT_OF_MEMORY_ERRNO if the block cannot grow in place.</returns>
+int mem_reallocation_strategy_buddy (allocator_t* allocator, ptr_t* pointer, sz_t size);
+
+/// <summary>
+/// Allocates a block of memory into the pointer argument from the size class sub-bins of free blocks using the two-level segregated fit strategy.
+/// The size is rounded up to the next sub-bin, so the first block of any non-empty sub-bin from there fits without a search.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
 /// <param name="pointer">The pointer into which to allocate.</param>
 /// <returns>The state code.</returns>
-int mem_allocation_strategy_next_fit (linkedlist_t* free_block_list, ptr_t* pointer);
+int mem_allocation_strategy_tlsf (allocator_t* allocator, ptr_t* pointer);
+
+/// <summary>
+/// Puts the memory of the pointer back into the free blocks using the two-level segregated fit strategy.
+/// The memory is merged right away with the free blocks right before and after it.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <param name="pointer">The pointer from which to free.</param>
+/// <returns>The state code.</returns>
+int mem_deallocation_strategy_tlsf (allocator_t* allocator, ptr_t* pointer);
+
+/// <summary>
+/// Allocates a block of memory into the pointer argument from the bitmap of granules of free blocks, with the first run of free granules that is long enough.
+/// The size is rounded up to whole granules, and the bitmap is searched a word at a time.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <param name="pointer">The pointer into which to allocate. Its size is set to the rounded size.</param>
+/// <returns>The state code.</returns>
+int mem_allocation_strategy_bitmap (allocator_t* allocator, ptr_t* pointer);
+
+/// <summary>
+/// Allocates an aligned block of memory into the pointer argument from the bitmap of granules of free blocks.
+/// Granules are aligned on their size, so only an alignment greater than a granule pads the run, and the padding is given back in whole granules.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <param name="pointer">The pointer into which to allocate. Its size is set to the rounded size.</param>
+/// <param name="alignment">The alignment of the address. It must be a power of two.</param>
+/// <returns>The state code.</returns>
+int mem_aligned_allocation_strategy_bitmap (allocator_t* allocator, ptr_t* pointer, sz_t alignment);
+
+/// <summary>
+/// Resizes the allocated block of the pointer in place to whole granules. A block shrinks by giving its tail back, and grows into the free block right after it.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <param name="pointer">The pointer to resize. Its size is set to the rounded size.</param>
+/// <param name="size">The new size of the allocation.</param>
+/// <returns>The state code. OUT_OF_MEMORY_ERRNO if the block cannot grow in place.</returns>
+int mem_reallocation_strategy_bitmap (allocator_t* allocator, ptr_t* pointer, sz_t size);
+
+/// <summary>
+/// Allocates a block of memory into the pointer argument with one of the first, best, worst, next and segregated fit strategies, switched as the workload goes.
+/// Every window of allocations measures the search length, the fragmentation and the failure rate of the strategy in use. The cheapest strategy runs next,
+/// and every other strategy is measured again from time to time. All of them share the default coalescing of contiguous free blocks, so any can follow another.
+/// </summary>
+/// <param name="allocator">The allocator.</param>
+/// <param name="pointer">The pointer into which to allocate.</param>
+/// <returns>The state code.</returns>
+int mem_allocation_strategy_adaptive (allocator_t* allocator, ptr_t* pointer);
+
+/// <summary>
+/// Gets a strategy among which the adaptive strategy switches.
+/// </summary>
+/// <param name="i_candidate">The index of the candidate.</param>
+/// <returns>The allocation strategy, or null if the index is out of bounds.</returns>
+mem_allocation_strategy_t mem_adaptive_candidate (unsigned int i_candidate);
+
+/// <summary>
+/// Gets the deallocation strategy that must be paired with an allocation strategy.
+/// </summary>
+/// <param name="strategy">The allocation strategy.</param>
+/// <returns>The deallocation strategy, or null if the allocation strategy uses the default coalescing of contiguous free blocks.</returns>
+mem_deallocation_strategy_t mem_deallocation_strategy_of (mem_allocation_strategy_t strategy);
+
+/// <summary>
+/// Gets the reallocation strategy that must be paired with an allocation strategy.
+/// </summary>
+/// <param name="strategy">The allocation strategy.</param>
+/// <returns>The reallocation strategy, or null if the allocation strategy uses the default growth into the next free block.</returns>
+mem_reallocation_strategy_t mem_reallocation_strategy_of (mem_allocation_strategy_t strategy);
+
+/// <summary>
+/// Gets the aligned allocation strategy that must be paired with an allocation strategy.
+/// </summary>
+/// <param name="strategy">The allocation strategy.</param>
+/// <returns>The aligned allocation strategy, or null if the allocation strategy uses the default padding by the alignment.</returns>
+mem_aligned_allocation_strategy_t mem_aligned_allocation_strategy_of (mem_allocation_strategy_t strategy);
+
+/// <summary>
+/// Gets the allocation strategy of a name.
+/// </summary>
+/// <param name="name">The name of the strategy. Values are first, first-soa, best, worst, next, segregated, buddy, tlsf, bitmap, adaptive.</param>
+/// <returns>The allocation strategy, or null if the name is not known.</returns>
+mem_allocation_strategy_t mem_allocation_strategy_of_name (const char* name);
+
+/// <summary>
+/// Gets the name of an allocation strategy.
+/// </summary>
+/// <param name="strategy">The allocation strategy.</param>
+/// <returns>The name of the strategy, or null if the strategy is not known.</returns>
+const char* mem_allocation_strategy_name_of (mem_allocation_strategy_t strategy);
 
 #endif
\ No newline at end of file
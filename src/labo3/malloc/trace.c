@@ -0,0 +1,300 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <errno.h>
+
+#include "../lib/collections.h"
+#include "../lib/logging.h"
+#include "trace.h"
+
+/// <summary>
+/// Creates the trace file at a path, writes its header, and starts recording.
+/// </summary>
+/// <param name="recorder">The recorder to initialize.</param>
+/// <param name="path">The path of the trace file. An existing file is replaced.</param>
+/// <returns>The state code.</returns>
+int mem_trace_recorder_open(trace_recorder_t* recorder, const char* path) {
+	log_debug("Entering mem_trace_recorder_open(). Path: %s.", path);
+	if (recorder == NULL || path == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	memset(recorder, 0, sizeof(trace_recorder_t));
+	if ((recorder->file = fopen(path, "wb")) == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	trace_header_t header = { TRACE_MAGIC, TRACE_VERSION, sizeof(trace_event_t), 0 };
+	setvbuf(recorder->file, NULL, _IOFBF, TRACE_BUFFER_SIZE);
+	if (fwrite(&header, sizeof(trace_header_t), 1, recorder->file) != 1 || hashmap_init(&recorder->ids, TRACE_IDS_INITIAL_CAPACITY) != SUCCESSFUL_EXEC) {
+		fclose(recorder->file);
+		return OUT_OF_MEMORY_ERRNO;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &recorder->start);
+
+	log_debug("Exiting mem_trace_recorder_open().");
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Flushes the remaining events into the trace file and closes it.
+/// </summary>
+/// <param name="recorder">The recorder.</param>
+/// <returns>The state code.</returns>
+int mem_trace_recorder_close(trace_recorder_t* recorder) {
+	log_debug("Entering mem_trace_recorder_close().");
+	if (recorder == NULL || recorder->file == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	int result = fclose(recorder->file) ? OUT_OF_MEMORY_ERRNO : SUCCESSFUL_EXEC;
+	recorder->file = NULL;
+	hashmap_destroy(&recorder->ids);
+	free(recorder->free_ids);
+	recorder->free_ids = NULL;
+
+	log_debug("Exiting mem_trace_recorder_close(). Event count: %lu.", recorder->event_count);
+	return result;
+}
+
+/// <summary>
+/// Writes an event, stamped with the time since the start of the recording.
+/// </summary>
+/// <param name="recorder">The recorder.</param>
+/// <param name="type">The type of the event.</param>
+/// <param name="id">The id of the block.</param>
+/// <param name="size">The size of the block.</param>
+/// <returns>The state code.</returns>
+static int mem_trace_write(trace_recorder_t* recorder, unsigned int type, uint32_t id, sz_t size) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	uint64_t ns = (now.tv_sec - recorder->start.tv_sec) * 1000000000ULL + now.tv_nsec - recorder->start.tv_nsec;
+	trace_event_t event = { (ns & ((1ULL << TRACE_TIME_BITS) - 1)) | (uint64_t) type << TRACE_TIME_BITS, size, id, 0 };
+	if (fwrite(&event, sizeof(trace_event_t), 1, recorder->file) != 1) {
+		return OUT_OF_MEMORY_ERRNO;
+	}
+
+	recorder->event_count++;
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Gets the id of the live block at an address.
+/// </summary>
+/// <param name="recorder">The recorder.</param>
+/// <param name="address">The address of the block.</param>
+/// <param name="id">The out argument for the id.</param>
+/// <returns>Whether the block has an id.</returns>
+static int mem_trace_find_id(trace_recorder_t* recorder, mem_address_t address, uint32_t* id) {
+	void* value;
+	hashmap_get(&recorder->ids, address, &value);
+	if (value == NULL) {
+		return 0;
+	}
+
+	*id = (uint32_t) ((unsigned long) value - 1);
+	return 1;
+}
+
+/// <summary>
+/// Records the allocation of a block. It is given an id.
+/// </summary>
+/// <param name="recorder">The recorder.</param>
+/// <param name="address">The address of the block.</param>
+/// <param name="size">The size of the block.</param>
+/// <returns>The state code.</returns>
+int mem_trace_record_allocation(trace_recorder_t* recorder, mem_address_t address, sz_t size) {
+	if (recorder == NULL || recorder->file == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	// The ids given back are given again first, so ids stay dense.
+	uint32_t id = recorder->free_id_count ? recorder->free_ids[--recorder->free_id_count] : recorder->next_id++;
+	if (hashmap_put(&recorder->ids, address, (void*) ((unsigned long) id + 1)) != SUCCESSFUL_EXEC) {
+		return COLLECTIONS_ERRNO;
+	}
+
+	return mem_trace_write(recorder, TRACE_EVENT_ALLOCATION, id, size);
+}
+
+/// <summary>
+/// Records the free of a block. Its id can be given again.
+/// A block allocated before the recording started has no id, so its free is not recorded.
+/// </summary>
+/// <param name="recorder">The recorder.</param>
+/// <param name="address">The address of the block.</param>
+/// <returns>The state code.</returns>
+int mem_trace_record_free(trace_recorder_t* recorder, mem_address_t address) {
+	if (recorder == NULL || recorder->file == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	uint32_t id;
+	if (!mem_trace_find_id(recorder, address, &id)) {
+		return SUCCESSFUL_EXEC;
+	}
+
+	// The stack of ids given back doubles as needed.
+	if (recorder->free_id_count == recorder->free_id_capacity) {
+		unsigned int capacity = recorder->free_id_capacity ? 2 * recorder->free_id_capacity : TRACE_IDS_INITIAL_CAPACITY;
+		uint32_t* free_ids = realloc(recorder->free_ids, capacity * sizeof(uint32_t));
+		if (free_ids == NULL) {
+			return OUT_OF_MEMORY_ERRNO;
+		}
+
+		recorder->free_ids = free_ids;
+		recorder->free_id_capacity = capacity;
+	}
+
+	hashmap_remove(&recorder->ids, address);
+	recorder->free_ids[recorder->free_id_count++] = id;
+	return mem_trace_write(recorder, TRACE_EVENT_FREE, id, 0);
+}
+
+/// <summary>
+/// Records the reallocation of a block, which keeps its id.
+/// A block allocated before the recording started has no id, so it is recorded as an allocation.
+/// </summary>
+/// <param name="recorder">The recorder.</param>
+/// <param name="address">The address of the block before the reallocation.</param>
+/// <param name="new_address">The address of the block after the reallocation. It is the same if the block did not move.</param>
+/// <param name="size">The new size of the block.</param>
+/// <returns>The state code.</returns>
+int mem_trace_record_reallocation(trace_recorder_t* recorder, mem_address_t address, mem_address_t new_address, sz_t size) {
+	if (recorder == NULL || recorder->file == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	uint32_t id;
+	if (!mem_trace_find_id(recorder, address, &id)) {
+		return mem_trace_record_allocation(recorder, new_address, size);
+	}
+
+	int result = mem_trace_record_relocation(recorder, address, new_address);
+	if (result != SUCCESSFUL_EXEC) {
+		return result;
+	}
+
+	return mem_trace_write(recorder, TRACE_EVENT_REALLOCATION, id, size);
+}
+
+/// <summary>
+/// Follows a block moved by the allocator itself, as by a compaction. No event is recorded, since the program did not ask for it.
+/// </summary>
+/// <param name="recorder">The recorder.</param>
+/// <param name="address">The address of the block before it moved.</param>
+/// <param name="new_address">The address of the block after it moved.</param>
+/// <returns>The state code.</returns>
+int mem_trace_record_relocation(trace_recorder_t* recorder, mem_address_t address, mem_address_t new_address) {
+	if (recorder == NULL || recorder->file == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	uint32_t id;
+	if (address == new_address || !mem_trace_find_id(recorder, address, &id)) {
+		return SUCCESSFUL_EXEC;
+	}
+
+	hashmap_remove(&recorder->ids, address);
+	if (hashmap_put(&recorder->ids, new_address, (void*) ((unsigned long) id + 1)) != SUCCESSFUL_EXEC) {
+		return COLLECTIONS_ERRNO;
+	}
+
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Maps a trace file in memory, read only, and checks its header. The pages are read as the events are, so traces larger than memory can be read.
+/// A trace of another version of the format is rejected.
+/// </summary>
+/// <param name="trace">The trace to initialize.</param>
+/// <param name="path">The path of the trace file.</param>
+/// <returns>The state code.</returns>
+int mem_trace_map(trace_t* trace, const char* path) {
+	log_debug("Entering mem_trace_map(). Path: %s.", path);
+	if (trace == NULL || path == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	int file = open(path, O_RDONLY);
+	if (file < 0) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	struct stat status;
+	if (fstat(file, &status) || status.st_size < (off_t) sizeof(trace_header_t)) {
+		close(file);
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	// The mapping stays valid once the file is closed.
+	void* mapping = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);
+	if (mapping == MAP_FAILED) {
+		return OUT_OF_MEMORY_ERRNO;
+	}
+
+	const trace_header_t* header = mapping;
+	if (header->magic != TRACE_MAGIC || header->version != TRACE_VERSION || header->event_size != sizeof(trace_event_t)) {
+		munmap(mapping, status.st_size);
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	// The events are read once, in order. A truncated last event, as left by a crashed recording, is ignored.
+	madvise(mapping, status.st_size, MADV_SEQUENTIAL);
+	trace->mapping = mapping;
+	trace->mapping_size = status.st_size;
+	trace->released_size = 0;
+	trace->events = (const trace_event_t*) (header + 1);
+	trace->event_count = (status.st_size - sizeof(trace_header_t)) / sizeof(trace_event_t);
+
+	log_debug("Exiting mem_trace_map(). Event count: %lu.", trace->event_count);
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Releases the pages of a mapped trace before an event, once they were read.
+/// </summary>
+/// <param name="trace">The trace.</param>
+/// <param name="i_event">The index of the first event still needed.</param>
+/// <returns>The state code.</returns>
+int mem_trace_release(trace_t* trace, unsigned long i_event) {
+	if (trace == NULL || trace->mapping == NULL || i_event > trace->event_count) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	// Only whole pages can be released.
+	unsigned long page_size = sysconf(_SC_PAGESIZE);
+	unsigned long size = ((const char*) &trace->events[i_event] - (const char*) trace->mapping) / page_size * page_size;
+	if (size > trace->released_size) {
+		madvise((char*) trace->mapping + trace->released_size, size - trace->released_size, MADV_DONTNEED);
+		trace->released_size = size;
+	}
+
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Unmaps a trace file mapped by mem_trace_map().
+/// </summary>
+/// <param name="trace">The trace.</param>
+/// <returns>The state code.</returns>
+int mem_trace_unmap(trace_t* trace) {
+	log_debug("Entering mem_trace_unmap().");
+	if (trace == NULL || trace->mapping == NULL || munmap(trace->mapping, trace->mapping_size)) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	trace->mapping = NULL;
+	trace->events = NULL;
+	trace->event_count = 0;
+
+	log_debug("Exiting mem_trace_unmap().");
+	return SUCCESSFUL_EXEC;
+}
\ No newline at end of file
@@ -0,0 +1,158 @@
+#ifndef MALLOC_TRACE_H
+#define MALLOC_TRACE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "../lib/collections.h"
+#include "commons.h"
+
+// The magic number at the start of a trace file, "SPTR" in little endian, and the version of its format.
+// Version 2 widened the size of the events to 64 bits.
+#define TRACE_MAGIC 0x52545053
+#define TRACE_VERSION 2
+
+// Types of the events of a trace.
+#define TRACE_EVENT_ALLOCATION 1
+#define TRACE_EVENT_FREE 2
+#define TRACE_EVENT_REALLOCATION 3
+
+// The stamp of an event holds its time in its low bits, and its type in the bits above.
+#define TRACE_TIME_BITS 56
+#define TRACE_EVENT_TYPE(event) ((unsigned int) ((event)->stamp >> TRACE_TIME_BITS))
+#define TRACE_EVENT_TIME(event) ((event)->stamp & ((1ULL << TRACE_TIME_BITS) - 1))
+
+// Initial capacity of the table of ids of a recorder. It doubles as needed.
+#define TRACE_IDS_INITIAL_CAPACITY 1024
+
+// Size of the write buffer of a recorder.
+#define TRACE_BUFFER_SIZE (1 << 16)
+
+// Structure for the header of a trace file. The events follow it, up to the end of the file.
+typedef struct trace_header_t {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t event_size;
+	uint32_t reserved;
+} trace_header_t;
+
+// Structure for an event of a trace, in 24 bytes.
+// The id of a block is given at its allocation, kept by its reallocations, moved or not, and given again after its free.
+// So ids stay below the peak count of live blocks. The size is the new size of the block, or 0 for a free.
+typedef struct trace_event_t {
+	// The nanoseconds since the start of the recording, and the type of the event.
+	uint64_t stamp;
+	uint64_t size;
+	uint32_t id;
+	uint32_t reserved;
+} trace_event_t;
+
+// Structure for a recorder of the events of an allocator into a trace file.
+typedef struct trace_recorder_t {
+	FILE* file;
+	struct timespec start;
+
+	// The ids of the live blocks by address, plus one, so that no value is null.
+	hashmap_t ids;
+
+	// The stack of the ids given back by frees, and the next id never given.
+	uint32_t* free_ids;
+	unsigned int free_id_count;
+	unsigned int free_id_capacity;
+	uint32_t next_id;
+
+	unsigned long event_count;
+} trace_recorder_t;
+
+// Structure for a trace file mapped in memory, to read its events in place.
+typedef struct trace_t {
+	const trace_event_t* events;
+	unsigned long event_count;
+
+	// The mapping of the whole file, header included.
+	void* mapping;
+	unsigned long mapping_size;
+
+	// The size of the start of the mapping whose pages were released.
+	unsigned long released_size;
+} trace_t;
+
+/// <summary>
+/// Creates the trace file at a path, writes its header, and starts recording.
+/// </summary>
+/// <param name="recorder">The recorder to initialize.</param>
+/// <param name="path">The path of the trace file. An existing file is replaced.</param>
+/// <returns>The state code.</returns>
+int mem_trace_recorder_open(trace_recorder_t* recorder, const char* path);
+
+/// <summary>
+/// Flushes the remaining events into the trace file and closes it.
+/// </summary>
+/// <param name="recorder">The recorder.</param>
+/// <returns>The state code.</returns>
+int mem_trace_recorder_close(trace_recorder_t* recorder);
+
+/// <summary>
+/// Records the allocation of a block. It is given an id.
+/// </summary>
+/// <param name="recorder">The recorder.</param>
+/// <param name="address">The address of the block.</param>
+/// <param name="size">The size of the block.</param>
+/// <returns>The state code.</returns>
+int mem_trace_record_allocation(trace_recorder_t* recorder, mem_address_t address, sz_t size);
+
+/// <summary>
+/// Records the free of a block. Its id can be given again.
+/// A block allocated before the recording started has no id, so its free is not recorded.
+/// </summary>
+/// <param name="recorder">The recorder.</param>
+/// <param name="address">The address of the block.</param>
+/// <returns>The state code.</returns>
+int mem_trace_record_free(trace_recorder_t* recorder, mem_address_t address);
+
+/// <summary>
+/// Records the reallocation of a block, which keeps its id.
+/// A block allocated before the recording started has no id, so it is recorded as an allocation.
+/// </summary>
+/// <param name="recorder">The recorder.</param>
+/// <param name="address">The address of the block before the reallocation.</param>
+/// <param name="new_address">The address of the block after the reallocation. It is the same if the block did not move.</param>
+/// <param name="size">The new size of the block.</param>
+/// <returns>The state code.</returns>
+int mem_trace_record_reallocation(trace_recorder_t* recorder, mem_address_t address, mem_address_t new_address, sz_t size);
+
+/// <summary>
+/// Follows a block moved by the allocator itself, as by a compaction. No event is recorded, since the program did not ask for it.
+/// </summary>
+/// <param name="recorder">The recorder.</param>
+/// <param name="address">The address of the block before it moved.</param>
+/// <param name="new_address">The address of the block after it moved.</param>
+/// <returns>The state code.</returns>
+int mem_trace_record_relocation(trace_recorder_t* recorder, mem_address_t address, mem_address_t new_address);
+
+/// <summary>
+/// Maps a trace file in memory, read only, and checks its header. The pages are read as the events are, so traces larger than memory can be read.
+/// A trace of another version of the format is rejected.
+/// </summary>
+/// <param name="trace">The trace to initialize.</param>
+/// <param name="path">The path of the trace file.</param>
+/// <returns>The state code.</returns>
+int mem_trace_map(trace_t* trace, const char* path);
+
+/// <summary>
+/// Releases the pages of a mapped trace before an event, once they were read.
+/// </summary>
+/// <param name="trace">The trace.</param>
+/// <param name="i_event">The index of the first event still needed.</param>
+/// <returns>The state code.</returns>
+int mem_trace_release(trace_t* trace, unsigned long i_event);
+
+/// <summary>
+/// Unmaps a trace file mapped by mem_trace_map().
+/// </summary>
+/// <param name="trace">The trace.</param>
+/// <returns>The state code.</returns>
+int mem_trace_unmap(trace_t* trace);
+
+#endif
\ No newline at end of file
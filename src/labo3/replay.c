@@ -0,0 +1,376 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include <string.h>
+#include <sys/types.h>
+#include <errno.h>
+
+#include "lib/logging.h"
+#include "lib/collections.h"
+#include "malloc/commons.h"
+#include "malloc/strategies.h"
+#include "malloc/allocator.h"
+#include "malloc/trace.h"
+#include "replay.h"
+
+#define true 1
+#define false 0
+#define LARGE_BUFFER_SIZE 4096
+#define INITIAL_BLOCK_CAPACITY 1024
+#define SAMPLE_INTERVAL 4096
+#define RELEASE_INTERVAL (1 << 20)
+
+// Set the logging level to whatever we need for debugging purposes.
+unsigned int log_level = INFO_LVL;
+
+// The buffer size to use for logging.
+const unsigned int LOG_BUFFER_SIZE = LARGE_BUFFER_SIZE;
+
+// Constant for a successful execution.
+const int SUCCESSFUL_EXEC = 0;
+
+// Error number for illegal arguments.
+const int ILLEGAL_ARGUMENTS_ERRNO = 1;
+
+// Error number for the impossibility to allocate memory.
+const int OUT_OF_MEMORY_ERRNO = 2;
+
+// Error number when trying to dequeue an empty queue.
+const int EMPTY_QUEUE_ERRNO = 3;
+
+// Error number when trying to access or modify an out of bound index.
+const int OUT_OF_BOUNDS_ERRNO = 4;
+
+// Error number when trying to modify a null linked list.
+const int NULL_LINKED_LIST_ERRNO = 5;
+
+// Error number when trying to modify a null queue.
+const int NULL_QUEUE_ERRNO = 6;
+
+// Error number for a generic error with collection handling.
+const int COLLECTIONS_ERRNO = 7;
+
+// Error number when trying to modify a null tree.
+const int NULL_TREE_ERRNO = 8;
+
+// Error number when trying to modify a null hash map.
+const int NULL_HASHMAP_ERRNO = 9;
+
+// The replay options activated currently.
+replay_options_t replay_options;
+
+// The measurements of the replay.
+replay_stats_t replay_stats;
+
+// The blocks of the replay, by id.
+replay_blocks_t replay_blocks;
+
+// The allocator under replay.
+allocator_t allocator;
+
+/// <summary>
+/// Replays a trace of allocations and frees through a strategy.
+/// </summary>
+int main (int argc, char* argv[]) {
+	int result = parse_args(argc, argv, &replay_options);
+	if (result != SUCCESSFUL_EXEC) {
+		exit(result);
+	}
+
+	if (replay_options.verbose) log_level = TRACE_LVL;
+
+	// The trace is read in place, so it can be larger than memory.
+	trace_t trace;
+	result = mem_trace_map(&trace, replay_options.trace_path);
+	if (result != SUCCESSFUL_EXEC) {
+		log_error("Trace %s could not be read. mem_trace_map() returned %d.", replay_options.trace_path, result);
+		exit(result);
+	}
+
+	allocator_options_t allocator_options = { .address_space_first_address = replay_options.address_space_first_address, 
+		.address_space_size = replay_options.address_space_size, .is_mapped = replay_options.mapped };
+	result = mem_allocator_init(&allocator, replay_options.allocation_strategy, &allocator_options);
+	if (result != SUCCESSFUL_EXEC) {
+		log_error("Allocator could not be initialized. init_allocator() returned %d.", result);
+		exit(result);
+	}
+
+	result = replay_trace(&trace);
+	log_replay(INFO_LVL, &trace);
+
+	free(replay_blocks.pointers);
+	mem_allocator_destroy(&allocator);
+	mem_trace_unmap(&trace);
+	return result;
+}
+
+/// <summary>
+/// Replays every event of a trace through the allocator.
+/// </summary>
+/// <param name="trace">The mapped trace.</param>
+/// <returns>The state code.</returns>
+int replay_trace(trace_t* trace) {
+	log_debug("Entering replay_trace().");
+	unsigned long i_event;
+	for (i_event = 0; i_event < trace->event_count; i_event++) {
+		int result = replay_event(&trace->events[i_event]);
+		if (result != SUCCESSFUL_EXEC) {
+			log_error("Event %lu could not be replayed. replay_event() returned %d.", i_event, result);
+			return result;
+		}
+
+		if (i_event % SAMPLE_INTERVAL == SAMPLE_INTERVAL - 1) {
+			sample_fragmentation();
+		}
+
+		// The events already replayed are not read again, so their pages can go.
+		if (i_event % RELEASE_INTERVAL == RELEASE_INTERVAL - 1) {
+			mem_trace_release(trace, i_event + 1);
+		}
+	}
+
+	log_debug("Exiting replay_trace().");
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Replays one event of a trace through the allocator.
+/// Events on a block whose allocation ran out of memory are skipped.
+/// </summary>
+/// <param name="event">The event.</param>
+/// <returns>The state code.</returns>
+int replay_event(const trace_event_t* event) {
+	ptr_t* pointer = replay_block(event->id);
+	if (pointer == NULL) {
+		return OUT_OF_MEMORY_ERRNO;
+	}
+
+	unsigned int type = TRACE_EVENT_TYPE(event);
+	if (type != TRACE_EVENT_ALLOCATION && !pointer->is_allocated) {
+		replay_stats.skipped_count++;
+		return SUCCESSFUL_EXEC;
+	}
+
+	int result;
+	sz_t size = pointer->size;
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	switch (type) {
+		case TRACE_EVENT_ALLOCATION:
+			result = pointer->is_allocated ? ILLEGAL_ARGUMENTS_ERRNO : mem_allocate(&allocator, event->size, pointer);
+			break;
+		case TRACE_EVENT_FREE:
+			result = mem_free(&allocator, pointer);
+			break;
+		case TRACE_EVENT_REALLOCATION:
+			result = mem_reallocate(&allocator, pointer, event->size);
+			break;
+		default:
+			result = ILLEGAL_ARGUMENTS_ERRNO;
+			break;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	replay_stats.ns += (end.tv_sec - start.tv_sec) * 1000000000UL + end.tv_nsec - start.tv_nsec;
+
+	// Running out of memory is a result of the replay, not a failure of it.
+	if (result == OUT_OF_MEMORY_ERRNO) {
+		replay_stats.out_of_memory_count++;
+		sample_fragmentation();
+		return SUCCESSFUL_EXEC;
+	} else if (result != SUCCESSFUL_EXEC) {
+		return result;
+	}
+
+	switch (type) {
+		case TRACE_EVENT_ALLOCATION:
+			replay_stats.allocation_count++;
+			replay_stats.allocated_bytes += pointer->size;
+			break;
+		case TRACE_EVENT_FREE:
+			replay_stats.free_count++;
+			replay_stats.allocated_bytes -= size;
+			break;
+		default:
+			replay_stats.reallocation_count++;
+			replay_stats.allocated_bytes += pointer->size - (unsigned long) size;
+			break;
+	}
+
+	if (replay_stats.allocated_bytes > replay_stats.peak_allocated_bytes) {
+		replay_stats.peak_allocated_bytes = replay_stats.allocated_bytes;
+	}
+
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Gets the block of an id, and makes room for it if the id was never seen.
+/// </summary>
+/// <param name="id">The id.</param>
+/// <returns>The block, or null if there was no memory to make room for it.</returns>
+ptr_t* replay_block(uint32_t id) {
+	if (id >= replay_blocks.capacity) {
+		// Ids stay below the peak count of live blocks, so the blocks double rarely.
+		unsigned long capacity = replay_blocks.capacity ? replay_blocks.capacity : INITIAL_BLOCK_CAPACITY;
+		while (capacity <= id) {
+			capacity *= 2;
+		}
+
+		ptr_t* pointers = realloc(replay_blocks.pointers, capacity * sizeof(ptr_t));
+		if (pointers == NULL) {
+			return NULL;
+		}
+
+		memset(pointers + replay_blocks.capacity, 0, (capacity - replay_blocks.capacity) * sizeof(ptr_t));
+		replay_blocks.pointers = pointers;
+		replay_blocks.capacity = capacity;
+	}
+
+	return &replay_blocks.pointers[id];
+}
+
+/// <summary>
+/// Gets the fragmentation of the allocator: the share of its free memory that is not within its greatest free block.
+/// </summary>
+/// <returns>The fragmentation, from 0 to 1.</returns>
+double fragmentation() {
+	unsigned long free_bytes;
+	sz_t greatest_free_block;
+	mem_count_free(&allocator, &free_bytes);
+	mem_greatest_free_block(&allocator, &greatest_free_block);
+	return free_bytes ? 1.0 - (double) greatest_free_block / free_bytes : 0.0;
+}
+
+/// <summary>
+/// Samples the fragmentation of the allocator, for its mean and its peak.
+/// </summary>
+void sample_fragmentation() {
+	double sample = fragmentation();
+	replay_stats.fragmentation_sum += sample;
+	replay_stats.sample_count++;
+	if (sample > replay_stats.peak_fragmentation) {
+		replay_stats.peak_fragmentation = sample;
+	}
+}
+
+/// <summary>
+/// Logs the measurements of the replay.
+/// </summary>
+/// <param name="level">The logging level to use.</param>
+/// <param name="trace">The replayed trace.</param>
+/// <returns>The state code.</returns>
+int log_replay(const int level, const trace_t* trace) {
+	log_debug("Entering log_replay().");
+	unsigned long replayed_count = replay_stats.allocation_count + replay_stats.free_count + replay_stats.reallocation_count;
+	double seconds = replay_stats.ns / 1e9;
+	double trace_seconds = trace->event_count ? TRACE_EVENT_TIME(&trace->events[trace->event_count - 1]) / 1e9 : 0.0;
+	unsigned long sample_count = replay_stats.sample_count ? replay_stats.sample_count : 1;
+	log_format(level, "\n\tReplay (strategy %s, trace %s)"
+		"\n\t  Events: %lu, Recorded over: %.3f s"
+		"\n\t  Allocations: %lu, Frees: %lu, Reallocations: %lu"
+		"\n\t  Out of memory: %lu, Skipped: %lu"
+		"\n\t  Time: %.3f ms, Throughput: %.0f events/s"
+		"\n\t  Peak allocated bytes: %lu"
+		"\n\t  Fragmentation mean: %.1f%%, peak: %.1f%%, final: %.1f%%",
+		replay_options.allocation_strategy_name, replay_options.trace_path,
+		trace->event_count, trace_seconds,
+		replay_stats.allocation_count, replay_stats.free_count, replay_stats.reallocation_count,
+		replay_stats.out_of_memory_count, replay_stats.skipped_count,
+		replay_stats.ns / 1e6, seconds > 0 ? replayed_count / seconds : 0.0,
+		replay_stats.peak_allocated_bytes,
+		100 * replay_stats.fragmentation_sum / sample_count, 100 * replay_stats.peak_fragmentation, 100 * fragmentation());
+
+	log_debug("Exiting log_replay().");
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Parse the command line arguments into an options structure.
+/// </summary>
+/// <param name="argc">The number of arguments in argv.</param>
+/// <param name="argv">The argument vector.</param>
+/// <param name="options">The options to parse into.</param>
+/// <returns>The state code.</returns>
+int parse_args(const int argc, char* argv[], replay_options_t* options) {
+	log_debug("Entering parse_args().");
+
+	char help_buffer[LARGE_BUFFER_SIZE];
+	memset(help_buffer, 0, LARGE_BUFFER_SIZE);
+
+	if (options == NULL || argv == NULL) {
+		sprint_help(help_buffer);
+		log_fatal(help_buffer);
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	int i_arg = 1;
+	while (i_arg < argc) {
+		char* option_name = argv[i_arg];
+		if (option_name[0] == '-') {
+			if (option_name[1] == '-') {
+				// Flag options handlers.
+				if (strcmp(option_name, "--verbose") == 0) {
+					options->verbose = true;
+				} else if (strcmp(option_name, "--mapped") == 0) {
+					options->mapped = true;
+				}
+
+				i_arg++;
+			} else {
+				// Normal options handlers.
+				char* option_value = argv[i_arg + 1];
+				if (strcmp(option_name, "-help") == 0) {
+					sprint_help(help_buffer);
+					log_info(help_buffer);
+					exit(SUCCESSFUL_EXEC);
+				} else if (option_value == NULL) {
+					log_warn("Option %s has no value.", option_name);
+				} else if (strcmp(option_name, "-trace") == 0) {
+					options->trace_path = option_value;
+				} else if (strcmp(option_name, "-first-address") == 0) {
+					options->address_space_first_address = strtoul(option_value, NULL, 10);
+				} else if (strcmp(option_name, "-size") == 0) {
+					options->address_space_size = strtoul(option_value, NULL, 10);
+				} else if (strcmp(option_name, "-strategy") == 0) {
+					options->allocation_strategy_name = option_value;
+					options->allocation_strategy = mem_allocation_strategy_of_name(option_value);
+				}
+
+				i_arg += 2;
+			}
+		} else {
+			// Option scheme not recognized, skip option.
+			log_warn("Option %s is not recognized.", option_name);
+			i_arg++;
+		}
+	}
+
+	if (options->trace_path == NULL || !options->address_space_size || options->allocation_strategy == NULL) {
+		log_fatal("-trace, -size and -strategy options are required.");
+		sprint_help(help_buffer);
+		log_fatal(help_buffer);
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	log_debug("Exiting parse_args().");
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Prints the help in the given buffer.
+/// </summary>
+/// <param name="buffer">The buffer to use.</param>
+/// <returns>The state code.</returns>
+int sprint_help(char* buffer) {
+	strcat(buffer, "\n\tRequired Arguments\n");
+	strcat(buffer, "\t  -trace {string} The path of the trace to replay, as recorded by tester -trace.\n");
+	strcat(buffer, "\t  -size {int > 0} The address space size.\n");
+	strcat(buffer, "\t  -strategy {string} The strategy to use. Values are first, first-soa, best, worst, next, segregated, buddy, tlsf, bitmap, adaptive.\n");
+	strcat(buffer, "\tOptional Arguments\n");
+	strcat(buffer, "\t  -first-address {int} The address space initial value.\n");
+	strcat(buffer, "\t  --verbose {flag} Whether to log everything.\n");
+	strcat(buffer, "\t  --mapped {flag} Whether the address space is reserved with mmap, so that allocated memory is real and written to. The first address is chosen by the system.\n");
+	return SUCCESSFUL_EXEC;
+}
\ No newline at end of file
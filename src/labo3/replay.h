@@ -0,0 +1,94 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+// Structure for the options of the replay.
+typedef struct replay_options_t {
+	mem_allocation_strategy_t allocation_strategy;
+	const char* allocation_strategy_name;
+	const char* trace_path;
+	mem_address_t address_space_first_address;
+	sz_t address_space_size;
+	unsigned int verbose;
+	unsigned int mapped;
+} replay_options_t;
+
+// Structure for the blocks of the replay, by id of the trace.
+typedef struct replay_blocks_t {
+	ptr_t* pointers;
+	unsigned long capacity;
+} replay_blocks_t;
+
+// Structure for the measurements of a replay.
+// Only the time spent within the allocator is measured. The fragmentation is sampled at intervals of events and at every out of memory.
+typedef struct replay_stats_t {
+	unsigned long allocation_count;
+	unsigned long free_count;
+	unsigned long reallocation_count;
+	unsigned long out_of_memory_count;
+	unsigned long skipped_count;
+	unsigned long ns;
+	unsigned long allocated_bytes;
+	unsigned long peak_allocated_bytes;
+	unsigned long sample_count;
+	double fragmentation_sum;
+	double peak_fragmentation;
+} replay_stats_t;
+
+/// <summary>
+/// Replays every event of a trace through the allocator.
+/// </summary>
+/// <param name="trace">The mapped trace.</param>
+/// <returns>The state code.</returns>
+int replay_trace(trace_t* trace);
+
+/// <summary>
+/// Replays one event of a trace through the allocator.
+/// Events on a block whose allocation ran out of memory are skipped.
+/// </summary>
+/// <param name="event">The event.</param>
+/// <returns>The state code.</returns>
+int replay_event(const trace_event_t* event);
+
+/// <summary>
+/// Gets the block of an id, and makes room for it if the id was never seen.
+/// </summary>
+/// <param name="id">The id.</param>
+/// <returns>The block, or null if there was no memory to make room for it.</returns>
+ptr_t* replay_block(uint32_t id);
+
+/// <summary>
+/// Gets the fragmentation of the allocator: the share of its free memory that is not within its greatest free block.
+/// </summary>
+/// <returns>The fragmentation, from 0 to 1.</returns>
+double fragmentation();
+
+/// <summary>
+/// Samples the fragmentation of the allocator, for its mean and its peak.
+/// </summary>
+void sample_fragmentation();
+
+/// <summary>
+/// Logs the measurements of the replay.
+/// </summary>
+/// <param name="level">The logging level to use.</param>
+/// <param name="trace">The replayed trace.</param>
+/// <returns>The state code.</returns>
+int log_replay(const int level, const trace_t* trace);
+
+/// <summary>
+/// Parse the command line arguments into an options structure.
+/// </summary>
+/// <param name="argc">The number of arguments in argv.</param>
+/// <param name="argv">The argument vector.</param>
+/// <param name="options">The options to parse into.</param>
+/// <returns>The state code.</returns>
+int parse_args(const int argc, char* argv[], replay_options_t* options);
+
+/// <summary>
+/// Prints the help in the given buffer.
+/// </summary>
+/// <param name="buffer">The buffer to use.</param>
+/// <returns>The state code.</returns>
+int sprint_help(char* buffer);
+
+#endif
\ No newline at end of file
@@ -6,12 +6,17 @@
 #include <sys/types.h>
 #include <errno.h>
 #include <math.h>
+#include <pthread.h>
 
 #include "lib/logging.h"
 #include "lib/collections.h"
 #include "malloc/commons.h"
 #include "malloc/strategies.h"
 #include "malloc/allocator.h"
+#include "malloc/arenas.h"
+#include "malloc/regions.h"
+#include "malloc/trace.h"
+#include "workload.h"
 #include "tester.h"
 
 #define true 1
@@ -21,6 +26,18 @@
 #define DEFAULT_SMALL_BLOCK_SIZE 64
 #define DEFAULT_MAXIMUM_ALLOC 1000
 #define DEFAULT_ALLOCATE_TO_FREE_RATIO 3
+#define INITIAL_ADDRESS_ARRAY_CAPACITY 1024
+#define INITIAL_LATENCY_ARRAY_CAPACITY 4096
+#define DEFAULT_STRESS_OPERATIONS 200000
+#define MAXIMUM_STRESS_THREADS 32
+#define STRESS_SLOT_COUNT 256
+#define FREE_BATCH_SIZE 64
+#define DEFAULT_SERIES_INTERVAL 1000
+#define SEARCH_COUNT 200
+#define SEARCH_MAXIMUM_HOLE_SIZE 32
+#define SEARCH_TAIL_SIZE (1 << 20)
+#define REGION_ALLOCATION_COUNT 262144
+#define REGION_BACKGROUND_COUNT 1024
 
 // Set the logging level to whatever we need for debugging purposes.
 unsigned int log_level = INFO_LVL;
@@ -52,179 +69,1371 @@ const int NULL_QUEUE_ERRNO = 6;
 // Error number for a generic error with collection handling.
 const int COLLECTIONS_ERRNO = 7;
 
+// Error number when trying to modify a null tree.
+const int NULL_TREE_ERRNO = 8;
+
+// Error number when trying to modify a null hash map.
+const int NULL_HASHMAP_ERRNO = 9;
+
+// The alignments of the mixed-alignment workload. Half of the allocations are aligned on 16 bytes, most others on a cache line, and one in 16 on a page.
+const sz_t ALIGNMENTS[ALIGNMENT_COUNT] = { 16, 64, 4096 };
+
 // The tester options activated currently.
 tester_options_t tester_options;
 
+// The measurements of the benchmark run.
+tester_benchmark_t tester_benchmark;
+
+// The allocator under test.
+allocator_t allocator;
+
+// The sizes requested by the live pointers of the allocator under test, by key.
+hashmap_t requested_sizes;
+
+// The time series of the benchmark runs.
+tester_series_t tester_series;
+
+// The strategies compared by --compare, in the order they run.
+const char* COMPARED_STRATEGY_NAMES[COMPARED_STRATEGY_COUNT] = { "first", "first-soa", "best", "worst", "next", "segregated", "buddy", "tlsf", "bitmap", "adaptive" };
+
+// The counts of free blocks of the search benchmark.
+const unsigned int SEARCH_FREE_BLOCK_COUNTS[SEARCH_FREE_BLOCK_COUNT_COUNT] = { 10000, 100000, 1000000 };
+
+// The scans of the free blocks as arrays compared by the search benchmark, after the free block list.
+const unsigned int SEARCH_SCAN_KINDS[SEARCH_VARIANT_COUNT - 1] = { BLOCK_ARRAYS_SCAN_SCALAR, BLOCK_ARRAYS_SCAN_SSE2, BLOCK_ARRAYS_SCAN_AVX2 };
+
+// The counts of allocations per request of the region benchmark.
+const unsigned int REGION_REQUEST_SIZES[REGION_REQUEST_SIZE_COUNT] = { 16, 256, 4096 };
+
+static int compare_latency(const void* left, const void* right);
+
+/// <summary>
+/// Starts the memory allocation tests.
+/// </summary>
+int main (int argc, char* argv[]) {
+	unsigned int result;
+
+	// Parse the arguments.
+	result = parse_args(argc, argv, &tester_options);
+	if (result != SUCCESSFUL_EXEC) {
+		exit(result);
+	}
+
+	unsigned int seed = tester_options.seed ? tester_options.seed : time(NULL);
+	srand(seed);
+
+	// Set default values if applicable.
+	if (tester_options.verbose) log_level = TRACE_LVL;
+	if (!tester_options.small_block_size) tester_options.small_block_size = DEFAULT_SMALL_BLOCK_SIZE;
+	if (!tester_options.max_alloc_size) tester_options.max_alloc_size = DEFAULT_MAXIMUM_ALLOC;
+	if (!tester_options.alloc_to_free_ratio) tester_options.alloc_to_free_ratio = DEFAULT_ALLOCATE_TO_FREE_RATIO;
+	if (!tester_options.stress_operations) tester_options.stress_operations = DEFAULT_STRESS_OPERATIONS;
+	if (!tester_options.series_interval) tester_options.series_interval = DEFAULT_SERIES_INTERVAL;
+
+	// Relocatable blocks are only allocated and freed through their handles.
+	if (tester_options.compact && (tester_options.batch || tester_options.aligned || tester_options.reallocate)) {
+		log_warn("Options --batch, --aligned and --reallocate are ignored with --compact.");
+		tester_options.batch = tester_options.aligned = tester_options.reallocate = false;
+	}
+
+	// A generated workload decides its own sizes and frees.
+	if (tester_options.workload != WORKLOAD_FORMULA && (tester_options.batch || tester_options.reallocate)) {
+		log_warn("Options --batch and --reallocate are ignored with -workload.");
+		tester_options.batch = tester_options.reallocate = false;
+	}
+
+	// The stress test runs on its own arenas, and the search and region benchmarks on their own heaps.
+	if (tester_options.stress) {
+		exit(test_stress());
+	}
+
+	if (tester_options.search) {
+		exit(test_search(seed));
+	}
+
+	if (tester_options.regions) {
+		exit(test_regions(seed));
+	}
+
+	// Sample the time series into a file, if asked.
+	if (tester_options.series_path != NULL && (result = series_open(tester_options.series_path)) != SUCCESSFUL_EXEC) {
+		log_error("Series %s could not be created. series_open() returned %d.", tester_options.series_path, result);
+		exit(result);
+	}
+
+	// Run every strategy, or the one asked.
+	result = tester_options.compare ? test_compare(seed) : test_strategy(seed);
+	if (result == SUCCESSFUL_EXEC && !tester_options.compare) result = series_close(NULL, 0);
+	free(tester_benchmark.allocation_latencies.latencies);
+	free(tester_benchmark.free_latencies.latencies);
+	exit(result);
+}
+
+/// <summary>
+/// Runs the test with the strategy of the options, from a fresh allocator, then logs its measurements.
+/// </summary>
+/// <param name="seed">The seed of the random deallocations and of the workload.</param>
+/// <returns>The state code.</returns>
+int test_strategy(unsigned int seed) {
+	log_debug("Entering test_strategy().");
+	unsigned int result;
+	srand(seed);
+
+	// Initialize the array into which we add the addresses of allocated blocks.
+	address_array_t allocated_addresses = { .addresses = NULL, .length = 0, .capacity = 0 };
+
+	// Initialize the allocator.
+	allocator_options_t allocator_options = { .address_space_first_address = tester_options.address_space_first_address, .address_space_size = tester_options.address_space_size, 
+		.is_mapped = tester_options.mapped, .is_compacting = tester_options.compact, .granule_size = tester_options.granule_size, 
+		.reserved_block_count = tester_options.reserved_block_count };
+	result = mem_allocator_init(&allocator, tester_options.allocation_strategy, &allocator_options);
+	if (result != SUCCESSFUL_EXEC) {
+		log_error("Allocator could not be initialized. init_allocator() returned %d.", result);
+		return result;
+	}
+
+	if ((result = hashmap_init(&requested_sizes, 0)) != SUCCESSFUL_EXEC) {
+		mem_allocator_destroy(&allocator);
+		return result;
+	}
+
+	// Record the workload, so that it can be replayed through any strategy.
+	trace_recorder_t trace_recorder;
+	if (tester_options.trace_path != NULL) {
+		result = mem_trace_recorder_open(&trace_recorder, tester_options.trace_path);
+		if (result != SUCCESSFUL_EXEC) {
+			log_error("Trace %s could not be created. mem_trace_recorder_open() returned %d.", tester_options.trace_path, result);
+			return result;
+		}
+
+		mem_allocator_record(&allocator, &trace_recorder);
+	}
+	
+	// Log the initial state of the memory. A benchmark only logs its measurements.
+	if (tester_options.benchmark) {
+		log_level = WARN_LVL;
+	} else {
+		log_mem_state(INFO_LVL);
+		log_mem_parameters(INFO_LVL);
+	}
+
+	if (tester_options.workload != WORKLOAD_FORMULA) {
+		// Run the generated workload until the allocator run out of memory, then free the blocks still alive.
+		workload_t workload;
+		result = workload_init(&workload, tester_options.workload, tester_options.max_alloc_size, seed);
+		if (result != SUCCESSFUL_EXEC) {
+			log_error("Workload could not be initialized. workload_init() returned %d.", result);
+			return result;
+		}
+
+		test_workload_until_out_of_mem(&workload);
+		test_workload_deallocate_all(&workload);
+		workload_destroy(&workload);
+	} else {
+		// Allocate until the allocator run out of memory.
+		test_allocate_until_out_of_mem(&allocated_addresses);
+
+		// Deallocate evrything.
+		if (tester_options.batch) test_deallocate_all_batch(&allocated_addresses);
+		else test_deallocate_all(&allocated_addresses);
+	}
+
+	// A comparison only logs its ranking.
+	if (tester_options.benchmark) {
+		log_level = INFO_LVL;
+		if (!tester_options.compare) log_benchmark(INFO_LVL);
+	}
+
+	if (tester_options.reallocate) {
+		log_reallocations(INFO_LVL);
+	}
+
+	if (tester_options.aligned) {
+		log_alignments(INFO_LVL);
+	}
+
+	if (tester_options.compact) {
+		log_compaction(INFO_LVL);
+	}
+
+	if (tester_options.allocation_strategy == &mem_allocation_strategy_adaptive && !tester_options.compare) {
+		log_adaptive(INFO_LVL);
+	}
+
+	if (tester_options.allocation_strategy == &mem_allocation_strategy_bitmap && !tester_options.compare) {
+		log_bitmap(INFO_LVL);
+	}
+
+	free(allocated_addresses.addresses);
+	hashmap_destroy(&requested_sizes);
+	mem_allocator_destroy(&allocator);
+	if (tester_options.trace_path != NULL && (result = mem_trace_recorder_close(&trace_recorder)) != SUCCESSFUL_EXEC) {
+		log_error("Trace %s could not be written. mem_trace_recorder_close() returned %d.", tester_options.trace_path, result);
+		return result;
+	}
+
+	log_debug("Exiting test_strategy().");
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Compares two results of a comparison for ranking, by utilization at out of memory, then by allocation count.
+/// </summary>
+/// <param name="left">The left result.</param>
+/// <param name="right">The right result.</param>
+/// <returns>A negative value if left ranks first, 0 if both rank the same and a positive value otherwise.</returns>
+static int compare_result(const void* left, const void* right) {
+	const compare_result_t* left_result = left;
+	const compare_result_t* right_result = right;
+	if (left_result->utilization != right_result->utilization) return left_result->utilization > right_result->utilization ? -1 : 1;
+	return left_result->allocation_count > right_result->allocation_count ? -1 : left_result->allocation_count < right_result->allocation_count;
+}
+
+/// <summary>
+/// Runs the benchmark with every strategy on the same workload and the same seed, then logs the strategies ranked by utilization at out of memory.
+/// </summary>
+/// <param name="seed">The seed of the random deallocations and of the workload.</param>
+/// <returns>The state code.</returns>
+int test_compare(unsigned int seed) {
+	log_debug("Entering test_compare().");
+	compare_result_t results[COMPARED_STRATEGY_COUNT];
+	unsigned int i_strategy, j_strategy;
+	int result;
+
+	// A comparison never logs every operation, and a trace would be replaced by every strategy.
+	tester_options.benchmark = true;
+	if (tester_options.trace_path != NULL) {
+		log_warn("Option -trace is ignored with --compare.");
+		tester_options.trace_path = NULL;
+	}
+
+	for (i_strategy = 0; i_strategy < COMPARED_STRATEGY_COUNT; i_strategy++) {
+		// Every strategy starts from fresh measurements. The latency arrays keep their memory.
+		latency_array_t allocation_latencies = tester_benchmark.allocation_latencies, free_latencies = tester_benchmark.free_latencies;
+		allocation_latencies.length = free_latencies.length = 0;
+		memset(&tester_benchmark, 0, sizeof(tester_benchmark_t));
+		tester_benchmark.allocation_latencies = allocation_latencies;
+		tester_benchmark.free_latencies = free_latencies;
+		tester_series.operation_count = tester_series.allocation_window_start = tester_series.free_window_start = 0;
+
+		tester_options.allocation_strategy_name = COMPARED_STRATEGY_NAMES[i_strategy];
+		tester_options.allocation_strategy = mem_allocation_strategy_of_name(tester_options.allocation_strategy_name);
+		if ((result = test_strategy(seed)) != SUCCESSFUL_EXEC) return result;
+
+		// Latency percentiles are read from the sorted latencies.
+		qsort(tester_benchmark.allocation_latencies.latencies, tester_benchmark.allocation_latencies.length, sizeof(unsigned long), &compare_latency);
+		qsort(tester_benchmark.free_latencies.latencies, tester_benchmark.free_latencies.length, sizeof(unsigned long), &compare_latency);
+		results[i_strategy] = (compare_result_t) { .strategy_name = tester_options.allocation_strategy_name, 
+			.allocation_count = tester_benchmark.allocation_count, .allocation_ns = tester_benchmark.allocation_ns, .free_ns = tester_benchmark.free_ns,
+			.utilization = 100.0 * tester_benchmark.requested_bytes_at_oom / tester_options.address_space_size,
+			.fragmentation_at_oom = fragmentation_at_oom(),
+			.mean_fragmentation = tester_benchmark.fragmentation_sample_count ? tester_benchmark.fragmentation_sum / tester_benchmark.fragmentation_sample_count : 0,
+			.allocation_p50 = latency_array_percentile(&tester_benchmark.allocation_latencies, 50), 
+			.allocation_p99 = latency_array_percentile(&tester_benchmark.allocation_latencies, 99),
+			.free_p50 = latency_array_percentile(&tester_benchmark.free_latencies, 50), 
+			.free_p99 = latency_array_percentile(&tester_benchmark.free_latencies, 99) };
+	}
+
+	// The latency rank of a strategy is one more than the count of strategies that are faster.
+	for (i_strategy = 0; i_strategy < COMPARED_STRATEGY_COUNT; i_strategy++) {
+		results[i_strategy].latency_rank = 1;
+		for (j_strategy = 0; j_strategy < COMPARED_STRATEGY_COUNT; j_strategy++) {
+			if (results[j_strategy].allocation_p50 + results[j_strategy].free_p50 < results[i_strategy].allocation_p50 + results[i_strategy].free_p50) {
+				results[i_strategy].latency_rank++;
+			}
+		}
+	}
+
+	qsort(results, COMPARED_STRATEGY_COUNT, sizeof(compare_result_t), &compare_result);
+	log_compare(INFO_LVL, results, COMPARED_STRATEGY_COUNT);
+	if ((result = series_close(results, COMPARED_STRATEGY_COUNT)) != SUCCESSFUL_EXEC) return result;
+
+	log_debug("Exiting test_compare().");
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Allocates n pointers (defined by alloc_to_free_ratio option) then deallocates one random pointer until an out of memory error happens.
+/// </summary>
+/// <param name="allocated_addresses">The array of the addresses of currently allocated blocks.</param>
+/// <returns>The state code.</returns>
+int test_allocate_until_out_of_mem(address_array_t* allocated_addresses) {
+	log_debug("Entering test_allocate_until_out_of_mem().");
+
+	// Allocate until first out of memory error.
+	unsigned int is_oom = false, i_allocate = 0, j_allocate = 0, result;
+	while (!is_oom) {
+		// Allocate n pointers for one free, in a single batch if asked.
+		if (tester_options.batch) {
+			result = test_allocate_batch(allocated_addresses, i_allocate, &is_oom);
+			if (result != SUCCESSFUL_EXEC) return result;
+		}
+
+		for (j_allocate = 0; !tester_options.batch && !is_oom && j_allocate < tester_options.alloc_to_free_ratio; j_allocate++) {
+			// Allocate one pointer of semi random size.
+			unsigned long pointer_index = ((unsigned long) i_allocate * tester_options.alloc_to_free_ratio) + j_allocate;
+			sz_t size = ((pointer_index + 43) * 4373 / 63 * 21) % (tester_options.max_alloc_size - 1) + 1;
+			mem_address_t key;
+			result = test_allocate_pointer(pointer_index, size, &key, &is_oom);
+			if (result != SUCCESSFUL_EXEC) return result;
+			if (!is_oom) address_array_add(allocated_addresses, key);
+		}
+
+		// Deallocates one random pointer.
+		result = test_deallocate_random_pointer(allocated_addresses);
+        if (result != SUCCESSFUL_EXEC) return result;
+
+		// Resize one random pointer, if asked.
+		if (tester_options.reallocate) {
+			result = test_reallocate_random_pointer(allocated_addresses);
+			if (result != SUCCESSFUL_EXEC) return result;
+		}
+		i_allocate++;
+	}
+	
+	log_debug("Exiting test_allocate_until_out_of_mem().");
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Allocates one pointer, through a handle with --compact or aligned with --aligned, and checks it.
+/// </summary>
+/// <param name="pointer_index">The index of the pointer since the start. The alignment is derived from it.</param>
+/// <param name="size">The size of the allocation.</param>
+/// <param name="key">The out argument for the key of the pointer: its address, or its handle with --compact.</param>
+/// <param name="is_oom">The out argument for whether the allocator is out of memory.</param>
+/// <returns>The state code.</returns>
+int test_allocate_pointer(unsigned long pointer_index, sz_t size, mem_address_t* key, unsigned int* is_oom) {
+	unsigned int i_alignment = pointer_index % 16 == 15 ? 2 : pointer_index % 2, is_allocated_flag = false;
+	ptr_t pointer;
+
+	// Allocate it and act on result.
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	mem_handle_t handle = 0;
+	int result;
+	if (tester_options.compact) result = mem_allocate_handle(&allocator, size, &handle);
+	else if (tester_options.aligned) result = mem_allocate_aligned(&allocator, size, ALIGNMENTS[i_alignment], &pointer);
+	else result = mem_allocate(&allocator, size, &pointer);
+	unsigned long latency = elapsed_ns(&start);
+	if (tester_options.compact && result == SUCCESSFUL_EXEC) mem_handle_pointer(&allocator, handle, &pointer);
+	tester_benchmark.allocation_ns += latency;
+	tester_benchmark.allocation_count++;
+	latency_array_add(&tester_benchmark.allocation_latencies, latency);
+	series_count_operation();
+	if (result == OUT_OF_MEMORY_ERRNO) {
+		log_info("Memory could not be allocated because the allocator is out of memory.");
+		record_out_of_memory();
+		*is_oom = true;
+		return SUCCESSFUL_EXEC;
+	} else if (result != SUCCESSFUL_EXEC) {
+		log_error("Memory could not be allocated. mem_allocate() returned %d.", result);
+		return result;
+	}
+
+	*key = tester_options.compact ? handle : pointer.address;
+	requested_size_add(*key, size);
+
+	// An aligned allocation must honour its alignment.
+	if (tester_options.aligned) {
+		tester_benchmark.aligned_allocation_counts[i_alignment]++;
+		if (pointer.address & (ALIGNMENTS[i_alignment] - 1)) log_warn("Memory was allocated by mem_allocate_aligned() ([%lu, %lu]) but is not aligned on %lu. Might be a bug.", 
+			pointer.address, pointer.size, ALIGNMENTS[i_alignment]);
+	}
+
+	// A mapped allocation is real memory, so it must be writable in full.
+	if (tester_options.mapped) memset((void*) pointer.address, 0xA5, pointer.size);
+	if (tester_options.benchmark) return SUCCESSFUL_EXEC;
+
+	// Make sure the memory was allocated.
+	mem_is_allocated(&allocator, pointer.address, &is_allocated_flag);
+	if (is_allocated_flag) log_info("Memory was allocated: [%lu, %lu]", pointer.address, pointer.size);
+	else log_warn("Memory was allocated by mem_allocate() ([%lu, %lu]) but flagged as unallocated by mem_is_allocated(). Might be a bug.", 
+		pointer.address, pointer.size);
+
+	// Log the state of the memory after allocation.
+	log_mem_state(INFO_LVL);
+	log_mem_parameters(INFO_LVL);
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Allocates and frees as a generated workload decides, until an out of memory error happens.
+/// </summary>
+/// <param name="workload">The workload generator.</param>
+/// <returns>The state code.</returns>
+int test_workload_until_out_of_mem(workload_t* workload) {
+	log_debug("Entering test_workload_until_out_of_mem().");
+	unsigned int is_oom = false, is_dead;
+	mem_address_t key;
+	int result;
+	while (!is_oom) {
+		// Free the blocks whose lifetime ended.
+		while (workload_next_death(workload, &key, &is_dead) == SUCCESSFUL_EXEC && is_dead) {
+			if ((result = test_deallocate_pointer(key)) != SUCCESSFUL_EXEC) return result;
+		}
+
+		result = test_allocate_pointer(workload->tick, workload_next_size(workload), &key, &is_oom);
+		if (result != SUCCESSFUL_EXEC) return result;
+		if (!is_oom && (result = workload_add(workload, key)) != SUCCESSFUL_EXEC) return result;
+	}
+
+	log_debug("Exiting test_workload_until_out_of_mem().");
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Deallocates all pointers still alive in a generated workload, in the order of their deaths.
+/// </summary>
+/// <param name="workload">The workload generator.</param>
+/// <returns>The state code.</returns>
+int test_workload_deallocate_all(workload_t* workload) {
+	log_debug("Entering test_workload_deallocate_all().");
+	unsigned int is_alive;
+	mem_address_t key;
+	int result;
+	while (workload_next_alive(workload, &key, &is_alive) == SUCCESSFUL_EXEC && is_alive) {
+		if ((result = test_deallocate_pointer(key)) != SUCCESSFUL_EXEC) return result;
+	}
+
+	log_debug("Exiting test_workload_deallocate_all().");
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Allocates n pointers (defined by alloc_to_free_ratio option) with a single call to mem_allocate_batch().
+/// </summary>
+/// <param name="allocated_addresses">The array of the addresses of currently allocated blocks.</param>
+/// <param name="i_allocate">The index of the batch. The sizes are derived from it.</param>
+/// <param name="is_oom">The out argument for whether the allocator is out of memory.</param>
+/// <returns>The state code.</returns>
+int test_allocate_batch(address_array_t* allocated_addresses, unsigned int i_allocate, unsigned int* is_oom) {
+	log_debug("Entering test_allocate_batch().");
+	unsigned int count = tester_options.alloc_to_free_ratio, i_pointer, is_allocated_flag = false;
+	sz_t sizes[count];
+	ptr_t pointers[count];
+	for (i_pointer = 0; i_pointer < count; i_pointer++) {
+		unsigned long pointer_index = ((unsigned long) i_allocate * count) + i_pointer;
+		sizes[i_pointer] = ((pointer_index + 43) * 4373 / 63 * 21) % (tester_options.max_alloc_size - 1) + 1;
+	}
+
+	// Allocate the batch. The latency of every pointer is its share of the batch.
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	int result = mem_allocate_batch(&allocator, count, sizes, pointers);
+	unsigned long latency = elapsed_ns(&start);
+	tester_benchmark.allocation_ns += latency;
+	tester_benchmark.allocation_count += count;
+	for (i_pointer = 0; i_pointer < count; i_pointer++) {
+		latency_array_add(&tester_benchmark.allocation_latencies, latency / count);
+	}
+
+	series_count_operation();
+
+	if (result == OUT_OF_MEMORY_ERRNO) {
+		log_info("Memory could not be allocated because the allocator is out of memory.");
+		record_out_of_memory();
+		*is_oom = true;
+		return SUCCESSFUL_EXEC;
+	} else if (result != SUCCESSFUL_EXEC) {
+		log_error("Memory could not be allocated. mem_allocate_batch() returned %d.", result);
+		return result;
+	}
+
+	for (i_pointer = 0; i_pointer < count; i_pointer++) {
+		address_array_add(allocated_addresses, pointers[i_pointer].address);
+		requested_size_add(pointers[i_pointer].address, sizes[i_pointer]);
+		if (tester_options.mapped) memset((void*) pointers[i_pointer].address, 0xA5, pointers[i_pointer].size);
+		if (tester_options.benchmark) continue;
+
+		// Make sure the memory was allocated.
+		mem_is_allocated(&allocator, pointers[i_pointer].address, &is_allocated_flag);
+		if (is_allocated_flag) log_info("Memory was allocated: [%lu, %lu]", pointers[i_pointer].address, pointers[i_pointer].size);
+		else log_warn("Memory was allocated by mem_allocate_batch() ([%lu, %lu]) but flagged as unallocated by mem_is_allocated(). Might be a bug.", 
+			pointers[i_pointer].address, pointers[i_pointer].size);
+	}
+
+	// Log the state of the memory after allocation.
+	if (!tester_options.benchmark) {
+		log_mem_state(INFO_LVL);
+		log_mem_parameters(INFO_LVL);
+	}
+
+	log_debug("Exiting test_allocate_batch().");
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Deallocates one random pointer within the given allocated pointer array.
+/// </summary>
+/// <param name="allocated_addresses">The array of the addresses of currently allocated blocks.</param>
+/// <returns>The state code.</returns>
+int test_deallocate_random_pointer(address_array_t* allocated_addresses) {
+	log_debug("Entering test_deallocate_random_pointer().");
+	if (!allocated_addresses->length) {
+		return SUCCESSFUL_EXEC;
+	}
+
+	// Get some random pointer from allocated addresses. Its size is kept by the allocator.
+	int random_index = rand() % allocated_addresses->length;
+	mem_address_t random_key = allocated_addresses->addresses[random_index];
+	ptr_t random_pointer;
+	pointer_of_key(random_key, &random_pointer);
+	log_info("Random index: %d, Random pointer: [%lu, %lu].", random_index, random_pointer.address, random_pointer.size);
+	address_array_remove(allocated_addresses, random_index);
+
+    // Free the random pointer to create some fragmentation.
+	int result = test_deallocate_pointer(random_key);
+	
+	log_debug("Exiting test_deallocate_random_pointer().");
+	return result;
+}
+
+/// <summary>
+/// Frees one pointer by its key only, and checks it.
+/// </summary>
+/// <param name="key">The key of the pointer: its address, or its handle with --compact.</param>
+/// <returns>The state code.</returns>
+int test_deallocate_pointer(mem_address_t key) {
+	unsigned int is_allocated_flag = false;
+
+	// Its size is kept by the allocator.
+	ptr_t pointer;
+	pointer_of_key(key, &pointer);
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	int result = free_key(key);
+	unsigned long latency = elapsed_ns(&start);
+	tester_benchmark.free_ns += latency;
+	tester_benchmark.free_count++;
+	latency_array_add(&tester_benchmark.free_latencies, latency);
+	series_count_operation();
+	if (result != SUCCESSFUL_EXEC) {
+		log_error("Memory could not be freed. %s returned %d.", tester_options.compact ? "mem_free_handle()" : "mem_free_address()", result);
+	} else {
+		requested_size_remove(key);
+	}
+
+	if (result == SUCCESSFUL_EXEC && !tester_options.benchmark) {
+        // Make sure the memory was deallocated.
+		mem_is_allocated(&allocator, pointer.address, &is_allocated_flag);
+		if (!is_allocated_flag) log_info("Memory pointer [%lu, %lu] was freed.", pointer.address, pointer.size);
+        else log_warn("Memory was freed by mem_free_address() but flagged as allocated by mem_is_allocated(). Might be a bug.");
+		if (!is_within_free_block(&pointer)) log_warn("Memory pointer [%lu, %lu] was freed by mem_free_address() but is not within a single free block. Might be a bug.", 
+			pointer.address, pointer.size);
+	}
+
+    // Log the state of the memory after deallocation.
+	if (!tester_options.benchmark) {
+		log_mem_state(INFO_LVL);
+		log_mem_parameters(INFO_LVL);
+	}
+
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Reallocates one random pointer within the given allocated pointer array to a random size, and counts whether it grew in place.
+/// </summary>
+/// <param name="allocated_addresses">The array of the addresses of currently allocated blocks.</param>
+/// <returns>The state code.</returns>
+int test_reallocate_random_pointer(address_array_t* allocated_addresses) {
+	log_debug("Entering test_reallocate_random_pointer().");
+	unsigned int is_allocated_flag = false;
+	if (!allocated_addresses->length) {
+		return SUCCESSFUL_EXEC;
+	}
+
+	// Get some random pointer from allocated addresses, and a random new size.
+	int random_index = rand() % allocated_addresses->length;
+	ptr_t random_pointer = { allocated_addresses->addresses[random_index], 0, true };
+	mem_allocated_size(&allocator, random_pointer.address, &random_pointer.size);
+	ptr_t old_pointer = random_pointer;
+	sz_t size = random_below(tester_options.max_alloc_size - 1) + 1;
+
+	// Resize it. On out of memory, the pointer is left untouched.
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	int result = mem_reallocate(&allocator, &random_pointer, size);
+	tester_benchmark.reallocation_ns += elapsed_ns(&start);
+	tester_benchmark.reallocation_count++;
+	if (size > old_pointer.size) {
+		tester_benchmark.growth_count++;
+		if (result == SUCCESSFUL_EXEC && random_pointer.address == old_pointer.address) tester_benchmark.in_place_growth_count++;
+	}
+
+	if (result == OUT_OF_MEMORY_ERRNO) {
+		log_info("Memory pointer [%lu, %lu] could not be reallocated to %lu because the allocator is out of memory.", old_pointer.address, old_pointer.size, size);
+		return SUCCESSFUL_EXEC;
+	} else if (result != SUCCESSFUL_EXEC) {
+		log_error("Memory could not be reallocated. mem_reallocate() returned %d.", result);
+		return result;
+	}
+
+	allocated_addresses->addresses[random_index] = random_pointer.address;
+	requested_size_remove(old_pointer.address);
+	requested_size_add(random_pointer.address, size);
+	if (tester_options.mapped) memset((void*) random_pointer.address, 0x5A, random_pointer.size);
+	if (tester_options.benchmark) return SUCCESSFUL_EXEC;
+
+	// Make sure the memory is still allocated.
+	mem_is_allocated(&allocator, random_pointer.address, &is_allocated_flag);
+	if (is_allocated_flag) log_info("Memory pointer [%lu, %lu] was reallocated %s: [%lu, %lu].", old_pointer.address, old_pointer.size, 
+		random_pointer.address == old_pointer.address ? "in place" : "by a move", random_pointer.address, random_pointer.size);
+	else log_warn("Memory was reallocated by mem_reallocate() ([%lu, %lu]) but flagged as unallocated by mem_is_allocated(). Might be a bug.", 
+		random_pointer.address, random_pointer.size);
+
+	// Log the state of the memory after reallocation.
+	log_mem_state(INFO_LVL);
+	log_mem_parameters(INFO_LVL);
+
+	log_debug("Exiting test_reallocate_random_pointer().");
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Deallocates all pointers within the given allocated pointer array.
+/// </summary>
+/// <param name="allocated_addresses">The array of the addresses of currently allocated blocks.</param>
+/// <returns>The state code.</returns>
+int test_deallocate_all(address_array_t* allocated_addresses) {
+	log_debug("Entering test_deallocate_all().");
+	unsigned int is_allocated_flag = false;
+	struct timespec start;
+
+	// Deallocate all currently allocated pointers, latest first.
+	while (allocated_addresses->length) {
+		mem_address_t current_key = allocated_addresses->addresses[allocated_addresses->length - 1];
+		ptr_t current_pointer;
+		pointer_of_key(current_key, &current_pointer);
+		address_array_remove(allocated_addresses, allocated_addresses->length - 1);
+        
+        // Try to deallocate the pointer, by its address or its handle only.
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		int result = free_key(current_key);
+		unsigned long latency = elapsed_ns(&start);
+		tester_benchmark.free_ns += latency;
+		tester_benchmark.free_count++;
+		latency_array_add(&tester_benchmark.free_latencies, latency);
+		series_count_operation();
+		if (result != SUCCESSFUL_EXEC) {
+			log_error("Memory could not be freed. %s returned %d.", tester_options.compact ? "mem_free_handle()" : "mem_free_address()", result);
+			continue;
+		}
+
+		requested_size_remove(current_key);
+		if (!tester_options.benchmark) {
+            // Make sure the memory was deallocated.
+			mem_is_allocated(&allocator, current_pointer.address, &is_allocated_flag);
+			if (!is_allocated_flag) log_info("Memory pointer [%lu, %lu] was freed.", current_pointer.address, current_pointer.size);
+			else log_warn("Memory was freed by mem_free_address() but flagged as allocated by mem_is_allocated(). Might be a bug.");
+			if (!is_within_free_block(&current_pointer)) log_warn("Memory pointer [%lu, %lu] was freed by mem_free_address() but is not within a single free block. Might be a bug.", 
+				current_pointer.address, current_pointer.size);
+
+            // Log the state of the memory after deallocation.
+			log_mem_state(INFO_LVL);
+			log_mem_parameters(INFO_LVL);
+		}
+	}
+	
+	log_debug("Exiting test_deallocate_all().");
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Deallocates all pointers within the given allocated pointer array, by batches of calls to mem_free_batch().
+/// </summary>
+/// <param name="allocated_addresses">The array of the addresses of currently allocated blocks.</param>
+/// <returns>The state code.</returns>
+int test_deallocate_all_batch(address_array_t* allocated_addresses) {
+	log_debug("Entering test_deallocate_all_batch().");
+	unsigned int is_allocated_flag = false, i_pointer;
+	ptr_t pointers[FREE_BATCH_SIZE];
+	struct timespec start;
+
+	// Deallocate all currently allocated pointers, latest first.
+	while (allocated_addresses->length) {
+		unsigned int count = allocated_addresses->length < FREE_BATCH_SIZE ? allocated_addresses->length : FREE_BATCH_SIZE;
+		for (i_pointer = 0; i_pointer < count; i_pointer++) {
+			pointers[i_pointer].address = allocated_addresses->addresses[allocated_addresses->length - 1];
+			mem_allocated_size(&allocator, pointers[i_pointer].address, &pointers[i_pointer].size);
+			pointers[i_pointer].is_allocated = true;
+			address_array_remove(allocated_addresses, allocated_addresses->length - 1);
+		}
+
+		// Try to deallocate the batch. The latency of every pointer is its share of the batch.
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		int result = mem_free_batch(&allocator, count, pointers);
+		unsigned long latency = elapsed_ns(&start);
+		tester_benchmark.free_ns += latency;
+		tester_benchmark.free_count += count;
+		for (i_pointer = 0; i_pointer < count; i_pointer++) {
+			latency_array_add(&tester_benchmark.free_latencies, latency / count);
+		}
+
+		series_count_operation();
+
+		if (result != SUCCESSFUL_EXEC) {
+			log_error("Memory could not be freed. mem_free_batch() returned %d.", result);
+			continue;
+		}
+
+		for (i_pointer = 0; i_pointer < count; i_pointer++) {
+			requested_size_remove(pointers[i_pointer].address);
+		}
+
+		if (tester_options.benchmark) {
+			continue;
+		}
+
+		// Make sure the memory was deallocated.
+		for (i_pointer = 0; i_pointer < count; i_pointer++) {
+			mem_is_allocated(&allocator, pointers[i_pointer].address, &is_allocated_flag);
+			if (!is_allocated_flag) log_info("Memory pointer [%lu, %lu] was freed.", pointers[i_pointer].address, pointers[i_pointer].size);
+			else log_warn("Memory was freed by mem_free_batch() but flagged as allocated by mem_is_allocated(). Might be a bug.");
+			if (!is_within_free_block(&pointers[i_pointer])) log_warn("Memory pointer [%lu, %lu] was freed by mem_free_batch() but is not within a single free block. Might be a bug.", 
+				pointers[i_pointer].address, pointers[i_pointer].size);
+		}
+
+		// Log the state of the memory after deallocation.
+		log_mem_state(INFO_LVL);
+		log_mem_parameters(INFO_LVL);
+	}
+	
+	log_debug("Exiting test_deallocate_all_batch().");
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Runs the search benchmark: the heap is cut into 10k to 1M free blocks, then the first fit on the free block list and on the free blocks as arrays,
+/// with every scan the processor supports, search it for the same random sizes. Reports the mean time and steps per search.
+/// </summary>
+/// <param name="seed">The seed of the random sizes.</param>
+/// <returns>The state code.</returns>
+int test_search(unsigned int seed) {
+	log_debug("Entering test_search().");
+	char row_buffer[SMALL_BUFFER_SIZE];
+	char table_buffer[LARGE_BUFFER_SIZE];
+	memset(&table_buffer, 0, LARGE_BUFFER_SIZE);
+
+	unsigned int i_count, i_variant, i_block, i_search;
+	int result;
+	for (i_count = 0; i_count < SEARCH_FREE_BLOCK_COUNT_COUNT; i_count++) {
+		unsigned int block_count = SEARCH_FREE_BLOCK_COUNTS[i_count];
+		unsigned long list_ns = 0, list_address_sum = 0;
+		mem_address_t* holes = malloc(block_count * sizeof(mem_address_t));
+		if (holes == NULL) {
+			return OUT_OF_MEMORY_ERRNO;
+		}
+
+		for (i_variant = 0; i_variant < SEARCH_VARIANT_COUNT; i_variant++) {
+			// Every variant gets a fresh heap: holes of 1 to 32 bytes between allocated bytes, then a large free tail.
+			mem_allocation_strategy_t strategy = i_variant ? &mem_allocation_strategy_first_fit_arrays : &mem_allocation_strategy_first_fit;
+			allocator_options_t allocator_options = { .address_space_first_address = tester_options.address_space_first_address, 
+				.address_space_size = block_count * (SEARCH_MAXIMUM_HOLE_SIZE + 1) + SEARCH_TAIL_SIZE };
+			if ((result = mem_allocator_init(&allocator, strategy, &allocator_options)) != SUCCESSFUL_EXEC) {
+				log_error("Allocator could not be initialized. init_allocator() returned %d.", result);
+				free(holes);
+				return result;
+			}
+
+			// A scan that the processor does not support is skipped.
+			if (i_variant && mem_block_arrays_use_scan(&allocator.free_blocks.arrays, SEARCH_SCAN_KINDS[i_variant - 1]) != SUCCESSFUL_EXEC) {
+				mem_allocator_destroy(&allocator);
+				continue;
+			}
+
+			ptr_t pointer;
+			for (i_block = 0; i_block < block_count; i_block++) {
+				if ((result = mem_allocate(&allocator, 1 + (i_block * 7919) % SEARCH_MAXIMUM_HOLE_SIZE, &pointer)) != SUCCESSFUL_EXEC || 
+					(holes[i_block] = pointer.address, result = mem_allocate(&allocator, 1, &pointer)) != SUCCESSFUL_EXEC) {
+					log_error("Search benchmark could not be set up. mem_allocate() returned %d.", result);
+					mem_allocator_destroy(&allocator);
+					free(holes);
+					return result;
+				}
+			}
+
+			for (i_block = 0; i_block < block_count; i_block++) {
+				mem_free_address(&allocator, holes[i_block]);
+			}
+
+			// Every search is given back right away, so every search sees the same heap. Half of the sizes fit no hole.
+			srand(seed);
+			unsigned long search_ns = 0, address_sum = 0, search_step_start = allocator.search_step_count;
+			struct timespec start;
+			for (i_search = 0; i_search < SEARCH_COUNT; i_search++) {
+				sz_t size = 1 + rand() % (2 * SEARCH_MAXIMUM_HOLE_SIZE);
+				clock_gettime(CLOCK_MONOTONIC, &start);
+				result = mem_allocate(&allocator, size, &pointer);
+				search_ns += elapsed_ns(&start);
+				if (result != SUCCESSFUL_EXEC) {
+					log_error("Memory could not be allocated. mem_allocate() returned %d.", result);
+					break;
+				}
+
+				address_sum += pointer.address;
+				mem_free(&allocator, &pointer);
+			}
+
+			// The first fit on arrays must find the same blocks as the first fit on the free block list.
+			if (!i_variant) {
+				list_ns = search_ns;
+				list_address_sum = address_sum;
+			} else if (address_sum != list_address_sum) {
+				log_warn("The first fit on arrays with the %s scan found other blocks than the first fit on the free block list. Might be a bug.", 
+					mem_block_arrays_scan_name(SEARCH_SCAN_KINDS[i_variant - 1]));
+			}
+
+			snprintf(row_buffer, SMALL_BUFFER_SIZE, "\n\t  %11u  %-14s %10lu %13lu %8.1fx",
+				block_count, i_variant ? mem_block_arrays_scan_name(SEARCH_SCAN_KINDS[i_variant - 1]) : "list", search_ns / SEARCH_COUNT, 
+				(allocator.search_step_count - search_step_start) / SEARCH_COUNT, search_ns ? (double) list_ns / search_ns : 0);
+			strncat(table_buffer, row_buffer, LARGE_BUFFER_SIZE - strlen(table_buffer) - 1);
+			mem_allocator_destroy(&allocator);
+			if (result != SUCCESSFUL_EXEC) {
+				free(holes);
+				return result;
+			}
+		}
+
+		free(holes);
+	}
+
+	log_format(INFO_LVL, "\n\tSearch benchmark (first fit, %u searches of 1 to %u bytes)"
+		"\n\t  Free blocks  Free blocks as Mean (ns) Steps/search  Speedup%s", 
+		SEARCH_COUNT, 2 * SEARCH_MAXIMUM_HOLE_SIZE, table_buffer);
+
+	log_debug("Exiting test_search().");
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Runs the region benchmark: on a heap fragmented by long-lived blocks, requests of 16 to 4096 allocations are served either by
+/// the allocator, with a free per allocation at the end of the request, or by a region, with a single reset at the end of the request.
+/// Reports the mean time per allocation of both and the speedup of the region.
+/// </summary>
+/// <param name="seed">The seed of the random sizes.</param>
+/// <returns>The state code.</returns>
+int test_regions(unsigned int seed) {
+	log_debug("Entering test_regions().");
+	char row_buffer[SMALL_BUFFER_SIZE];
+	char table_buffer[LARGE_BUFFER_SIZE];
+	memset(&table_buffer, 0, LARGE_BUFFER_SIZE);
+
+	ptr_t* pointers = malloc(REGION_REQUEST_SIZES[REGION_REQUEST_SIZE_COUNT - 1] * sizeof(ptr_t));
+	if (pointers == NULL) {
+		return OUT_OF_MEMORY_ERRNO;
+	}
+
+	unsigned int i_size, i_variant, i_block, i_request;
+	int result = SUCCESSFUL_EXEC;
+	for (i_size = 0; i_size < REGION_REQUEST_SIZE_COUNT && result == SUCCESSFUL_EXEC; i_size++) {
+		unsigned int request_size = REGION_REQUEST_SIZES[i_size];
+		unsigned int request_count = REGION_ALLOCATION_COUNT / request_size;
+		unsigned long allocator_ns = 0;
+
+		for (i_variant = 0; i_variant < 2 && result == SUCCESSFUL_EXEC; i_variant++) {
+			allocator_options_t allocator_options = { .address_space_first_address = tester_options.address_space_first_address, 
+				.address_space_size = tester_options.address_space_size, .granule_size = tester_options.granule_size, 
+				.reserved_block_count = tester_options.reserved_block_count };
+			if ((result = mem_allocator_init(&allocator, tester_options.allocation_strategy, &allocator_options)) != SUCCESSFUL_EXEC) {
+				log_error("Allocator could not be initialized. init_allocator() returned %d.", result);
+				break;
+			}
+
+			// Every variant gets the same fragmented heap: long-lived blocks, every other one freed.
+			srand(seed);
+			ptr_t pointer;
+			mem_address_t* background = malloc(REGION_BACKGROUND_COUNT * sizeof(mem_address_t));
+			if (background == NULL) {
+				mem_allocator_destroy(&allocator);
+				result = OUT_OF_MEMORY_ERRNO;
+				break;
+			}
+
+			for (i_block = 0; i_block < REGION_BACKGROUND_COUNT; i_block++) {
+				if ((result = mem_allocate(&allocator, 1 + random_below(tester_options.max_alloc_size), &pointer)) != SUCCESSFUL_EXEC) {
+					log_error("Region benchmark could not be set up. mem_allocate() returned %d.", result);
+					break;
+				}
+
+				background[i_block] = pointer.address;
+			}
+
+			for (i_block = 0; result == SUCCESSFUL_EXEC && i_block < REGION_BACKGROUND_COUNT; i_block += 2) {
+				mem_free_address(&allocator, background[i_block]);
+			}
+
+			free(background);
+			if (result != SUCCESSFUL_EXEC) {
+				mem_allocator_destroy(&allocator);
+				break;
+			}
+
+			region_t region;
+			if (i_variant && (result = mem_region_create(&region, &allocator, 0)) != SUCCESSFUL_EXEC) {
+				log_error("Region could not be created. mem_region_create() returned %d.", result);
+				mem_allocator_destroy(&allocator);
+				break;
+			}
+
+			// The region keeps its first chunk across requests, so the baseline is taken after it is created.
+			unsigned long free_before, free_after;
+			unsigned long libc_call_start, libc_call_end;
+			mem_count_free(&allocator, &free_before);
+			mem_count_libc_calls(&allocator, &libc_call_start);
+
+			// Every request allocates its blocks, then gives them all back at its end.
+			unsigned long request_ns = 0;
+			struct timespec start;
+			for (i_request = 0; i_request < request_count && result == SUCCESSFUL_EXEC; i_request++) {
+				clock_gettime(CLOCK_MONOTONIC, &start);
+				for (i_block = 0; i_block < request_size; i_block++) {
+					sz_t size = 1 + random_below(tester_options.max_alloc_size);
+					result = i_variant ? mem_region_alloc(&region, size, &pointers[i_block]) : mem_allocate(&allocator, size, &pointers[i_block]);
+					if (result != SUCCESSFUL_EXEC) {
+						log_error("Memory could not be allocated. It returned %d.", result);
+						break;
+					}
+				}
+
+				if (i_variant) {
+					if (result == SUCCESSFUL_EXEC) result = mem_region_reset(&region);
+				} else {
+					unsigned int i_free;
+					for (i_free = 0; i_free < i_block; i_free++) {
+						mem_free(&allocator, &pointers[i_free]);
+					}
+				}
+
+				request_ns += elapsed_ns(&start);
+			}
+
+			// Everything a request took must be back once it ended.
+			mem_count_free(&allocator, &free_after);
+			mem_count_libc_calls(&allocator, &libc_call_end);
+			if (i_variant) {
+				libc_call_end += region.libc_call_count;
+			}
+
+			if (result == SUCCESSFUL_EXEC && free_after != free_before) {
+				log_warn("The %s leaked %ld bytes over the requests. Might be a bug.", i_variant ? "region" : "allocator", (long) (free_before - free_after));
+			}
+
+			if (i_variant) {
+				mem_region_destroy(&region);
+			} else {
+				allocator_ns = request_ns;
+			}
+
+			snprintf(row_buffer, SMALL_BUFFER_SIZE, "\n\t  %14u  %-9s %14lu %10lu %8.1fx",
+				request_size, i_variant ? "region" : "allocator", request_ns / REGION_ALLOCATION_COUNT, 
+				libc_call_end - libc_call_start, request_ns ? (double) allocator_ns / request_ns : 0);
+			strncat(table_buffer, row_buffer, LARGE_BUFFER_SIZE - strlen(table_buffer) - 1);
+			mem_allocator_destroy(&allocator);
+		}
+	}
+
+	free(pointers);
+	if (result != SUCCESSFUL_EXEC) {
+		return result;
+	}
+
+	log_format(INFO_LVL, "\n\tRegion benchmark (%s, %u allocations of 1 to %lu bytes, %u long-lived blocks)"
+		"\n\t  Allocs/request  Served by Mean (ns/alloc) Libc calls  Speedup%s", 
+		tester_options.allocation_strategy_name, REGION_ALLOCATION_COUNT, tester_options.max_alloc_size, REGION_BACKGROUND_COUNT / 2, table_buffer);
+
+	log_debug("Exiting test_regions().");
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Runs the multi-threaded stress test on arenas, with 1 to the maximum count of threads, doubling every time.
+/// Reports the throughput of every thread count.
+/// </summary>
+/// <returns>The state code.</returns>
+int test_stress() {
+	log_debug("Entering test_stress().");
+
+	allocator_options_t allocator_options = { .address_space_first_address = tester_options.address_space_first_address, .address_space_size = tester_options.address_space_size, .is_mapped = tester_options.mapped, 
+		.granule_size = tester_options.granule_size, .reserved_block_count = tester_options.reserved_block_count };
+	pthread_t threads[MAXIMUM_STRESS_THREADS];
+	stress_thread_t works[MAXIMUM_STRESS_THREADS];
+	unsigned int thread_count, i_thread;
+	for (thread_count = 1; thread_count <= MAXIMUM_STRESS_THREADS; thread_count *= 2) {
+		// Every thread count gets fresh arenas. By default, there is one arena per thread.
+		arenas_t arenas;
+		unsigned int arena_count = tester_options.arena_count ? tester_options.arena_count : thread_count;
+		int result = mem_arenas_init(&arenas, arena_count, tester_options.arena_assignment, tester_options.magazine_capacity, tester_options.allocation_strategy, &allocator_options);
+		if (result != SUCCESSFUL_EXEC) {
+			log_error("Arenas could not be initialized. mem_arenas_init() returned %d.", result);
+			return result;
+		}
+
+		struct timespec start;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (i_thread = 0; i_thread < thread_count; i_thread++) {
+			works[i_thread] = (stress_thread_t) { .arenas = &arenas, .seed = rand(), .operations = tester_options.stress_operations };
+			pthread_create(&threads[i_thread], NULL, &test_stress_thread, &works[i_thread]);
+		}
+
+		unsigned long out_of_memory_count = 0;
+		for (i_thread = 0; i_thread < thread_count; i_thread++) {
+			pthread_join(threads[i_thread], NULL);
+			out_of_memory_count += works[i_thread].out_of_memory_count;
+			if (works[i_thread].result != SUCCESSFUL_EXEC) {
+				log_error("Stress thread %u failed with %d.", i_thread, works[i_thread].result);
+				result = works[i_thread].result;
+			}
+		}
+
+		unsigned long ns = elapsed_ns(&start);
+		unsigned long operation_count = thread_count * tester_options.stress_operations;
+
+		// Every thread freed all its pointers, so the arenas must be back to their initial state.
+		unsigned int allocated_blocks;
+		unsigned long free_memory;
+		mem_arenas_count_allocated_block(&arenas, &allocated_blocks);
+		mem_arenas_count_free(&arenas, &free_memory);
+		if (allocated_blocks || free_memory != tester_options.address_space_size) {
+			log_warn("Arenas have %u allocated blocks and %lu free bytes after the stress test. Might be a bug.", allocated_blocks, free_memory);
+		}
+
+		log_info("Stress (strategy %s): Threads: %u, Arenas: %u, Operations: %lu, Time: %.3f ms, Throughput: %.0f ops/s, Out of memory: %lu.",
+			tester_options.allocation_strategy_name, thread_count, arena_count, operation_count, ns / 1e6, operation_count / (ns / 1e9), out_of_memory_count);
+		if (tester_options.magazine_capacity) {
+			magazine_stats_t stats;
+			mem_arenas_magazine_stats(&arenas, &stats);
+			log_info("  Magazines: Allocations: %lu, Hit rate: %.1f%%, Refills: %lu, Flushes: %lu.",
+				stats.allocation_count, stats.allocation_count ? 100.0 * stats.hit_count / stats.allocation_count : 0.0, stats.refill_count, stats.flush_count);
+		}
+
+		mem_arenas_destroy(&arenas);
+		if (result != SUCCESSFUL_EXEC) {
+			return result;
+		}
+	}
+
+	log_debug("Exiting test_stress().");
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Runs the work of one thread of the stress test.
+/// </summary>
+/// <param name="argument">The work of the thread, as a stress_thread_t.</param>
+/// <returns>Null. The state code is put into the work of the thread.</returns>
+void* test_stress_thread(void* argument) {
+	stress_thread_t* work = argument;
+	ptr_t slots[STRESS_SLOT_COUNT];
+	memset(slots, 0, sizeof(slots));
+
+	// Every operation picks a random slot: it frees the slot if it is allocated, and allocates into it otherwise.
+	unsigned int seed = work->seed, i_slot;
+	unsigned long i_operation;
+	work->result = SUCCESSFUL_EXEC;
+	for (i_operation = 0; i_operation < work->operations && work->result == SUCCESSFUL_EXEC; i_operation++) {
+		ptr_t* slot = &slots[rand_r(&seed) % STRESS_SLOT_COUNT];
+		if (slot->is_allocated) {
+			work->result = mem_arenas_free(work->arenas, slot);
+		} else {
+			sz_t size = rand_r(&seed) % tester_options.max_alloc_size + 1;
+			work->result = mem_arenas_allocate(work->arenas, size, slot);
+			if (work->result == OUT_OF_MEMORY_ERRNO) {
+				work->out_of_memory_count++;
+				work->result = SUCCESSFUL_EXEC;
+			} else if (work->result == SUCCESSFUL_EXEC && tester_options.mapped) {
+				memset((void*) slot->address, 0xA5, slot->size);
+			}
+		}
+	}
+
+	for (i_slot = 0; i_slot < STRESS_SLOT_COUNT; i_slot++) {
+		if (slots[i_slot].is_allocated) {
+			int result = mem_arenas_free(work->arenas, &slots[i_slot]);
+			if (result != SUCCESSFUL_EXEC) work->result = result;
+		}
+	}
+
+	return NULL;
+}
+
 /// <summary>
-/// Starts the memory allocation tests.
+/// Checks whether the memory of a freed pointer is entirely within a single free block.
+/// Freed memory is always merged with its free neighbours, so it cannot span many free blocks.
 /// </summary>
-int main (int argc, char* argv[]) {
-	unsigned int result;
-	srand(time(NULL));
+/// <param name="pointer">The freed pointer.</param>
+/// <returns>Whether the memory is within a single free block.</returns>
+int is_within_free_block(const ptr_t* pointer) {
+	ptr_t span;
+	unsigned int span_count;
+	mem_find_free_spans(&allocator, pointer->address, pointer->address + pointer->size, &span, 1, &span_count);
+	return span_count == 1 && span.address <= pointer->address && span.address + span.size >= pointer->address + pointer->size;
+}
 
-	// Parse the arguments.
-	result = parse_args(argc, argv, &tester_options);
-	if (result != SUCCESSFUL_EXEC) {
-		exit(result);
+/// <summary>
+/// Appends an address to an array of addresses. The array grows as needed.
+/// </summary>
+/// <param name="array">The array in which to add.</param>
+/// <param name="address">The address to add.</param>
+/// <returns>The state code.</returns>
+int address_array_add(address_array_t* array, mem_address_t address) {
+	if (array == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
 	}
 
-	// Set default values if applicable.
-	if (tester_options.verbose) log_level = TRACE_LVL;
-	if (!tester_options.small_block_size) tester_options.small_block_size = DEFAULT_SMALL_BLOCK_SIZE;
-	if (!tester_options.max_alloc_size) tester_options.max_alloc_size = DEFAULT_MAXIMUM_ALLOC;
-	if (!tester_options.alloc_to_free_ratio) tester_options.alloc_to_free_ratio = DEFAULT_ALLOCATE_TO_FREE_RATIO;
+	if (array->length == array->capacity) {
+		// Double the capacity of the array.
+		unsigned int capacity = array->capacity ? 2 * array->capacity : INITIAL_ADDRESS_ARRAY_CAPACITY;
+		mem_address_t* addresses = realloc(array->addresses, capacity * sizeof(mem_address_t));
+		if (addresses == NULL) {
+			return OUT_OF_MEMORY_ERRNO;
+		}
 
-	// Initialize the list into which we add alocated pointers.
-	linkedlist_t allocated_pointer_list;
-	linkedlist_init(&allocated_pointer_list);
+		array->addresses = addresses;
+		array->capacity = capacity;
+	}
 
-	// Initialize the allocator.
-	allocator_options_t allocator_options = { .address_space_first_address = tester_options.address_space_first_address, .address_space_size = tester_options.address_space_size };
-	result = mem_allocator_init(tester_options.allocation_strategy, &allocator_options);
-	if (result != SUCCESSFUL_EXEC) {
-		log_error("Allocator could not be initialized. init_allocator() returned %d.", result);
-		exit(result);
+	array->addresses[array->length++] = address;
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Removes the address at the given index of an array of addresses. The last address takes its place.
+/// </summary>
+/// <param name="array">The array in which to remove.</param>
+/// <param name="index">The index of the address to remove.</param>
+/// <returns>The state code.</returns>
+int address_array_remove(address_array_t* array, unsigned int index) {
+	if (array == NULL || index >= array->length) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
 	}
-	
-	// Log the initial state of the memory.
-	log_mem_state(INFO_LVL);
-	log_mem_parameters(INFO_LVL);
 
-	// Allocate until the allocator run out of memory.
-	test_allocate_until_out_of_mem(&allocated_pointer_list);
+	array->addresses[index] = array->addresses[--array->length];
+	return SUCCESSFUL_EXEC;
+}
 
-	// Deallocate evrything.
-	test_deallocate_all(&allocated_pointer_list);
-	
-	linkedlist_destroy(&allocated_pointer_list);
-	mem_allocator_destroy();
-	exit(SUCCESSFUL_EXEC);
+/// <summary>
+/// Keeps the size requested for a live pointer, and adds it to the requested bytes.
+/// </summary>
+/// <param name="key">The key of the pointer: its address, or its handle with --compact.</param>
+/// <param name="size">The requested size.</param>
+/// <returns>The state code.</returns>
+int requested_size_add(mem_address_t key, sz_t size) {
+	int result = hashmap_put(&requested_sizes, key, (void*) size);
+	if (result != SUCCESSFUL_EXEC) {
+		return result;
+	}
+
+	tester_benchmark.requested_bytes += size;
+	return SUCCESSFUL_EXEC;
 }
 
 /// <summary>
-/// Allocates n pointers (defined by alloc_to_free_ratio option) then deallocates one random pointer until an out of memory error happens.
+/// Forgets the size requested for a pointer that is freed, and removes it from the requested bytes.
 /// </summary>
-/// <param name="allocated_pointer_list">The linked list of currently allocated pointers.</param>
+/// <param name="key">The key of the pointer: its address, or its handle with --compact.</param>
 /// <returns>The state code.</returns>
-int test_allocate_until_out_of_mem(linkedlist_t* allocated_pointer_list) {
-	log_debug("Entering test_allocate_until_out_of_mem().");
+int requested_size_remove(mem_address_t key) {
+	void* size;
+	hashmap_get(&requested_sizes, key, &size);
+	tester_benchmark.requested_bytes -= (sz_t) size;
+	return hashmap_remove(&requested_sizes, key);
+}
 
-	// Allocate until first out of memory error.
-	unsigned int is_oom = false, i_allocate = 0, j_allocate = 0, result, is_allocated_flag = false;
-	while (!is_oom) {
-		// Allocate n pointers for one free.
-		for (j_allocate = 0; j_allocate < tester_options.alloc_to_free_ratio; j_allocate++) {
-			// Allocate one pointer of semi random size.
-			int pointer_index = (i_allocate * tester_options.alloc_to_free_ratio) + j_allocate;
-			ptr_t* pointer = malloc(sizeof(ptr_t));
-			sz_t size = ((pointer_index + 43) * 4373 / 63 * 21) % (tester_options.max_alloc_size - 1) + 1;
+/// <summary>
+/// Appends a latency to an array of latencies. The array grows as needed.
+/// </summary>
+/// <param name="array">The array in which to add.</param>
+/// <param name="latency">The latency to add, in nanoseconds.</param>
+/// <returns>The state code.</returns>
+int latency_array_add(latency_array_t* array, unsigned long latency) {
+	if (array == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
 
-			// Allocate it and act on result.
-			result = mem_allocate(size, pointer);
-			if (result == OUT_OF_MEMORY_ERRNO) {
-				log_info("Memory could not be allocated because the allocator is out of memory.", result);
-				is_oom = true;
-				free(pointer);
-				break;
-			} else if (result != SUCCESSFUL_EXEC) {
-				log_error("Memory could not be allocated. mem_allocate() returned %d.", result);
-				return result;
-			} else {
-				linkedlist_add(allocated_pointer_list, 0, pointer);
-                
-                // Make sure the memory was allocated.
-				mem_is_allocated(pointer->address, &is_allocated_flag);
-				if (is_allocated_flag) log_info("Memory was allocated: [%lu, %u]", pointer->address, pointer->size);
-                else log_warn("Memory was allocated by mem_allocate() ([%lu, %u]) but flagged as unallocated by mem_is_allocated(). Might be a bug.", 
-                    pointer->address, pointer->size);
-                    
-                // Log the state of the memory after allocation.
-				log_mem_state(INFO_LVL);
-				log_mem_parameters(INFO_LVL);
-			}
+	if (array->length == array->capacity) {
+		// Double the capacity of the array.
+		unsigned long capacity = array->capacity ? 2 * array->capacity : INITIAL_LATENCY_ARRAY_CAPACITY;
+		unsigned long* latencies = realloc(array->latencies, capacity * sizeof(unsigned long));
+		if (latencies == NULL) {
+			return OUT_OF_MEMORY_ERRNO;
 		}
 
-		// Deallocates one random pointer.
-		result = test_deallocate_random_pointer(allocated_pointer_list);
-        if (result != SUCCESSFUL_EXEC) return result;
-		i_allocate++;
+		array->latencies = latencies;
+		array->capacity = capacity;
 	}
-	
-	log_debug("Exiting test_allocate_until_out_of_mem().");
+
+	array->latencies[array->length++] = latency;
 	return SUCCESSFUL_EXEC;
 }
 
 /// <summary>
-/// Deallocates one random pointer within the given allocated pointer list.
+/// Gets the given percentile of an array of latencies. The array must be sorted.
+/// </summary>
+/// <param name="array">The sorted array of latencies.</param>
+/// <param name="percentile">The percentile to get, from 0 to 100.</param>
+/// <returns>The latency at the percentile, in nanoseconds. 0 if the array is empty.</returns>
+unsigned long latency_array_percentile(const latency_array_t* array, unsigned int percentile) {
+	if (array == NULL || !array->length) {
+		return 0;
+	}
+
+	// Nearest rank: the smallest latency such that the percentile of all latencies are lower or equal.
+	unsigned long rank = (array->length * percentile + 99) / 100;
+	return array->latencies[rank ? rank - 1 : 0];
+}
+
+/// <summary>
+/// Compares two latencies for sorting.
+/// </summary>
+/// <param name="left">The left latency.</param>
+/// <param name="right">The right latency.</param>
+/// <returns>A negative value if left is smaller, 0 if both are equal and a positive value otherwise.</returns>
+static int compare_latency(const void* left, const void* right) {
+	unsigned long left_latency = *(const unsigned long*) left;
+	unsigned long right_latency = *(const unsigned long*) right;
+	return left_latency < right_latency ? -1 : left_latency > right_latency;
+}
+
+/// <summary>
+/// Gets the p50, p99 and max of the latencies of an array from an index, without reordering the array.
 /// </summary>
-/// <param name="allocated_pointer_list">The linked list of currently allocated pointers.</param>
+/// <param name="array">The array of latencies.</param>
+/// <param name="start">The index of the first latency of the window.</param>
+/// <param name="percentiles">The out argument for the p50, p99 and max latencies, in nanoseconds. All are 0 if the window is empty.</param>
 /// <returns>The state code.</returns>
-int test_deallocate_random_pointer(linkedlist_t* allocated_pointer_list) {
-	log_debug("Entering test_deallocate_random_pointer().");
-	unsigned int is_allocated_flag = false;
+int latency_window_percentiles(const latency_array_t* array, unsigned long start, unsigned long percentiles[3]) {
+	if (array == NULL || percentiles == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
 
-	// Get some random pointer from allocated pointers.
-	void* element;
-	int random_index = rand() % allocated_pointer_list->length;
-	linkedlist_get(allocated_pointer_list, random_index, &element);
-	ptr_t* random_pointer = element;
-	log_info("Random index: %d, Random pointer: [%lu, %u].", random_index, random_pointer->address, random_pointer->size);
-	linkedlist_remove(allocated_pointer_list, random_index);
+	percentiles[0] = percentiles[1] = percentiles[2] = 0;
+	if (start >= array->length) {
+		return SUCCESSFUL_EXEC;
+	}
 
-    // Free the random pointer to create some fragmentation.
-	int result = mem_free(random_pointer);
-	if (result != SUCCESSFUL_EXEC) {
-		log_error("Memory could not be freed. mem_free() returned %d.", result);
-	} else {
-        // Make sure the memory was deallocated.
-		mem_is_allocated(random_pointer->address, &is_allocated_flag);
-		if (!is_allocated_flag) log_info("Memory pointer [%lu, %u] was freed.", random_pointer->address, random_pointer->size);
-        else log_warn("Memory was freed by mem_free() but flagged as allocated by mem_is_allocated(). Might be a bug.");
+	// The percentiles are read from a sorted copy of the window, since the whole array is sorted only at the end of the run.
+	latency_array_t window = { .length = array->length - start, .capacity = array->length - start };
+	if ((window.latencies = malloc(window.length * sizeof(unsigned long))) == NULL) {
+		return OUT_OF_MEMORY_ERRNO;
 	}
 
-    // Log the state of the memory after deallocation.
-	log_mem_state(INFO_LVL);
-	log_mem_parameters(INFO_LVL);
-	free(random_pointer);
-	
-	log_debug("Exiting test_deallocate_random_pointer().");
+	memcpy(window.latencies, array->latencies + start, window.length * sizeof(unsigned long));
+	qsort(window.latencies, window.length, sizeof(unsigned long), &compare_latency);
+	percentiles[0] = latency_array_percentile(&window, 50);
+	percentiles[1] = latency_array_percentile(&window, 99);
+	percentiles[2] = latency_array_percentile(&window, 100);
+	free(window.latencies);
 	return SUCCESSFUL_EXEC;
 }
 
 /// <summary>
-/// Deallocates all pointers within the given allocated pointer list.
+/// Counts one operation on the allocator, and samples the time series at every interval of operations.
+/// </summary>
+void series_count_operation() {
+	if (++tester_series.operation_count % tester_options.series_interval == 0) {
+		series_sample();
+	}
+}
+
+/// <summary>
+/// Samples the state of the free memory, and writes it with the latencies of the window as a row of the time series, if one is written.
 /// </summary>
-/// <param name="allocated_pointer_list">The linked list of currently allocated pointers.</param>
 /// <returns>The state code.</returns>
-int test_deallocate_all(linkedlist_t* allocated_pointer_list) {
-	log_debug("Entering test_deallocate_all().");
-	unsigned int is_allocated_flag = false;
+int series_sample() {
+	unsigned int free_blocks;
+	unsigned long free_bytes;
+	sz_t greatest_block;
+	mem_count_free_block(&allocator, &free_blocks);
+	mem_count_free(&allocator, &free_bytes);
+	mem_greatest_free_block(&allocator, &greatest_block);
+	double fragmentation = free_bytes ? 100.0 * (free_bytes - greatest_block) / free_bytes : 0;
+	tester_benchmark.fragmentation_sum += fragmentation;
+	tester_benchmark.fragmentation_sample_count++;
+	if (tester_series.file == NULL) {
+		return SUCCESSFUL_EXEC;
+	}
 
-	// Deallocate all currently allocated pointers.
-	node_t* current = allocated_pointer_list->head;
-	while (current != NULL) {
-		ptr_t* current_pointer = current->element;
-        
-        // Try to deallocate the pointer.
-		int result = mem_free(current_pointer);
-		if (result != SUCCESSFUL_EXEC) {
-			log_error("Memory could not be freed. mem_free() returned %d.", result);
-		} else {
-            // Make sure the memory was deallocated.
-			mem_is_allocated(current_pointer->address, &is_allocated_flag);
-			if (!is_allocated_flag) log_info("Memory pointer [%lu, %u] was freed.", current_pointer->address, current_pointer->size);
-			else log_warn("Memory was freed by mem_free() but flagged as allocated by mem_is_allocated(). Might be a bug.");
+	unsigned long allocation_percentiles[3], free_percentiles[3];
+	latency_window_percentiles(&tester_benchmark.allocation_latencies, tester_series.allocation_window_start, allocation_percentiles);
+	latency_window_percentiles(&tester_benchmark.free_latencies, tester_series.free_window_start, free_percentiles);
+	tester_series.allocation_window_start = tester_benchmark.allocation_latencies.length;
+	tester_series.free_window_start = tester_benchmark.free_latencies.length;
 
-            // Log the state of the memory after deallocation.
-			log_mem_state(INFO_LVL);
-			log_mem_parameters(INFO_LVL);
+	const char* format = tester_series.is_json 
+		? "%s\n    {\"strategy\": \"%s\", \"operation\": %lu, \"allocations\": %lu, \"frees\": %lu, \"free_bytes\": %lu, \"free_blocks\": %u, "
+			"\"largest_free_block\": %lu, \"fragmentation\": %.3f, \"allocation_p50_ns\": %lu, \"allocation_p99_ns\": %lu, \"allocation_max_ns\": %lu, "
+			"\"free_p50_ns\": %lu, \"free_p99_ns\": %lu, \"free_max_ns\": %lu}"
+		: "%s%s,%lu,%lu,%lu,%lu,%u,%lu,%.3f,%lu,%lu,%lu,%lu,%lu,%lu\n";
+	fprintf(tester_series.file, format, tester_series.is_json && tester_series.row_count ? "," : "", tester_options.allocation_strategy_name, 
+		tester_series.operation_count, tester_benchmark.allocation_count, tester_benchmark.free_count, free_bytes, free_blocks, greatest_block, fragmentation,
+		allocation_percentiles[0], allocation_percentiles[1], allocation_percentiles[2], free_percentiles[0], free_percentiles[1], free_percentiles[2]);
+	tester_series.row_count++;
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Creates the file of the time series, and writes its header. The series is in JSON if the path ends with .json, in CSV otherwise.
+/// </summary>
+/// <param name="path">The path of the file.</param>
+/// <returns>The state code.</returns>
+int series_open(const char* path) {
+	log_debug("Entering series_open(). Path: %s.", path);
+	if (path == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	if ((tester_series.file = fopen(path, "w")) == NULL) {
+		log_error("Series %s could not be opened: %s.", path, strerror(errno));
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	unsigned long length = strlen(path);
+	tester_series.is_json = length >= 5 && strcmp(path + length - 5, ".json") == 0;
+	if (tester_series.is_json) fprintf(tester_series.file, "{\n  \"series\": [");
+	else fprintf(tester_series.file, "strategy,operation,allocations,frees,free_bytes,free_blocks,largest_free_block,fragmentation,"
+		"allocation_p50_ns,allocation_p99_ns,allocation_max_ns,free_p50_ns,free_p99_ns,free_max_ns\n");
+
+	log_debug("Exiting series_open().");
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Writes the ranking of a comparison into the file of the time series, if in JSON, and closes it.
+/// </summary>
+/// <param name="results">The results of the strategies, ranked. Null if there was no comparison.</param>
+/// <param name="count">The count of results.</param>
+/// <returns>The state code.</returns>
+int series_close(const compare_result_t* results, unsigned int count) {
+	log_debug("Entering series_close().");
+	if (tester_series.file == NULL) {
+		return SUCCESSFUL_EXEC;
+	}
+
+	unsigned int i_result;
+	if (tester_series.is_json) {
+		fprintf(tester_series.file, "\n  ],\n  \"ranking\": [");
+		for (i_result = 0; results != NULL && i_result < count; i_result++) {
+			fprintf(tester_series.file, "%s\n    {\"rank\": %u, \"strategy\": \"%s\", \"allocations\": %lu, \"utilization\": %.3f, \"fragmentation_at_oom\": %.3f, "
+				"\"mean_fragmentation\": %.3f, \"allocation_p50_ns\": %lu, \"allocation_p99_ns\": %lu, \"free_p50_ns\": %lu, \"free_p99_ns\": %lu, "
+				"\"allocation_ns\": %lu, \"free_ns\": %lu, \"latency_rank\": %u}",
+				i_result ? "," : "", i_result + 1, results[i_result].strategy_name, results[i_result].allocation_count, results[i_result].utilization, 
+				results[i_result].fragmentation_at_oom, results[i_result].mean_fragmentation, results[i_result].allocation_p50, results[i_result].allocation_p99, 
+				results[i_result].free_p50, results[i_result].free_p99, results[i_result].allocation_ns, results[i_result].free_ns, results[i_result].latency_rank);
 		}
 
-		free(current_pointer);
-		current = current->next;
+		fprintf(tester_series.file, "\n  ]\n}\n");
 	}
-	
-	log_debug("Exiting test_deallocate_all().");
+
+	int is_written = !ferror(tester_series.file);
+	if (fclose(tester_series.file) != 0 || !is_written) {
+		tester_series.file = NULL;
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	tester_series.file = NULL;
+	log_debug("Exiting series_close().");
 	return SUCCESSFUL_EXEC;
 }
 
@@ -262,6 +1471,26 @@ int parse_args(const int argc, char* argv[], tester_options_t* options) {
                 // Flag options handlers.
 				if (strcmp(option_name, "--verbose") == 0) {
 					options->verbose = true;
+				} else if (strcmp(option_name, "--benchmark") == 0) {
+					options->benchmark = true;
+				} else if (strcmp(option_name, "--mapped") == 0) {
+					options->mapped = true;
+				} else if (strcmp(option_name, "--stress") == 0) {
+					options->stress = true;
+				} else if (strcmp(option_name, "--reallocate") == 0) {
+					options->reallocate = true;
+				} else if (strcmp(option_name, "--aligned") == 0) {
+					options->aligned = true;
+				} else if (strcmp(option_name, "--batch") == 0) {
+					options->batch = true;
+				} else if (strcmp(option_name, "--compact") == 0) {
+					options->compact = true;
+				} else if (strcmp(option_name, "--compare") == 0) {
+					options->compare = true;
+				} else if (strcmp(option_name, "--search") == 0) {
+					options->search = true;
+				} else if (strcmp(option_name, "--regions") == 0) {
+					options->regions = true;
 				}
 
                 i_arg++;
@@ -273,35 +1502,61 @@ int parse_args(const int argc, char* argv[], tester_options_t* options) {
                     log_info(help_buffer);
                     exit(SUCCESSFUL_EXEC);
 				} else if (strcmp(option_name, "-first-address") == 0) {
-					options->address_space_first_address = atoi(option_value);
+					options->address_space_first_address = strtoul(option_value, NULL, 10);
 					first_address_set = true;
 				} else if (strcmp(option_name, "-size") == 0) {
-					options->address_space_size = atoi(option_value);
+					options->address_space_size = strtoul(option_value, NULL, 10);
 					size_set = true;
 				} else if (strcmp(option_name, "-small-block-size") == 0) {
-					options->small_block_size = atoi(option_value);
+					options->small_block_size = strtoul(option_value, NULL, 10);
 				} else if (strcmp(option_name, "-alloc-to-free-ratio") == 0) {
 					options->alloc_to_free_ratio = atoi(option_value);
 				} else if (strcmp(option_name, "-max-allocation") == 0) {
-					options->max_alloc_size = atoi(option_value);
-				} else if (strcmp(option_name, "-strategy") == 0) {
-					if (strcmp(option_value, "first") == 0) {
-						options->allocation_strategy = &mem_allocation_strategy_first_fit;
-						strategy_set = true;
-					} else if (strcmp(option_value, "best") == 0) {
-						options->allocation_strategy = &mem_allocation_strategy_best_fit;
-						strategy_set = true;
-					} else if (strcmp(option_value, "worst") == 0) {
-						options->allocation_strategy = &mem_allocation_strategy_worst_fit;
-						strategy_set = true;
-					} else if (strcmp(option_value, "next") == 0) {
-						options->allocation_strategy = &mem_allocation_strategy_next_fit;
-						strategy_set = true;
+					options->max_alloc_size = strtoul(option_value, NULL, 10);
+				} else if (strcmp(option_name, "-granule-size") == 0) {
+					options->granule_size = strtoul(option_value, NULL, 10);
+				} else if (strcmp(option_name, "-reserved-blocks") == 0) {
+					options->reserved_block_count = strtoul(option_value, NULL, 10);
+				} else if (strcmp(option_name, "-workload") == 0) {
+					options->workload_name = option_value;
+					if (workload_kind_of_name(option_value, &options->workload) != SUCCESSFUL_EXEC) {
+						sprint_help(help_buffer);
+						log_fatal(help_buffer);
+						return ILLEGAL_ARGUMENTS_ERRNO;
+					}
+				} else if (strcmp(option_name, "-trace") == 0) {
+					options->trace_path = option_value;
+				} else if (strcmp(option_name, "-series") == 0) {
+					options->series_path = option_value;
+				} else if (strcmp(option_name, "-series-interval") == 0) {
+					options->series_interval = atol(option_value);
+				} else if (strcmp(option_name, "-seed") == 0) {
+					options->seed = atoi(option_value);
+				} else if (strcmp(option_name, "-arenas") == 0) {
+					options->arena_count = atoi(option_value);
+				} else if (strcmp(option_name, "-magazine-capacity") == 0) {
+					options->magazine_capacity = atoi(option_value);
+				} else if (strcmp(option_name, "-stress-operations") == 0) {
+					options->stress_operations = atol(option_value);
+				} else if (strcmp(option_name, "-arena-assignment") == 0) {
+					if (strcmp(option_value, "round-robin") == 0) {
+						options->arena_assignment = ARENA_ASSIGNMENT_ROUND_ROBIN;
+					} else if (strcmp(option_value, "thread-id") == 0) {
+						options->arena_assignment = ARENA_ASSIGNMENT_THREAD_ID;
 					} else {
 						sprint_help(help_buffer);
 						log_fatal(help_buffer);
 						return ILLEGAL_ARGUMENTS_ERRNO;
 					}
+				} else if (strcmp(option_name, "-strategy") == 0) {
+					options->allocation_strategy_name = option_value;
+					options->allocation_strategy = mem_allocation_strategy_of_name(option_value);
+					strategy_set = options->allocation_strategy != NULL;
+					if (!strategy_set) {
+						sprint_help(help_buffer);
+						log_fatal(help_buffer);
+						return ILLEGAL_ARGUMENTS_ERRNO;
+					}
 				}
 
 				i_arg += 2;
@@ -317,14 +1572,14 @@ int parse_args(const int argc, char* argv[], tester_options_t* options) {
 		options->address_space_first_address = 0;
 	}
 
-	if (!size_set) {
+	if (!size_set && !options->search) {
 		log_fatal("-size option is required.");
 		sprint_help(help_buffer);
 		log_fatal(help_buffer);
 		return ILLEGAL_ARGUMENTS_ERRNO;
 	}
 
-	if (!strategy_set) {
+	if (!strategy_set && !options->compare && !options->search) {
 		log_fatal("-strategy option is required.");
 		sprint_help(help_buffer);
 		log_fatal(help_buffer);
@@ -343,13 +1598,34 @@ int parse_args(const int argc, char* argv[], tester_options_t* options) {
 int sprint_help(char* buffer) {
 	strcat(buffer, "\n\tRequired Arguments\n");
 	strcat(buffer, "\t  -size {int > 0} The address space size.\n");
-	strcat(buffer, "\t  -strategy {string} The strategy to use. Values are first, best, worst, next.\n");
+	strcat(buffer, "\t  -strategy {string} The strategy to use. Values are first, first-soa, best, worst, next, segregated, buddy, tlsf, bitmap, adaptive.\n");
 	strcat(buffer, "\tOptional Arguments\n");
 	strcat(buffer, "\t  -first-address {int} The address space initial value.\n");
 	strcat(buffer, "\t  -small-block-size {int > 0} The size of what is considered a small block.\n");
 	strcat(buffer, "\t  -alloc-to-free-ratio {int > 0} How many allocation for a single free for the test.\n");
 	strcat(buffer, "\t  -max-allocation {int > 0} The maximum allocation for the test.\n");
+	strcat(buffer, "\t  -granule-size {int > 0} The size of the granules of the bitmap strategy. It must be a power of two. Defaults to 16, doubled until the address space holds at most 2^27 granules, i.e. for spaces above 2 GiB.\n");
+	strcat(buffer, "\t  -reserved-blocks {int > 0} The count of free block records reserved when the allocator is initialized, so that allocations and frees never grow the pool until more free blocks exist.\n");
+	strcat(buffer, "\t  -seed {int > 0} The seed of the random deallocations. Defaults to the current time.\n");
+	strcat(buffer, "\t  -workload {string} The workload to generate. Values are formula, lognormal, zipf, phases, producer-consumer. Defaults to formula, sizes from a fixed formula freed at random.\n");
+	strcat(buffer, "\t  -trace {string} The path of a trace file into which to record the allocations and frees, for the replay tool.\n");
 	strcat(buffer, "\t  --verbose {flag} Whether to log everything.\n");
+	strcat(buffer, "\t  --benchmark {flag} Whether to only measure the time spent in the allocator, without logging every operation. Reports p50, p99 and max latency per call.\n");
+	strcat(buffer, "\t  --mapped {flag} Whether the address space is reserved with mmap, so that allocated memory is real and written to. The first address is chosen by the system.\n");
+	strcat(buffer, "\t  --reallocate {flag} Whether to also resize one random pointer for every free. Reports how often growth happened in place.\n");
+	strcat(buffer, "\t  --aligned {flag} Whether to allocate with mixed alignments of 16, 64 and 4096 bytes. Reports the fragmentation when memory ran out.\n");
+	strcat(buffer, "\t  --batch {flag} Whether to allocate every group of alloc-to-free-ratio pointers with mem_allocate_batch(), and to free everything with mem_free_batch().\n");
+	strcat(buffer, "\t  --compact {flag} Whether to allocate relocatable blocks through handles, and to compact the heap when it is out of memory. Reports the bytes moved and the time spent.\n");
+	strcat(buffer, "\t  --compare {flag} Whether to benchmark every strategy on the same workload and seed, then rank them by utilization at out of memory: the bytes requested by the live pointers, over the address space size. -strategy is not required.\n");
+	strcat(buffer, "\t  -series {string} The path of a file into which to write the time series of fragmentation, largest free block, free blocks and latency percentiles. JSON if it ends with .json, CSV otherwise.\n");
+	strcat(buffer, "\t  -series-interval {int > 0} The count of operations between two samples of the time series. Defaults to 1000.\n");
+	strcat(buffer, "\t  --search {flag} Whether to run the search benchmark instead: the first fit on the free block list against the first fit on arrays, with every supported scan, on 10k to 1M free blocks. -size and -strategy are not required.\n");
+	strcat(buffer, "\t  --regions {flag} Whether to run the region benchmark instead: requests of 16 to 4096 allocations freed one by one against the same requests bump allocated from a region and reset at once, on a fragmented heap.\n");
+	strcat(buffer, "\t  --stress {flag} Whether to run the multi-threaded stress test on arenas instead, from 1 to 32 threads. Reports the throughput.\n");
+	strcat(buffer, "\t  -arenas {int > 0} The count of arenas of the stress test. Defaults to one per thread.\n");
+	strcat(buffer, "\t  -arena-assignment {string} How stress threads are assigned to arenas. Values are round-robin, thread-id. Defaults to round-robin.\n");
+	strcat(buffer, "\t  -magazine-capacity {int <= 64} The capacity of the per-thread magazines of the stress test, by size class. Defaults to 0, without magazines.\n");
+	strcat(buffer, "\t  -stress-operations {int > 0} The count of operations per thread of the stress test.\n");
 	return SUCCESSFUL_EXEC;
 }
 
@@ -365,14 +1641,14 @@ int log_mem_state(const int level) {
 	memset(&mem_state_buffer, 0, LARGE_BUFFER_SIZE);
 	strcat(mem_state_buffer, "  ");
 
-	node_t* current = free_block_list->head;
+	node_t* current = allocator.free_blocks.list.head;
 	ptr_t* current_pointer;
 	while (current != NULL) {
 		current_pointer = current->element;
 
 		// Concatenate state of current block.
-		sprintf(mem_block_buffer, "[%lu, %u] -> ", current_pointer->address, current_pointer->size);
-		strncat(mem_state_buffer, mem_block_buffer, LARGE_BUFFER_SIZE - strlen(mem_state_buffer));
+		sprintf(mem_block_buffer, "[%lu, %lu] -> ", current_pointer->address, current_pointer->size);
+		strncat(mem_state_buffer, mem_block_buffer, LARGE_BUFFER_SIZE - strlen(mem_state_buffer) - 1);
         
 		// Move to the next node.
 		current = current->next;
@@ -395,31 +1671,293 @@ int log_mem_parameters(const int level) {
 	memset(&mem_parameters_buffer, 0, LARGE_BUFFER_SIZE);
 
 	unsigned int allocated_blocks;
-	mem_count_allocated_block(&allocated_blocks);
+	mem_count_allocated_block(&allocator, &allocated_blocks);
 	sprintf(mem_parameter_buffer, "\t  Allocated Blocks: %u\n", allocated_blocks);
 	strcat(mem_parameters_buffer, mem_parameter_buffer);
 
 	unsigned int free_blocks;
-	mem_count_free_block(&free_blocks);
+	mem_count_free_block(&allocator, &free_blocks);
 	sprintf(mem_parameter_buffer, "\t  Free Blocks: %u\n", free_blocks);
 	strcat(mem_parameters_buffer, mem_parameter_buffer);
 
 	unsigned long free_memory;
-	mem_count_free(&free_memory);
+	mem_count_free(&allocator, &free_memory);
 	sprintf(mem_parameter_buffer, "\t  Free memory: %lu\n", free_memory);
 	strcat(mem_parameters_buffer, mem_parameter_buffer);
 
 	sz_t greatest_block;
-	mem_greatest_free_block(&greatest_block);
-	sprintf(mem_parameter_buffer, "\t  Greatest block: %u\n", greatest_block);
+	mem_greatest_free_block(&allocator, &greatest_block);
+	sprintf(mem_parameter_buffer, "\t  Greatest block: %lu\n", greatest_block);
 	strcat(mem_parameters_buffer, mem_parameter_buffer);
 
 	unsigned int small_blocks;
-	mem_count_free_block_smaller_than(tester_options.small_block_size, &small_blocks);
-	sprintf(mem_parameter_buffer, "\t  Block smaller than %d: %u", tester_options.small_block_size, small_blocks);
+	mem_count_free_block_smaller_than(&allocator, tester_options.small_block_size, &small_blocks);
+	sprintf(mem_parameter_buffer, "\t  Block smaller than %lu: %u", tester_options.small_block_size, small_blocks);
 	strcat(mem_parameters_buffer, mem_parameter_buffer);
 
 	log_format(level, "\n\tMemory parameters\n%s", mem_parameters_buffer);
 	log_debug("Exiting log_mem_parameters().");
 	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Logs the measurements of the benchmark run.
+/// </summary>
+/// <param name="level">The logging level to use.</param>
+/// <returns>The state code.</returns>
+int log_benchmark(const int level) {
+	log_debug("Entering log_benchmark().");
+	unsigned long allocation_count = tester_benchmark.allocation_count ? tester_benchmark.allocation_count : 1;
+	unsigned long free_count = tester_benchmark.free_count ? tester_benchmark.free_count : 1;
+
+	unsigned long libc_call_count;
+	mem_count_libc_calls(&allocator, &libc_call_count);
+
+	// Latency percentiles are read from the sorted latencies.
+	latency_array_t* allocation_latencies = &tester_benchmark.allocation_latencies;
+	latency_array_t* free_latencies = &tester_benchmark.free_latencies;
+	qsort(allocation_latencies->latencies, allocation_latencies->length, sizeof(unsigned long), &compare_latency);
+	qsort(free_latencies->latencies, free_latencies->length, sizeof(unsigned long), &compare_latency);
+
+	log_format(level, "\n\tBenchmark (strategy %s, workload %s)"
+		"\n\t  Allocations: %lu, Time: %.3f ms, Average: %lu ns"
+		"\n\t    Latency p50: %lu ns, p99: %lu ns, max: %lu ns"
+		"\n\t  Frees: %lu, Time: %.3f ms, Average: %lu ns"
+		"\n\t    Latency p50: %lu ns, p99: %lu ns, max: %lu ns"
+		"\n\t  Free blocks at out of memory: %u, Fragmentation: %.1f%%"
+		"\n\t  Allocator libc calls: %lu",
+		tester_options.allocation_strategy_name, tester_options.workload_name != NULL ? tester_options.workload_name : "formula",
+		tester_benchmark.allocation_count, tester_benchmark.allocation_ns / 1e6, tester_benchmark.allocation_ns / allocation_count,
+		latency_array_percentile(allocation_latencies, 50), latency_array_percentile(allocation_latencies, 99), latency_array_percentile(allocation_latencies, 100),
+		tester_benchmark.free_count, tester_benchmark.free_ns / 1e6, tester_benchmark.free_ns / free_count,
+		latency_array_percentile(free_latencies, 50), latency_array_percentile(free_latencies, 99), latency_array_percentile(free_latencies, 100),
+		tester_benchmark.free_blocks_at_oom, fragmentation_at_oom(), libc_call_count);
+
+	log_debug("Exiting log_benchmark().");
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Logs the strategies of a comparison as a table, ranked by utilization at out of memory.
+/// </summary>
+/// <param name="level">The logging level to use.</param>
+/// <param name="results">The results of the strategies, ranked.</param>
+/// <param name="count">The count of results.</param>
+/// <returns>The state code.</returns>
+int log_compare(const int level, const compare_result_t* results, unsigned int count) {
+	log_debug("Entering log_compare().");
+	char row_buffer[SMALL_BUFFER_SIZE];
+	char table_buffer[LARGE_BUFFER_SIZE];
+	memset(&table_buffer, 0, LARGE_BUFFER_SIZE);
+
+	unsigned int i_result;
+	for (i_result = 0; i_result < count; i_result++) {
+		const compare_result_t* result = &results[i_result];
+		snprintf(row_buffer, SMALL_BUFFER_SIZE, "\n\t  %4u  %-10s %7.1f%% %8.1f%% %8.1f%% %8lu %8lu %8lu %8lu %10.3f %7u",
+			i_result + 1, result->strategy_name, result->utilization, result->fragmentation_at_oom, result->mean_fragmentation, 
+			result->allocation_p50, result->allocation_p99, result->free_p50, result->free_p99, (result->allocation_ns + result->free_ns) / 1e6, result->latency_rank);
+		strncat(table_buffer, row_buffer, LARGE_BUFFER_SIZE - strlen(table_buffer) - 1);
+	}
+
+	log_format(level, "\n\tComparison (workload %s, size %lu)"
+		"\n\t  Rank  Strategy   Utilized  Frag@OOM Frag mean  Alloc50  Alloc99   Free50   Free99  Time (ms) Latency%s",
+		tester_options.workload_name != NULL ? tester_options.workload_name : "formula", tester_options.address_space_size, table_buffer);
+
+	log_debug("Exiting log_compare().");
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Logs the windows and allocations of every strategy of the adaptive strategy, and its last switches.
+/// </summary>
+/// <param name="level">The logging level to use.</param>
+/// <returns>The state code.</returns>
+int log_adaptive(const int level) {
+	log_debug("Entering log_adaptive().");
+	char line_buffer[SMALL_BUFFER_SIZE];
+	char lines_buffer[LARGE_BUFFER_SIZE];
+	memset(&lines_buffer, 0, LARGE_BUFFER_SIZE);
+
+	const adaptive_state_t* state = &allocator.adaptive;
+	unsigned int i_candidate;
+	for (i_candidate = 0; i_candidate < ADAPTIVE_CANDIDATE_COUNT; i_candidate++) {
+		snprintf(line_buffer, SMALL_BUFFER_SIZE, "\n\t  %s: Windows: %lu, Allocations: %lu, Last cost: %.3f", 
+			mem_allocation_strategy_name_of(mem_adaptive_candidate(i_candidate)), state->window_counts[i_candidate], state->allocation_counts[i_candidate], state->costs[i_candidate]);
+		strncat(lines_buffer, line_buffer, LARGE_BUFFER_SIZE - strlen(lines_buffer) - 1);
+	}
+
+	// The ring holds the last switches, oldest first.
+	unsigned long i_switch = state->switch_count > ADAPTIVE_SWITCH_HISTORY ? state->switch_count - ADAPTIVE_SWITCH_HISTORY : 0;
+	for (; i_switch < state->switch_count; i_switch++) {
+		const adaptive_switch_t* event = &state->switches[i_switch % ADAPTIVE_SWITCH_HISTORY];
+		snprintf(line_buffer, SMALL_BUFFER_SIZE, "\n\t  Switch at window %lu: %s to %s, Search length: %.1f, Fragmentation: %.1f%%, Failures: %.1f%%", 
+			event->window, mem_allocation_strategy_name_of(mem_adaptive_candidate(event->from)), mem_allocation_strategy_name_of(mem_adaptive_candidate(event->to)), 
+			event->search_length, 100 * event->fragmentation, 100 * event->failure_rate);
+		strncat(lines_buffer, line_buffer, LARGE_BUFFER_SIZE - strlen(lines_buffer) - 1);
+	}
+
+	log_format(level, "\n\tAdaptive strategy (windows of %u allocations)"
+		"\n\t  Windows: %lu, Switches: %lu, Search steps: %lu%s",
+		ADAPTIVE_WINDOW_SIZE, state->window_count, state->switch_count, allocator.search_step_count, lines_buffer);
+
+	log_debug("Exiting log_adaptive().");
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Logs the granules of the bitmap strategy, and checks that the popcount of the bitmap agrees with the count of free bytes.
+/// </summary>
+/// <param name="level">The logging level to use.</param>
+/// <returns>The state code.</returns>
+int log_bitmap(const int level) {
+	log_debug("Entering log_bitmap().");
+	const block_bitmap_t* bitmap = &allocator.free_blocks.bitmap;
+	unsigned long free_bytes, bitmap_free_bytes = mem_block_bitmap_count_free(bitmap);
+	mem_count_free(&allocator, &free_bytes);
+
+	// The bytes before the first granule and after the last are free, but have no bit.
+	if (bitmap_free_bytes > free_bytes || free_bytes - bitmap_free_bytes >= 2 * bitmap->granule_size) {
+		log_warn("The bitmap counts %lu free bytes, but mem_count_free() counts %lu. Might be a bug.", bitmap_free_bytes, free_bytes);
+	}
+
+	log_format(level, "\n\tBitmap strategy (granules of %lu bytes)"
+		"\n\t  Granules: %lu, Words: %lu, Free bytes by popcount: %lu, Search steps: %lu",
+		bitmap->granule_size, bitmap->granule_count, bitmap->word_count, bitmap_free_bytes, allocator.search_step_count);
+
+	log_debug("Exiting log_bitmap().");
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Logs the counts of the reallocations, and how often growth happened in place.
+/// </summary>
+/// <param name="level">The logging level to use.</param>
+/// <returns>The state code.</returns>
+int log_reallocations(const int level) {
+	log_debug("Entering log_reallocations().");
+	unsigned long reallocation_count = tester_benchmark.reallocation_count ? tester_benchmark.reallocation_count : 1;
+	unsigned long growth_count = tester_benchmark.growth_count ? tester_benchmark.growth_count : 1;
+
+	log_format(level, "\n\tReallocations (strategy %s)"
+		"\n\t  Reallocations: %lu, Time: %.3f ms, Average: %lu ns"
+		"\n\t  Growths: %lu, In place: %lu (%.1f%%)",
+		tester_options.allocation_strategy_name,
+		tester_benchmark.reallocation_count, tester_benchmark.reallocation_ns / 1e6, tester_benchmark.reallocation_ns / reallocation_count,
+		tester_benchmark.growth_count, tester_benchmark.in_place_growth_count, 100.0 * tester_benchmark.in_place_growth_count / growth_count);
+
+	log_debug("Exiting log_reallocations().");
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Logs the counts of the aligned allocations, and the fragmentation of the memory when it ran out.
+/// </summary>
+/// <param name="level">The logging level to use.</param>
+/// <returns>The state code.</returns>
+int log_alignments(const int level) {
+	log_debug("Entering log_alignments().");
+	log_format(level, "\n\tAlignments (strategy %s)"
+		"\n\t  Allocations aligned on %lu: %lu, on %lu: %lu, on %lu: %lu"
+		"\n\t  At out of memory: Free memory: %lu, Free blocks: %u, Greatest block: %lu, Fragmentation: %.1f%%",
+		tester_options.allocation_strategy_name,
+		ALIGNMENTS[0], tester_benchmark.aligned_allocation_counts[0], ALIGNMENTS[1], tester_benchmark.aligned_allocation_counts[1], 
+		ALIGNMENTS[2], tester_benchmark.aligned_allocation_counts[2],
+		tester_benchmark.free_bytes_at_oom, tester_benchmark.free_blocks_at_oom, tester_benchmark.greatest_free_block_at_oom, fragmentation_at_oom());
+
+	log_debug("Exiting log_alignments().");
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Gets the fragmentation of the free memory when the allocator ran out of memory: the part of it that is not in the greatest free block.
+/// </summary>
+/// <returns>The fragmentation, in percent.</returns>
+double fragmentation_at_oom() {
+	if (!tester_benchmark.free_bytes_at_oom) {
+		return 0;
+	}
+
+	return 100.0 * (tester_benchmark.free_bytes_at_oom - tester_benchmark.greatest_free_block_at_oom) / tester_benchmark.free_bytes_at_oom;
+}
+
+/// <summary>
+/// Records the state of the free memory when the allocator ran out of memory.
+/// </summary>
+void record_out_of_memory() {
+	mem_count_free_block(&allocator, &tester_benchmark.free_blocks_at_oom);
+	mem_count_free(&allocator, &tester_benchmark.free_bytes_at_oom);
+	mem_greatest_free_block(&allocator, &tester_benchmark.greatest_free_block_at_oom);
+	tester_benchmark.requested_bytes_at_oom = tester_benchmark.requested_bytes;
+	series_sample();
+}
+
+/// <summary>
+/// Logs the measurements of the compactions.
+/// </summary>
+/// <param name="level">The logging level to use.</param>
+/// <returns>The state code.</returns>
+int log_compaction(const int level) {
+	log_debug("Entering log_compaction().");
+	compaction_stats_t stats;
+	mem_compaction_stats(&allocator, &stats);
+
+	log_format(level, "\n\tCompaction (strategy %s)"
+		"\n\t  Allocations: %lu, Compactions: %lu, Time: %.3f ms"
+		"\n\t  Moved blocks: %lu, Moved bytes: %lu",
+		tester_options.allocation_strategy_name,
+		tester_benchmark.allocation_count, stats.compaction_count, stats.ns / 1e6,
+		stats.moved_block_count, stats.moved_bytes);
+
+	log_debug("Exiting log_compaction().");
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Gets the pointer of an allocated block from its key in the array of allocated blocks: its address, or its handle with --compact.
+/// </summary>
+/// <param name="key">The key of the block.</param>
+/// <param name="pointer">The out argument for the pointer.</param>
+/// <returns>The state code.</returns>
+int pointer_of_key(mem_address_t key, ptr_t* pointer) {
+	if (tester_options.compact) {
+		return mem_handle_pointer(&allocator, key, pointer);
+	}
+
+	pointer->address = key;
+	pointer->is_allocated = true;
+	return mem_allocated_size(&allocator, key, &pointer->size);
+}
+
+/// <summary>
+/// Frees an allocated block from its key in the array of allocated blocks: its address, or its handle with --compact.
+/// </summary>
+/// <param name="key">The key of the block.</param>
+/// <returns>The state code.</returns>
+int free_key(mem_address_t key) {
+	return tester_options.compact ? mem_free_handle(&allocator, key) : mem_free_address(&allocator, key);
+}
+
+/// <summary>
+/// Gets the time elapsed since the given start, in nanoseconds.
+/// </summary>
+/// <param name="start">The start time, from the monotonic clock.</param>
+/// <returns>The elapsed nanoseconds.</returns>
+unsigned long elapsed_ns(const struct timespec* start) {
+	struct timespec end;
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	return (end.tv_sec - start->tv_sec) * 1000000000UL + end.tv_nsec - start->tv_nsec;
+}
+
+/// <summary>
+/// Gets a random size below a bound. A bound greater than RAND_MAX takes two draws, so that every size of the address space can be drawn.
+/// </summary>
+/// <param name="bound">The bound. This cannot be 0.</param>
+/// <returns>The size, from 0 to the bound minus 1.</returns>
+sz_t random_below(sz_t bound) {
+	if (bound <= RAND_MAX) {
+		return rand() % bound;
+	}
+
+	sz_t draw = (sz_t) rand() << 31;
+	return (draw | rand()) % bound;
 }
\ No newline at end of file
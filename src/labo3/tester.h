@@ -1,37 +1,341 @@
 #ifndef TESTER_H
 #define TESTER_H
 
+// Number of alignments of the mixed-alignment workload.
+#define ALIGNMENT_COUNT 3
+
+// Number of strategies compared by --compare.
+#define COMPARED_STRATEGY_COUNT 10
+
+// Number of counts of free blocks of the search benchmark, and of the searches compared on each.
+#define SEARCH_FREE_BLOCK_COUNT_COUNT 3
+#define SEARCH_VARIANT_COUNT 4
+
+// Number of counts of allocations per request of the region benchmark.
+#define REGION_REQUEST_SIZE_COUNT 3
+
 // Structure for the options of the tester.
 typedef struct tester_options_t {
 	mem_allocation_strategy_t allocation_strategy;
+	const char* allocation_strategy_name;
+	const char* trace_path;
+	const char* series_path;
+	const char* workload_name;
+	unsigned int workload;
 	mem_address_t address_space_first_address;
 	sz_t address_space_size;
 	sz_t small_block_size;
 	sz_t max_alloc_size;
+	sz_t granule_size;
+	unsigned int reserved_block_count;
 	unsigned int alloc_to_free_ratio;
+	unsigned int seed;
 	unsigned int verbose;
+	unsigned int benchmark;
+	unsigned int mapped;
+	unsigned int stress;
+	unsigned int reallocate;
+	unsigned int aligned;
+	unsigned int batch;
+	unsigned int compact;
+	unsigned int compare;
+	unsigned int search;
+	unsigned int regions;
+	unsigned int arena_count;
+	unsigned int arena_assignment;
+	unsigned int magazine_capacity;
+	unsigned long stress_operations;
+	unsigned long series_interval;
 } tester_options_t;
 
+// Structure for the array of latencies of a benchmark run, in nanoseconds.
+typedef struct latency_array_t {
+	unsigned long* latencies;
+	unsigned long length;
+	unsigned long capacity;
+} latency_array_t;
+
+// Structure for the measurements of a benchmark run.
+// Only the time spent within the allocator is measured.
+typedef struct tester_benchmark_t {
+	unsigned long allocation_count;
+	unsigned long free_count;
+	unsigned long allocation_ns;
+	unsigned long free_ns;
+	unsigned int free_blocks_at_oom;
+	unsigned long free_bytes_at_oom;
+	sz_t greatest_free_block_at_oom;
+
+	// The sum of the sizes requested by the live pointers, now and when memory ran out. Rounding and headers are not counted.
+	unsigned long requested_bytes;
+	unsigned long requested_bytes_at_oom;
+	unsigned long aligned_allocation_counts[ALIGNMENT_COUNT];
+	unsigned long reallocation_count;
+	unsigned long reallocation_ns;
+	unsigned long growth_count;
+	unsigned long in_place_growth_count;
+	latency_array_t allocation_latencies;
+	latency_array_t free_latencies;
+	double fragmentation_sum;
+	unsigned long fragmentation_sample_count;
+} tester_benchmark_t;
+
+// Structure for the time series of the benchmark runs. The state of the free memory is sampled every interval of operations.
+// The latency percentiles of a sample are over the window of operations since the previous sample.
+typedef struct tester_series_t {
+	FILE* file;
+	unsigned int is_json;
+	unsigned long row_count;
+	unsigned long operation_count;
+	unsigned long allocation_window_start;
+	unsigned long free_window_start;
+} tester_series_t;
+
+// Structure for the result of one strategy of a comparison.
+typedef struct compare_result_t {
+	const char* strategy_name;
+	unsigned long allocation_count;
+	unsigned long allocation_ns;
+	unsigned long free_ns;
+	// The part of the address space requested by the live pointers when memory ran out, in percent.
+	double utilization;
+	double fragmentation_at_oom;
+	double mean_fragmentation;
+	unsigned long allocation_p50;
+	unsigned long allocation_p99;
+	unsigned long free_p50;
+	unsigned long free_p99;
+	// The rank of the strategy by the sum of its allocation and free p50 latencies, from 1.
+	unsigned int latency_rank;
+} compare_result_t;
+
+// Structure for the work of one thread of the stress test.
+// Every thread allocates into and frees from its own slots, at random.
+typedef struct stress_thread_t {
+	arenas_t* arenas;
+	unsigned int seed;
+	unsigned long operations;
+	unsigned long out_of_memory_count;
+	int result;
+} stress_thread_t;
+
+// Structure for the array of the addresses of currently allocated blocks, or of their handles if they are relocatable. The allocator knows their sizes.
+// A removed address is replaced by the last one, so any address is removed in O(1).
+typedef struct address_array_t {
+	mem_address_t* addresses;
+	unsigned int length;
+	unsigned int capacity;
+} address_array_t;
+
+/// <summary>
+/// Runs the test with the strategy of the options, from a fresh allocator, then logs its measurements.
+/// </summary>
+/// <param name="seed">The seed of the random deallocations and of the workload.</param>
+/// <returns>The state code.</returns>
+int test_strategy(unsigned int seed);
+
+/// <summary>
+/// Runs the benchmark with every strategy on the same workload and the same seed, then logs the strategies ranked by utilization at out of memory.
+/// </summary>
+/// <param name="seed">The seed of the random deallocations and of the workload.</param>
+/// <returns>The state code.</returns>
+int test_compare(unsigned int seed);
+
 /// <summary>
 /// Allocates n pointers (defined by alloc_to_free_ratio option) then deallocates one random pointer until an out of memory error happens.
 /// </summary>
-/// <param name="allocated_pointer_list">The linked list of currently allocated pointers.</param>
+/// <param name="allocated_addresses">The array of the addresses of currently allocated blocks.</param>
+/// <returns>The state code.</returns>
+int test_allocate_until_out_of_mem(address_array_t* allocated_addresses);
+
+/// <summary>
+/// Allocates one pointer, through a handle with --compact or aligned with --aligned, and checks it.
+/// </summary>
+/// <param name="pointer_index">The index of the pointer since the start. The alignment is derived from it.</param>
+/// <param name="size">The size of the allocation.</param>
+/// <param name="key">The out argument for the key of the pointer: its address, or its handle with --compact.</param>
+/// <param name="is_oom">The out argument for whether the allocator is out of memory.</param>
+/// <returns>The state code.</returns>
+int test_allocate_pointer(unsigned long pointer_index, sz_t size, mem_address_t* key, unsigned int* is_oom);
+
+/// <summary>
+/// Allocates and frees as a generated workload decides, until an out of memory error happens.
+/// </summary>
+/// <param name="workload">The workload generator.</param>
+/// <returns>The state code.</returns>
+int test_workload_until_out_of_mem(workload_t* workload);
+
+/// <summary>
+/// Deallocates all pointers still alive in a generated workload, in the order of their deaths.
+/// </summary>
+/// <param name="workload">The workload generator.</param>
+/// <returns>The state code.</returns>
+int test_workload_deallocate_all(workload_t* workload);
+
+/// <summary>
+/// Allocates n pointers (defined by alloc_to_free_ratio option) with a single call to mem_allocate_batch().
+/// </summary>
+/// <param name="allocated_addresses">The array of the addresses of currently allocated blocks.</param>
+/// <param name="i_allocate">The index of the batch. The sizes are derived from it.</param>
+/// <param name="is_oom">The out argument for whether the allocator is out of memory.</param>
+/// <returns>The state code.</returns>
+int test_allocate_batch(address_array_t* allocated_addresses, unsigned int i_allocate, unsigned int* is_oom);
+
+/// <summary>
+/// Deallocates one random pointer within the given allocated pointer array.
+/// </summary>
+/// <param name="allocated_addresses">The array of the addresses of currently allocated blocks.</param>
+/// <returns>The state code.</returns>
+int test_deallocate_random_pointer(address_array_t* allocated_addresses);
+
+/// <summary>
+/// Frees one pointer by its key only, and checks it.
+/// </summary>
+/// <param name="key">The key of the pointer: its address, or its handle with --compact.</param>
+/// <returns>The state code.</returns>
+int test_deallocate_pointer(mem_address_t key);
+
+/// <summary>
+/// Reallocates one random pointer within the given allocated pointer array to a random size, and counts whether it grew in place.
+/// </summary>
+/// <param name="allocated_addresses">The array of the addresses of currently allocated blocks.</param>
+/// <returns>The state code.</returns>
+int test_reallocate_random_pointer(address_array_t* allocated_addresses);
+
+/// <summary>
+/// Deallocates all pointers within the given allocated pointer array.
+/// </summary>
+/// <param name="allocated_addresses">The array of the addresses of currently allocated blocks.</param>
+/// <returns>The state code.</returns>
+int test_deallocate_all(address_array_t* allocated_addresses);
+
+/// <summary>
+/// Deallocates all pointers within the given allocated pointer array, by batches of calls to mem_free_batch().
+/// </summary>
+/// <param name="allocated_addresses">The array of the addresses of currently allocated blocks.</param>
+/// <returns>The state code.</returns>
+int test_deallocate_all_batch(address_array_t* allocated_addresses);
+
+/// <summary>
+/// Runs the search benchmark: the heap is cut into 10k to 1M free blocks, then the first fit on the free block list and on the free blocks as arrays,
+/// with every scan the processor supports, search it for the same random sizes. Reports the mean time and steps per search.
+/// </summary>
+/// <param name="seed">The seed of the random sizes.</param>
+/// <returns>The state code.</returns>
+int test_search(unsigned int seed);
+
+/// <summary>
+/// Runs the region benchmark: on a heap fragmented by long-lived blocks, requests of 16 to 4096 allocations are served either by
+/// the allocator, with a free per allocation at the end of the request, or by a region, with a single reset at the end of the request.
+/// Reports the mean time per allocation of both and the speedup of the region.
+/// </summary>
+/// <param name="seed">The seed of the random sizes.</param>
+/// <returns>The state code.</returns>
+int test_regions(unsigned int seed);
+
+/// <summary>
+/// Runs the multi-threaded stress test on arenas, with 1 to the maximum count of threads, doubling every time.
+/// Reports the throughput of every thread count.
+/// </summary>
+/// <returns>The state code.</returns>
+int test_stress();
+
+/// <summary>
+/// Runs the work of one thread of the stress test.
+/// </summary>
+/// <param name="argument">The work of the thread, as a stress_thread_t.</param>
+/// <returns>Null. The state code is put into the work of the thread.</returns>
+void* test_stress_thread(void* argument);
+
+/// <summary>
+/// Checks whether the memory of a freed pointer is entirely within a single free block.
+/// Freed memory is always merged with its free neighbours, so it cannot span many free blocks.
+/// </summary>
+/// <param name="pointer">The freed pointer.</param>
+/// <returns>Whether the memory is within a single free block.</returns>
+int is_within_free_block(const ptr_t* pointer);
+
+/// <summary>
+/// Appends an address to an array of addresses. The array grows as needed.
+/// </summary>
+/// <param name="array">The array in which to add.</param>
+/// <param name="address">The address to add.</param>
+/// <returns>The state code.</returns>
+int address_array_add(address_array_t* array, mem_address_t address);
+
+/// <summary>
+/// Removes the address at the given index of an array of addresses. The last address takes its place.
+/// </summary>
+/// <param name="array">The array in which to remove.</param>
+/// <param name="index">The index of the address to remove.</param>
 /// <returns>The state code.</returns>
-int test_allocate_until_out_of_mem(linkedlist_t* allocated_pointer_list);
+int address_array_remove(address_array_t* array, unsigned int index);
 
 /// <summary>
-/// Deallocates one random pointer within the given allocated pointer list.
+/// Keeps the size requested for a live pointer, and adds it to the requested bytes.
 /// </summary>
-/// <param name="allocated_pointer_list">The linked list of currently allocated pointers.</param>
+/// <param name="key">The key of the pointer: its address, or its handle with --compact.</param>
+/// <param name="size">The requested size.</param>
 /// <returns>The state code.</returns>
-int test_deallocate_random_pointer(linkedlist_t* allocated_pointer_list);
+int requested_size_add(mem_address_t key, sz_t size);
 
 /// <summary>
-/// Deallocates all pointers within the given allocated pointer list.
+/// Forgets the size requested for a pointer that is freed, and removes it from the requested bytes.
 /// </summary>
-/// <param name="allocated_pointer_list">The linked list of currently allocated pointers.</param>
+/// <param name="key">The key of the pointer: its address, or its handle with --compact.</param>
 /// <returns>The state code.</returns>
-int test_deallocate_all(linkedlist_t* allocated_pointer_list);
+int requested_size_remove(mem_address_t key);
+
+/// <summary>
+/// Appends a latency to an array of latencies. The array grows as needed.
+/// </summary>
+/// <param name="array">The array in which to add.</param>
+/// <param name="latency">The latency to add, in nanoseconds.</param>
+/// <returns>The state code.</returns>
+int latency_array_add(latency_array_t* array, unsigned long latency);
+
+/// <summary>
+/// Gets the given percentile of an array of latencies. The array must be sorted.
+/// </summary>
+/// <param name="array">The sorted array of latencies.</param>
+/// <param name="percentile">The percentile to get, from 0 to 100.</param>
+/// <returns>The latency at the percentile, in nanoseconds. 0 if the array is empty.</returns>
+unsigned long latency_array_percentile(const latency_array_t* array, unsigned int percentile);
+
+/// <summary>
+/// Gets the p50, p99 and max of the latencies of an array from an index, without reordering the array.
+/// </summary>
+/// <param name="array">The array of latencies.</param>
+/// <param name="start">The index of the first latency of the window.</param>
+/// <param name="percentiles">The out argument for the p50, p99 and max latencies, in nanoseconds. All are 0 if the window is empty.</param>
+/// <returns>The state code.</returns>
+int latency_window_percentiles(const latency_array_t* array, unsigned long start, unsigned long percentiles[3]);
+
+/// <summary>
+/// Counts one operation on the allocator, and samples the time series at every interval of operations.
+/// </summary>
+void series_count_operation();
+
+/// <summary>
+/// Samples the state of the free memory, and writes it with the latencies of the window as a row of the time series, if one is written.
+/// </summary>
+/// <returns>The state code.</returns>
+int series_sample();
+
+/// <summary>
+/// Creates the file of the time series, and writes its header. The series is in JSON if the path ends with .json, in CSV otherwise.
+/// </summary>
+/// <param name="path">The path of the file.</param>
+/// <returns>The state code.</returns>
+int series_open(const char* path);
+
+/// <summary>
+/// Writes the ranking of a comparison into the file of the time series, if in JSON, and closes it.
+/// </summary>
+/// <param name="results">The results of the strategies, ranked. Null if there was no comparison.</param>
+/// <param name="count">The count of results.</param>
+/// <returns>The state code.</returns>
+int series_close(const compare_result_t* results, unsigned int count);
 
 /// <summary>
 /// Parse the command line arguments into an options structure.
@@ -63,4 +367,95 @@ int log_mem_state(const int level);
 /// <returns>The state code.</returns>
 int log_mem_parameters(const int level);
 
+/// <summary>
+/// Logs the measurements of the benchmark run.
+/// </summary>
+/// <param name="level">The logging level to use.</param>
+/// <returns>The state code.</returns>
+int log_benchmark(const int level);
+
+/// <summary>
+/// Logs the strategies of a comparison as a table, ranked by utilization at out of memory.
+/// </summary>
+/// <param name="level">The logging level to use.</param>
+/// <param name="results">The results of the strategies, ranked.</param>
+/// <param name="count">The count of results.</param>
+/// <returns>The state code.</returns>
+int log_compare(const int level, const compare_result_t* results, unsigned int count);
+
+/// <summary>
+/// Logs the windows and allocations of every strategy of the adaptive strategy, and its last switches.
+/// </summary>
+/// <param name="level">The logging level to use.</param>
+/// <returns>The state code.</returns>
+int log_adaptive(const int level);
+
+/// <summary>
+/// Logs the granules of the bitmap strategy, and checks that the popcount of the bitmap agrees with the count of free bytes.
+/// </summary>
+/// <param name="level">The logging level to use.</param>
+/// <returns>The state code.</returns>
+int log_bitmap(const int level);
+
+/// <summary>
+/// Logs the counts of the reallocations, and how often growth happened in place.
+/// </summary>
+/// <param name="level">The logging level to use.</param>
+/// <returns>The state code.</returns>
+int log_reallocations(const int level);
+
+/// <summary>
+/// Logs the counts of the aligned allocations, and the fragmentation of the memory when it ran out.
+/// </summary>
+/// <param name="level">The logging level to use.</param>
+/// <returns>The state code.</returns>
+int log_alignments(const int level);
+
+/// <summary>
+/// Gets the fragmentation of the free memory when the allocator ran out of memory: the part of it that is not in the greatest free block.
+/// </summary>
+/// <returns>The fragmentation, in percent.</returns>
+double fragmentation_at_oom();
+
+/// <summary>
+/// Records the state of the free memory when the allocator ran out of memory.
+/// </summary>
+void record_out_of_memory();
+
+/// <summary>
+/// Logs the measurements of the compactions.
+/// </summary>
+/// <param name="level">The logging level to use.</param>
+/// <returns>The state code.</returns>
+int log_compaction(const int level);
+
+/// <summary>
+/// Gets the pointer of an allocated block from its key in the array of allocated blocks: its address, or its handle with --compact.
+/// </summary>
+/// <param name="key">The key of the block.</param>
+/// <param name="pointer">The out argument for the pointer.</param>
+/// <returns>The state code.</returns>
+int pointer_of_key(mem_address_t key, ptr_t* pointer);
+
+/// <summary>
+/// Frees an allocated block from its key in the array of allocated blocks: its address, or its handle with --compact.
+/// </summary>
+/// <param name="key">The key of the block.</param>
+/// <returns>The state code.</returns>
+int free_key(mem_address_t key);
+
+/// <summary>
+/// Gets the time elapsed since the given start, in nanoseconds.
+/// </summary>
+/// <param name="start">The start time, from the monotonic clock.</param>
+/// <returns>The elapsed nanoseconds.</returns>
+unsigned long elapsed_ns(const struct timespec* start);
+
+/// <summary>
+/// Gets a random size below a bound. A bound greater than RAND_MAX takes two draws, so that every size of the address space can be drawn.
+/// </summary>
+/// <param name="bound">The bound. This cannot be 0.</param>
+/// <returns>The size, from 0 to the bound minus 1.</returns>
+sz_t random_below(sz_t bound);
+
 #endif
\ No newline at end of file
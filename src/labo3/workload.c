@@ -0,0 +1,379 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include "lib/logging.h"
+#include "malloc/commons.h"
+#include "workload.h"
+
+#define true 1
+#define false 0
+
+/// <summary>
+/// Mixes a 64 bits value, by the splitmix64 generator. It spreads a seed over the state of a stream.
+/// </summary>
+/// <param name="value">The value to mix. It advances by one step.</param>
+/// <returns>The mixed value.</returns>
+static uint64_t prng_splitmix(uint64_t* value) {
+	uint64_t mixed = (*value += 0x9E3779B97F4A7C15ULL);
+	mixed = (mixed ^ (mixed >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	mixed = (mixed ^ (mixed >> 27)) * 0x94D049BB133111EBULL;
+	return mixed ^ (mixed >> 31);
+}
+
+/// <summary>
+/// Rotates a 64 bits value to the left.
+/// </summary>
+/// <param name="value">The value.</param>
+/// <param name="count">The count of bits, from 1 to 63.</param>
+/// <returns>The rotated value.</returns>
+static uint64_t prng_rotate(uint64_t value, unsigned int count) {
+	return (value << count) | (value >> (64 - count));
+}
+
+/// <summary>
+/// Seeds a stream of pseudo random numbers. Streams of the same seed are independent.
+/// </summary>
+/// <param name="prng">The stream to seed.</param>
+/// <param name="seed">The seed.</param>
+/// <param name="stream">The index of the stream.</param>
+/// <returns>The state code.</returns>
+int prng_seed(prng_t* prng, uint64_t seed, unsigned int stream) {
+	if (prng == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	// Every stream starts from its own point of the splitmix64 sequence of the seed.
+	uint64_t value = stream;
+	value = seed ^ prng_splitmix(&value);
+	unsigned int i_state;
+	for (i_state = 0; i_state < 4; i_state++) {
+		prng->state[i_state] = prng_splitmix(&value);
+	}
+
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Gets the next pseudo random number of a stream.
+/// </summary>
+/// <param name="prng">The stream.</param>
+/// <returns>The number, uniform over 64 bits.</returns>
+uint64_t prng_next(prng_t* prng) {
+	uint64_t* state = prng->state;
+	uint64_t result = prng_rotate(state[1] * 5, 7) * 9;
+	uint64_t shifted = state[1] << 17;
+	state[2] ^= state[0];
+	state[3] ^= state[1];
+	state[1] ^= state[2];
+	state[0] ^= state[3];
+	state[2] ^= shifted;
+	state[3] = prng_rotate(state[3], 45);
+	return result;
+}
+
+/// <summary>
+/// Gets the next pseudo random number of a stream, uniform within (0, 1).
+/// </summary>
+/// <param name="prng">The stream.</param>
+/// <returns>The number.</returns>
+double prng_uniform(prng_t* prng) {
+	// The 53 high bits fill the mantissa; the half step keeps the number away from 0 and 1.
+	return ((prng_next(prng) >> 11) + 0.5) / 9007199254740992.0;
+}
+
+/// <summary>
+/// Gets the next pseudo random number of a stream, from the standard normal distribution.
+/// </summary>
+/// <param name="prng">The stream.</param>
+/// <returns>The number.</returns>
+double prng_normal(prng_t* prng) {
+	// Box-Muller transform. The second number it gives is dropped, so every number takes the same draws.
+	double radius = sqrt(-2.0 * log(prng_uniform(prng)));
+	return radius * cos(2.0 * M_PI * prng_uniform(prng));
+}
+
+/// <summary>
+/// Gets the next pseudo random number of a stream, from the exponential distribution.
+/// </summary>
+/// <param name="prng">The stream.</param>
+/// <param name="mean">The mean of the distribution.</param>
+/// <returns>The number.</returns>
+double prng_exponential(prng_t* prng, double mean) {
+	return -mean * log(prng_uniform(prng));
+}
+
+/// <summary>
+/// Gets the kind of workload of a name.
+/// </summary>
+/// <param name="name">The name: formula, lognormal, zipf, phases or producer-consumer.</param>
+/// <param name="kind">The out argument for the kind.</param>
+/// <returns>The state code.</returns>
+int workload_kind_of_name(const char* name, unsigned int* kind) {
+	if (name == NULL || kind == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	if (strcmp(name, "formula") == 0) {
+		*kind = WORKLOAD_FORMULA;
+	} else if (strcmp(name, "lognormal") == 0) {
+		*kind = WORKLOAD_LOGNORMAL;
+	} else if (strcmp(name, "zipf") == 0) {
+		*kind = WORKLOAD_ZIPF;
+	} else if (strcmp(name, "phases") == 0) {
+		*kind = WORKLOAD_PHASES;
+	} else if (strcmp(name, "producer-consumer") == 0) {
+		*kind = WORKLOAD_PRODUCER_CONSUMER;
+	} else {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Initializes a workload generator.
+/// </summary>
+/// <param name="workload">The workload to initialize.</param>
+/// <param name="kind">The kind of workload. It cannot be the formula workload, which the tester runs itself.</param>
+/// <param name="max_size">The maximum size of an allocation.</param>
+/// <param name="seed">The seed of the streams of the workload.</param>
+/// <returns>The state code.</returns>
+int workload_init(workload_t* workload, unsigned int kind, sz_t max_size, uint64_t seed) {
+	log_debug("Entering workload_init(). Kind: %u, Maximum size: %lu.", kind, max_size);
+	if (workload == NULL || kind == WORKLOAD_FORMULA || kind > WORKLOAD_PRODUCER_CONSUMER || !max_size) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	memset(workload, 0, sizeof(workload_t));
+	workload->kind = kind;
+	workload->max_size = max_size;
+	unsigned int i_stream;
+	for (i_stream = 0; i_stream < WORKLOAD_STREAM_COUNT; i_stream++) {
+		prng_seed(&workload->streams[i_stream], seed, i_stream);
+	}
+
+	// The probability of the size of rank k is proportional to 1 / k^s.
+	if (kind == WORKLOAD_ZIPF) {
+		workload->zipf_granule = WORKLOAD_ZIPF_GRANULE;
+		while (max_size / workload->zipf_granule > WORKLOAD_ZIPF_MAXIMUM_RANK_COUNT) {
+			workload->zipf_granule *= 2;
+		}
+
+		workload->zipf_count = max_size >= workload->zipf_granule ? max_size / workload->zipf_granule : 1;
+		if ((workload->zipf_cdf = malloc(workload->zipf_count * sizeof(double))) == NULL) {
+			return OUT_OF_MEMORY_ERRNO;
+		}
+
+		unsigned int i_rank;
+		double sum = 0.0;
+		for (i_rank = 0; i_rank < workload->zipf_count; i_rank++) {
+			sum += pow(i_rank + 1, -WORKLOAD_ZIPF_EXPONENT);
+			workload->zipf_cdf[i_rank] = sum;
+		}
+
+		for (i_rank = 0; i_rank < workload->zipf_count; i_rank++) {
+			workload->zipf_cdf[i_rank] /= sum;
+		}
+	}
+
+	log_debug("Exiting workload_init().");
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Destroys a workload generator.
+/// </summary>
+/// <param name="workload">The workload.</param>
+/// <returns>The state code.</returns>
+int workload_destroy(workload_t* workload) {
+	log_debug("Entering workload_destroy().");
+	if (workload == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	free(workload->zipf_cdf);
+	free(workload->deaths);
+	free(workload->survivors);
+	memset(workload, 0, sizeof(workload_t));
+
+	log_debug("Exiting workload_destroy().");
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Gets whether the workload is in a phase of large long-lived blocks.
+/// </summary>
+/// <param name="workload">The workload.</param>
+/// <returns>Whether the phase is of large blocks.</returns>
+static int workload_is_large_phase(const workload_t* workload) {
+	return (workload->tick / WORKLOAD_PHASE_LENGTH) % 2;
+}
+
+/// <summary>
+/// Gets the size of the next allocation.
+/// </summary>
+/// <param name="workload">The workload.</param>
+/// <returns>The size, from 1 to the maximum size.</returns>
+sz_t workload_next_size(workload_t* workload) {
+	prng_t* stream = &workload->streams[WORKLOAD_SIZE_STREAM];
+	double size;
+	if (workload->kind == WORKLOAD_ZIPF) {
+		// Find the rank of the draw in the cumulative probabilities.
+		double draw = prng_uniform(stream);
+		unsigned int low = 0, high = workload->zipf_count - 1;
+		while (low < high) {
+			unsigned int middle = (low + high) / 2;
+			if (workload->zipf_cdf[middle] < draw) low = middle + 1;
+			else high = middle;
+		}
+
+		size = (low + 1) * (double) workload->zipf_granule;
+	} else {
+		// Phases of small blocks have sizes 4 times smaller, and phases of large blocks 4 times larger.
+		double median = (double) workload->max_size / WORKLOAD_LOGNORMAL_MEDIAN_DIVISOR;
+		if (workload->kind == WORKLOAD_PHASES) {
+			median = workload_is_large_phase(workload) ? 4 * median : median / 4;
+		}
+
+		size = median * exp(WORKLOAD_LOGNORMAL_SIGMA * prng_normal(stream));
+	}
+
+	return size < 1 ? 1 : size > workload->max_size ? workload->max_size : (sz_t) size;
+}
+
+/// <summary>
+/// Adds the block of the last allocation, and decides when it is freed. The clock of the workload advances by one allocation.
+/// </summary>
+/// <param name="workload">The workload.</param>
+/// <param name="key">The key of the block, given back when it must be freed.</param>
+/// <returns>The state code.</returns>
+int workload_add(workload_t* workload, mem_address_t key) {
+	if (workload == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	prng_t* stream = &workload->streams[WORKLOAD_LIFETIME_STREAM];
+	unsigned long tick = workload->tick++;
+	if (prng_next(stream) % 100 < WORKLOAD_SURVIVOR_PERCENT) {
+		if (workload->survivor_count == workload->survivor_capacity) {
+			unsigned long capacity = workload->survivor_capacity ? 2 * workload->survivor_capacity : WORKLOAD_INITIAL_CAPACITY;
+			mem_address_t* survivors = realloc(workload->survivors, capacity * sizeof(mem_address_t));
+			if (survivors == NULL) {
+				return OUT_OF_MEMORY_ERRNO;
+			}
+
+			workload->survivors = survivors;
+			workload->survivor_capacity = capacity;
+		}
+
+		workload->survivors[workload->survivor_count++] = key;
+		return SUCCESSFUL_EXEC;
+	}
+
+	// Decide the tick of the death of the block.
+	if (workload->kind == WORKLOAD_PRODUCER_CONSUMER) {
+		// Messages are consumed in order, so no message dies before the one produced before it.
+		tick += 1 + (unsigned long) prng_exponential(stream, WORKLOAD_QUEUE_DEPTH);
+		tick = workload->last_tick = tick > workload->last_tick ? tick : workload->last_tick;
+	} else if (workload->kind == WORKLOAD_PHASES) {
+		tick += 1 + (unsigned long) prng_exponential(stream, workload_is_large_phase(workload) ? WORKLOAD_LONG_LIFETIME : WORKLOAD_SHORT_LIFETIME);
+	} else {
+		tick += 1 + (unsigned long) prng_exponential(stream, WORKLOAD_MEAN_LIFETIME);
+	}
+
+	if (workload->death_count == workload->death_capacity) {
+		unsigned long capacity = workload->death_capacity ? 2 * workload->death_capacity : WORKLOAD_INITIAL_CAPACITY;
+		workload_death_t* deaths = realloc(workload->deaths, capacity * sizeof(workload_death_t));
+		if (deaths == NULL) {
+			return OUT_OF_MEMORY_ERRNO;
+		}
+
+		workload->deaths = deaths;
+		workload->death_capacity = capacity;
+	}
+
+	// Sift the death up the min-heap.
+	unsigned long i_death = workload->death_count++;
+	while (i_death && workload->deaths[(i_death - 1) / 2].tick > tick) {
+		workload->deaths[i_death] = workload->deaths[(i_death - 1) / 2];
+		i_death = (i_death - 1) / 2;
+	}
+
+	workload->deaths[i_death] = (workload_death_t) { tick, key };
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Removes the earliest death of the min-heap.
+/// </summary>
+/// <param name="workload">The workload. It has at least one death.</param>
+/// <returns>The earliest death.</returns>
+static workload_death_t workload_pop_death(workload_t* workload) {
+	workload_death_t first = workload->deaths[0];
+	workload_death_t last = workload->deaths[--workload->death_count];
+
+	// Sift the last death down from the root.
+	unsigned long i_death = 0, i_child;
+	while ((i_child = 2 * i_death + 1) < workload->death_count) {
+		if (i_child + 1 < workload->death_count && workload->deaths[i_child + 1].tick < workload->deaths[i_child].tick) {
+			i_child++;
+		}
+
+		if (workload->deaths[i_child].tick >= last.tick) {
+			break;
+		}
+
+		workload->deaths[i_death] = workload->deaths[i_child];
+		i_death = i_child;
+	}
+
+	workload->deaths[i_death] = last;
+	return first;
+}
+
+/// <summary>
+/// Takes the next block whose lifetime ended, if any.
+/// </summary>
+/// <param name="workload">The workload.</param>
+/// <param name="key">The out argument for the key of the block.</param>
+/// <param name="flag">The out argument for whether a block was taken.</param>
+/// <returns>The state code.</returns>
+int workload_next_death(workload_t* workload, mem_address_t* key, unsigned int* flag) {
+	if (workload == NULL || key == NULL || flag == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	*flag = workload->death_count && workload->deaths[0].tick <= workload->tick;
+	if (*flag) {
+		*key = workload_pop_death(workload).key;
+	}
+
+	return SUCCESSFUL_EXEC;
+}
+
+/// <summary>
+/// Takes the next block still alive, in the order of their deaths, then the survivors.
+/// </summary>
+/// <param name="workload">The workload.</param>
+/// <param name="key">The out argument for the key of the block.</param>
+/// <param name="flag">The out argument for whether a block was taken.</param>
+/// <returns>The state code.</returns>
+int workload_next_alive(workload_t* workload, mem_address_t* key, unsigned int* flag) {
+	if (workload == NULL || key == NULL || flag == NULL) {
+		return ILLEGAL_ARGUMENTS_ERRNO;
+	}
+
+	*flag = true;
+	if (workload->death_count) {
+		*key = workload_pop_death(workload).key;
+	} else if (workload->survivor_count) {
+		*key = workload->survivors[--workload->survivor_count];
+	} else {
+		*flag = false;
+	}
+
+	return SUCCESSFUL_EXEC;
+}
\ No newline at end of file
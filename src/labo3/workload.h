@@ -0,0 +1,179 @@
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include <stdint.h>
+
+// Kinds of workloads. The formula workload is the historic one of the tester: sizes from a fixed formula, and random frees at the alloc-to-free ratio.
+#define WORKLOAD_FORMULA 0
+#define WORKLOAD_LOGNORMAL 1
+#define WORKLOAD_ZIPF 2
+#define WORKLOAD_PHASES 3
+#define WORKLOAD_PRODUCER_CONSUMER 4
+
+// Streams of random numbers of a workload. Every stream is seeded apart, so drawing more from one does not change the others.
+#define WORKLOAD_SIZE_STREAM 0
+#define WORKLOAD_LIFETIME_STREAM 1
+#define WORKLOAD_STREAM_COUNT 2
+
+// Lognormal sizes have a median of the maximum size divided by this, and a spread of sigma.
+#define WORKLOAD_LOGNORMAL_MEDIAN_DIVISOR 16
+#define WORKLOAD_LOGNORMAL_SIGMA 1.0
+
+// Zipf sizes are multiples of the granule, the smallest being the most frequent.
+// A maximum size of more ranks than the greatest rank count gets a larger granule, so the cumulative probabilities stay small.
+#define WORKLOAD_ZIPF_GRANULE 16
+#define WORKLOAD_ZIPF_MAXIMUM_RANK_COUNT (1 << 20)
+#define WORKLOAD_ZIPF_EXPONENT 1.1
+
+// Lifetimes are exponential, in allocations. Some blocks survive until the end instead, so that the heap fills up.
+#define WORKLOAD_MEAN_LIFETIME 1000
+#define WORKLOAD_SURVIVOR_PERCENT 10
+
+// The phases workload switches, every phase length, between small short-lived blocks and large long-lived blocks.
+#define WORKLOAD_PHASE_LENGTH 5000
+#define WORKLOAD_SHORT_LIFETIME 100
+#define WORKLOAD_LONG_LIFETIME 10000
+
+// The producer-consumer workload frees its messages in order, after a mean queue depth.
+#define WORKLOAD_QUEUE_DEPTH 256
+
+// Initial capacity of the blocks of a workload. It doubles as needed.
+#define WORKLOAD_INITIAL_CAPACITY 1024
+
+// Structure for a stream of pseudo random numbers, by the xoshiro256** generator.
+// The same seed and stream always give the same numbers, on any platform.
+typedef struct prng_t {
+	uint64_t state[4];
+} prng_t;
+
+// Structure for a block of a workload and the allocation count at which it is freed.
+typedef struct workload_death_t {
+	unsigned long tick;
+	mem_address_t key;
+} workload_death_t;
+
+// Structure for a workload generator: the sizes of the allocations, and when every block is freed.
+typedef struct workload_t {
+	unsigned int kind;
+	sz_t max_size;
+	prng_t streams[WORKLOAD_STREAM_COUNT];
+
+	// The count of allocations so far, which is the clock of the lifetimes.
+	unsigned long tick;
+
+	// The cumulative probabilities of the sizes of the Zipf workload, by rank.
+	double* zipf_cdf;
+	unsigned int zipf_count;
+	sz_t zipf_granule;
+
+	// The blocks to free, as a min-heap by tick.
+	workload_death_t* deaths;
+	unsigned long death_count;
+	unsigned long death_capacity;
+
+	// The blocks that survive until the end.
+	mem_address_t* survivors;
+	unsigned long survivor_count;
+	unsigned long survivor_capacity;
+
+	// The tick of the last message of the producer-consumer queue, since messages are consumed in order.
+	unsigned long last_tick;
+} workload_t;
+
+/// <summary>
+/// Seeds a stream of pseudo random numbers. Streams of the same seed are independent.
+/// </summary>
+/// <param name="prng">The stream to seed.</param>
+/// <param name="seed">The seed.</param>
+/// <param name="stream">The index of the stream.</param>
+/// <returns>The state code.</returns>
+int prng_seed(prng_t* prng, uint64_t seed, unsigned int stream);
+
+/// <summary>
+/// Gets the next pseudo random number of a stream.
+/// </summary>
+/// <param name="prng">The stream.</param>
+/// <returns>The number, uniform over 64 bits.</returns>
+uint64_t prng_next(prng_t* prng);
+
+/// <summary>
+/// Gets the next pseudo random number of a stream, uniform within (0, 1).
+/// </summary>
+/// <param name="prng">The stream.</param>
+/// <returns>The number.</returns>
+double prng_uniform(prng_t* prng);
+
+/// <summary>
+/// Gets the next pseudo random number of a stream, from the standard normal distribution.
+/// </summary>
+/// <param name="prng">The stream.</param>
+/// <returns>The number.</returns>
+double prng_normal(prng_t* prng);
+
+/// <summary>
+/// Gets the next pseudo random number of a stream, from the exponential distribution.
+/// </summary>
+/// <param name="prng">The stream.</param>
+/// <param name="mean">The mean of the distribution.</param>
+/// <returns>The number.</returns>
+double prng_exponential(prng_t* prng, double mean);
+
+/// <summary>
+/// Gets the kind of workload of a name.
+/// </summary>
+/// <param name="name">The name: formula, lognormal, zipf, phases or producer-consumer.</param>
+/// <param name="kind">The out argument for the kind.</param>
+/// <returns>The state code.</returns>
+int workload_kind_of_name(const char* name, unsigned int* kind);
+
+/// <summary>
+/// Initializes a workload generator.
+/// </summary>
+/// <param name="workload">The workload to initialize.</param>
+/// <param name="kind">The kind of workload. It cannot be the formula workload, which the tester runs itself.</param>
+/// <param name="max_size">The maximum size of an allocation.</param>
+/// <param name="seed">The seed of the streams of the workload.</param>
+/// <returns>The state code.</returns>
+int workload_init(workload_t* workload, unsigned int kind, sz_t max_size, uint64_t seed);
+
+/// <summary>
+/// Destroys a workload generator.
+/// </summary>
+/// <param name="workload">The workload.</param>
+/// <returns>The state code.</returns>
+int workload_destroy(workload_t* workload);
+
+/// <summary>
+/// Gets the size of the next allocation.
+/// </summary>
+/// <param name="workload">The workload.</param>
+/// <returns>The size, from 1 to the maximum size.</returns>
+sz_t workload_next_size(workload_t* workload);
+
+/// <summary>
+/// Adds the block of the last allocation, and decides when it is freed. The clock of the workload advances by one allocation.
+/// </summary>
+/// <param name="workload">The workload.</param>
+/// <param name="key">The key of the block, given back when it must be freed.</param>
+/// <returns>The state code.</returns>
+int workload_add(workload_t* workload, mem_address_t key);
+
+/// <summary>
+/// Takes the next block whose lifetime ended, if any.
+/// </summary>
+/// <param name="workload">The workload.</param>
+/// <param name="key">The out argument for the key of the block.</param>
+/// <param name="flag">The out argument for whether a block was taken.</param>
+/// <returns>The state code.</returns>
+int workload_next_death(workload_t* workload, mem_address_t* key, unsigned int* flag);
+
+/// <summary>
+/// Takes the next block still alive, in the order of their deaths, then the survivors.
+/// </summary>
+/// <param name="workload">The workload.</param>
+/// <param name="key">The out argument for the key of the block.</param>
+/// <param name="flag">The out argument for whether a block was taken.</param>
+/// <returns>The state code.</returns>
+int workload_next_alive(workload_t* workload, mem_address_t* key, unsigned int* flag);
+
+#endif
\ No newline at end of file